@@ -0,0 +1,103 @@
+#include "AllocationCounter.h"
+
+#ifdef OAK_COUNT_ALLOCATIONS
+#include <new>
+#include <cstdlib>
+#endif
+
+namespace oak {
+
+namespace {
+
+// Plain thread_locals: no constructors, so operator new can touch them at any
+// point of a thread's life
+thread_local uint64_t tls_count = 0;
+thread_local uint64_t tls_bytes = 0;
+thread_local int tls_excluded = 0;
+
+} // namespace
+
+#ifdef OAK_COUNT_ALLOCATIONS
+
+namespace detail {
+
+inline void countAllocation(std::size_t size) {
+    if (tls_excluded == 0) {
+        ++tls_count;
+        tls_bytes += size;
+    }
+}
+
+} // namespace detail
+
+bool AllocationCounter::enabled() {
+    return true;
+}
+
+#else
+
+bool AllocationCounter::enabled() {
+    return false;
+}
+
+#endif
+
+AllocationCount AllocationCounter::thisThread() {
+    return {tls_count, tls_bytes};
+}
+
+AllocationCounter::Exclude::Exclude() {
+    ++tls_excluded;
+}
+
+AllocationCounter::Exclude::~Exclude() {
+    --tls_excluded;
+}
+
+} // namespace oak
+
+#ifdef OAK_COUNT_ALLOCATIONS
+
+// Replacements for the global allocation functions. The array, nothrow and
+// sized forms are covered by the standard library's defaults, which forward
+// to these; the aligned forms are replaced separately.
+
+void* operator new(std::size_t size) {
+    oak::detail::countAllocation(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#ifndef _WIN32
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    oak::detail::countAllocation(size);
+    auto align = static_cast<std::size_t>(alignment);
+    void* p = nullptr;
+    if (posix_memalign(&p, align < sizeof(void*) ? sizeof(void*) : align, size == 0 ? 1 : size) == 0) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif
+
+#endif
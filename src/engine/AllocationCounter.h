@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+namespace oak {
+
+struct AllocationCount {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    AllocationCount operator-(const AllocationCount& other) const {
+        return {count - other.count, bytes - other.bytes};
+    }
+};
+
+// Allocations a module made on the processing thread while handling frames
+struct AllocationStats {
+    uint64_t frames = 0;
+    uint64_t allocations = 0;            // All frames, including warm-up
+    uint64_t bytes = 0;
+    uint64_t steady_frames = 0;          // Frames after warm-up
+    uint64_t steady_allocations = 0;     // Expected to stay zero
+    double steady_allocations_per_frame = 0.0;
+};
+
+// Per-thread heap allocation counters.
+//
+// Built with OAK_COUNT_ALLOCATIONS (CMake option, off by default), the global
+// operator new is replaced by one that counts on the calling thread before
+// calling malloc; aligned allocations are not counted on Windows. The engine
+// samples the processing thread around each module's process() call, see
+// ModuleBase::getAllocationStats(). Without the option every count reads zero.
+class AllocationCounter {
+public:
+    static bool enabled();
+
+    // Running totals for the calling thread
+    static AllocationCount thisThread();
+
+    // Allocations on this thread inside the scope are not counted, for code
+    // outside our control such as GUI calls
+    class Exclude {
+    public:
+        Exclude();
+        ~Exclude();
+        Exclude(const Exclude&) = delete;
+        Exclude& operator=(const Exclude&) = delete;
+    };
+};
+
+} // namespace oak
@@ -0,0 +1,165 @@
+#include "DetectionBatcher.h"
+#include "ThreadTuning.h"
+#include "Trace.h"
+#include <algorithm>
+#include <iostream>
+
+namespace oak {
+
+DetectionBatcher::DetectionBatcher(const DetectionBatchConfig& config, const ThreadOptions& thread_options)
+    : config_(config),
+      thread_options_(thread_options),
+      ring_(std::max(config.queue_capacity, 2u)) {
+    config_.max_messages = std::max(config_.max_messages, 1u);
+}
+
+DetectionBatcher::~DetectionBatcher() {
+    stop();
+}
+
+void DetectionBatcher::start(DetectionBatchCallback callback) {
+    if (running_) {
+        return;
+    }
+    callback_ = callback;
+    running_ = true;
+    worker_ = std::thread(&DetectionBatcher::workerLoop, this);
+}
+
+void DetectionBatcher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool DetectionBatcher::push(std::shared_ptr<dai::ImgDetections> message) {
+    if (!message || !running_) {
+        return false;
+    }
+    if (!ring_.tryPush(std::move(message))) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    messages_.fetch_add(1, std::memory_order_relaxed);
+
+    // Wake the worker only when it sleeps waiting for this many messages. The
+    // fence pairs with the worker's: either it sees this message before it
+    // sleeps, or we see its threshold. Taking wake_mutex_ keeps the notify
+    // from landing between its check and its wait.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring_.size() >= wake_threshold_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+    return true;
+}
+
+void DetectionBatcher::workerLoop() {
+    configureCurrentThread("oak-batcher", thread_options_);
+
+    const auto window = std::chrono::milliseconds(config_.window_ms);
+    DetectionBatch batch;
+    batch.frames.reserve(config_.max_messages);
+    std::chrono::steady_clock::time_point window_start;
+
+    while (true) {
+        bool stopping = !running_.load();
+        bool was_empty = batch.frames.empty();
+
+        // Take everything queued, so a backlog is absorbed by one larger batch
+        drainInto(batch, SIZE_MAX);
+        auto now = std::chrono::steady_clock::now();
+        if (was_empty && !batch.frames.empty()) {
+            window_start = now;
+        }
+
+        bool due = !batch.frames.empty() &&
+                   (stopping || batch.frames.size() >= config_.max_messages || now - window_start >= window);
+        if (due) {
+            deliver(batch);
+            continue;
+        }
+        if (stopping) {
+            break;
+        }
+
+        // Sleep until the window closes or enough messages arrive to open or fill a batch
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        auto timeout = batch.frames.empty() ? window : window - (now - window_start);
+        size_t wanted = batch.frames.empty() ? 1 : config_.max_messages - batch.frames.size();
+        wake_threshold_.store(wanted, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_cv_.wait_for(lock, timeout, [&] {
+            return !running_.load() || ring_.size() >= wanted;
+        });
+        wake_threshold_.store(SIZE_MAX, std::memory_order_relaxed);
+    }
+}
+
+void DetectionBatcher::drainInto(DetectionBatch& batch, size_t max_messages) {
+    std::shared_ptr<dai::ImgDetections> message;
+    while (batch.frames.size() < max_messages && ring_.tryPop(message)) {
+        const auto& detections = message->detections;
+        batch.frames.push_back({message->getSequenceNum(), message->getTimestamp(),
+                                static_cast<uint32_t>(batch.detections.size()),
+                                static_cast<uint32_t>(detections.size())});
+        batch.detections.insert(batch.detections.end(), detections.begin(), detections.end());
+    }
+}
+
+void DetectionBatcher::deliver(DetectionBatch& batch) {
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    batch.dropped_before = dropped - dropped_reported_;
+    dropped_reported_ = dropped;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        batch.batch_index = batches_;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (callback_) {
+        TraceSpan span("batch_callback", "DetectionBatcher", static_cast<int64_t>(batch.batch_index));
+        try {
+            callback_(batch);
+        } catch (const std::exception& e) {
+            std::cerr << "Detection batch callback failed: " << e.what() << std::endl;
+        }
+    }
+    double elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        batches_++;
+        batched_messages_ += batch.frames.size();
+        delivery_ms_total_ += elapsed_ms;
+    }
+
+    // Keep capacity so steady-state batches do not allocate
+    batch.frames.clear();
+    batch.detections.clear();
+}
+
+DetectionBatchStats DetectionBatcher::getStats() const {
+    DetectionBatchStats stats;
+    stats.messages = messages_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.queue_depth = static_cast<uint32_t>(ring_.size());
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats.batches = batches_;
+    if (batches_ > 0) {
+        stats.mean_batch_messages = static_cast<double>(batched_messages_) / static_cast<double>(batches_);
+        stats.mean_delivery_ms = delivery_ms_total_ / static_cast<double>(batches_);
+    }
+    return stats;
+}
+
+} // namespace oak
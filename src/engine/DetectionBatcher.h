@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <condition_variable>
+#include <depthai/depthai.hpp>
+#include "Types.h"
+#include "SpscRing.h"
+
+namespace oak {
+
+// Per-message slice of a batch
+struct DetectionBatchFrame {
+    int64_t sequence_num;
+    std::chrono::steady_clock::time_point timestamp;
+    uint32_t first;                      // Index of the first detection in DetectionBatch::detections
+    uint32_t count;
+};
+
+// Detections of several messages, stored contiguously
+struct DetectionBatch {
+    std::vector<DetectionBatchFrame> frames;
+    std::vector<dai::ImgDetection> detections;
+    uint64_t batch_index = 0;
+    uint64_t dropped_before = 0;         // Messages dropped since the previous batch (consumer too slow)
+};
+
+using DetectionBatchCallback = std::function<void(const DetectionBatch&)>;
+
+struct DetectionBatchStats {
+    uint64_t messages = 0;               // Accepted from the producer
+    uint64_t dropped = 0;                // Rejected because the queue was full
+    uint64_t batches = 0;
+    double mean_batch_messages = 0.0;
+    double mean_delivery_ms = 0.0;       // Time spent in the consumer callback
+    uint32_t queue_depth = 0;
+};
+
+// Collects ImgDetections messages and hands them to a consumer in batches,
+// on its own thread. A batch is delivered when max_messages are collected or
+// window_ms after its first message, whichever comes first.
+//
+// push() never waits for the consumer: messages go through a lock-free SPSC
+// ring, and it only takes a lock to wake the worker when the worker sleeps
+// waiting for that message. When the consumer falls behind the ring fills up,
+// later batches grow to absorb the backlog, and messages beyond
+// queue_capacity are dropped and reported.
+// push() must not be called concurrently; the module's detection stream on
+// the task pool guarantees that.
+class DetectionBatcher {
+public:
+    explicit DetectionBatcher(const DetectionBatchConfig& config = DetectionBatchConfig{},
+                              const ThreadOptions& thread_options = ThreadOptions{});
+    ~DetectionBatcher();
+
+    DetectionBatcher(const DetectionBatcher&) = delete;
+    DetectionBatcher& operator=(const DetectionBatcher&) = delete;
+
+    void start(DetectionBatchCallback callback);
+    // Delivers whatever is still queued, then joins the worker
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // Producer side; returns false if the message was dropped
+    bool push(std::shared_ptr<dai::ImgDetections> message);
+
+    DetectionBatchStats getStats() const;
+
+private:
+    void workerLoop();
+    void drainInto(DetectionBatch& batch, size_t max_messages);
+    void deliver(DetectionBatch& batch);
+
+    DetectionBatchConfig config_;
+    ThreadOptions thread_options_;
+    DetectionBatchCallback callback_;
+    SpscRing<std::shared_ptr<dai::ImgDetections>> ring_;
+
+    std::atomic<bool> running_{false};
+    std::thread worker_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<size_t> wake_threshold_{SIZE_MAX};  // Queued messages the sleeping worker waits for
+
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t dropped_reported_ = 0;      // Worker thread only
+
+    mutable std::mutex stats_mutex_;
+    uint64_t batches_ = 0;
+    uint64_t batched_messages_ = 0;
+    double delivery_ms_total_ = 0.0;
+};
+
+} // namespace oak
@@ -0,0 +1,554 @@
+#include "DetectionLog.h"
+#include "SampleStats.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace oak {
+
+namespace {
+
+constexpr char kMagic[8] = {'O', 'A', 'K', 'D', 'L', 'O', 'G', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 4096;
+constexpr size_t kColumnAlign = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "committed count must be lock-free in shared memory");
+
+// Fixed layout at the start of every segment file
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t index_stride;
+    uint64_t capacity;
+    std::atomic<uint64_t> committed;     // Records visible to readers, published last
+    int64_t min_timestamp_us;            // Over all written records (may include one uncommitted)
+    int64_t max_timestamp_us;
+};
+
+struct IndexEntry {
+    int64_t min_timestamp_us;
+    int64_t max_timestamp_us;
+    uint64_t label_mask;                 // Bit per label; labels >= 63 share the top bit
+};
+
+uint64_t labelBit(uint16_t label) {
+    return uint64_t{1} << std::min<uint16_t>(label, 63);
+}
+
+size_t alignUp(size_t value) {
+    return (value + kColumnAlign - 1) & ~(kColumnAlign - 1);
+}
+
+// Byte offsets of the index and each column for a given capacity
+struct Layout {
+    size_t index, timestamp, sequence, confidence, box, source, label, total;
+
+    Layout(uint64_t capacity, uint32_t stride) {
+        size_t n = static_cast<size_t>(capacity);
+        size_t blocks = (n + stride - 1) / stride;
+        index = kHeaderSize;
+        timestamp = alignUp(index + blocks * sizeof(IndexEntry));
+        sequence = alignUp(timestamp + n * sizeof(int64_t));
+        confidence = alignUp(sequence + n * sizeof(int64_t));
+        box = alignUp(confidence + n * sizeof(float));          // xmin, ymin, xmax, ymax columns
+        source = alignUp(box + 4 * n * sizeof(float));
+        label = alignUp(source + n * sizeof(uint16_t));
+        total = alignUp(label + n * sizeof(uint16_t));
+    }
+};
+
+class MappedFile {
+public:
+    ~MappedFile() { close(); }
+
+    // Maps the whole file read-write; create extends a new file to size bytes
+    bool open(const std::string& path, size_t size, bool create) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                            create ? CREATE_NEW : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        if (!create) {
+            LARGE_INTEGER file_size;
+            GetFileSizeEx(file_, &file_size);
+            size = static_cast<size_t>(file_size.QuadPart);
+        }
+        ULARGE_INTEGER map_size;
+        map_size.QuadPart = size;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE,
+                                      map_size.HighPart, map_size.LowPart, nullptr);
+        if (!mapping_) {
+            close();
+            return false;
+        }
+        data_ = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+        fd_ = ::open(path.c_str(), O_RDWR | (create ? O_CREAT | O_EXCL : 0), 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        if (create) {
+            // Sparse: blocks are only allocated as records are written
+            if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+                close();
+                return false;
+            }
+        } else {
+            struct stat st;
+            if (::fstat(fd_, &st) != 0) {
+                close();
+                return false;
+            }
+            size = static_cast<size_t>(st.st_size);
+        }
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        data_ = data == MAP_FAILED ? nullptr : data;
+#endif
+        if (!data_) {
+            close();
+            return false;
+        }
+        size_ = size;
+        return true;
+    }
+
+    void sync() {
+        if (!data_) {
+            return;
+        }
+#ifdef _WIN32
+        FlushViewOfFile(data_, 0);
+        FlushFileBuffers(file_);
+#else
+        ::msync(data_, size_, MS_SYNC);
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    uint8_t* data() const { return static_cast<uint8_t*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace
+
+struct DetectionLog::Segment {
+    std::string path;
+    MappedFile file;
+    SegmentHeader* header = nullptr;
+    IndexEntry* index = nullptr;
+    int64_t* timestamp = nullptr;
+    int64_t* sequence = nullptr;
+    float* confidence = nullptr;
+    float* box[4] = {nullptr, nullptr, nullptr, nullptr};
+    uint16_t* source = nullptr;
+    uint16_t* label = nullptr;
+    uint64_t capacity = 0;
+    uint32_t stride = 0;
+
+    void bind() {
+        header = reinterpret_cast<SegmentHeader*>(file.data());
+        capacity = header->capacity;
+        stride = header->index_stride;
+        Layout layout(capacity, stride);
+        uint8_t* base = file.data();
+        index = reinterpret_cast<IndexEntry*>(base + layout.index);
+        timestamp = reinterpret_cast<int64_t*>(base + layout.timestamp);
+        sequence = reinterpret_cast<int64_t*>(base + layout.sequence);
+        confidence = reinterpret_cast<float*>(base + layout.confidence);
+        for (size_t c = 0; c < 4; ++c) {
+            box[c] = reinterpret_cast<float*>(base + layout.box) + c * capacity;
+        }
+        source = reinterpret_cast<uint16_t*>(base + layout.source);
+        label = reinterpret_cast<uint16_t*>(base + layout.label);
+    }
+
+    uint64_t committed() const {
+        return header->committed.load(std::memory_order_acquire);
+    }
+};
+
+DetectionLog::DetectionLog(const DetectionLogConfig& config)
+    : config_(config) {
+}
+
+DetectionLog::~DetectionLog() {
+    close();
+}
+
+int64_t DetectionLog::toWallClockUs(std::chrono::steady_clock::time_point timestamp) {
+    auto age = std::chrono::steady_clock::now() - timestamp;
+    auto wall = std::chrono::system_clock::now() - std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+    return std::chrono::duration_cast<std::chrono::microseconds>(wall.time_since_epoch()).count();
+}
+
+std::shared_ptr<DetectionLog::Segment> DetectionLog::openSegment(const std::string& path, bool create) {
+    auto segment = std::make_shared<Segment>();
+    segment->path = path;
+
+    uint32_t stride = std::max(config_.index_stride, 1u);
+    uint64_t capacity = std::max<uint64_t>(config_.segment_capacity, stride);
+    Layout layout(capacity, stride);
+    if (!segment->file.open(path, layout.total, create)) {
+        std::cerr << "Failed to map detection log segment: " << path << std::endl;
+        return nullptr;
+    }
+
+    auto* header = reinterpret_cast<SegmentHeader*>(segment->file.data());
+    if (create) {
+        std::memcpy(header->magic, kMagic, sizeof(kMagic));
+        header->version = kVersion;
+        header->index_stride = stride;
+        header->capacity = capacity;
+        header->min_timestamp_us = INT64_MAX;
+        header->max_timestamp_us = INT64_MIN;
+        header->committed.store(0, std::memory_order_release);
+    } else {
+        // Validate against the segment's own geometry, which may predate the current config
+        bool valid = segment->file.size() >= kHeaderSize &&
+                     std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+                     header->version == kVersion && header->index_stride > 0 &&
+                     Layout(header->capacity, header->index_stride).total <= segment->file.size() &&
+                     header->committed.load() <= header->capacity;
+        if (!valid) {
+            std::cerr << "Ignoring invalid detection log segment: " << path << std::endl;
+            return nullptr;
+        }
+    }
+
+    segment->bind();
+    return segment;
+}
+
+bool DetectionLog::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_) {
+        return true;
+    }
+
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(config_.directory, ec);
+
+    // Segment files are named detections_<id>.odl; ids sort numerically as text
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::directory_iterator(config_.directory, ec)) {
+        auto name = entry.path().filename().string();
+        if (name.rfind("detections_", 0) == 0 && entry.path().extension() == ".odl") {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const auto& path : paths) {
+        if (auto segment = openSegment(path.string(), false)) {
+            segments_.push_back(segment);
+        }
+        unsigned id = 0;
+        if (std::sscanf(path.filename().string().c_str(), "detections_%u.odl", &id) == 1) {
+            next_segment_id_ = std::max(next_segment_id_, id + 1);
+        }
+    }
+
+    // Resume the newest segment if it has room, otherwise start a new one
+    if (!segments_.empty() && segments_.back()->committed() < segments_.back()->capacity) {
+        active_ = segments_.back();
+    } else if (!rollover()) {
+        return false;
+    }
+
+    uint64_t records = 0;
+    for (const auto& segment : segments_) {
+        records += segment->committed();
+    }
+    std::cout << "Detection log opened: " << config_.directory << " (" << segments_.size()
+              << " segments, " << records << " records)" << std::endl;
+    return true;
+}
+
+void DetectionLog::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_) {
+        active_->file.sync();
+    }
+    active_.reset();
+    segments_.clear();
+}
+
+bool DetectionLog::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_ != nullptr;
+}
+
+bool DetectionLog::rollover() {
+    if (active_) {
+        active_->file.sync();
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "detections_%06u.odl", next_segment_id_++);
+    auto segment = openSegment((std::filesystem::path(config_.directory) / name).string(), true);
+    if (!segment) {
+        active_.reset();
+        return false;
+    }
+    segments_.push_back(segment);
+    active_ = segment;
+    return true;
+}
+
+bool DetectionLog::append(const dai::ImgDetections& detections, uint16_t source) {
+    return append(toWallClockUs(detections.getTimestamp()), detections.getSequenceNum(),
+                  source, detections.detections);
+}
+
+bool DetectionLog::append(int64_t timestamp_us, int64_t sequence, uint16_t source,
+                          const std::vector<dai::ImgDetection>& detections) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) {
+        dropped_ += detections.size();
+        return false;
+    }
+
+    for (const auto& det : detections) {
+        Segment* segment = active_.get();
+        uint64_t row = segment->header->committed.load(std::memory_order_relaxed);
+        if (row >= segment->capacity) {
+            if (!rollover()) {
+                dropped_ += detections.size();
+                return false;
+            }
+            segment = active_.get();
+            row = 0;
+        }
+
+        // Columns first ...
+        auto label = static_cast<uint16_t>(std::min<uint32_t>(det.label, UINT16_MAX));
+        segment->timestamp[row] = timestamp_us;
+        segment->sequence[row] = sequence;
+        segment->confidence[row] = det.confidence;
+        segment->box[0][row] = det.xmin;
+        segment->box[1][row] = det.ymin;
+        segment->box[2][row] = det.xmax;
+        segment->box[3][row] = det.ymax;
+        segment->source[row] = source;
+        segment->label[row] = label;
+
+        // ... then the index; the first row of a block overwrites whatever an
+        // interrupted append may have left there ...
+        IndexEntry& entry = segment->index[row / segment->stride];
+        if (row % segment->stride == 0) {
+            entry = {timestamp_us, timestamp_us, labelBit(label)};
+        } else {
+            entry.min_timestamp_us = std::min(entry.min_timestamp_us, timestamp_us);
+            entry.max_timestamp_us = std::max(entry.max_timestamp_us, timestamp_us);
+            entry.label_mask |= labelBit(label);
+        }
+        auto* header = segment->header;
+        header->min_timestamp_us = std::min(header->min_timestamp_us, timestamp_us);
+        header->max_timestamp_us = std::max(header->max_timestamp_us, timestamp_us);
+
+        // ... and finally publish the record
+        header->committed.store(row + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+size_t DetectionLog::query(const DetectionQuery& query, std::vector<DetectionRecord>& out) const {
+    std::vector<std::shared_ptr<Segment>> segments;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments = segments_;
+    }
+
+    const size_t start_size = out.size();
+    const uint64_t label_mask = query.label ? labelBit(*query.label) : ~uint64_t{0};
+    auto full = [&] { return query.limit > 0 && out.size() - start_size >= query.limit; };
+
+    for (const auto& segment : segments) {
+        // Only what the acquired committed count covers is stable: appends
+        // keep updating the header range and the open block's index entry,
+        // so those are only used once every record they cover is published
+        uint64_t committed = segment->committed();
+        if (committed == 0) {
+            continue;
+        }
+        const auto* header = segment->header;
+        if (committed == segment->capacity &&
+            (header->max_timestamp_us < query.begin_us || header->min_timestamp_us > query.end_us)) {
+            continue;
+        }
+
+        for (uint64_t block = 0; block * segment->stride < committed; ++block) {
+            bool sealed = (block + 1) * segment->stride <= committed;
+            const IndexEntry& entry = segment->index[block];
+            if (sealed && (entry.max_timestamp_us < query.begin_us || entry.min_timestamp_us > query.end_us ||
+                           (entry.label_mask & label_mask) == 0)) {
+                continue;
+            }
+
+            uint64_t end = std::min<uint64_t>(committed, (block + 1) * segment->stride);
+            for (uint64_t row = block * segment->stride; row < end; ++row) {
+                int64_t ts = segment->timestamp[row];
+                if (ts < query.begin_us || ts > query.end_us ||
+                    (query.label && segment->label[row] != *query.label) ||
+                    (query.source && segment->source[row] != *query.source)) {
+                    continue;
+                }
+                out.push_back({ts, segment->sequence[row], segment->source[row], segment->label[row],
+                               segment->confidence[row], segment->box[0][row], segment->box[1][row],
+                               segment->box[2][row], segment->box[3][row]});
+                if (full()) {
+                    return out.size() - start_size;
+                }
+            }
+        }
+    }
+    return out.size() - start_size;
+}
+
+void DetectionLog::sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_) {
+        active_->file.sync();
+    }
+}
+
+DetectionLogStats DetectionLog::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DetectionLogStats stats;
+    stats.segments = static_cast<uint32_t>(segments_.size());
+    stats.dropped = dropped_;
+    for (const auto& segment : segments_) {
+        stats.records += segment->committed();
+    }
+    return stats;
+}
+
+DetectionLogBenchmark benchmarkDetectionLog(uint32_t messages, uint32_t detections_per_message,
+                                            uint32_t queries) {
+    namespace fs = std::filesystem;
+    using clock = std::chrono::steady_clock;
+    DetectionLogBenchmark result;
+
+    DetectionLogConfig config;
+    config.directory = (fs::temp_directory_path() / "oak-detection-log-bench").string();
+    config.segment_capacity = 1 << 16;   // Several segments, so segment skipping is exercised
+    std::error_code ec;
+    fs::remove_all(config.directory, ec);
+
+    // 30 fps, labels 0-9 drawn uniformly
+    constexpr int64_t kFrameUs = 33333;
+    constexpr int64_t kStartUs = 1700000000000000;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<uint32_t> label(0, 9);
+    std::uniform_real_distribution<float> unit(0.0f, 0.9f);
+    std::vector<dai::ImgDetection> detections(std::max(detections_per_message, 1u));
+
+    {
+        DetectionLog log(config);
+        if (!log.open()) {
+            return result;
+        }
+
+        std::vector<double> append_ns;
+        append_ns.reserve(messages);
+        for (uint32_t m = 0; m < messages; ++m) {
+            for (auto& det : detections) {
+                det.label = label(rng);
+                det.confidence = 0.5f;
+                det.xmin = unit(rng);
+                det.ymin = unit(rng);
+                det.xmax = det.xmin + 0.1f;
+                det.ymax = det.ymin + 0.1f;
+            }
+            auto start = clock::now();
+            log.append(kStartUs + m * kFrameUs, m, 0, detections);
+            append_ns.push_back(std::chrono::duration<double, std::nano>(clock::now() - start).count());
+        }
+        SampleSummary appends = summarizeSamples(append_ns);
+        result.append_ns = appends.mean;
+        result.append_p99_ns = appends.p99;
+
+        auto stats = log.getStats();
+        result.records = stats.records;
+        result.segments = stats.segments;
+
+        std::vector<DetectionRecord> out;
+        out.reserve(result.records);
+        std::uniform_int_distribution<uint32_t> frame(0, std::max(messages, 30u) - 30);
+        double label_us = 0.0;
+        double window_us = 0.0;
+        size_t label_matches = 0;
+        size_t window_matches = 0;
+        for (uint32_t q = 0; q < queries; ++q) {
+            DetectionQuery by_label;
+            by_label.label = static_cast<uint16_t>(q % 10);
+            out.clear();
+            auto start = clock::now();
+            label_matches += log.query(by_label, out);
+            label_us += std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+            DetectionQuery window;
+            window.begin_us = kStartUs + frame(rng) * kFrameUs;
+            window.end_us = window.begin_us + 1000000;
+            out.clear();
+            start = clock::now();
+            window_matches += log.query(window, out);
+            window_us += std::chrono::duration<double, std::micro>(clock::now() - start).count();
+        }
+        if (queries > 0) {
+            result.label_query_us = label_us / queries;
+            result.label_query_matches = static_cast<double>(label_matches) / queries;
+            result.window_query_us = window_us / queries;
+            result.window_query_matches = static_cast<double>(window_matches) / queries;
+        }
+    }
+
+    fs::remove_all(config.directory, ec);
+    return result;
+}
+
+} // namespace oak
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <depthai/depthai.hpp>
+#include "Types.h"
+
+namespace oak {
+
+// One stored detection, as returned by queries
+struct DetectionRecord {
+    int64_t timestamp_us;    // Wall clock (system_clock) microseconds
+    int64_t sequence;        // Frame sequence number
+    uint16_t source;         // Caller-defined stream id (e.g. camera socket)
+    uint16_t label;
+    float confidence;
+    float xmin, ymin, xmax, ymax;
+};
+
+struct DetectionQuery {
+    int64_t begin_us = INT64_MIN;        // Inclusive
+    int64_t end_us = INT64_MAX;          // Inclusive
+    std::optional<uint16_t> label;
+    std::optional<uint16_t> source;
+    size_t limit = 0;                    // 0 = no limit
+};
+
+struct DetectionLogStats {
+    uint64_t records = 0;
+    uint32_t segments = 0;
+    uint64_t dropped = 0;                // Appends that failed (log closed or rollover failed)
+};
+
+// Append and query cost over a synthetic log, in a temporary directory
+// that is removed afterwards
+struct DetectionLogBenchmark {
+    uint64_t records = 0;
+    uint32_t segments = 0;
+    double append_ns = 0.0;              // Per message
+    double append_p99_ns = 0.0;
+    double label_query_us = 0.0;         // One label over the whole log
+    double label_query_matches = 0.0;
+    double window_query_us = 0.0;        // Every label over a one-second window
+    double window_query_matches = 0.0;
+};
+
+DetectionLogBenchmark benchmarkDetectionLog(uint32_t messages, uint32_t detections_per_message,
+                                            uint32_t queries);
+
+// Append-only detection store backed by memory-mapped segment files.
+//
+// Each segment holds a fixed number of records stored column by column
+// (timestamps, sequences, confidences, boxes, sources, labels), plus a sparse
+// index with one entry per index_stride records: min/max timestamp and a
+// bitmask of the labels present. Range queries skip whole segments and blocks
+// using the index and only scan the columns they need.
+//
+// Appends copy into the mapping with no allocation; only segment rollover
+// creates a file. Records are written before the segment's committed count is
+// published, so a crash never exposes a torn record: on reopen the log
+// resumes after the last committed one. Data reaches the page cache
+// immediately (safe against process crashes); sync() forces it to disk.
+// Queries may run concurrently with appends; they see every record
+// committed when they reach its segment.
+class DetectionLog {
+public:
+    explicit DetectionLog(const DetectionLogConfig& config = DetectionLogConfig{});
+    ~DetectionLog();
+
+    DetectionLog(const DetectionLog&) = delete;
+    DetectionLog& operator=(const DetectionLog&) = delete;
+
+    // Map existing segments in the directory (or create the first one)
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    // Append every detection of a message; the host timestamp is converted to wall clock
+    bool append(const dai::ImgDetections& detections, uint16_t source = 0);
+    bool append(int64_t timestamp_us, int64_t sequence, uint16_t source,
+                const std::vector<dai::ImgDetection>& detections);
+
+    // Records matching the query, in append order; returns the number added to out
+    size_t query(const DetectionQuery& query, std::vector<DetectionRecord>& out) const;
+
+    // Flush dirty pages of the active segment to disk
+    void sync();
+
+    DetectionLogStats getStats() const;
+
+    static int64_t toWallClockUs(std::chrono::steady_clock::time_point timestamp);
+
+private:
+    struct Segment;
+
+    std::shared_ptr<Segment> openSegment(const std::string& path, bool create);
+    bool rollover();
+
+    DetectionLogConfig config_;
+    mutable std::mutex mutex_;           // Serializes appends and segment list changes
+    std::vector<std::shared_ptr<Segment>> segments_;
+    std::shared_ptr<Segment> active_;
+    uint32_t next_segment_id_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+} // namespace oak
@@ -2,12 +2,35 @@
 #include "../modules/PreviewModule.h"
 #include "../modules/RecordModule.h"
 #include "../modules/InferenceModule.h"
+#include "../modules/DepthModule.h"
+#include "../modules/MultiCameraModule.h"
+#include "ThreadTuning.h"
+#include "InferenceProfile.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <stdexcept>
+#include <algorithm>
 
 namespace oak {
 
+namespace {
+
+// Messages the module has pulled from its device queues so far
+uint64_t streamMessages(const ModuleBase& module) {
+    uint64_t total = 0;
+    for (const auto& stats : module.getQueueStats()) {
+        total += stats.received;
+    }
+    return total;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
 EngineManager& EngineManager::getInstance() {
     static EngineManager instance;
     return instance;
@@ -20,23 +43,40 @@ EngineManager::~EngineManager() {
 bool EngineManager::initialize(const EngineConfig& config) {
     std::lock_guard<std::mutex> lock(mutex_);
 
-    if (device_) {
+    if (device_ || simulated_) {
         std::cerr << "Engine already initialized" << std::endl;
         return false;
     }
 
     config_ = config;
+    if (config_.enable_tracing) {
+        Tracer::enable(config_.trace_events_per_thread);
+    }
 
     try {
+        if (config_.simulation.enabled) {
+            // Modules run against host-generated frames (see SimulatedSource.h)
+            std::cout << "Using simulated device, no hardware connected" << std::endl;
+            simulated_ = true;
+            task_pool_ = std::make_shared<TaskPool>(config_.worker_threads, config_.max_stream_backlog,
+                                                    config_.pool_threads);
+            task_pool_->start();
+            if (config_.thumbnails.enabled) {
+                thumbnails_ = std::make_shared<ThumbnailHistory>(config_.thumbnails, task_pool_);
+            }
+
+            state_ = ModuleState::IDLE;
+            running_ = true;
+            return true;
+        }
+
         // Connect to device
         if (config_.device_id.empty()) {
             std::cout << "Connecting to first available device..." << std::endl;
-            device_ = std::make_shared<dai::Device>();
         } else {
             std::cout << "Connecting to device: " << config_.device_id << std::endl;
-            dai::DeviceInfo info(config_.device_id);
-            device_ = std::make_shared<dai::Device>(info);
         }
+        device_ = connectDevice();
 
         std::cout << "Connected to device: " << device_->getDeviceName() << std::endl;
         std::cout << "MxId: " << device_->getMxId() << std::endl;
@@ -49,8 +89,24 @@ bool EngineManager::initialize(const EngineConfig& config) {
         }
         std::cout << std::endl;
 
+        link_capacity_ = estimateLinkCapacity(*device_, config_.use_poe);
+        std::cout << "Link: " << link_capacity_.link << ", ~" << link_capacity_.mbps << " Mbps usable (estimated)"
+                  << std::endl;
+
+        task_pool_ = std::make_shared<TaskPool>(config_.worker_threads, config_.max_stream_backlog,
+                                                config_.pool_threads);
+        task_pool_->start();
+        if (config_.thumbnails.enabled) {
+            thumbnails_ = std::make_shared<ThumbnailHistory>(config_.thumbnails, task_pool_);
+        }
+
         state_ = ModuleState::IDLE;
         running_ = true;
+
+        if (config_.watchdog.enabled && !watchdog_thread_.joinable()) {
+            watchdog_stop_ = false;
+            watchdog_thread_ = std::thread(&EngineManager::watchdogLoop, this);
+        }
         return true;
 
     } catch (const std::exception& e) {
@@ -63,22 +119,50 @@ bool EngineManager::initialize(const EngineConfig& config) {
 void EngineManager::shutdown() {
     std::cout << "Shutting down engine..." << std::endl;
 
+    // Interrupts a recovery in progress
+    {
+        std::lock_guard<std::mutex> lock(watchdog_mutex_);
+        watchdog_stop_ = true;
+    }
+    watchdog_cv_.notify_all();
+    if (watchdog_thread_.joinable()) {
+        watchdog_thread_.join();
+    }
+
+    std::lock_guard<std::recursive_mutex> lifecycle(lifecycle_mutex_);
     stopModule();
 
+    std::shared_ptr<DetectionBatcher> batcher;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batcher = std::move(detection_batcher_);
+    }
+    if (batcher) {
+        batcher->stop();
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
     running_ = false;
+    thumbnails_.reset();
+
+    if (task_pool_) {
+        task_pool_->stop();
+        task_pool_.reset();
+    }
     
     if (device_) {
         device_->close();
         device_.reset();
     }
+    simulated_ = false;
 
     state_ = ModuleState::IDLE;
     std::cout << "Engine shutdown complete" << std::endl;
 }
 
 bool EngineManager::startPreview(const OutputConfig& config) {
-    if (!device_) {
+    std::lock_guard<std::recursive_mutex> lifecycle(lifecycle_mutex_);
+    if (!device_ && !simulated_) {
         std::cerr << "Device not initialized" << std::endl;
         return false;
     }
@@ -93,12 +177,14 @@ bool EngineManager::startPreview(const OutputConfig& config) {
     }
 
     state_ = ModuleState::PREVIEW;
+    restart_ = [this, config] { return startPreview(config); };
     current_output_config_ = config;
     return true;
 }
 
 bool EngineManager::startRecording(const RecordConfig& config) {
-    if (!device_) {
+    std::lock_guard<std::recursive_mutex> lifecycle(lifecycle_mutex_);
+    if (!device_ && !simulated_) {
         std::cerr << "Device not initialized" << std::endl;
         return false;
     }
@@ -113,26 +199,132 @@ bool EngineManager::startRecording(const RecordConfig& config) {
     }
 
     state_ = ModuleState::RECORD;
+    restart_ = [this, config] { return startRecording(config); };
     return true;
 }
 
 bool EngineManager::startInference(const InferenceConfig& config) {
-    if (!device_) {
+    std::lock_guard<std::recursive_mutex> lifecycle(lifecycle_mutex_);
+    if (!device_ && !simulated_) {
         std::cerr << "Device not initialized" << std::endl;
         return false;
     }
 
     stopModule();
 
-    auto module = std::make_shared<InferenceModule>(config);
+    // Settings oak-tune found for this model, unless the caller chose their own
+    InferenceConfig resolved = config;
+    applyInferenceProfile(resolved);
+
+    auto module = std::make_shared<InferenceModule>(resolved);
     module->setFrameCallback(frame_callback_);
-    module->setDetectionCallback(detection_callback_);
+    module->setDetectionCallback(moduleDetectionCallback());
+    module->setCropCallback(crop_callback_);
+    module->setCascadeCallback(cascade_callback_);
     
     if (!buildAndStartPipeline(module)) {
         return false;
     }
 
     state_ = ModuleState::INFERENCE;
+    restart_ = [this, config] { return startInference(config); };
+    return true;
+}
+
+bool EngineManager::startDepth(const DepthConfig& config) {
+    std::lock_guard<std::recursive_mutex> lifecycle(lifecycle_mutex_);
+    if (!device_ && !simulated_) {
+        std::cerr << "Device not initialized" << std::endl;
+        return false;
+    }
+
+    stopModule();
+
+    auto module = std::make_shared<DepthModule>(config);
+    module->setFrameCallback(frame_callback_);
+    module->setPointCloudCallback(point_cloud_callback_);
+
+    if (!buildAndStartPipeline(module)) {
+        return false;
+    }
+
+    state_ = ModuleState::DEPTH;
+    restart_ = [this, config] { return startDepth(config); };
+    return true;
+}
+
+bool EngineManager::startMultiCamera(const MultiCameraConfig& config) {
+    std::lock_guard<std::recursive_mutex> lifecycle(lifecycle_mutex_);
+    if (!device_ && !simulated_) {
+        std::cerr << "Device not initialized" << std::endl;
+        return false;
+    }
+
+    stopModule();
+
+    MultiCameraConfig resolved = config;
+    if (resolved.sockets.empty()) {
+        resolved.sockets = getConnectedCameras();
+    }
+    if (resolved.sockets.empty()) {
+        std::cerr << "No cameras available for multi-camera capture" << std::endl;
+        return false;
+    }
+
+    auto module = std::make_shared<MultiCameraModule>(resolved);
+    module->setFrameCallback(frame_callback_);
+    module->setFrameSetCallback(frameset_callback_);
+
+    if (!buildAndStartPipeline(module)) {
+        return false;
+    }
+
+    state_ = ModuleState::MULTI_CAMERA;
+    restart_ = [this, config] { return startMultiCamera(config); };
+    return true;
+}
+
+bool EngineManager::fitLinkBudget(ModuleBase& module) {
+    // Snapshots are on demand and not part of the steady-state load
+    LinkCapacity capacity = link_capacity_;
+    if (config_.link_budget.capacity_mbps > 0.0f) {
+        capacity.link += " (configured)";
+        capacity.mbps = config_.link_budget.capacity_mbps;
+        capacity.estimated = false;
+    }
+
+    std::vector<StreamDemand> demands = module.getStreamDemands();
+    if (thumbnails_) {
+        // Thumbnails ride along on the cameras the module opens
+        auto sockets = module.getRequiredSockets();
+        if (sockets.empty()) {
+            sockets.push_back(dai::CameraBoardSocket::CAM_A);
+        }
+        for (auto& demand : thumbnails_->getStreamDemands(sockets)) {
+            demands.push_back(std::move(demand));
+        }
+    }
+
+    LinkPlan plan = planLinkBudget(demands, capacity, config_.link_budget);
+    std::cout << formatLinkPlan(plan) << std::endl;
+    link_plan_ = plan;
+
+    if (!plan.fits) {
+        switch (config_.link_budget.policy) {
+            case LinkBudgetPolicy::REPORT:
+                std::cerr << "Warning: " << module.getName()
+                          << " exceeds the link budget, frames will be dropped or delayed" << std::endl;
+                return true;
+            case LinkBudgetPolicy::REJECT:
+                std::cerr << module.getName() << " rejected: streams exceed the link budget" << std::endl;
+                return false;
+            case LinkBudgetPolicy::DEGRADE:
+                std::cerr << module.getName()
+                          << " rejected: streams exceed the link budget even at their minimum settings" << std::endl;
+                return false;
+        }
+    }
+    module.applyStreamPlan(plan.streams);
     return true;
 }
 
@@ -141,6 +333,32 @@ bool EngineManager::buildAndStartPipeline(std::shared_ptr<ModuleBase> module) {
 
     try {
         std::cout << "[DEBUG] Building pipeline for module: " << module->getName() << std::endl;
+
+        if (simulated_) {
+            // No device pipeline: the module reads host queues fed by the source
+            simulated_source_ = std::make_unique<SimulatedSource>(config_.simulation);
+            module->setTaskPool(task_pool_);
+            if (!module->configureSimulated(*simulated_source_)) {
+                std::cerr << module->getName() << " has no simulated mode" << std::endl;
+                simulated_source_.reset();
+                return false;
+            }
+            if (config_.snapshot.enabled) {
+                snapshot_service_ = std::make_shared<SnapshotService>(config_.snapshot, task_pool_);
+                snapshot_service_->configureSimulated(*simulated_source_);
+            }
+            if (thumbnails_) {
+                thumbnails_->configureSimulated(*simulated_source_);
+            }
+            simulated_source_->start();
+
+            active_module_ = module;
+            pipeline_running_ = true;
+            processing_thread_ = std::thread(&EngineManager::processingLoop, this);
+
+            std::cout << "Module started (simulated): " << module->getName() << std::endl;
+            return true;
+        }
         
         // Check device state
         if (!device_) {
@@ -149,38 +367,80 @@ bool EngineManager::buildAndStartPipeline(std::shared_ptr<ModuleBase> module) {
         }
         std::cout << "[DEBUG] Device pointer is valid" << std::endl;
         
+        TraceSpan buildSpan("buildAndStartPipeline", "engine");
+
+        // Size the module's streams to the link before any output is requested
+        if (!fitLinkBudget(*module)) {
+            return false;
+        }
+
         // Create pipeline with device (V3 API style)
         // Note: Don't access device methods here as device may be in transition state
         std::cout << "[DEBUG] Creating new pipeline with device..." << std::endl;
+        TraceSpan stepSpan("create_pipeline", "engine");
         pipeline_ = std::make_unique<dai::Pipeline>(device_);
+        stepSpan.end();
         std::cout << "[DEBUG] Pipeline created successfully" << std::endl;
 
-        // Create camera node
-        std::cout << "[DEBUG] Creating camera node..." << std::endl;
-        camera_node_ = pipeline_->create<dai::node::Camera>();
-        std::cout << "[DEBUG] Building camera node..." << std::endl;
-        camera_node_->build(dai::CameraBoardSocket::CAM_A);
-        std::cout << "[DEBUG] Camera node built successfully" << std::endl;
+        // Create one camera node per socket the module requested
+        TraceSpan camerasSpan("build_cameras", "engine");
+        auto sockets = module->getRequiredSockets();
+        if (sockets.empty()) {
+            sockets.push_back(dai::CameraBoardSocket::CAM_A);
+        }
+        for (auto socket : sockets) {
+            auto node = pipeline_->create<dai::node::Camera>();
+            node->build(socket);
+            camera_nodes_[socket] = node;
+        }
+        auto primary = camera_nodes_.find(dai::CameraBoardSocket::CAM_A);
+        camera_node_ = primary != camera_nodes_.end() ? primary->second : camera_nodes_.begin()->second;
+        camerasSpan.end();
 
-        // Configure module with pipeline and camera
+        // Configure module with pipeline and cameras
         std::cout << "[DEBUG] Configuring module..." << std::endl;
-        if (!module->configure(*pipeline_, camera_node_)) {
+        module->setTaskPool(task_pool_);
+        TraceSpan configureSpan("configure_module", "engine");
+        if (!module->configureCameras(*pipeline_, camera_nodes_)) {
             std::cerr << "[DEBUG] Failed to configure module" << std::endl;
+            pipeline_.reset();
+            camera_nodes_.clear();
+            camera_node_.reset();
             return false;
         }
+        configureSpan.end();
         std::cout << "[DEBUG] Module configured successfully" << std::endl;
 
-        // Create control queue for camera settings BEFORE starting pipeline
+        // Still branch on the primary camera, alongside the module's outputs
+        if (config_.snapshot.enabled) {
+            snapshot_service_ = std::make_shared<SnapshotService>(config_.snapshot, task_pool_);
+            snapshot_service_->configure(*pipeline_, *camera_node_);
+        }
+        if (thumbnails_) {
+            auto primarySocket = primary != camera_nodes_.end() ? primary->first : camera_nodes_.begin()->first;
+            thumbnails_->configure(*pipeline_, camera_nodes_, primarySocket);
+        }
+
+        // Create control queues for camera settings BEFORE starting pipeline
         // V3 API: createInputQueue must be called before pipeline->start()
-        std::cout << "[DEBUG] Creating control queue..." << std::endl;
-        control_queue_ = camera_node_->inputControl.createInputQueue();
-        std::cout << "[DEBUG] Control queue created successfully" << std::endl;
+        for (const auto& [socket, node] : camera_nodes_) {
+            control_queues_[socket] = node->inputControl.createInputQueue();
+        }
 
         // Start pipeline (V3 API)
         std::cout << "[DEBUG] Starting pipeline..." << std::endl;
+        TraceSpan startSpan("pipeline_start", "engine");
         pipeline_->start();
+        startSpan.end();
         std::cout << "[DEBUG] Pipeline started successfully" << std::endl;
 
+        // Settings made before this pipeline, or before a reconnect, carry over
+        if (camera_settings_set_) {
+            for (const auto& [socket, queue] : control_queues_) {
+                camera_controller_.applySettings(queue, camera_settings_);
+            }
+        }
+
         active_module_ = module;
         pipeline_running_ = true;
 
@@ -192,13 +452,32 @@ bool EngineManager::buildAndStartPipeline(std::shared_ptr<ModuleBase> module) {
 
     } catch (const std::exception& e) {
         std::cerr << "Failed to build pipeline: " << e.what() << std::endl;
+        snapshot_service_.reset();
+        if (thumbnails_) {
+            thumbnails_->detach();
+        }
         pipeline_.reset();
+        control_queues_.clear();
+        camera_nodes_.clear();
         camera_node_.reset();
         return false;
     }
 }
 
 bool EngineManager::stopModule() {
+    // Wakes and cancels a recovery waiting for the device
+    {
+        std::lock_guard<std::mutex> lock(watchdog_mutex_);
+        ++lifecycle_generation_;
+    }
+    watchdog_cv_.notify_all();
+
+    std::lock_guard<std::recursive_mutex> lifecycle(lifecycle_mutex_);
+    restart_ = nullptr;
+    return stopActiveModule(true);
+}
+
+bool EngineManager::stopActiveModule(bool reopen_device) {
     std::cout << "[DEBUG] stopModule() called" << std::endl;
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -219,6 +498,11 @@ bool EngineManager::stopModule() {
         std::cout << "[DEBUG] Processing thread joined" << std::endl;
     }
 
+    // Let per-frame work the module queued finish before it is cleaned up
+    if (task_pool_) {
+        task_pool_->waitIdle();
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
 
     if (active_module_) {
@@ -228,25 +512,36 @@ bool EngineManager::stopModule() {
         std::cout << "[DEBUG] Active module cleaned up" << std::endl;
     }
 
-    stopPipeline();
+    stopPipeline(reopen_device);
     
     state_ = ModuleState::IDLE;
     std::cout << "Module stopped" << std::endl;
     return true;
 }
 
-void EngineManager::stopPipeline() {
+void EngineManager::stopPipeline(bool reopen_device) {
     std::cout << "[DEBUG] stopPipeline() called" << std::endl;
+
+    if (snapshot_service_) {
+        snapshot_service_->cancelAll("pipeline stopped");
+        snapshot_service_.reset();
+    }
+
+    if (thumbnails_) {
+        thumbnails_->detach();
+    }
+
+    if (simulated_source_) {
+        simulated_source_->stop();
+        simulated_source_.reset();
+    }
     
     // Reset queues first
-    std::cout << "[DEBUG] Resetting control queue..." << std::endl;
-    control_queue_.reset();
-    std::cout << "[DEBUG] Control queue reset" << std::endl;
+    control_queues_.clear();
     
-    // Reset camera node
-    std::cout << "[DEBUG] Resetting camera node..." << std::endl;
+    // Reset camera nodes
     camera_node_.reset();
-    std::cout << "[DEBUG] Camera node reset" << std::endl;
+    camera_nodes_.clear();
     
     // Stop and wait for pipeline
     if (pipeline_) {
@@ -269,8 +564,9 @@ void EngineManager::stopPipeline() {
     
     // Close and reopen device to reset state for next pipeline
     // This is necessary because in DepthAI V3, stopping a pipeline leaves the device
-    // in a state that prevents creating a new pipeline with the same device
-    if (device_) {
+    // in a state that prevents creating a new pipeline with the same device.
+    // Skipped during recovery, where the device is gone anyway.
+    if (device_ && reopen_device) {
         std::cout << "[DEBUG] Closing device to reset state..." << std::endl;
         try {
             // Use config device_id (we stored it during initialize)
@@ -281,12 +577,7 @@ void EngineManager::stopPipeline() {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
             
             // Reopen device using the same config
-            if (config_.device_id.empty()) {
-                device_ = std::make_shared<dai::Device>();
-            } else {
-                dai::DeviceInfo info(config_.device_id);
-                device_ = std::make_shared<dai::Device>(info);
-            }
+            device_ = connectDevice();
             std::cout << "[DEBUG] Device reopened successfully" << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "[DEBUG] Error closing/reopening device: " << e.what() << std::endl;
@@ -300,23 +591,39 @@ void EngineManager::stopPipeline() {
 
 void EngineManager::processingLoop() {
     std::cout << "Processing loop started" << std::endl;
+    configureCurrentThread("oak-processing", config_.processing_thread);
+    processing_errors_ = 0;
 
     while (pipeline_running_ && running_) {
         try {
             std::shared_ptr<ModuleBase> module;
+            std::shared_ptr<SnapshotService> snapshots;
+            std::shared_ptr<ThumbnailHistory> thumbnails;
             {
                 std::lock_guard<std::mutex> lock(mutex_);
                 module = active_module_;
+                snapshots = snapshot_service_;
+                thumbnails = thumbnails_;
             }
 
-            if (module && pipeline_ && pipeline_->isRunning()) {
+            if (module && (simulated_source_ || (pipeline_ && pipeline_->isRunning()))) {
+                auto before = AllocationCounter::thisThread();
                 module->process();
+                module->recordAllocations(AllocationCounter::thisThread() - before);
+                processing_errors_ = 0;
+                if (snapshots) {
+                    snapshots->poll();
+                }
+                if (thumbnails) {
+                    thumbnails->poll();
+                }
             } else {
                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
             }
 
         } catch (const std::exception& e) {
             std::cerr << "Error in processing loop: " << e.what() << std::endl;
+            ++processing_errors_;
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
@@ -324,13 +631,291 @@ void EngineManager::processingLoop() {
     std::cout << "Processing loop stopped" << std::endl;
 }
 
+std::shared_ptr<dai::Device> EngineManager::connectDevice() const {
+    if (config_.device_id.empty()) {
+        return std::make_shared<dai::Device>();
+    }
+    dai::DeviceInfo info(config_.device_id);
+    return std::make_shared<dai::Device>(info);
+}
+
+bool EngineManager::watchdogWait(uint32_t ms) {
+    std::unique_lock<std::mutex> lock(watchdog_mutex_);
+    return !watchdog_cv_.wait_for(lock, std::chrono::milliseconds(ms), [this] { return watchdog_stop_; });
+}
+
+bool EngineManager::recoveryWait(uint32_t ms, uint64_t generation) {
+    std::unique_lock<std::mutex> lock(watchdog_mutex_);
+    return !watchdog_cv_.wait_for(lock, std::chrono::milliseconds(ms), [this, generation] {
+        return watchdog_stop_ || lifecycle_generation_ != generation;
+    });
+}
+
+uint64_t EngineManager::lifecycleGeneration() {
+    std::lock_guard<std::mutex> lock(watchdog_mutex_);
+    return lifecycle_generation_;
+}
+
+bool EngineManager::deviceDiscoverable() const {
+    try {
+        for (const auto& info : dai::Device::getAllAvailableDevices()) {
+            if (config_.device_id.empty() || info.getMxId() == config_.device_id || info.name == config_.device_id) {
+                return true;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Device discovery failed: " << e.what() << std::endl;
+    }
+    return false;
+}
+
+void EngineManager::watchdogLoop() {
+    configureCurrentThread("oak-watchdog", ThreadOptions{});
+    std::cout << "Device watchdog started" << std::endl;
+    const WatchdogConfig& watchdog = config_.watchdog;
+
+    // Liveness of the running pipeline: its streams keep delivering messages.
+    // Processing errors alone (a throwing callback) are not a loss while data flows.
+    const ModuleBase* watched = nullptr;
+    uint64_t messages = 0;
+    uint64_t previous_messages = 0;
+    auto last_alive = std::chrono::steady_clock::now();
+
+    while (watchdogWait(watchdog.check_interval_ms)) {
+        std::shared_ptr<ModuleBase> module;
+        std::shared_ptr<dai::Device> device;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            module = active_module_;
+            device = device_;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!module || !pipeline_running_) {
+            watched = nullptr;
+            continue;
+        }
+        if (module.get() != watched) {
+            // A new pipeline gets a full timeout to deliver its first message
+            watched = module.get();
+            messages = previous_messages = streamMessages(*module);
+            last_alive = now;
+            continue;
+        }
+
+        previous_messages = messages;
+        messages = streamMessages(*module);
+        if (messages != previous_messages) {
+            last_alive = now;
+        }
+
+        std::string reason;
+        uint32_t errors = processing_errors_;
+        if (!device || device->isClosed()) {
+            reason = "device closed";
+        } else if (errors >= watchdog.error_threshold && messages == previous_messages) {
+            reason = std::to_string(errors) + " consecutive processing errors";
+        } else if (watchdog.heartbeat_timeout_ms > 0 &&
+                   elapsedMs(last_alive, now) > watchdog.heartbeat_timeout_ms) {
+            reason = "no data for " + std::to_string(static_cast<int>(elapsedMs(last_alive, now))) + " ms";
+        }
+        if (reason.empty()) {
+            continue;
+        }
+
+        recoverDevice(reason, last_alive);
+        watched = nullptr;
+    }
+
+    std::cout << "Device watchdog stopped" << std::endl;
+}
+
+void EngineManager::recoverDevice(const std::string& reason, std::chrono::steady_clock::time_point last_alive) {
+    using Clock = std::chrono::steady_clock;
+    const WatchdogConfig& watchdog = config_.watchdog;
+
+    // The lifecycle lock is held for the teardown and for each connect and
+    // restart, not while waiting for the device, so stopModule() and the
+    // startX() calls stay responsive; stopModule() cancels the recovery
+    std::unique_lock<std::recursive_mutex> lifecycle(lifecycle_mutex_);
+    {
+        // Stopped by the user while we were deciding
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_module_ || !restart_) {
+            return;
+        }
+    }
+    std::function<bool()> restart = restart_;
+    uint64_t generation = lifecycleGeneration();
+
+    auto detected = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        ++recovery_stats_.losses;
+        recovery_stats_.recovering = true;
+        recovery_stats_.last_reason = reason;
+        recovery_stats_.last_detect_ms = elapsedMs(last_alive, detected);
+    }
+    std::cerr << "Device lost (" << reason << "), recovering " << getActiveModuleName() << std::endl;
+
+    // Release the old pipeline and the dead handle; the usual close/reopen
+    // of stopModule() would only wait on a device that is not there
+    stopActiveModule(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (device_) {
+            try {
+                device_->close();
+            } catch (const std::exception& e) {
+                std::cerr << "Error closing lost device: " << e.what() << std::endl;
+            }
+            device_.reset();
+        }
+    }
+    lifecycle.unlock();
+    auto released = Clock::now();
+
+    // Discovery is cheap, so poll it at the check interval until the device
+    // is back (USB re-enumeration, PoE reboot) and connect at once; only
+    // failed connects or restarts back off. recovery_timeout_ms bounds the
+    // whole wait, max_attempts the failed connects.
+    auto connected = released;
+    uint32_t backoff = watchdog.initial_backoff_ms;
+    uint32_t failures = 0;
+    bool restored = false;
+    bool cancelled = false;
+    while (!restored) {
+        if (watchdog.recovery_timeout_ms > 0 && elapsedMs(released, Clock::now()) >= watchdog.recovery_timeout_ms) {
+            std::cerr << "Device not back within " << watchdog.recovery_timeout_ms << " ms" << std::endl;
+            break;
+        }
+        if (!deviceDiscoverable()) {
+            if (!recoveryWait(watchdog.check_interval_ms, generation)) {
+                cancelled = lifecycleGeneration() != generation;
+                break;
+            }
+            continue;
+        }
+
+        lifecycle.lock();
+        // stopModule() ran while we were waiting: the module is not wanted back
+        if (lifecycleGeneration() != generation) {
+            cancelled = true;
+            break;
+        }
+        try {
+            auto device = connectDevice();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                device_ = device;
+                link_capacity_ = estimateLinkCapacity(*device_, config_.use_poe);
+            }
+            connected = Clock::now();
+            std::cout << "Reconnected to " << device->getMxId() << " in "
+                      << static_cast<int>(elapsedMs(released, connected)) << " ms" << std::endl;
+
+            // Same module, same config; buildAndStartPipeline() reapplies the camera settings
+            restored = restart();
+            if (!restored) {
+                throw std::runtime_error("module restart failed");
+            }
+        } catch (const std::exception& e) {
+            ++failures;
+            {
+                std::lock_guard<std::mutex> lock(recovery_mutex_);
+                ++recovery_stats_.failed_attempts;
+            }
+            std::cerr << "Reconnect attempt " << failures << " failed: " << e.what() << std::endl;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (device_) {
+                    try {
+                        device_->close();
+                    } catch (const std::exception&) {
+                    }
+                    device_.reset();
+                }
+            }
+            // A failed restart went through stopModule(): still ours to retry
+            restart_ = restart;
+            generation = lifecycleGeneration();
+        }
+        lifecycle.unlock();
+        if (restored) {
+            break;
+        }
+
+        if (watchdog.max_attempts > 0 && failures >= watchdog.max_attempts) {
+            break;
+        }
+        if (!recoveryWait(backoff, generation)) {
+            cancelled = lifecycleGeneration() != generation;
+            break;
+        }
+        backoff = std::min(watchdog.max_backoff_ms,
+                           static_cast<uint32_t>(backoff * std::max(1.0f, watchdog.backoff_multiplier)));
+    }
+    if (lifecycle.owns_lock()) {
+        lifecycle.unlock();
+    }
+
+    if (cancelled) {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        ++recovery_stats_.cancelled;
+        recovery_stats_.recovering = false;
+        std::cout << "Device recovery cancelled, the module was stopped" << std::endl;
+        return;
+    }
+    if (!restored) {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        recovery_stats_.recovering = false;
+        std::cerr << "Device not recovered after " << failures << " failed attempts" << std::endl;
+        return;
+    }
+    auto restarted = Clock::now();
+
+    // Recovered means streaming again: wait for the first message
+    std::shared_ptr<ModuleBase> module;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        module = active_module_;
+    }
+    uint32_t first_data_timeout = watchdog.heartbeat_timeout_ms > 0 ? watchdog.heartbeat_timeout_ms : 5000;
+    while (module && streamMessages(*module) == 0 &&
+           elapsedMs(restarted, Clock::now()) < first_data_timeout) {
+        if (!watchdogWait(5)) {
+            break;
+        }
+    }
+    auto streaming = Clock::now();
+
+    std::lock_guard<std::mutex> lock(recovery_mutex_);
+    RecoveryStats& stats = recovery_stats_;
+    ++stats.recoveries;
+    stats.recovering = false;
+    stats.last_teardown_ms = elapsedMs(detected, released);
+    stats.last_reconnect_ms = elapsedMs(released, connected);
+    stats.last_restart_ms = elapsedMs(connected, restarted);
+    stats.last_first_data_ms = elapsedMs(restarted, streaming);
+    stats.last_total_ms = elapsedMs(detected, streaming);
+    stats.mean_total_ms += (stats.last_total_ms - stats.mean_total_ms) / stats.recoveries;
+    stats.max_total_ms = std::max(stats.max_total_ms, stats.last_total_ms);
+    std::cout << "Device recovered in " << static_cast<int>(stats.last_total_ms) << " ms (teardown "
+              << static_cast<int>(stats.last_teardown_ms) << ", reconnect " << static_cast<int>(stats.last_reconnect_ms)
+              << ", restart " << static_cast<int>(stats.last_restart_ms) << ", first data "
+              << static_cast<int>(stats.last_first_data_ms) << ")" << std::endl;
+}
+
 bool EngineManager::updateCameraSettings(const CameraSettings& settings) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     camera_settings_ = settings;
+    camera_settings_set_ = true;
 
-    if (control_queue_) {
-        camera_controller_.applySettings(control_queue_, settings);
+    if (!control_queues_.empty()) {
+        for (const auto& [socket, queue] : control_queues_) {
+            camera_controller_.applySettings(queue, settings);
+        }
         return true;
     }
 
@@ -351,12 +936,184 @@ std::string EngineManager::getActiveModuleName() const {
     return "NONE";
 }
 
+std::vector<QueueStats> EngineManager::getQueueStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_module_) {
+        return active_module_->getQueueStats();
+    }
+    return {};
+}
+
+std::optional<SyncStats> EngineManager::getSyncStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto multi = std::dynamic_pointer_cast<MultiCameraModule>(active_module_)) {
+        return multi->getSyncStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<MotionGateStats> EngineManager::getMotionGateStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto inference = std::dynamic_pointer_cast<InferenceModule>(active_module_)) {
+        return inference->getMotionGateStats();
+    }
+    return std::nullopt;
+}
+
+std::future<Snapshot> EngineManager::captureSnapshot() {
+    std::shared_ptr<SnapshotService> service;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        service = snapshot_service_;
+    }
+    if (!service) {
+        std::promise<Snapshot> unavailable;
+        unavailable.set_exception(std::make_exception_ptr(std::runtime_error(
+            config_.snapshot.enabled ? "no pipeline running" : "snapshots are disabled")));
+        return unavailable.get_future();
+    }
+    return service->request();
+}
+
+std::optional<SnapshotStats> EngineManager::getSnapshotStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (snapshot_service_) {
+        return snapshot_service_->getStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<Thumbnail> EngineManager::getThumbnail(std::chrono::steady_clock::time_point time,
+                                                    const std::string& stream) const {
+    std::shared_ptr<ThumbnailHistory> thumbnails;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        thumbnails = thumbnails_;
+    }
+    if (!thumbnails) {
+        return std::nullopt;
+    }
+    return thumbnails->nearest(time, stream);
+}
+
+std::optional<ThumbnailStats> EngineManager::getThumbnailStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thumbnails_) {
+        return thumbnails_->getStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<LinkPlan> EngineManager::getLinkPlan() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return link_plan_;
+}
+
+std::optional<TileMergeStats> EngineManager::getTileMergeStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto inference = std::dynamic_pointer_cast<InferenceModule>(active_module_)) {
+        return inference->getTileMergeStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<CropStats> EngineManager::getCropStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto inference = std::dynamic_pointer_cast<InferenceModule>(active_module_)) {
+        return inference->getCropStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<CascadeStats> EngineManager::getCascadeStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto inference = std::dynamic_pointer_cast<InferenceModule>(active_module_)) {
+        return inference->getCascadeStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<AnalyticsStats> EngineManager::getAnalyticsStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (analytics_) {
+        return analytics_->getStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<AnalyticsCounts> EngineManager::getAnalyticsCounts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (analytics_) {
+        return analytics_->getCounts();
+    }
+    return std::nullopt;
+}
+
+cv::Mat EngineManager::getAnalyticsHeatmap() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (analytics_) {
+        return analytics_->getHeatmap();
+    }
+    return {};
+}
+
+std::optional<DetectionBatchStats> EngineManager::getDetectionBatchStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (detection_batcher_) {
+        return detection_batcher_->getStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<AllocationStats> EngineManager::getAllocationStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_module_) {
+        return active_module_->getAllocationStats();
+    }
+    return std::nullopt;
+}
+
+std::optional<RecoveryStats> EngineManager::getRecoveryStats() const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (simulated_ || !config_.watchdog.enabled) {
+            return std::nullopt;
+        }
+    }
+    std::lock_guard<std::mutex> lock(recovery_mutex_);
+    return recovery_stats_;
+}
+
+std::optional<TaskPoolStats> EngineManager::getTaskPoolStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (task_pool_) {
+        return task_pool_->getStats();
+    }
+    return std::nullopt;
+}
+
+void EngineManager::setTracingEnabled(bool enabled) {
+    if (enabled) {
+        Tracer::enable(config_.trace_events_per_thread);
+    } else {
+        Tracer::disable();
+    }
+}
+
+bool EngineManager::writeTrace(const std::string& path) const {
+    uint64_t dropped = Tracer::droppedEvents();
+    if (dropped > 0) {
+        std::cout << "Trace buffers overflowed, " << dropped << " spans dropped" << std::endl;
+    }
+    return Tracer::writeChromeTrace(path);
+}
+
 std::string EngineManager::getDeviceId() const {
     std::lock_guard<std::mutex> lock(mutex_);
     if (device_) {
         return device_->getMxId();
     }
-    return "";
+    return simulated_ ? "simulated" : "";
 }
 
 std::string EngineManager::getDeviceName() const {
@@ -364,12 +1121,12 @@ std::string EngineManager::getDeviceName() const {
     if (device_) {
         return device_->getDeviceName();
     }
-    return "";
+    return simulated_ ? "Simulated device" : "";
 }
 
 bool EngineManager::isDeviceConnected() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return device_ != nullptr;
+    return device_ != nullptr || simulated_;
 }
 
 std::vector<dai::CameraBoardSocket> EngineManager::getConnectedCameras() const {
@@ -392,7 +1149,125 @@ void EngineManager::setDetectionCallback(DetectionCallback callback) {
     std::lock_guard<std::mutex> lock(mutex_);
     detection_callback_ = callback;
     if (active_module_) {
-        active_module_->setDetectionCallback(callback);
+        active_module_->setDetectionCallback(moduleDetectionCallback());
+    }
+}
+
+void EngineManager::setDetectionBatchCallback(DetectionBatchCallback callback,
+                                              const DetectionBatchConfig& config) {
+    std::shared_ptr<DetectionBatcher> previous;
+    std::shared_ptr<ModuleBase> module;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = std::move(detection_batcher_);
+        if (callback) {
+            detection_batcher_ = std::make_shared<DetectionBatcher>(config, config_.delivery_thread);
+            detection_batcher_->start(callback);
+        }
+        module = active_module_;
+        if (module) {
+            module->setDetectionCallback(moduleDetectionCallback());
+        }
+    }
+
+    // Outside the lock, since the callbacks and the consumer may call back
+    // into the engine: let the callbacks queued with the old batcher push
+    // into it, then flush it. (A process() call that loaded the old callback
+    // just before the swap may still submit one; its push after stop() is
+    // dropped, and the task keeps the batcher alive.)
+    if (module) {
+        module->drainDetectionCallbacks();
+    }
+    if (previous) {
+        previous->stop();
+    }
+}
+
+DetectionCallback EngineManager::moduleDetectionCallback() const {
+    if (!detection_batcher_ && !analytics_) {
+        return detection_callback_;
+    }
+
+    // The batcher only queues the message, so the processing thread never waits on the consumer;
+    // analytics cost microseconds per message and run inline
+    auto callback = detection_callback_;
+    auto batcher = detection_batcher_;
+    auto analytics = analytics_;
+    auto analytics_callback = analytics_callback_;
+    return [callback, batcher, analytics, analytics_callback](std::shared_ptr<dai::ImgDetections> detections) {
+        if (callback) {
+            callback(detections);
+        }
+        if (analytics && detections) {
+            thread_local std::vector<AnalyticsEvent> events;
+            events.clear();
+            analytics->update(*detections, events);
+            if (!events.empty() && analytics_callback) {
+                analytics_callback(events);
+            }
+        }
+        if (batcher) {
+            batcher->push(std::move(detections));
+        }
+    };
+}
+
+void EngineManager::setAnalyticsCallback(AnalyticsCallback callback, const AnalyticsConfig& config) {
+    // The module's wrapper holds its own copies of the analytics and callback;
+    // queued detections finish with the old ones
+    std::shared_ptr<ZoneAnalytics> previous;
+    std::shared_ptr<ModuleBase> module;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = std::move(analytics_);
+        analytics_callback_ = callback;
+        if (callback || !config.zones.empty() || !config.tripwires.empty()) {
+            analytics_ = std::make_shared<ZoneAnalytics>(config);
+        }
+        module = active_module_;
+        if (module) {
+            module->setDetectionCallback(moduleDetectionCallback());
+        }
+    }
+
+    // Outside the lock, since the old callback may call into the engine: the
+    // detections queued before the swap are analysed before this returns,
+    // and the previous analytics are normally released here, not on a pool thread
+    if (module) {
+        module->drainDetectionCallbacks();
+    }
+    previous.reset();
+}
+
+void EngineManager::setPointCloudCallback(PointCloudCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    point_cloud_callback_ = callback;
+    if (auto depth = std::dynamic_pointer_cast<DepthModule>(active_module_)) {
+        depth->setPointCloudCallback(callback);
+    }
+}
+
+void EngineManager::setCropCallback(CropCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    crop_callback_ = callback;
+    if (auto inference = std::dynamic_pointer_cast<InferenceModule>(active_module_)) {
+        inference->setCropCallback(callback);
+    }
+}
+
+void EngineManager::setCascadeCallback(CascadeCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cascade_callback_ = callback;
+    if (auto inference = std::dynamic_pointer_cast<InferenceModule>(active_module_)) {
+        inference->setCascadeCallback(callback);
+    }
+}
+
+void EngineManager::setFrameSetCallback(FrameSetCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frameset_callback_ = callback;
+    if (auto multi = std::dynamic_pointer_cast<MultiCameraModule>(active_module_)) {
+        multi->setFrameSetCallback(callback);
     }
 }
 
@@ -5,14 +5,47 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <optional>
+#include <future>
+#include <chrono>
+#include <functional>
 #include <depthai/depthai.hpp>
 
 #include "Types.h"
 #include "ModuleBase.h"
 #include "CameraController.h"
+#include "DetectionBatcher.h"
+#include "SimulatedSource.h"
+#include "SnapshotService.h"
+#include "ThumbnailHistory.h"
+#include "LinkBudget.h"
+#include "../processing/MotionGate.h"
+#include "../processing/TileMerger.h"
+#include "../processing/CropExtractor.h"
+#include "../processing/CascadeClassifier.h"
+#include "../processing/ZoneAnalytics.h"
 
 namespace oak {
 
+// Device losses and how long the engine took to get back to streaming
+// (see WatchdogConfig)
+struct RecoveryStats {
+    uint64_t losses = 0;                 // Device losses detected
+    uint64_t recoveries = 0;             // Device reconnected and the module restored
+    uint64_t failed_attempts = 0;        // Connect attempts that threw
+    uint64_t cancelled = 0;              // Recoveries ended by stopModule() or a module start
+    bool recovering = false;             // A recovery is in progress right now
+    std::string last_reason;             // What detected the last loss
+    double last_detect_ms = 0.0;         // Last sign of life -> loss detected
+    double last_teardown_ms = 0.0;       // Loss detected -> old pipeline released
+    double last_reconnect_ms = 0.0;      // Released -> device connected
+    double last_restart_ms = 0.0;        // Connected -> module restarted
+    double last_first_data_ms = 0.0;     // Restarted -> first message from the device
+    double last_total_ms = 0.0;          // Loss detected -> first message
+    double mean_total_ms = 0.0;
+    double max_total_ms = 0.0;
+};
+
 class EngineManager {
 public:
     static EngineManager& getInstance();
@@ -28,8 +61,24 @@ public:
     bool startPreview(const OutputConfig& config = OutputConfig{});
     bool startRecording(const RecordConfig& config);
     bool startInference(const InferenceConfig& config);
+    bool startDepth(const DepthConfig& config = DepthConfig{});
+    bool startMultiCamera(const MultiCameraConfig& config = MultiCameraConfig{});
     bool stopModule();
 
+    // Full-resolution still from the running pipeline's primary camera, JPEG
+    // encoded (see SnapshotService.h). Fails through the future when no
+    // pipeline is running or EngineConfig::snapshot is disabled.
+    std::future<Snapshot> captureSnapshot();
+    std::optional<SnapshotStats> getSnapshotStats() const;
+
+    // Thumbnail captured closest to `time` (device capture time on the host
+    // clock, e.g. now - 10 s), see ThumbnailHistory.h. stream empty = the
+    // primary camera. nullopt when EngineConfig::thumbnails is disabled or
+    // nothing was captured on that stream.
+    std::optional<Thumbnail> getThumbnail(std::chrono::steady_clock::time_point time,
+                                          const std::string& stream = "") const;
+    std::optional<ThumbnailStats> getThumbnailStats() const;
+
     // Camera settings
     bool updateCameraSettings(const CameraSettings& settings);
     CameraSettings getCameraSettings() const;
@@ -38,6 +87,29 @@ public:
     ModuleState getState() const { return state_.load(); }
     std::string getActiveModuleName() const;
     bool isRunning() const { return running_.load(); }
+    std::vector<QueueStats> getQueueStats() const;
+    std::optional<SyncStats> getSyncStats() const;
+    std::optional<DetectionBatchStats> getDetectionBatchStats() const;
+    std::optional<TaskPoolStats> getTaskPoolStats() const;
+    std::optional<MotionGateStats> getMotionGateStats() const;
+    std::optional<TileMergeStats> getTileMergeStats() const;
+    std::optional<CropStats> getCropStats() const;
+    std::optional<CascadeStats> getCascadeStats() const;
+    // Zone and tripwire analytics (see setAnalyticsCallback)
+    std::optional<AnalyticsStats> getAnalyticsStats() const;
+    std::optional<AnalyticsCounts> getAnalyticsCounts() const;
+    cv::Mat getAnalyticsHeatmap() const;
+    // Link budget of the last pipeline started on a device (see LinkBudget.h)
+    std::optional<LinkPlan> getLinkPlan() const;
+    // Processing-thread allocations of the active module (see AllocationCounter.h)
+    std::optional<AllocationStats> getAllocationStats() const;
+    // Device losses and reconnects; nullopt when simulated or the watchdog is disabled
+    std::optional<RecoveryStats> getRecoveryStats() const;
+
+    // Tracing (Chrome/Perfetto JSON export)
+    void setTracingEnabled(bool enabled);
+    bool isTracingEnabled() const { return Tracer::enabled(); }
+    bool writeTrace(const std::string& path) const;
 
     // Device info
     std::string getDeviceId() const;
@@ -48,6 +120,24 @@ public:
     // Callbacks
     void setFrameCallback(FrameCallback callback);
     void setDetectionCallback(DetectionCallback callback);
+    void setPointCloudCallback(PointCloudCallback callback);
+    void setFrameSetCallback(FrameSetCallback callback);
+    // Per-detection crops of the inference module (InferenceConfig::crops)
+    void setCropCallback(CropCallback callback);
+    // Detections merged with the second network's per-object results (InferenceConfig::cascade)
+    void setCascadeCallback(CascadeCallback callback);
+
+    // Batched detection delivery on a separate worker thread; runs alongside
+    // the per-message DetectionCallback. Pass nullptr to disable.
+    void setDetectionBatchCallback(DetectionBatchCallback callback,
+                                   const DetectionBatchConfig& config = DetectionBatchConfig{});
+
+    // Zone occupancy, line crossings and heatmap over every detection
+    // message of the active module, evaluated inline (see ZoneAnalytics.h).
+    // The callback gets each message's events, only when there are any.
+    // Replaces the previous analytics and their counts; nullptr with no
+    // zones or tripwires disables them.
+    void setAnalyticsCallback(AnalyticsCallback callback, const AnalyticsConfig& config);
 
 private:
     EngineManager() = default;
@@ -55,21 +145,52 @@ private:
 
     // Internal pipeline management
     bool buildAndStartPipeline(std::shared_ptr<ModuleBase> module);
-    void stopPipeline();
+    bool fitLinkBudget(ModuleBase& module);
+    bool stopActiveModule(bool reopen_device);
+    void stopPipeline(bool reopen_device);
     void processingLoop();
+    std::shared_ptr<dai::Device> connectDevice() const;
+
+    // Device-loss watchdog
+    void watchdogLoop();
+    bool deviceDiscoverable() const;
+    bool watchdogWait(uint32_t ms);
+    // Like watchdogWait(), and false once stopModule() has run since `generation`
+    bool recoveryWait(uint32_t ms, uint64_t generation);
+    uint64_t lifecycleGeneration();
+    void recoverDevice(const std::string& reason, std::chrono::steady_clock::time_point last_alive);
+    DetectionCallback moduleDetectionCallback() const;
 
     // Device and pipeline (V3 style - pipeline takes device in constructor)
     std::shared_ptr<dai::Device> device_;
     std::unique_ptr<dai::Pipeline> pipeline_;
+
+    // Replaces device and pipeline when EngineConfig::simulation is enabled
+    bool simulated_ = false;
+    std::unique_ptr<SimulatedSource> simulated_source_;
     
-    // Camera node shared across modules
+    // Camera nodes for the sockets the active module requested;
+    // camera_node_ is the primary one (CAM_A when present)
+    CameraNodes camera_nodes_;
     std::shared_ptr<dai::node::Camera> camera_node_;
     
-    // Control queue for camera settings (V3 uses InputQueue for input queues)
-    std::shared_ptr<dai::InputQueue> control_queue_;
+    // Control queues for camera settings, one per camera node (V3 uses InputQueue for input queues)
+    std::map<dai::CameraBoardSocket, std::shared_ptr<dai::InputQueue>> control_queues_;
     
     // Camera controller
     CameraController camera_controller_;
+
+    // Device link, measured on connect, and the plan of the last pipeline
+    LinkCapacity link_capacity_;
+    std::optional<LinkPlan> link_plan_;
+
+    // Stills from the running pipeline; rebuilt with every pipeline
+    std::shared_ptr<SnapshotService> snapshot_service_;
+    // Lookback history; created with the engine, attached to every pipeline
+    std::shared_ptr<ThumbnailHistory> thumbnails_;
+
+    // Host worker pool shared by all modules (per-frame post-processing)
+    std::shared_ptr<TaskPool> task_pool_;
     
     // Active module
     std::shared_ptr<ModuleBase> active_module_;
@@ -78,7 +199,11 @@ private:
     std::atomic<ModuleState> state_{ModuleState::IDLE};
     EngineConfig config_;
     CameraSettings camera_settings_;
+    bool camera_settings_set_ = false;   // updateCameraSettings() was called; reapplied on every start
     OutputConfig current_output_config_;
+    // Starts the active module again with the config it was started with;
+    // set by every startX(), cleared by stopModule() (guarded by lifecycle_mutex_)
+    std::function<bool()> restart_;
 
     // Threading
     std::atomic<bool> running_{false};
@@ -86,10 +211,29 @@ private:
     std::thread processing_thread_;
     mutable std::mutex mutex_;
     std::condition_variable cv_;
+    // Serializes module start/stop with device recovery
+    std::recursive_mutex lifecycle_mutex_;
+
+    // Watchdog
+    std::thread watchdog_thread_;
+    std::mutex watchdog_mutex_;
+    std::condition_variable watchdog_cv_;
+    bool watchdog_stop_ = false;
+    uint64_t lifecycle_generation_ = 0;  // Bumped by stopModule(), cancels a recovery (guarded by watchdog_mutex_)
+    std::atomic<uint32_t> processing_errors_{0};  // Consecutive, reset by a clean iteration
+    mutable std::mutex recovery_mutex_;
+    RecoveryStats recovery_stats_;
 
     // Callbacks
     FrameCallback frame_callback_;
     DetectionCallback detection_callback_;
+    PointCloudCallback point_cloud_callback_;
+    FrameSetCallback frameset_callback_;
+    CropCallback crop_callback_;
+    CascadeCallback cascade_callback_;
+    std::shared_ptr<DetectionBatcher> detection_batcher_;
+    std::shared_ptr<ZoneAnalytics> analytics_;
+    AnalyticsCallback analytics_callback_;
 };
 
 } // namespace oak
@@ -0,0 +1,122 @@
+#include "FrameSynchronizer.h"
+#include <algorithm>
+
+namespace oak {
+
+FrameSynchronizer::FrameSynchronizer(std::vector<dai::CameraBoardSocket> sockets,
+                                     std::chrono::microseconds tolerance,
+                                     size_t buffer_size)
+    : sockets_(std::move(sockets)), tolerance_(tolerance), overflow_(sockets_.size()) {
+    for (size_t i = 0; i < sockets_.size(); ++i) {
+        buffers_.push_back(std::make_unique<SpscRing<std::shared_ptr<dai::ImgFrame>>>(buffer_size));
+    }
+
+    scratch_.sockets.reserve(sockets_.size());
+    scratch_.frames.reserve(sockets_.size());
+
+    stats_.sockets = sockets_;
+    stats_.misses_per_socket.assign(sockets_.size(), 0);
+}
+
+std::chrono::microseconds FrameSynchronizer::deviceTime(const dai::ImgFrame& frame) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        frame.getTimestampDevice().time_since_epoch());
+}
+
+bool FrameSynchronizer::push(size_t stream_index, std::shared_ptr<dai::ImgFrame> frame) {
+    if (stream_index >= buffers_.size() || !frame) {
+        return false;
+    }
+    if (!buffers_[stream_index]->tryPush(std::move(frame))) {
+        overflow_[stream_index].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+size_t FrameSynchronizer::poll(const FrameSetCallback& callback) {
+    const size_t n = buffers_.size();
+    size_t emitted = 0;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    while (true) {
+        // Every stream needs a candidate before anything can be decided
+        auto newest = std::chrono::microseconds::min();
+        bool complete = true;
+        for (size_t i = 0; i < n; ++i) {
+            auto* head = buffers_[i]->front();
+            if (!head) {
+                complete = false;
+                break;
+            }
+            newest = std::max(newest, deviceTime(**head));
+        }
+        if (!complete) {
+            break;
+        }
+
+        // Heads too old to pair with the newest head can never be matched
+        bool dropped = false;
+        for (size_t i = 0; i < n; ++i) {
+            auto* head = buffers_[i]->front();
+            while (head && deviceTime(**head) < newest - tolerance_) {
+                buffers_[i]->pop();
+                dropped = true;
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                ++stats_.sync_misses;
+                ++stats_.misses_per_socket[i];
+                head = buffers_[i]->front();
+            }
+        }
+        if (dropped) {
+            continue;
+        }
+
+        // All heads lie within tolerance of each other: emit one frameset
+        scratch_.sockets.clear();
+        scratch_.frames.clear();
+        auto oldest = newest;
+        for (size_t i = 0; i < n; ++i) {
+            std::shared_ptr<dai::ImgFrame> frame;
+            buffers_[i]->tryPop(frame);
+            oldest = std::min(oldest, deviceTime(*frame));
+            scratch_.sockets.push_back(sockets_[i]);
+            scratch_.frames.push_back(std::move(frame));
+        }
+        scratch_.timestamp = newest;
+        scratch_.skew = newest - oldest;
+
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            int64_t skew = scratch_.skew.count();
+            ++stats_.framesets;
+            stats_.last_skew_us = skew;
+            stats_.max_skew_us = std::max(stats_.max_skew_us, skew);
+            stats_.mean_skew_us += (static_cast<double>(skew) - stats_.mean_skew_us) /
+                                   static_cast<double>(stats_.framesets);
+        }
+
+        if (callback) {
+            callback(scratch_);
+        }
+        scratch_.frames.clear();  // Release frames, keep capacity
+        ++emitted;
+    }
+
+    return emitted;
+}
+
+SyncStats FrameSynchronizer::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    SyncStats stats = stats_;
+    stats.overflow_drops = 0;
+    for (const auto& count : overflow_) {
+        stats.overflow_drops += count.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+} // namespace oak
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <depthai/depthai.hpp>
+#include "SpscRing.h"
+
+namespace oak {
+
+// Frames from several sockets that belong to the same capture instant
+struct FrameSet {
+    std::chrono::microseconds timestamp{0};   // Device timestamp of the newest member
+    std::chrono::microseconds skew{0};        // Newest minus oldest member timestamp
+    std::vector<dai::CameraBoardSocket> sockets;
+    std::vector<std::shared_ptr<dai::ImgFrame>> frames;  // Parallel to sockets
+};
+
+using FrameSetCallback = std::function<void(const FrameSet&)>;
+
+struct SyncStats {
+    uint64_t framesets = 0;
+    uint64_t sync_misses = 0;         // Frames discarded without a partner
+    uint64_t overflow_drops = 0;      // Frames rejected because a buffer was full
+    int64_t last_skew_us = 0;
+    int64_t max_skew_us = 0;
+    double mean_skew_us = 0.0;
+    std::vector<dai::CameraBoardSocket> sockets;
+    std::vector<uint64_t> misses_per_socket;  // Parallel to sockets
+};
+
+// Groups frames from different sockets into framesets by device timestamp.
+// Each socket has its own bounded lock-free SPSC buffer, so push() for a
+// socket may run on a different thread than poll() as long as each socket
+// has a single producer.
+class FrameSynchronizer {
+public:
+    FrameSynchronizer(std::vector<dai::CameraBoardSocket> sockets,
+                      std::chrono::microseconds tolerance,
+                      size_t buffer_size = 16);
+
+    // Producer side. Returns false (and counts an overflow) when the buffer is full.
+    bool push(size_t stream_index, std::shared_ptr<dai::ImgFrame> frame);
+
+    // Consumer side. Emits every complete frameset currently buffered and
+    // returns how many were emitted.
+    size_t poll(const FrameSetCallback& callback);
+
+    size_t streamCount() const { return sockets_.size(); }
+    const std::vector<dai::CameraBoardSocket>& getSockets() const { return sockets_; }
+    SyncStats getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static std::chrono::microseconds deviceTime(const dai::ImgFrame& frame);
+
+    std::vector<dai::CameraBoardSocket> sockets_;
+    std::chrono::microseconds tolerance_;
+    std::vector<std::unique_ptr<SpscRing<std::shared_ptr<dai::ImgFrame>>>> buffers_;
+    std::vector<std::atomic<uint64_t>> overflow_;
+
+    FrameSet scratch_;  // Reused for every emitted frameset
+
+    mutable std::mutex stats_mutex_;
+    SyncStats stats_;
+};
+
+} // namespace oak
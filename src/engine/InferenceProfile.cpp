@@ -0,0 +1,192 @@
+#include "InferenceProfile.h"
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <system_error>
+#include <unordered_map>
+
+namespace oak {
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+struct CachedHash {
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type modified;
+    uint64_t hash = 0;
+};
+
+std::mutex g_hash_mutex;
+std::unordered_map<std::string, CachedHash> g_hash_cache;  // By absolute path
+
+std::optional<uint64_t> hashFileContents(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::nullopt;
+    }
+    uint64_t hash = kFnvOffset;
+    std::vector<char> buffer(1 << 16);
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize count = in.gcount();
+        for (std::streamsize i = 0; i < count; ++i) {
+            hash ^= static_cast<uint8_t>(buffer[static_cast<size_t>(i)]);
+            hash *= kFnvPrime;
+        }
+    }
+    if (in.bad()) {
+        return std::nullopt;
+    }
+    return hash;
+}
+
+std::string hashToString(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+} // namespace
+
+std::optional<uint64_t> hashModelFile(const std::string& path) {
+    std::error_code error;
+    std::string key = std::filesystem::absolute(path, error).string();
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+    auto modified = error ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(path, error);
+    if (error) {
+        return hashFileContents(path);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_hash_mutex);
+        auto it = g_hash_cache.find(key);
+        if (it != g_hash_cache.end() && it->second.size == size && it->second.modified == modified) {
+            return it->second.hash;
+        }
+    }
+    auto hash = hashFileContents(path);
+    if (hash) {
+        std::lock_guard<std::mutex> lock(g_hash_mutex);
+        g_hash_cache[key] = CachedHash{size, modified, *hash};
+    }
+    return hash;
+}
+
+std::string inferenceProfilePath(const std::string& directory, uint64_t model_hash) {
+    return (std::filesystem::path(directory) / (hashToString(model_hash) + ".profile")).string();
+}
+
+std::optional<InferenceProfile> loadInferenceProfile(const std::string& directory, uint64_t model_hash) {
+    std::ifstream in(inferenceProfilePath(directory, model_hash));
+    if (!in) {
+        return std::nullopt;
+    }
+
+    InferenceProfile profile;
+    profile.model_hash = model_hash;
+    std::string line;
+    try {
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            auto eq = line.find('=');
+            if (eq == std::string::npos) {
+                continue;
+            }
+            std::string key = line.substr(0, eq);
+            std::string value = line.substr(eq + 1);
+            if (key == "model_path") profile.model_path = value;
+            else if (key == "input_width") profile.input_width = static_cast<uint32_t>(std::stoul(value));
+            else if (key == "input_height") profile.input_height = static_cast<uint32_t>(std::stoul(value));
+            else if (key == "inference_threads") profile.tuning.inference_threads = std::stoi(value);
+            else if (key == "nce_per_thread") profile.tuning.nce_per_thread = std::stoi(value);
+            else if (key == "shaves_per_thread") profile.tuning.shaves_per_thread = std::stoi(value);
+            else if (key == "pool_frames") profile.tuning.pool_frames = std::stoi(value);
+            else if (key == "input_queue_size") profile.tuning.input_queue_size = std::stoi(value);
+            else if (key == "fps") profile.fps = std::stod(value);
+            else if (key == "p95_latency_ms") profile.p95_latency_ms = std::stod(value);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ignoring malformed inference profile " << inferenceProfilePath(directory, model_hash)
+                  << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    return profile;
+}
+
+bool saveInferenceProfile(const std::string& directory, const InferenceProfile& profile) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Written next to the target and renamed, so a reader never sees half a file
+    std::string path = inferenceProfilePath(directory, profile.model_hash);
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp);
+        if (!out) {
+            std::cerr << "Failed to write inference profile " << path << std::endl;
+            return false;
+        }
+        out << "# oak-tune inference profile\n"
+            << "model_hash=" << hashToString(profile.model_hash) << "\n"
+            << "model_path=" << profile.model_path << "\n"
+            << "input_width=" << profile.input_width << "\n"
+            << "input_height=" << profile.input_height << "\n"
+            << "inference_threads=" << profile.tuning.inference_threads << "\n"
+            << "nce_per_thread=" << profile.tuning.nce_per_thread << "\n"
+            << "shaves_per_thread=" << profile.tuning.shaves_per_thread << "\n"
+            << "pool_frames=" << profile.tuning.pool_frames << "\n"
+            << "input_queue_size=" << profile.tuning.input_queue_size << "\n"
+            << "fps=" << profile.fps << "\n"
+            << "p95_latency_ms=" << profile.p95_latency_ms << "\n";
+        if (!out) {
+            std::cerr << "Failed to write inference profile " << path << std::endl;
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::cerr << "Failed to write inference profile " << path << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool applyInferenceProfile(InferenceConfig& config) {
+    if (!config.use_tuned_profile || !config.tuning.isDefault()) {
+        return false;
+    }
+    auto hash = hashModelFile(config.model_path);
+    if (!hash) {
+        return false;
+    }
+    auto profile = loadInferenceProfile(config.profile_directory, *hash);
+    if (!profile) {
+        return false;
+    }
+
+    if (!profile->model_path.empty() && profile->model_path != config.model_path) {
+        if (!std::filesystem::exists(profile->model_path)) {
+            std::cerr << "Inference profile " << inferenceProfilePath(config.profile_directory, *hash)
+                      << " names a missing model, using its settings with " << config.model_path << std::endl;
+        } else {
+            config.model_path = profile->model_path;
+            if (profile->input_width > 0 && profile->input_height > 0) {
+                config.input_width = profile->input_width;
+                config.input_height = profile->input_height;
+            }
+        }
+    }
+    config.tuning = profile->tuning;
+    std::cout << "Loaded inference profile " << inferenceProfilePath(config.profile_directory, *hash)
+              << " (" << profile->fps << " fps, p95 " << profile->p95_latency_ms << " ms when tuned)" << std::endl;
+    return true;
+}
+
+} // namespace oak
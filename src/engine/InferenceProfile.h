@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <optional>
+#include "Types.h"
+
+namespace oak {
+
+// Best DetectionNetwork settings found for one model by oak-tune.
+//
+// Profiles are small text files named after a hash of the model file, so
+// they follow the model rather than its path: a renamed copy finds its
+// profile, a re-exported model with the same name does not. The tuner may
+// also pick the same network exported at another input size; the profile
+// then points at that file.
+struct InferenceProfile {
+    uint64_t model_hash = 0;
+    std::string model_path;              // Model to run; empty = the one that was tuned
+    uint32_t input_width = 0;            // 0 = keep the config's
+    uint32_t input_height = 0;
+    InferenceTuning tuning;
+    double fps = 0.0;                    // Measured when tuned, for reference
+    double p95_latency_ms = 0.0;
+};
+
+// FNV-1a over the file contents; nullopt when it cannot be read. Cached per
+// path while the file's size and modification time stay the same, so only
+// the first start with a model reads it whole.
+std::optional<uint64_t> hashModelFile(const std::string& path);
+
+std::string inferenceProfilePath(const std::string& directory, uint64_t model_hash);
+
+std::optional<InferenceProfile> loadInferenceProfile(const std::string& directory, uint64_t model_hash);
+bool saveInferenceProfile(const std::string& directory, const InferenceProfile& profile);
+
+// Applies the saved profile of config.model_path, if there is one, when the
+// config asks for it and leaves the tuning at its defaults. Returns whether
+// a profile was applied.
+bool applyInferenceProfile(InferenceConfig& config);
+
+} // namespace oak
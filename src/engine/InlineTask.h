@@ -0,0 +1,111 @@
+#pragma once
+
+#include <new>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+namespace oak {
+
+// Move-only void() callable with in-place storage, used instead of
+// std::function for per-frame tasks. Callables up to Capacity bytes (a
+// module pointer, a couple of shared_ptrs and a sequence number) are stored
+// inline, so creating and queuing one does not allocate; larger ones fall
+// back to the heap.
+template <size_t Capacity>
+class InlineTask {
+public:
+    InlineTask() = default;
+    InlineTask(std::nullptr_t) {}
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineTask> &&
+                                                      !std::is_same_v<std::decay_t<F>, std::nullptr_t>>>
+    InlineTask(F&& callable) {
+        using Callable = std::decay_t<F>;
+        if constexpr (fitsInline<Callable>()) {
+            new (storage_) Callable(std::forward<F>(callable));
+            ops_ = &kInlineOps<Callable>;
+        } else {
+            *reinterpret_cast<Callable**>(storage_) = new Callable(std::forward<F>(callable));
+            ops_ = &kHeapOps<Callable>;
+        }
+    }
+
+    InlineTask(InlineTask&& other) noexcept {
+        moveFrom(other);
+    }
+
+    InlineTask& operator=(InlineTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineTask& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+
+    ~InlineTask() {
+        reset();
+    }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    void operator()() { ops_->invoke(storage_); }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* to, void* from);  // Leaves from destroyed
+        void (*destroy)(void* storage);
+    };
+
+    template <typename Callable>
+    static constexpr bool fitsInline() {
+        return sizeof(Callable) <= Capacity && alignof(Callable) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Callable>;
+    }
+
+    template <typename Callable>
+    static constexpr Ops kInlineOps = {
+        [](void* storage) { (*static_cast<Callable*>(storage))(); },
+        [](void* to, void* from) {
+            new (to) Callable(std::move(*static_cast<Callable*>(from)));
+            static_cast<Callable*>(from)->~Callable();
+        },
+        [](void* storage) { static_cast<Callable*>(storage)->~Callable(); },
+    };
+
+    template <typename Callable>
+    static constexpr Ops kHeapOps = {
+        [](void* storage) { (**static_cast<Callable**>(storage))(); },
+        [](void* to, void* from) { *static_cast<Callable**>(to) = *static_cast<Callable**>(from); },
+        [](void* storage) { delete *static_cast<Callable**>(storage); },
+    };
+
+    void moveFrom(InlineTask& other) {
+        if (other.ops_) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    const Ops* ops_ = nullptr;
+};
+
+} // namespace oak
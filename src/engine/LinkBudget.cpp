@@ -0,0 +1,175 @@
+#include "LinkBudget.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <sstream>
+
+namespace oak {
+
+namespace {
+
+// Gigabit Ethernet after TCP/XLink framing
+constexpr double kEthernetMbps = 800.0;
+
+const char* formatName(const StreamDemand& stream) {
+    if (stream.bytes_per_pixel <= 0.0f) {
+        return "fixed";
+    }
+    if (stream.bytes_per_pixel >= 3.0f) {
+        return "BGR";
+    }
+    if (stream.bytes_per_pixel >= 2.0f) {
+        return "RAW16";
+    }
+    if (stream.bytes_per_pixel >= 1.5f) {
+        return "NV12";
+    }
+    return "GRAY8";
+}
+
+std::string describe(const StreamDemand& stream) {
+    char text[96];
+    if (stream.bytes_per_pixel <= 0.0f) {
+        std::snprintf(text, sizeof(text), "%-22s %8.1f Mbps", "fixed rate", stream.mbps());
+    } else {
+        char format[48];
+        std::snprintf(format, sizeof(format), "%ux%u@%.1f %s", stream.width, stream.height,
+                      stream.fps, formatName(stream));
+        std::snprintf(text, sizeof(text), "%-22s %8.1f Mbps", format, stream.mbps());
+    }
+    return text;
+}
+
+bool lowerFps(StreamDemand& stream) {
+    if (stream.min_fps <= 0.0f || stream.fps <= stream.min_fps) {
+        return false;
+    }
+    stream.fps = std::max(stream.min_fps, stream.fps * 0.75f);
+    return true;
+}
+
+// Height follows the requested aspect, so repeated steps do not drift
+bool lowerResolution(StreamDemand& stream, const StreamDemand& requested) {
+    if (stream.min_width == 0 || stream.width <= stream.min_width || stream.width == 0) {
+        return false;
+    }
+    uint32_t width = std::max(stream.min_width, stream.width * 3 / 4) & ~1u;
+    if (width >= stream.width) {
+        return false;
+    }
+    stream.height = static_cast<uint32_t>(static_cast<uint64_t>(requested.height) * width / requested.width) & ~1u;
+    stream.width = width;
+    return true;
+}
+
+// One step down for a stream; false once it is at every floor
+bool degradeOnce(PlannedStream& planned, bool keep_resolution) {
+    StreamDemand& stream = planned.planned;
+    if (stream.can_use_nv12 && stream.bytes_per_pixel > 1.5f) {
+        stream.bytes_per_pixel = 1.5f;
+        return true;
+    }
+    if (keep_resolution) {
+        return lowerFps(stream) || lowerResolution(stream, planned.requested);
+    }
+    return lowerResolution(stream, planned.requested) || lowerFps(stream);
+}
+
+double plannedTotal(const std::vector<PlannedStream>& streams) {
+    double total = 0.0;
+    for (const auto& stream : streams) {
+        total += stream.planned.mbps();
+    }
+    return total;
+}
+
+} // namespace
+
+bool PlannedStream::degraded() const {
+    return planned.width != requested.width || planned.height != requested.height ||
+           planned.fps != requested.fps || planned.bytes_per_pixel != requested.bytes_per_pixel;
+}
+
+LinkCapacity estimateLinkCapacity(dai::Device& device, bool use_poe) {
+    if (use_poe) {
+        return {"PoE (1 Gbps Ethernet)", kEthernetMbps};
+    }
+    switch (device.getUsbSpeed()) {
+        case dai::Device::UsbSpeed::SUPER_PLUS: return {"USB 3 (10 Gbps)", 6000.0};
+        case dai::Device::UsbSpeed::SUPER:      return {"USB 3 (5 Gbps)", 3000.0};
+        case dai::Device::UsbSpeed::HIGH:       return {"USB 2 (480 Mbps)", 280.0};
+        case dai::Device::UsbSpeed::FULL:       return {"USB 1.1 (12 Mbps)", 8.0};
+        case dai::Device::UsbSpeed::LOW:        return {"USB 1.0 (1.5 Mbps)", 1.0};
+        default:
+            // Not on USB: an Ethernet device
+            return {"Ethernet (1 Gbps)", kEthernetMbps};
+    }
+}
+
+LinkPlan planLinkBudget(const std::vector<StreamDemand>& demands, const LinkCapacity& capacity,
+                        const LinkBudgetConfig& config) {
+    LinkPlan plan;
+    plan.capacity = capacity;
+    plan.budget_mbps = capacity.mbps * std::clamp(static_cast<double>(config.headroom), 0.05, 1.0);
+    for (const auto& demand : demands) {
+        plan.streams.push_back({demand, demand});
+        plan.requested_mbps += demand.mbps();
+    }
+    plan.planned_mbps = plan.requested_mbps;
+
+    if (config.policy == LinkBudgetPolicy::DEGRADE && plan.planned_mbps > plan.budget_mbps) {
+        // Stream indices by priority, lowest first
+        std::map<int, std::vector<size_t>> levels;
+        for (size_t i = 0; i < plan.streams.size(); ++i) {
+            levels[plan.streams[i].requested.priority].push_back(i);
+        }
+        for (const auto& [priority, indices] : levels) {
+            bool stepped = true;
+            while (stepped && plan.planned_mbps > plan.budget_mbps) {
+                // One step per stream per round, so equal priorities share the cut
+                stepped = false;
+                for (size_t i : indices) {
+                    if (degradeOnce(plan.streams[i], config.keep_resolution)) {
+                        stepped = true;
+                        plan.planned_mbps = plannedTotal(plan.streams);
+                        if (plan.planned_mbps <= plan.budget_mbps) {
+                            break;
+                        }
+                    }
+                }
+            }
+            if (plan.planned_mbps <= plan.budget_mbps) {
+                break;
+            }
+        }
+    }
+
+    plan.fits = plan.planned_mbps <= plan.budget_mbps;
+    return plan;
+}
+
+std::string formatLinkPlan(const LinkPlan& plan) {
+    std::ostringstream out;
+    char line[192];
+    std::snprintf(line, sizeof(line), "Link budget: %s, %s%.0f Mbps usable, budget %.0f Mbps\n",
+                  plan.capacity.link.c_str(), plan.capacity.estimated ? "~" : "", plan.capacity.mbps,
+                  plan.budget_mbps);
+    out << line;
+    for (const auto& stream : plan.streams) {
+        std::snprintf(line, sizeof(line), "  %-18s p%-2d %s", stream.requested.name.c_str(),
+                      stream.requested.priority, describe(stream.requested).c_str());
+        out << line;
+        if (stream.degraded()) {
+            out << "  ->  " << describe(stream.planned);
+        }
+        out << "\n";
+    }
+    std::snprintf(line, sizeof(line), "  total %.1f Mbps requested, %.1f Mbps planned (%.0f%% of budget)%s",
+                  plan.requested_mbps, plan.planned_mbps,
+                  plan.budget_mbps > 0.0 ? plan.planned_mbps * 100.0 / plan.budget_mbps : 0.0,
+                  plan.fits ? "" : " - DOES NOT FIT");
+    out << line;
+    return out.str();
+}
+
+} // namespace oak
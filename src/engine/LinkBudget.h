@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <depthai/depthai.hpp>
+#include "Types.h"
+
+namespace oak {
+
+// One device -> host stream a module is about to request
+struct StreamDemand {
+    std::string name;                    // Module's stream name, used when applying the plan
+    uint32_t width = 0;
+    uint32_t height = 0;
+    float fps = 0.0f;
+    float bytes_per_pixel = 0.0f;        // 3 BGR888i, 1.5 NV12, 2 depth; 0 for fixed-rate streams
+    double fixed_mbps = 0.0;             // Encoded video, detections and other non-raw payloads
+    int priority = 0;                    // Lower priorities are degraded first
+    bool can_use_nv12 = false;           // BGR stream whose consumers also accept NV12
+    float min_fps = 0.0f;                // Lowest acceptable fps; 0 = fps is fixed
+    uint32_t min_width = 0;              // Lowest acceptable width; 0 = resolution is fixed
+
+    double mbps() const {
+        return fixed_mbps + static_cast<double>(width) * height * bytes_per_pixel * fps * 8.0 / 1e6;
+    }
+};
+
+struct PlannedStream {
+    StreamDemand requested;
+    StreamDemand planned;                // Same as requested unless degraded
+
+    bool degraded() const;
+    bool switchedToNv12() const { return planned.bytes_per_pixel < requested.bytes_per_pixel; }
+};
+
+struct LinkCapacity {
+    std::string link;                    // e.g. "USB 3 (5 Gbps)"
+    double mbps = 0.0;                   // Usable payload throughput
+    bool estimated = true;               // From the link type, not measured or configured
+};
+
+struct LinkPlan {
+    LinkCapacity capacity;
+    double budget_mbps = 0.0;            // capacity * headroom
+    double requested_mbps = 0.0;
+    double planned_mbps = 0.0;
+    bool fits = true;                    // Planned streams within the budget
+    std::vector<PlannedStream> streams;
+};
+
+// Estimated usable throughput of the link the device is on. Only the link
+// type is detected (negotiated USB speed, or PoE); nothing is measured, so
+// the figure is a typical XLink rate for that type, not what this cable,
+// hub or host controller sustains. PoE devices (or use_poe) are sized for
+// gigabit Ethernet. Set LinkBudgetConfig::capacity_mbps to a measured value
+// where the estimate is off.
+LinkCapacity estimateLinkCapacity(dai::Device& device, bool use_poe);
+
+// Sums the demands and, under DEGRADE, lowers streams in priority order
+// (lowest first) until the total fits the budget: BGR streams that allow it
+// switch to NV12 first, then fps is lowered in 25% steps to min_fps and
+// the width (aspect kept) in 25% steps to min_width, or resolution first
+// with keep_resolution = false. Streams at equal priority are degraded in
+// turn.
+LinkPlan planLinkBudget(const std::vector<StreamDemand>& demands, const LinkCapacity& capacity,
+                        const LinkBudgetConfig& config);
+
+// Multi-line table of the plan, one row per stream
+std::string formatLinkPlan(const LinkPlan& plan);
+
+} // namespace oak
@@ -1,16 +1,31 @@
 #pragma once
 
+#include <map>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 #include <functional>
 #include <depthai/depthai.hpp>
 #include "Types.h"
+#include "StreamQueue.h"
+#include "Trace.h"
+#include "FrameSynchronizer.h"
+#include "TaskPool.h"
+#include "AllocationCounter.h"
+#include "SimulatedSource.h"
+#include "LinkBudget.h"
+#include "../processing/PointCloud.h"
 
 namespace oak {
 
 // Callback types for data output
 using FrameCallback = std::function<void(std::shared_ptr<dai::ImgFrame>)>;
 using DetectionCallback = std::function<void(std::shared_ptr<dai::ImgDetections>)>;
+using PointCloudCallback = std::function<void(const PointCloud&)>;
+
+// Camera nodes built by the engine, keyed by board socket
+using CameraNodes = std::map<dai::CameraBoardSocket, std::shared_ptr<dai::node::Camera>>;
 
 class ModuleBase {
 public:
@@ -20,6 +35,32 @@ public:
     virtual bool configure(dai::Pipeline& pipeline, 
                           std::shared_ptr<dai::node::Camera> camera) = 0;
 
+    // Sockets the engine builds camera nodes for before configuring the module
+    virtual std::vector<dai::CameraBoardSocket> getRequiredSockets() const {
+        return {dai::CameraBoardSocket::CAM_A};
+    }
+
+    // Device -> host streams configure() would open, for the link budget
+    virtual std::vector<StreamDemand> getStreamDemands() const { return {}; }
+
+    // Adopt the planner's (possibly degraded) streams; called before configure()
+    virtual void applyStreamPlan(const std::vector<PlannedStream>& streams) {
+        (void)streams;
+    }
+
+    // Multi-camera entry point; single-camera modules receive the CAM_A node
+    virtual bool configureCameras(dai::Pipeline& pipeline, const CameraNodes& cameras) {
+        auto it = cameras.find(dai::CameraBoardSocket::CAM_A);
+        return configure(pipeline, it != cameras.end() ? it->second : nullptr);
+    }
+
+    // Device-less entry point: open the module's queues on simulated outputs.
+    // Modules that need device-side nodes to be meaningful keep this default.
+    virtual bool configureSimulated(SimulatedSource& source) {
+        (void)source;
+        return false;
+    }
+
     // Get module name
     virtual std::string getName() const = 0;
 
@@ -32,15 +73,111 @@ public:
     // Cleanup resources
     virtual void cleanup() {}
 
-    // Set callbacks
-    void setFrameCallback(FrameCallback callback) { frame_callback_ = callback; }
-    void setDetectionCallback(DetectionCallback callback) { detection_callback_ = callback; }
+    // Per-stream queue statistics (deliveries and drops)
+    virtual std::vector<QueueStats> getQueueStats() const { return {}; }
+
+    // Set callbacks; they run on the engine task pool, in order per stream.
+    // Safe while the module runs: each task keeps the callback it was submitted with.
+    void setFrameCallback(FrameCallback callback) { std::atomic_store(&frame_callback_, share(std::move(callback))); }
+    void setDetectionCallback(DetectionCallback callback) {
+        std::atomic_store(&detection_callback_, share(std::move(callback)));
+    }
+
+    // Blocks until the detection callbacks submitted so far have run. Not
+    // from a callback of this module.
+    virtual void drainDetectionCallbacks() {}
+
+    // Engine-owned pool for per-frame host work (callbacks, conversions)
+    void setTaskPool(std::shared_ptr<TaskPool> pool) { task_pool_ = pool; }
+
+    // Called by the engine with the allocations one process() call made
+    void recordAllocations(const AllocationCount& delta) {
+        uint64_t frames = frames_in_call_;
+        frames_in_call_ = 0;
+        if (frames == 0) {
+            return;  // Idle polls are not part of the frame path
+        }
+        uint64_t total = frames_.fetch_add(frames, std::memory_order_relaxed) + frames;
+        allocations_.fetch_add(delta.count, std::memory_order_relaxed);
+        bytes_.fetch_add(delta.bytes, std::memory_order_relaxed);
+        if (total > kAllocationWarmupFrames) {
+            steady_frames_.fetch_add(frames, std::memory_order_relaxed);
+            steady_allocations_.fetch_add(delta.count, std::memory_order_relaxed);
+        }
+    }
+
+    AllocationStats getAllocationStats() const {
+        AllocationStats stats;
+        stats.frames = frames_.load(std::memory_order_relaxed);
+        stats.allocations = allocations_.load(std::memory_order_relaxed);
+        stats.bytes = bytes_.load(std::memory_order_relaxed);
+        stats.steady_frames = steady_frames_.load(std::memory_order_relaxed);
+        stats.steady_allocations = steady_allocations_.load(std::memory_order_relaxed);
+        if (stats.steady_frames > 0) {
+            stats.steady_allocations_per_frame =
+                static_cast<double>(stats.steady_allocations) / static_cast<double>(stats.steady_frames);
+        }
+        return stats;
+    }
 
 protected:
     ModuleBase() = default;
-    
-    FrameCallback frame_callback_;
-    DetectionCallback detection_callback_;
+
+    // Frames that fill queues, pools and scratch buffers to their working size
+    static constexpr uint64_t kAllocationWarmupFrames = 120;
+
+    // Called from process() for each frame it handled, so the engine can
+    // attribute the call's allocations to frames
+    void markFrame() { ++frames_in_call_; }
+
+    // Run work off the processing thread, in order per stream.
+    // Runs inline when no pool is attached; returns false if the stream's backlog is full.
+    bool runOnStream(uint64_t stream, TaskPool::Task task) {
+        if (!task_pool_) {
+            task();
+            return true;
+        }
+        return task_pool_->submit(poolStream(stream), std::move(task));
+    }
+
+    // Pool-wide id of one of this module's streams. Module stream ids are
+    // small per-module enums; they are tagged with the module type so they
+    // never share a strand with another module's or with the engine
+    // services' (whose ids stay below 2^32).
+    uint64_t poolStream(uint64_t stream) const {
+        return ((static_cast<uint64_t>(getStateType()) + 1) << 32) | stream;
+    }
+
+    // Waits for the tasks already submitted to one of this module's streams
+    void drainStream(uint64_t stream) {
+        if (task_pool_) {
+            task_pool_->waitStream(poolStream(stream));
+        }
+    }
+
+    // Current callbacks (null if unset); capture the pointer in the task
+    std::shared_ptr<const FrameCallback> frameCallback() const { return std::atomic_load(&frame_callback_); }
+    std::shared_ptr<const DetectionCallback> detectionCallback() const {
+        return std::atomic_load(&detection_callback_);
+    }
+
+    std::shared_ptr<TaskPool> task_pool_;
+
+private:
+    template <typename Callback>
+    static std::shared_ptr<const Callback> share(Callback callback) {
+        return callback ? std::make_shared<const Callback>(std::move(callback)) : nullptr;
+    }
+
+    // Swapped with std::atomic_store while pool tasks read them
+    std::shared_ptr<const FrameCallback> frame_callback_;
+    std::shared_ptr<const DetectionCallback> detection_callback_;
+    uint64_t frames_in_call_ = 0;        // Processing thread only
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> steady_frames_{0};
+    std::atomic<uint64_t> steady_allocations_{0};
 };
 
 } // namespace oak
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <new>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <functional>
+
+namespace oak {
+
+// Reusable objects handed out as std::shared_ptr. The last holder to let go
+// returns the object to a locked free list, from whatever thread it runs
+// on, so a free object is never one that another thread is still copying a
+// reference to (which use_count() cannot tell). The shared_ptr control
+// blocks are recycled the same way: once the pool has reached its working
+// size, acquire() and release do not allocate.
+//
+// Objects keep their contents between uses; the caller resets what it needs.
+// Objects still held when the pool is destroyed are freed by their last
+// holder.
+template <typename T>
+class ObjectPool {
+public:
+    using Factory = std::function<std::unique_ptr<T>()>;
+
+    // At most max_objects exist at once; make() creates them (default-constructed if empty)
+    explicit ObjectPool(size_t max_objects = SIZE_MAX, Factory make = nullptr)
+        : state_(std::make_shared<State>()) {
+        state_->max_objects = max_objects;
+        state_->make = make ? std::move(make) : Factory([] { return std::make_unique<T>(); });
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // A free object, a new one while fewer than max_objects exist, otherwise nullptr
+    std::shared_ptr<T> acquire() {
+        std::unique_ptr<T> object;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->free.empty()) {
+                object = std::move(state_->free.back());
+                state_->free.pop_back();
+            } else if (state_->created >= state_->max_objects) {
+                return nullptr;
+            } else {
+                ++state_->created;
+                // Release never has to grow the list
+                state_->free.reserve(state_->created);
+            }
+        }
+        if (!object) {
+            try {
+                object = state_->make();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state_->mutex);
+                --state_->created;
+                throw;
+            }
+        }
+        return std::shared_ptr<T>(object.release(), Release{state_}, BlockAllocator<T>(state_));
+    }
+
+    // Objects created so far (free or held)
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->created;
+    }
+
+    size_t available() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->free.size();
+    }
+
+private:
+    // Control blocks up to this size are recycled
+    static constexpr size_t kBlockBytes = 128;
+
+    struct State {
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<T>> free;
+        std::vector<void*> blocks;       // Free control blocks
+        size_t created = 0;
+        size_t blocks_created = 0;
+        size_t max_objects = SIZE_MAX;
+        Factory make;
+
+        ~State() {
+            for (void* block : blocks) {
+                ::operator delete(block);
+            }
+        }
+    };
+
+    struct Release {
+        std::shared_ptr<State> state;
+
+        void operator()(T* object) const {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->free.emplace_back(object);
+        }
+    };
+
+    template <typename U>
+    struct BlockAllocator {
+        using value_type = U;
+
+        std::shared_ptr<State> state;
+
+        explicit BlockAllocator(std::shared_ptr<State> shared) : state(std::move(shared)) {}
+        template <typename V>
+        BlockAllocator(const BlockAllocator<V>& other) : state(other.state) {}
+
+        static bool pooled(size_t n) {
+            return n * sizeof(U) <= kBlockBytes && alignof(U) <= alignof(std::max_align_t);
+        }
+
+        U* allocate(size_t n) {
+            if (!pooled(n)) {
+                return static_cast<U*>(::operator new(n * sizeof(U)));
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->blocks.empty()) {
+                    void* block = state->blocks.back();
+                    state->blocks.pop_back();
+                    return static_cast<U*>(block);
+                }
+                ++state->blocks_created;
+                state->blocks.reserve(state->blocks_created);
+            }
+            return static_cast<U*>(::operator new(kBlockBytes));
+        }
+
+        void deallocate(U* pointer, size_t n) {
+            if (!pooled(n)) {
+                ::operator delete(pointer);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->blocks.push_back(pointer);
+        }
+
+        template <typename V>
+        bool operator==(const BlockAllocator<V>& other) const { return state == other.state; }
+        template <typename V>
+        bool operator!=(const BlockAllocator<V>& other) const { return state != other.state; }
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace oak
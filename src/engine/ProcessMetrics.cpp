@@ -0,0 +1,81 @@
+#include "ProcessMetrics.h"
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#endif
+
+namespace oak {
+
+#if defined(__linux__)
+
+ProcessSample sampleProcess() {
+    ProcessSample sample;
+
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            sample.rss_bytes = std::stoull(line.substr(6)) * 1024;  // Reported in kB
+        } else if (line.rfind("Threads:", 0) == 0) {
+            sample.threads = static_cast<uint32_t>(std::stoul(line.substr(8)));
+        }
+    }
+
+    std::error_code error;
+    uint32_t fds = 0;
+    for (std::filesystem::directory_iterator it("/proc/self/fd", error), end; !error && it != end;
+         it.increment(error)) {
+        ++fds;
+    }
+    // The iterator holds one descriptor of its own while counting
+    sample.open_files = fds > 0 ? fds - 1 : 0;
+    return sample;
+}
+
+#elif defined(_WIN32)
+
+ProcessSample sampleProcess() {
+    ProcessSample sample;
+
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        sample.rss_bytes = counters.WorkingSetSize;
+    }
+
+    DWORD handles = 0;
+    if (GetProcessHandleCount(GetCurrentProcess(), &handles)) {
+        sample.open_files = handles;
+    }
+
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot != INVALID_HANDLE_VALUE) {
+        DWORD pid = GetCurrentProcessId();
+        THREADENTRY32 entry{};
+        entry.dwSize = sizeof(entry);
+        for (BOOL ok = Thread32First(snapshot, &entry); ok; ok = Thread32Next(snapshot, &entry)) {
+            if (entry.th32OwnerProcessID == pid) {
+                ++sample.threads;
+            }
+        }
+        CloseHandle(snapshot);
+    }
+    return sample;
+}
+
+#else
+
+ProcessSample sampleProcess() {
+    return {};
+}
+
+#endif
+
+} // namespace oak
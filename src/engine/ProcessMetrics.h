@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace oak {
+
+// Point-in-time resource usage of the current process
+struct ProcessSample {
+    uint64_t rss_bytes = 0;
+    uint32_t threads = 0;
+    uint32_t open_files = 0;             // File descriptors (POSIX) or handles (Windows)
+};
+
+// Reads /proc/self on Linux and the process APIs on Windows; fields the
+// platform cannot report stay zero.
+ProcessSample sampleProcess();
+
+} // namespace oak
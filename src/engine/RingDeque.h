@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+namespace oak {
+
+// Double-ended queue on a circular buffer that only grows. Unlike std::deque
+// it keeps its storage when drained, so once a queue has reached its working
+// size, pushing and popping never allocate. Not thread-safe.
+template <typename T>
+class RingDeque {
+public:
+    explicit RingDeque(size_t capacity = 0) {
+        reserve(capacity);
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return slots_.size(); }
+
+    void reserve(size_t capacity) {
+        if (capacity > slots_.size()) {
+            grow(capacity);
+        }
+    }
+
+    void push_back(T value) {
+        if (size_ == slots_.size()) {
+            grow(std::max<size_t>(8, slots_.size() * 2));
+        }
+        slots_[(head_ + size_) % slots_.size()] = std::move(value);
+        ++size_;
+    }
+
+    void push_front(T value) {
+        if (size_ == slots_.size()) {
+            grow(std::max<size_t>(8, slots_.size() * 2));
+        }
+        head_ = (head_ + slots_.size() - 1) % slots_.size();
+        slots_[head_] = std::move(value);
+        ++size_;
+    }
+
+    T& front() { return slots_[head_]; }
+    T& back() { return slots_[(head_ + size_ - 1) % slots_.size()]; }
+    // 0 = front
+    T& operator[](size_t index) { return slots_[(head_ + index) % slots_.size()]; }
+    const T& operator[](size_t index) const { return slots_[(head_ + index) % slots_.size()]; }
+
+    // Popped slots are reset so they release what they held right away
+    void pop_front() {
+        slots_[head_] = T{};
+        head_ = (head_ + 1) % slots_.size();
+        --size_;
+    }
+
+    void pop_back() {
+        back() = T{};
+        --size_;
+    }
+
+    void clear() {
+        while (!empty()) {
+            pop_back();
+        }
+        head_ = 0;
+    }
+
+private:
+    void grow(size_t capacity) {
+        std::vector<T> slots(capacity);
+        for (size_t i = 0; i < size_; ++i) {
+            slots[i] = std::move(slots_[(head_ + i) % slots_.size()]);
+        }
+        slots_ = std::move(slots);
+        head_ = 0;
+    }
+
+    std::vector<T> slots_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace oak
@@ -0,0 +1,61 @@
+#include "SampleStats.h"
+#include <algorithm>
+
+namespace oak {
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+    return samples[index];
+}
+
+SampleSummary summarizeSamples(std::vector<double>& samples) {
+    SampleSummary summary;
+    summary.count = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+    double total = 0.0;
+    for (double value : samples) {
+        total += value;
+    }
+    summary.mean = total / static_cast<double>(samples.size());
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+    };
+    summary.p50 = at(0.50);
+    summary.p95 = at(0.95);
+    summary.p99 = at(0.99);
+    summary.max = samples.back();
+    return summary;
+}
+
+void LatencyRecorder::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    samples_ms_.clear();
+    active_ = true;
+}
+
+void LatencyRecorder::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = false;
+}
+
+void LatencyRecorder::record(std::chrono::steady_clock::time_point captured) {
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captured).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_) {
+        samples_ms_.push_back(ms);
+    }
+}
+
+SampleSummary LatencyRecorder::summarize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return summarizeSamples(samples_ms_);
+}
+
+} // namespace oak
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+
+namespace oak {
+
+// Distribution of a set of samples, in their unit
+struct SampleSummary {
+    size_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Sample at rank p * size (p in [0, 1]); partially reorders samples
+double percentile(std::vector<double>& samples, double p);
+
+// Reorders samples; all zero if there are none
+SampleSummary summarizeSamples(std::vector<double>& samples);
+
+// Capture-to-callback latency of the messages delivered while active, in
+// milliseconds. record() may be called from any thread.
+class LatencyRecorder {
+public:
+    // Drops earlier samples (keeping their capacity) and starts recording
+    void start();
+    // Stops recording; the samples stay until the next start()
+    void stop();
+    void record(std::chrono::steady_clock::time_point captured);
+    SampleSummary summarize();
+
+private:
+    std::mutex mutex_;
+    std::vector<double> samples_ms_;
+    bool active_ = false;
+};
+
+} // namespace oak
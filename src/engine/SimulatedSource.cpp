@@ -0,0 +1,191 @@
+#include "SimulatedSource.h"
+#include "ThreadTuning.h"
+#include "../processing/TileMerger.h"
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+
+namespace oak {
+
+namespace {
+
+// Distinct frames per output; enough that consumers see changing content
+constexpr int kPatternCount = 8;
+
+} // namespace
+
+SimulatedSource::SimulatedSource(const SimulationConfig& config)
+    : config_(config) {
+}
+
+SimulatedSource::~SimulatedSource() {
+    stop();
+}
+
+std::shared_ptr<dai::MessageQueue> SimulatedSource::addFrameOutput(const std::string& name, uint32_t width,
+                                                                   uint32_t height, const QueueConfig& queue,
+                                                                   dai::ImgFrame::Type type) {
+    // Full rate relies on back-pressure, otherwise the source would spin
+    // generating frames that are overwritten before anyone reads them
+    bool blocking = queue.blocking || config_.fps <= 0.0f;
+    Output output;
+    output.queue = std::make_shared<dai::MessageQueue>(name, std::max(queue.depth, 1u), blocking);
+    output.type = type;
+
+    int cols = static_cast<int>(width);
+    int rows = static_cast<int>(height);
+    for (int i = 0; i < kPatternCount; ++i) {
+        // Gradient with a moving bar, so each pattern differs everywhere
+        cv::Mat pattern(rows, cols, CV_8UC3);
+        for (int y = 0; y < rows; ++y) {
+            auto* row = pattern.ptr<uint8_t>(y);
+            for (int x = 0; x < cols; ++x) {
+                row[3 * x + 0] = static_cast<uint8_t>((x + i * 32) & 0xFF);
+                row[3 * x + 1] = static_cast<uint8_t>((y + i * 16) & 0xFF);
+                row[3 * x + 2] = static_cast<uint8_t>(i * 255 / kPatternCount);
+            }
+        }
+        int bar = cols * i / kPatternCount;
+        cv::rectangle(pattern, cv::Point(bar, 0), cv::Point(bar + cols / 16, rows - 1),
+                      cv::Scalar(255, 255, 255), cv::FILLED);
+        if (type == dai::ImgFrame::Type::GRAY8) {
+            cv::cvtColor(pattern, pattern, cv::COLOR_BGR2GRAY);
+        }
+        output.patterns.push_back(pattern);
+    }
+
+    outputs_.push_back(std::move(output));
+    return outputs_.back().queue;
+}
+
+std::shared_ptr<dai::MessageQueue> SimulatedSource::addStillOutput(const std::string& name, uint32_t width,
+                                                                   uint32_t height) {
+    auto queue = addFrameOutput(name, width, height, QueueConfig{2, false, QueuePolicy::LOSSLESS});
+    outputs_.back().on_demand = true;
+    outputs_.back().patterns.resize(2);  // Stills are rare; keep the memory down
+    return queue;
+}
+
+std::shared_ptr<dai::MessageQueue> SimulatedSource::addDetectionOutput(const std::string& name,
+                                                                       const QueueConfig& queue,
+                                                                       uint32_t tiles) {
+    bool blocking = queue.blocking || config_.fps <= 0.0f;
+    Output output;
+    output.queue = std::make_shared<dai::MessageQueue>(name, std::max(queue.depth, 1u), blocking);
+    output.detections = true;
+    output.tiles = std::max(tiles, 1u);
+    outputs_.push_back(std::move(output));
+    return outputs_.back().queue;
+}
+
+void SimulatedSource::start() {
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&SimulatedSource::run, this);
+
+    std::cout << "Simulated source started: " << outputs_.size() << " outputs, "
+              << (config_.fps > 0.0f ? std::to_string(config_.fps) + " fps" : std::string("full rate"))
+              << std::endl;
+}
+
+void SimulatedSource::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& output : outputs_) {
+        output.queue->close();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::shared_ptr<dai::ImgDetections> SimulatedSource::makeDetections(int64_t seq) {
+    auto message = std::make_shared<dai::ImgDetections>();
+    message->detections.reserve(config_.detections_per_frame);
+    for (uint32_t i = 0; i < config_.detections_per_frame; ++i) {
+        // Boxes drift slowly so trackers and overlays see plausible motion
+        float phase = static_cast<float>(seq) * 0.02f + static_cast<float>(i);
+        float cx = 0.5f + 0.35f * std::sin(phase);
+        float cy = 0.5f + 0.35f * std::cos(phase * 0.7f);
+        dai::ImgDetection detection{};
+        detection.label = i % 80;
+        detection.confidence = 0.5f + 0.5f * static_cast<float>((seq + i) % 10) / 10.0f;
+        detection.xmin = std::max(0.0f, cx - 0.05f);
+        detection.ymin = std::max(0.0f, cy - 0.08f);
+        detection.xmax = std::min(1.0f, cx + 0.05f);
+        detection.ymax = std::min(1.0f, cy + 0.08f);
+        message->detections.push_back(detection);
+    }
+    return message;
+}
+
+void SimulatedSource::run() {
+    configureCurrentThread("oak-simulator", ThreadOptions{});
+
+    using Clock = std::chrono::steady_clock;
+    auto period = config_.fps > 0.0f
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / config_.fps))
+        : Clock::duration::zero();
+    auto next = Clock::now();
+    int64_t seq = 0;
+
+    while (running_) {
+        auto timestamp = Clock::now();
+        try {
+            for (auto& output : outputs_) {
+                std::shared_ptr<dai::Buffer> message;
+                if (output.on_demand) {
+                    uint32_t requests = still_requests_.load(std::memory_order_relaxed);
+                    if (requests == 0 || !still_requests_.compare_exchange_strong(requests, requests - 1)) {
+                        continue;
+                    }
+                }
+                if (output.detections && output.tiles > 1) {
+                    for (uint32_t tile = 0; tile < output.tiles; ++tile) {
+                        auto tileMessage = makeDetections(seq + tile);
+                        tileMessage->setSequenceNum(seq * TileMerger::kSequenceStride + tile);
+                        tileMessage->setTimestamp(timestamp);
+                        tileMessage->setTimestampDevice(timestamp);
+                        output.queue->send(tileMessage);
+                    }
+                    continue;
+                }
+                if (output.detections) {
+                    message = makeDetections(seq);
+                } else {
+                    auto frame = std::make_shared<dai::ImgFrame>();
+                    frame->setCvFrame(output.patterns[static_cast<size_t>(seq) % output.patterns.size()],
+                                      output.type);
+                    message = frame;
+                }
+                message->setSequenceNum(seq);
+                message->setTimestamp(timestamp);
+                message->setTimestampDevice(timestamp);
+                output.queue->send(message);
+            }
+        } catch (const std::exception& e) {
+            // A closed queue releases a blocked send during stop()
+            if (running_) {
+                std::cerr << "Simulated source: " << e.what() << std::endl;
+            }
+            break;
+        }
+        ++seq;
+        generated_.fetch_add(1, std::memory_order_relaxed);
+
+        if (period > Clock::duration::zero()) {
+            next += period;
+            auto now = Clock::now();
+            if (next < now) {
+                next = now;  // Fell behind; do not burst to catch up
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
+
+} // namespace oak
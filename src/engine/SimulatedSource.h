@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <depthai/depthai.hpp>
+#include <opencv2/opencv.hpp>
+#include "Types.h"
+
+namespace oak {
+
+// Stands in for a device: generates BGR frames and detection messages on a
+// host thread and sends them into host-side message queues, which modules
+// read through StreamQueue exactly as they read device outputs.
+//
+// Frames carry sequence numbers and steady_clock timestamps taken when they
+// are generated, so queue drop accounting and capture-to-callback latency
+// behave as with a device. At fps = 0 the outputs are blocking, and the
+// source runs as fast as the slowest module stream drains.
+class SimulatedSource {
+public:
+    explicit SimulatedSource(const SimulationConfig& config);
+    ~SimulatedSource();
+
+    SimulatedSource(const SimulatedSource&) = delete;
+    SimulatedSource& operator=(const SimulatedSource&) = delete;
+
+    // Register outputs before start(); the returned queue goes to StreamQueue::open()
+    // BGR888i, NV12 or GRAY8 frames
+    std::shared_ptr<dai::MessageQueue> addFrameOutput(const std::string& name, uint32_t width,
+                                                      uint32_t height, const QueueConfig& queue,
+                                                      dai::ImgFrame::Type type = dai::ImgFrame::Type::BGR888i);
+    // Frames sent only on request, one per requestStill() call
+    std::shared_ptr<dai::MessageQueue> addStillOutput(const std::string& name, uint32_t width, uint32_t height);
+    void requestStill() { still_requests_.fetch_add(1, std::memory_order_relaxed); }
+    // With tiles > 1, each frame yields one message per tile, numbered like
+    // the device tiling script does (see TileMerger)
+    std::shared_ptr<dai::MessageQueue> addDetectionOutput(const std::string& name, const QueueConfig& queue,
+                                                          uint32_t tiles = 1);
+
+    void start();
+    // Closes the outputs (releasing a blocked send) and joins the generator
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    uint64_t getGeneratedCount() const { return generated_.load(std::memory_order_relaxed); }
+
+private:
+    struct Output {
+        std::shared_ptr<dai::MessageQueue> queue;
+        bool detections = false;
+        dai::ImgFrame::Type type = dai::ImgFrame::Type::BGR888i;
+        uint32_t tiles = 1;
+        bool on_demand = false;
+        std::vector<cv::Mat> patterns;   // Pre-rendered frames, cycled
+    };
+
+    void run();
+    std::shared_ptr<dai::ImgDetections> makeDetections(int64_t seq);
+
+    SimulationConfig config_;
+    std::vector<Output> outputs_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    std::atomic<uint64_t> generated_{0};
+    std::atomic<uint32_t> still_requests_{0};
+};
+
+} // namespace oak
@@ -0,0 +1,219 @@
+#include "SnapshotService.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace oak {
+
+namespace {
+
+// Task pool stream for host-side JPEG encoding; module streams are small ids
+constexpr uint64_t kSnapshotStream = 0x534E4150;  // "SNAP"
+
+// A still captured this long before the oldest open request belonged to
+// one that already timed out
+constexpr auto kCaptureSlack = std::chrono::milliseconds(250);
+
+// Device side: every full-resolution frame is dropped unless the host has
+// asked for one
+const char* kStillScript = R"(
+pending = 0
+while True:
+    while node.io['trigger'].tryGet() is not None:
+        pending += 1
+    frame = node.io['frames'].get()
+    if pending > 0:
+        node.io['out'].send(frame)
+        pending -= 1
+)";
+
+} // namespace
+
+SnapshotService::SnapshotService(const SnapshotConfig& config, std::shared_ptr<TaskPool> pool)
+    : config_(config),
+      pool_(std::move(pool)),
+      queue_("snapshot", QueueConfig{4, false, QueuePolicy::LOSSLESS}) {
+}
+
+SnapshotService::~SnapshotService() {
+    cancelAll("snapshot service stopped");
+}
+
+void SnapshotService::configure(dai::Pipeline& pipeline, dai::node::Camera& camera) {
+    auto* fullResolution = camera.requestFullResolutionOutput(dai::ImgFrame::Type::NV12);
+
+    auto script = pipeline.create<dai::node::Script>();
+    script->setScript(kStillScript);
+    script->inputs["frames"].setBlocking(false);
+    script->inputs["frames"].setMaxSize(1);
+    fullResolution->link(script->inputs["frames"]);
+    trigger_queue_ = script->inputs["trigger"].createInputQueue();
+
+    if (config_.encode_on_device) {
+        auto encoder = pipeline.create<dai::node::VideoEncoder>();
+        encoder->setDefaultProfilePreset(30.0f, dai::VideoEncoderProperties::Profile::MJPEG);
+        encoder->setQuality(config_.jpeg_quality);
+        script->outputs["out"].link(encoder->input);
+        queue_.open(encoder->out);
+        device_jpeg_ = true;
+    } else {
+        queue_.open(script->outputs["out"]);
+        device_jpeg_ = false;
+    }
+
+    std::cout << "Snapshots: full resolution, JPEG on the "
+              << (device_jpeg_ ? "device" : "host") << std::endl;
+}
+
+void SnapshotService::configureSimulated(SimulatedSource& source) {
+    queue_.open(source.addStillOutput("snapshot", config_.simulated_width, config_.simulated_height));
+    simulated_ = &source;
+    device_jpeg_ = false;
+}
+
+std::future<Snapshot> SnapshotService::request() {
+    Pending pending;
+    pending.requested = std::chrono::steady_clock::now();
+    auto future = pending.promise.get_future();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    stats_.requested++;
+    if (pending_.size() >= config_.max_pending) {
+        lock.unlock();
+        fail(pending, "too many snapshot requests outstanding");
+        return future;
+    }
+    if (trigger_queue_) {
+        trigger_queue_->send(std::make_shared<dai::Buffer>());
+    } else if (simulated_) {
+        simulated_->requestStill();
+    } else {
+        lock.unlock();
+        fail(pending, "snapshot service is not configured");
+        return future;
+    }
+    pending_.push_back(std::move(pending));
+    return future;
+}
+
+void SnapshotService::poll() {
+    if (!queue_.isOpen()) {
+        return;
+    }
+
+    // Oldest open request for a still, or nothing if the still is stale
+    auto takeRequest = [this](std::chrono::steady_clock::time_point captured, Pending& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty() || captured + kCaptureSlack < pending_.front().requested) {
+            return false;
+        }
+        out = std::move(pending_.front());
+        pending_.pop_front();
+        return true;
+    };
+
+    if (device_jpeg_) {
+        while (auto encoded = queue_.next<dai::EncodedFrame>()) {
+            Pending pending;
+            if (!takeRequest(encoded->getTimestamp(), pending)) {
+                continue;
+            }
+            Snapshot snapshot;
+            snapshot.jpeg = encoded->getData();
+            snapshot.width = encoded->getWidth();
+            snapshot.height = encoded->getHeight();
+            snapshot.sequence = encoded->getSequenceNum();
+            snapshot.captured = encoded->getTimestamp();
+            complete(std::move(pending), std::move(snapshot));
+        }
+    } else {
+        while (auto frame = queue_.next<dai::ImgFrame>()) {
+            Pending pending;
+            if (!takeRequest(frame->getTimestamp(), pending)) {
+                continue;
+            }
+            encodeOnHost(std::move(pending), std::move(frame));
+        }
+    }
+
+    // Expire requests whose still never came
+    auto deadline = std::chrono::steady_clock::now() - std::chrono::milliseconds(config_.timeout_ms);
+    std::vector<Pending> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!pending_.empty() && pending_.front().requested < deadline) {
+            expired.push_back(std::move(pending_.front()));
+            pending_.pop_front();
+        }
+    }
+    for (auto& pending : expired) {
+        fail(pending, "snapshot timed out");
+    }
+}
+
+void SnapshotService::encodeOnHost(Pending pending, std::shared_ptr<dai::ImgFrame> frame) {
+    auto shared = std::make_shared<Pending>(std::move(pending));
+    TaskPool::Task task([this, shared, frame] {
+        TraceSpan span("snapshot_encode", "snapshot", frame->getSequenceNum());
+        try {
+            Snapshot snapshot;
+            cv::Mat image = frame->getCvFrame();  // NV12 is converted to BGR here
+            if (!cv::imencode(".jpg", image, snapshot.jpeg, {cv::IMWRITE_JPEG_QUALITY, config_.jpeg_quality})) {
+                fail(*shared, "JPEG encoding failed");
+                return;
+            }
+            snapshot.width = static_cast<uint32_t>(image.cols);
+            snapshot.height = static_cast<uint32_t>(image.rows);
+            snapshot.sequence = frame->getSequenceNum();
+            snapshot.captured = frame->getTimestamp();
+            complete(std::move(*shared), std::move(snapshot));
+        } catch (const std::exception& e) {
+            fail(*shared, std::string("JPEG encoding failed: ") + e.what());
+        }
+    });
+
+    if (!pool_) {
+        task();
+    } else if (!pool_->submit(kSnapshotStream, std::move(task))) {
+        fail(*shared, "snapshot encoder backlog full");
+    }
+}
+
+void SnapshotService::complete(Pending pending, Snapshot snapshot) {
+    snapshot.latency_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - pending.requested).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.completed++;
+        stats_.mean_latency_ms += (snapshot.latency_ms - stats_.mean_latency_ms) / static_cast<double>(stats_.completed);
+        stats_.max_latency_ms = std::max(stats_.max_latency_ms, snapshot.latency_ms);
+    }
+    pending.promise.set_value(std::move(snapshot));
+}
+
+void SnapshotService::fail(Pending& pending, const std::string& reason) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.failed++;
+    }
+    pending.promise.set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+}
+
+void SnapshotService::cancelAll(const std::string& reason) {
+    std::deque<Pending> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled.swap(pending_);
+    }
+    for (auto& pending : cancelled) {
+        fail(pending, reason);
+    }
+    queue_.reset();
+}
+
+SnapshotStats SnapshotService::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace oak
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <depthai/depthai.hpp>
+#include "Types.h"
+#include "StreamQueue.h"
+#include "TaskPool.h"
+#include "SimulatedSource.h"
+
+namespace oak {
+
+struct Snapshot {
+    std::vector<uint8_t> jpeg;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int64_t sequence = -1;
+    std::chrono::steady_clock::time_point captured;  // Capture time on the host clock
+    double latency_ms = 0.0;             // From request to JPEG ready
+};
+
+struct SnapshotStats {
+    uint64_t requested = 0;
+    uint64_t completed = 0;
+    uint64_t failed = 0;                 // Timed out, cancelled or encoding failed
+    double mean_latency_ms = 0.0;
+    double max_latency_ms = 0.0;
+};
+
+// Full-resolution stills from the camera of the running pipeline, without
+// restarting it.
+//
+// The pipeline gets a full-resolution output from the primary camera that
+// runs into a Script node; the script drops every frame unless the host
+// has sent a trigger, in which case the next frame goes on to an MJPEG
+// encoder (or, with encode_on_device off, straight to the host, where the
+// JPEG is encoded on the task pool). The active module's streams are not
+// touched, and a still is normally ready a couple of frames after the
+// request.
+//
+// Each request returns a future; results are matched to requests in order.
+// Requests fail with an exception on timeout, when the pipeline stops, or
+// when too many are outstanding.
+class SnapshotService {
+public:
+    SnapshotService(const SnapshotConfig& config, std::shared_ptr<TaskPool> pool);
+    ~SnapshotService();
+
+    SnapshotService(const SnapshotService&) = delete;
+    SnapshotService& operator=(const SnapshotService&) = delete;
+
+    // Adds the still branch; call before the pipeline starts
+    void configure(dai::Pipeline& pipeline, dai::node::Camera& camera);
+    // Device-less: stills come from the simulated source and are encoded on the host
+    void configureSimulated(SimulatedSource& source);
+
+    std::future<Snapshot> request();
+
+    // Processing thread: collects stills and expires old requests
+    void poll();
+
+    // Fails every outstanding request, e.g. when the pipeline stops
+    void cancelAll(const std::string& reason);
+
+    SnapshotStats getStats() const;
+
+private:
+    struct Pending {
+        std::promise<Snapshot> promise;
+        std::chrono::steady_clock::time_point requested;
+    };
+
+    void complete(Pending pending, Snapshot snapshot);
+    void fail(Pending& pending, const std::string& reason);
+    void encodeOnHost(Pending pending, std::shared_ptr<dai::ImgFrame> frame);
+
+    SnapshotConfig config_;
+    std::shared_ptr<TaskPool> pool_;
+    StreamQueue queue_;
+    bool device_jpeg_ = false;
+
+    // Exactly one of these delivers triggers
+    std::shared_ptr<dai::InputQueue> trigger_queue_;
+    SimulatedSource* simulated_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::deque<Pending> pending_;
+    SnapshotStats stats_;
+};
+
+} // namespace oak
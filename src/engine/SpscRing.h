@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+namespace oak {
+
+// Bounded single-producer/single-consumer ring buffer.
+// Lock-free: the producer only writes tail_, the consumer only writes head_.
+// Capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity = 16) {
+        size_t cap = 2;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side. Returns false when full.
+    bool tryPush(T value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns nullptr when empty.
+    T* front() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    // Consumer side. Returns false when empty.
+    bool tryPop(T& out) {
+        T* slot = front();
+        if (!slot) {
+            return false;
+        }
+        out = std::move(*slot);
+        pop();
+        return true;
+    }
+
+    // Consumer side. Discards the front element (must not be empty).
+    void pop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        slots_[head & mask_] = T{};
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t capacity() const { return mask_ + 1; }
+    bool empty() const { return size() == 0; }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+} // namespace oak
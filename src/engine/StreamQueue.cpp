@@ -0,0 +1,120 @@
+#include "StreamQueue.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace oak {
+
+StreamQueue::StreamQueue(std::string name, const QueueConfig& config)
+    : name_(std::move(name)),
+      config_(config),
+      trace_get_name_(Tracer::intern(name_ + " tryGet")),
+      trace_transit_name_(Tracer::intern(name_ + " device->host")) {
+    if (config_.depth == 0) {
+        config_.depth = 1;
+    }
+    stats_.name = name_;
+    stats_.config = config_;
+}
+
+void StreamQueue::open(dai::Node::Output& output) {
+    queue_ = output.createOutputQueue(config_.depth, config_.blocking);
+
+    std::cout << "Queue '" << name_ << "': depth " << config_.depth
+              << (config_.blocking ? ", blocking, " : ", non-blocking, ")
+              << queuePolicyToString(config_.policy) << std::endl;
+}
+
+void StreamQueue::open(std::shared_ptr<dai::MessageQueue> queue) {
+    queue_ = std::move(queue);
+
+    std::cout << "Queue '" << name_ << "': simulated, "
+              << queuePolicyToString(config_.policy) << std::endl;
+}
+
+void StreamQueue::reset() {
+    queue_.reset();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The pause until the next run is not an interval
+    last_delivery_ = {};
+    if (stats_.gap_dropped > 0 || stats_.drained > 0) {
+        std::cout << "Queue '" << name_ << "': " << stats_.delivered << " delivered, "
+                  << stats_.gap_dropped << " lost in sequence gaps, "
+                  << stats_.drained << " drained" << std::endl;
+    }
+}
+
+void StreamQueue::setSequenceStride(int64_t stride, int64_t parts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sequence_stride_ = std::max<int64_t>(stride, 1);
+    sequence_parts_ = std::max<int64_t>(parts, 0);
+}
+
+QueueStats StreamQueue::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void StreamQueue::observeLocked(int64_t seq, bool drained, size_t bytes) {
+    ++stats_.received;
+    stats_.received_bytes += bytes;
+    // With a variable number of parts per frame a gap says nothing
+    bool count_gaps = sequence_stride_ <= 1 || sequence_parts_ > 0;
+    if (sequence_stride_ > 1 && sequence_parts_ > 0) {
+        seq = seq / sequence_stride_ * sequence_parts_ + seq % sequence_stride_;
+    }
+
+    // Sequence numbers only move forward within a pipeline run; a restart
+    // (seq going backwards) is not a drop.
+    if (count_gaps && stats_.last_seq >= 0 && seq > stats_.last_seq + 1) {
+        int64_t gap = seq - stats_.last_seq - 1;
+        stats_.gap_dropped += static_cast<uint64_t>(gap);
+        recordDropLocked(DropReason::SEQUENCE_GAP, stats_.last_seq + 1, gap);
+    }
+    stats_.last_seq = seq;
+
+    if (drained) {
+        ++stats_.drained;
+        recordDropLocked(DropReason::DRAINED, seq, 1);
+    }
+}
+
+void StreamQueue::deliverLocked() {
+    ++stats_.delivered;
+
+    auto now = std::chrono::steady_clock::now();
+    if (last_delivery_ != std::chrono::steady_clock::time_point{}) {
+        double interval = std::chrono::duration<double, std::milli>(now - last_delivery_).count();
+        ++stats_.intervals;
+        double delta = interval - stats_.interval_mean_ms;
+        stats_.interval_mean_ms += delta / static_cast<double>(stats_.intervals);
+        interval_m2_ += delta * (interval - stats_.interval_mean_ms);
+        stats_.interval_jitter_ms = std::sqrt(interval_m2_ / static_cast<double>(stats_.intervals));
+        stats_.interval_max_ms = std::max(stats_.interval_max_ms, interval);
+    }
+    last_delivery_ = now;
+}
+
+void StreamQueue::recordDropLocked(DropReason reason, int64_t first_seq, int64_t gap) {
+    if (config_.drop_log_capacity == 0) {
+        return;
+    }
+
+    // Coalesce consecutive drains into a single event
+    if (!stats_.recent_drops.empty()) {
+        auto& last = stats_.recent_drops.back();
+        if (last.reason == reason && last.first_seq + last.gap == first_seq) {
+            last.gap += gap;
+            last.when = std::chrono::steady_clock::now();
+            return;
+        }
+    }
+
+    stats_.recent_drops.push_back({reason, first_seq, gap, std::chrono::steady_clock::now()});
+    while (stats_.recent_drops.size() > config_.drop_log_capacity) {
+        stats_.recent_drops.pop_front();
+    }
+}
+
+} // namespace oak
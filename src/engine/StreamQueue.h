@@ -0,0 +1,134 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <depthai/depthai.hpp>
+#include "Types.h"
+#include "Trace.h"
+
+namespace oak {
+
+enum class DropReason {
+    SEQUENCE_GAP,  // Never reached the host (device or queue overflow)
+    DRAINED        // Received but skipped by a LATEST_ONLY queue
+};
+
+struct DropEvent {
+    DropReason reason;
+    int64_t first_seq;     // First missing/skipped sequence number
+    int64_t gap;           // Number of consecutive messages lost
+    std::chrono::steady_clock::time_point when;
+};
+
+struct QueueStats {
+    std::string name;
+    QueueConfig config;
+    uint64_t received = 0;      // Messages pulled from the queue
+    uint64_t delivered = 0;     // Messages handed to the module
+    uint64_t gap_dropped = 0;   // Messages missing from the sequence
+    uint64_t drained = 0;       // Messages skipped by LATEST_ONLY
+    uint64_t received_bytes = 0;  // Payload of received messages (what crossed the link)
+    int64_t last_seq = -1;
+    // Host-side spacing between delivered messages; the jitter shows how
+    // regularly the processing thread gets to run
+    uint64_t intervals = 0;
+    double interval_mean_ms = 0.0;
+    double interval_jitter_ms = 0.0;    // Standard deviation
+    double interval_max_ms = 0.0;
+    std::deque<DropEvent> recent_drops;  // Bounded by config.drop_log_capacity
+};
+
+// Wraps a host-side output queue with a QoS policy and drop accounting.
+// Drops are detected from gaps in the message sequence numbers, so they are
+// recorded even when the underlying queue overwrites messages silently.
+class StreamQueue {
+public:
+    StreamQueue(std::string name, const QueueConfig& config);
+
+    // Create the underlying queue on a node output (before pipeline start)
+    void open(dai::Node::Output& output);
+    // Read from a host-fed queue instead (simulated source)
+    void open(std::shared_ptr<dai::MessageQueue> queue);
+    void reset();
+    bool isOpen() const { return queue_ != nullptr; }
+
+    // For messages numbered frame * stride + part with `parts` per frame
+    // (tiled detections): gaps are then counted in missing parts. parts = 0
+    // when the count varies per frame (per-object crops): no gaps are counted.
+    void setSequenceStride(int64_t stride, int64_t parts);
+
+    // Returns the next message according to the policy, or nullptr if none
+    template <typename T>
+    std::shared_ptr<T> next() {
+        if (!queue_) {
+            return nullptr;
+        }
+
+        // Only polls that return a message are traced
+        TraceSpan span(trace_get_name_, "queue");
+
+        std::shared_ptr<T> message;
+        if (config_.policy == QueuePolicy::LATEST_ONLY) {
+            // Drained one by one rather than with tryGetAll(), which would
+            // allocate a vector on every poll
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (auto newer = queue_->tryGet<T>()) {
+                if (message) {
+                    observeLocked(message->getSequenceNum(), true, message->getData().size());
+                }
+                message = std::move(newer);
+            }
+            if (!message) {
+                span.cancel();
+                return nullptr;
+            }
+            observeLocked(message->getSequenceNum(), false, message->getData().size());
+            deliverLocked();
+        } else {
+            message = queue_->tryGet<T>();
+            if (!message) {
+                span.cancel();
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            observeLocked(message->getSequenceNum(), false, message->getData().size());
+            deliverLocked();
+        }
+
+        span.setSequence(message->getSequenceNum());
+        if (Tracer::enabled()) {
+            // Capture to host arrival: device processing plus link transfer
+            Tracer::record(trace_transit_name_, "device", Tracer::toNs(message->getTimestamp()),
+                           Tracer::nowNs(), message->getSequenceNum());
+        }
+        return message;
+    }
+
+    const std::string& getName() const { return name_; }
+    const QueueConfig& getConfig() const { return config_; }
+    QueueStats getStats() const;
+
+private:
+    void observeLocked(int64_t seq, bool drained, size_t bytes);
+    void deliverLocked();
+    void recordDropLocked(DropReason reason, int64_t first_seq, int64_t gap);
+
+    std::string name_;
+    QueueConfig config_;
+    std::shared_ptr<dai::MessageQueue> queue_;
+    const char* trace_get_name_;
+    const char* trace_transit_name_;
+
+    mutable std::mutex mutex_;
+    QueueStats stats_;
+    std::chrono::steady_clock::time_point last_delivery_{};
+    double interval_m2_ = 0.0;          // Welford sum of squared deviations
+    int64_t sequence_stride_ = 1;
+    int64_t sequence_parts_ = 1;
+};
+
+} // namespace oak
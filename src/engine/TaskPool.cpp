@@ -0,0 +1,334 @@
+#include "TaskPool.h"
+#include "ThreadTuning.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace oak {
+
+namespace {
+
+// Identifies the pool and worker the current thread belongs to
+thread_local const TaskPool* tls_pool = nullptr;
+thread_local size_t tls_worker = 0;
+
+// Tasks a strand runs before yielding its worker to other streams
+constexpr int kStrandBurst = 8;
+
+} // namespace
+
+TaskPool::TaskPool(uint32_t threads, uint32_t max_stream_backlog, const ThreadOptions& thread_options)
+    : max_stream_backlog_(std::max(max_stream_backlog, 1u)),
+      thread_options_(thread_options) {
+    if (threads == 0) {
+        // Leave one core for the processing thread
+        uint32_t cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    thread_count_ = threads;
+}
+
+TaskPool::~TaskPool() {
+    stop();
+}
+
+void TaskPool::start() {
+    if (!workers_.empty()) {
+        return;
+    }
+
+    stopping_ = false;
+    for (uint32_t i = 0; i < thread_count_; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    accepting_ = true;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&TaskPool::workerLoop, this, i);
+    }
+    std::cout << "Task pool started: " << thread_count_ << " workers" << std::endl;
+}
+
+void TaskPool::stop() {
+    if (workers_.empty()) {
+        return;
+    }
+
+    accepting_ = false;
+    waitIdle();
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    workers_.clear();
+
+    std::lock_guard<std::mutex> lock(strands_mutex_);
+    strands_.clear();
+}
+
+bool TaskPool::submit(Task task) {
+    if (!accepting_ || !task) {
+        return false;
+    }
+    in_flight_.fetch_add(1);
+    push({std::move(task), nullptr});
+    return true;
+}
+
+bool TaskPool::submit(uint64_t stream, Task task) {
+    if (!accepting_ || !task) {
+        return false;
+    }
+
+    std::shared_ptr<Strand> strand;
+    {
+        std::lock_guard<std::mutex> lock(strands_mutex_);
+        auto& slot = strands_[stream];
+        if (!slot) {
+            slot = std::make_shared<Strand>();
+            slot->tasks.reserve(max_stream_backlog_);
+        }
+        strand = slot;
+    }
+
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        if (strand->tasks.size() >= max_stream_backlog_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        in_flight_.fetch_add(1);
+        strand->tasks.push_back(std::move(task));
+        if (!strand->scheduled) {
+            strand->scheduled = true;
+            schedule = true;
+        }
+    }
+
+    if (schedule) {
+        in_flight_.fetch_add(1);
+        push({nullptr, std::move(strand)});
+    }
+    return true;
+}
+
+void TaskPool::push(Entry entry, bool to_front) {
+    size_t target = tls_pool == this ? tls_worker
+                                     : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+        if (to_front) {
+            workers_[target]->tasks.push_front(std::move(entry));
+        } else {
+            workers_[target]->tasks.push_back(std::move(entry));
+        }
+    }
+    queued_.fetch_add(1);
+
+    // A sleeping worker re-checks queued_ under wake_mutex_ before waiting,
+    // so taking the lock here cannot miss it
+    if (sleeping_.load() > 0) {
+        { std::lock_guard<std::mutex> lock(wake_mutex_); }
+        wake_cv_.notify_one();
+    }
+}
+
+bool TaskPool::popLocal(size_t index, Entry& entry) {
+    auto& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    entry = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool TaskPool::steal(size_t index, Entry& entry) {
+    size_t count = workers_.size();
+    for (size_t offset = 1; offset < count; ++offset) {
+        auto& victim = *workers_[(index + offset) % count];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        entry = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        stolen_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void TaskPool::execute(Task& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "Task pool task failed: " << e.what() << std::endl;
+    }
+    task = nullptr;
+    workers_[tls_worker]->executed.fetch_add(1, std::memory_order_relaxed);
+    finish();
+}
+
+void TaskPool::finish() {
+    if (in_flight_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cv_.notify_all();
+    }
+}
+
+void TaskPool::runStrand(const std::shared_ptr<Strand>& strand) {
+    for (int i = 0; i < kStrandBurst; ++i) {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(strand->mutex);
+            if (strand->tasks.empty()) {
+                strand->scheduled = false;
+                strand->idle.notify_all();
+                return;
+            }
+            task = std::move(strand->tasks.front());
+            strand->tasks.pop_front();
+        }
+        execute(task);
+    }
+
+    // Still busy: requeue behind this worker's other tasks instead of hogging it
+    in_flight_.fetch_add(1);
+    push({nullptr, strand}, true);
+}
+
+void TaskPool::workerLoop(size_t index) {
+    tls_pool = this;
+    tls_worker = index;
+    configureCurrentThread("oak-pool-" + std::to_string(index), thread_options_);
+
+    Entry entry;
+    while (true) {
+        if (popLocal(index, entry) || steal(index, entry)) {
+            queued_.fetch_sub(1);
+            if (entry.strand) {
+                runStrand(entry.strand);
+                entry.strand.reset();
+                finish();
+            } else {
+                execute(entry.task);
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        if (stopping_) {
+            break;
+        }
+        sleeping_.fetch_add(1);
+        wake_cv_.wait_for(lock, std::chrono::milliseconds(10),
+                          [this] { return queued_.load() > 0 || stopping_.load(); });
+        sleeping_.fetch_sub(1);
+    }
+
+    tls_pool = nullptr;
+}
+
+void TaskPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cv_.wait(lock, [this] { return in_flight_.load() == 0; });
+}
+
+void TaskPool::waitStream(uint64_t stream) {
+    std::shared_ptr<Strand> strand;
+    {
+        std::lock_guard<std::mutex> lock(strands_mutex_);
+        auto it = strands_.find(stream);
+        if (it == strands_.end()) {
+            return;
+        }
+        strand = it->second;
+    }
+    // Tasks submitted while waiting extend the wait; the strand goes idle
+    // only once its queue is empty and its last task has returned
+    std::unique_lock<std::mutex> lock(strand->mutex);
+    strand->idle.wait(lock, [&strand] { return !strand->scheduled; });
+}
+
+TaskPoolStats TaskPool::getStats() const {
+    TaskPoolStats stats;
+    stats.threads = thread_count_;
+    stats.stolen = stolen_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.in_flight = in_flight_.load();
+    for (const auto& worker : workers_) {
+        uint64_t executed = worker->executed.load(std::memory_order_relaxed);
+        stats.executed_per_thread.push_back(executed);
+        stats.executed += executed;
+    }
+    std::lock_guard<std::mutex> lock(strands_mutex_);
+    stats.streams = static_cast<uint32_t>(strands_.size());
+    return stats;
+}
+
+TaskPoolStress stressTaskPool(uint32_t threads, uint32_t streams, uint32_t tasks_per_stream) {
+    struct StreamState {
+        std::atomic<int> running{0};
+        std::atomic<int64_t> last{-1};
+    };
+    std::vector<StreamState> states(std::max(streams, 1u));
+    std::atomic<uint64_t> order_violations{0};
+    std::atomic<uint64_t> overlap_violations{0};
+    std::atomic<uint64_t> executed{0};
+
+    TaskPoolStress result;
+    TaskPool pool(threads, 64);
+    pool.start();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < tasks_per_stream; ++i) {
+        for (size_t s = 0; s < states.size(); ++s) {
+            StreamState* state = &states[s];
+            int64_t index = i;
+            auto task = [state, index, &order_violations, &overlap_violations, &executed] {
+                if (state->running.fetch_add(1) != 0) {
+                    overlap_violations.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (state->last.exchange(index, std::memory_order_relaxed) != index - 1) {
+                    order_violations.fetch_add(1, std::memory_order_relaxed);
+                }
+                // A little work, so tasks of one stream would overlap if the strand let them
+                volatile uint32_t sink = 0;
+                for (uint32_t k = 0; k < 200; ++k) {
+                    sink = sink + k;
+                }
+                state->running.fetch_sub(1);
+                executed.fetch_add(1, std::memory_order_relaxed);
+            };
+            // Backlogs are bounded: wait for room rather than lose tasks
+            while (!pool.submit(s + 1, task)) {
+                ++result.retries;
+                std::this_thread::yield();
+            }
+        }
+    }
+    pool.waitIdle();
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.stolen = pool.getStats().stolen;
+    pool.stop();
+
+    result.tasks = executed.load();
+    result.order_violations = order_violations.load();
+    result.overlap_violations = overlap_violations.load();
+    if (result.elapsed_ms > 0.0) {
+        result.tasks_per_second = static_cast<double>(result.tasks) * 1000.0 / result.elapsed_ms;
+    }
+    return result;
+}
+
+} // namespace oak
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+#include "Types.h"
+#include "InlineTask.h"
+#include "RingDeque.h"
+
+namespace oak {
+
+struct TaskPoolStats {
+    uint32_t threads = 0;
+    uint64_t executed = 0;
+    uint64_t stolen = 0;                 // Tasks a worker took from another worker's queue
+    uint64_t dropped = 0;                // Rejected because a stream backlog was full
+    int64_t in_flight = 0;               // Submitted and not yet finished
+    uint32_t streams = 0;
+    std::vector<uint64_t> executed_per_thread;
+};
+
+// Outcome of stressTaskPool()
+struct TaskPoolStress {
+    uint64_t tasks = 0;                  // Executed
+    uint64_t retries = 0;                // Submissions refused by a full backlog, then retried
+    uint64_t order_violations = 0;       // A task ran before an earlier one of its stream
+    uint64_t overlap_violations = 0;     // Two tasks of one stream ran at the same time
+    uint64_t stolen = 0;
+    double elapsed_ms = 0.0;
+    double tasks_per_second = 0.0;
+};
+
+// Submits tasks_per_stream short tasks to each of `streams` streams,
+// round-robin from one thread, on a pool of `threads` workers, and checks
+// that every stream ran its tasks in order and one at a time
+TaskPoolStress stressTaskPool(uint32_t threads, uint32_t streams, uint32_t tasks_per_stream);
+
+// Work-stealing thread pool for host-side per-frame work.
+//
+// Each worker has its own deque: it runs its newest task first and, when
+// empty, steals the oldest task of another worker. Tasks submitted from a
+// worker stay on that worker; tasks from other threads are spread round-robin.
+//
+// Tasks submitted with a stream id run in submission order and never
+// concurrently with each other (a strand), while different streams run in
+// parallel. Stream ids are global to the pool: engine services use tagged
+// constants below 2^32 and modules tag theirs (ModuleBase::poolStream).
+// Each stream holds at most max_stream_backlog waiting tasks; beyond that
+// submit() drops the task and returns false, so a slow consumer can never
+// stall the producer.
+//
+// Tasks are stored inline and queues keep their storage, so submitting and
+// running typical per-frame tasks does not allocate once the pool is warm.
+class TaskPool {
+public:
+    using Task = InlineTask<64>;
+
+    explicit TaskPool(uint32_t threads = 0, uint32_t max_stream_backlog = 64,
+                      const ThreadOptions& thread_options = ThreadOptions{});
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    void start();
+    // Rejects new work, finishes everything queued, then joins the workers
+    void stop();
+
+    // Unordered task
+    bool submit(Task task);
+    // Ordered within stream
+    bool submit(uint64_t stream, Task task);
+
+    // Block until every submitted task has finished
+    void waitIdle();
+    // Block until the tasks submitted to `stream` so far have finished; not
+    // from a task of that stream
+    void waitStream(uint64_t stream);
+
+    uint32_t size() const { return static_cast<uint32_t>(workers_.size()); }
+    TaskPoolStats getStats() const;
+
+private:
+    struct Strand;
+
+    // A queued unit of work: either a plain task or a turn of a strand
+    struct Entry {
+        Task task;
+        std::shared_ptr<Strand> strand;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        RingDeque<Entry> tasks{64};
+        std::thread thread;
+        std::atomic<uint64_t> executed{0};
+    };
+
+    struct Strand {
+        std::mutex mutex;
+        RingDeque<Task> tasks;
+        bool scheduled = false;          // A runner for this strand is queued or running
+        std::condition_variable idle;    // Signalled when scheduled turns false
+    };
+
+    void push(Entry entry, bool to_front = false);
+    bool popLocal(size_t index, Entry& entry);
+    bool steal(size_t index, Entry& entry);
+    void execute(Task& task);
+    void finish();
+    void runStrand(const std::shared_ptr<Strand>& strand);
+    void workerLoop(size_t index);
+
+    uint32_t thread_count_;
+    uint32_t max_stream_backlog_;
+    ThreadOptions thread_options_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> accepting_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<size_t> next_worker_{0};
+
+    std::atomic<int64_t> queued_{0};     // Tasks in worker deques
+    std::atomic<int64_t> in_flight_{0};  // Queued, in strands, or running
+    std::atomic<uint32_t> sleeping_{0};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+
+    mutable std::mutex strands_mutex_;
+    std::map<uint64_t, std::shared_ptr<Strand>> strands_;
+
+    std::atomic<uint64_t> stolen_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace oak
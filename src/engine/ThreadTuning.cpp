@@ -0,0 +1,195 @@
+#include "ThreadTuning.h"
+#include "SampleStats.h"
+#include "Trace.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace oak {
+
+namespace {
+
+void warn(const std::string& name, const std::string& what, int error) {
+    std::cerr << "Thread " << name << ": " << what << " failed";
+    if (error != 0) {
+        std::cerr << " (" << std::strerror(error) << ")";
+    }
+    std::cerr << std::endl;
+}
+
+bool setName(const std::string& name) {
+#if defined(__linux__)
+    // The kernel limit is 16 bytes including the terminator
+    return pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()) == 0;
+#elif defined(__APPLE__)
+    return pthread_setname_np(name.c_str()) == 0;
+#elif defined(_WIN32)
+    std::wstring wide(name.begin(), name.end());
+    return SUCCEEDED(SetThreadDescription(GetCurrentThread(), wide.c_str()));
+#else
+    (void)name;
+    return true;
+#endif
+}
+
+bool setAffinity(const std::string& name, const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return true;
+    }
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        warn(name, "CPU affinity", result);
+        return false;
+    }
+    return true;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+    if (mask == 0 || SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+        warn(name, "CPU affinity", 0);
+        return false;
+    }
+    return true;
+#else
+    // macOS only offers affinity hints through thread_policy_set
+    warn(name, "CPU affinity (unsupported on this platform)", 0);
+    return false;
+#endif
+}
+
+bool setRealtime(const std::string& name, int priority) {
+#if defined(_WIN32)
+    (void)priority;
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        warn(name, "real-time priority", 0);
+        return false;
+    }
+    return true;
+#else
+    sched_param param{};
+    param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO),
+                                      sched_get_priority_max(SCHED_FIFO));
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0) {
+        warn(name, "SCHED_FIFO", result);
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool setNice(const std::string& name, int nice) {
+    nice = std::clamp(nice, -20, 19);
+#if defined(__linux__)
+    // On Linux the nice value is per thread when addressed by tid
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) != 0) {
+        warn(name, "nice " + std::to_string(nice), errno);
+        return false;
+    }
+    return true;
+#elif defined(_WIN32)
+    // Map the nice range onto the thread priority levels
+    int priority = nice <= -15 ? THREAD_PRIORITY_HIGHEST
+                 : nice < 0    ? THREAD_PRIORITY_ABOVE_NORMAL
+                 : nice == 0   ? THREAD_PRIORITY_NORMAL
+                 : nice < 15   ? THREAD_PRIORITY_BELOW_NORMAL
+                               : THREAD_PRIORITY_LOWEST;
+    if (!SetThreadPriority(GetCurrentThread(), priority)) {
+        warn(name, "thread priority", 0);
+        return false;
+    }
+    return true;
+#else
+    warn(name, "per-thread nice (unsupported on this platform)", 0);
+    return false;
+#endif
+}
+
+} // namespace
+
+bool configureCurrentThread(const std::string& name, const ThreadOptions& options) {
+    Tracer::setThreadName(name);
+
+    bool ok = setName(name);
+    if (!ok) {
+        warn(name, "naming", 0);
+    }
+    ok = setAffinity(name, options.cpus) && ok;
+    if (options.realtime) {
+        ok = setRealtime(name, options.realtime_priority) && ok;
+    } else if (options.nice) {
+        ok = setNice(name, *options.nice) && ok;
+    }
+    return ok;
+}
+
+JitterStats measureWakeupJitter(const ThreadOptions& options,
+                                std::chrono::milliseconds duration,
+                                std::chrono::microseconds period) {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<double> lateness;
+    lateness.reserve(static_cast<size_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration).count() /
+        std::max<int64_t>(period.count(), 1)) + 1);
+
+    std::thread probe([&] {
+        configureCurrentThread("oak-jitter", options);
+
+        auto end = Clock::now() + duration;
+        auto next = Clock::now() + period;
+        while (next < end) {
+            std::this_thread::sleep_until(next);
+            auto woke = Clock::now();
+            lateness.push_back(std::chrono::duration<double, std::micro>(woke - next).count());
+            next += period;
+            // Skip periods missed entirely instead of firing a burst to catch up
+            while (next <= woke) {
+                next += period;
+            }
+        }
+    });
+    probe.join();
+
+    SampleSummary summary = summarizeSamples(lateness);
+    JitterStats stats;
+    stats.samples = summary.count;
+    stats.mean_us = summary.mean;
+    stats.p50_us = summary.p50;
+    stats.p99_us = summary.p99;
+    stats.max_us = summary.max;
+    return stats;
+}
+
+} // namespace oak
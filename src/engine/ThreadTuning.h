@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include "Types.h"
+
+namespace oak {
+
+// Wake-up lateness of a periodic thread, in microseconds
+struct JitterStats {
+    uint64_t samples = 0;
+    double mean_us = 0.0;
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+};
+
+// Names the calling thread (OS-visible, truncated to 15 characters on Linux,
+// and in traces) and applies its CPU set and scheduling policy. Each option
+// that cannot be applied, e.g. SCHED_FIFO without CAP_SYS_NICE, is reported
+// on stderr and skipped; returns false if any of them failed.
+bool configureCurrentThread(const std::string& name, const ThreadOptions& options);
+
+// cyclictest-style probe: a thread configured with options sleeps until the
+// next period boundary, over and over, and records how late it woke up.
+// Run once with default options and once with the tuned ones to see the
+// effect of pinning and real-time priority under the current load.
+JitterStats measureWakeupJitter(const ThreadOptions& options,
+                                std::chrono::milliseconds duration,
+                                std::chrono::microseconds period = std::chrono::microseconds(1000));
+
+} // namespace oak
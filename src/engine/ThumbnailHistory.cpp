@@ -0,0 +1,378 @@
+#include "ThumbnailHistory.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace oak {
+
+namespace {
+
+// Task pool streams for host-side JPEG encoding, one per camera so each
+// camera's thumbnails reach the history in capture order
+constexpr uint64_t kThumbnailStream = 0x54484D42;  // "THMB"
+
+// Typical MJPEG payload at thumbnail quality, for the link budget
+constexpr double kJpegBytesPerPixel = 0.2;
+
+} // namespace
+
+cv::Mat decodeThumbnail(const Thumbnail& thumbnail) {
+    if (thumbnail.data.empty()) {
+        return {};
+    }
+    if (thumbnail.format == ThumbnailFormat::JPEG) {
+        return cv::imdecode(thumbnail.data, cv::IMREAD_COLOR);
+    }
+    size_t expected = static_cast<size_t>(thumbnail.width) * thumbnail.height * 3 / 2;
+    if (thumbnail.data.size() < expected) {
+        return {};
+    }
+    cv::Mat nv12(static_cast<int>(thumbnail.height * 3 / 2), static_cast<int>(thumbnail.width), CV_8UC1,
+                 const_cast<uint8_t*>(thumbnail.data.data()));
+    cv::Mat bgr;
+    cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+    return bgr;
+}
+
+ThumbnailHistory::ThumbnailHistory(const ThumbnailConfig& config, std::shared_ptr<TaskPool> pool)
+    : config_(config),
+      pool_(std::move(pool)),
+      arena_(static_cast<size_t>(config.memory_budget_kb) * 1024),
+      order_(std::max<uint32_t>(config.max_frames, 1)) {
+    config_.max_frames = std::max<uint32_t>(config_.max_frames, 1);
+    if (config_.fps > 0.0f) {
+        // Slack for device timestamp jitter around the nominal period
+        min_interval_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(0.8 / config_.fps));
+    }
+    stats_.budget_bytes = arena_.size();
+}
+
+ThumbnailHistory::~ThumbnailHistory() {
+    detach();
+}
+
+void ThumbnailHistory::configure(dai::Pipeline& pipeline, const CameraNodes& cameras,
+                                 dai::CameraBoardSocket primary) {
+    detach();
+    bool device_jpeg = config_.format == ThumbnailFormat::JPEG && config_.encode_on_device;
+
+    for (const auto& [socket, camera] : cameras) {
+        if (!config_.all_cameras && socket != primary) {
+            continue;
+        }
+        // Stretched rather than cropped: a thumbnail shows the whole field of view
+        auto* output = camera->requestOutput({config_.width, config_.height}, dai::ImgFrame::Type::NV12,
+                                             dai::ImgResizeMode::STRETCH, config_.fps);
+        if (device_jpeg) {
+            auto encoder = pipeline.create<dai::node::VideoEncoder>();
+            encoder->setDefaultProfilePreset(config_.fps, dai::VideoEncoderProperties::Profile::MJPEG);
+            encoder->setQuality(config_.jpeg_quality);
+            output->link(encoder->input);
+            addSource(cameraSocketToString(socket), true, &encoder->out, nullptr);
+        } else {
+            addSource(cameraSocketToString(socket), false, output, nullptr);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        primary_ = cameraSocketToString(primary);
+    }
+    const char* format = config_.format == ThumbnailFormat::NV12 ? "NV12"
+                         : (device_jpeg ? "JPEG on the device" : "JPEG on the host");
+    std::cout << "Thumbnails: " << config_.width << "x" << config_.height << " @ " << config_.fps << " fps, "
+              << format << ", " << config_.memory_budget_kb / 1024 << " MiB history" << std::endl;
+}
+
+std::vector<StreamDemand> ThumbnailHistory::getStreamDemands(
+    const std::vector<dai::CameraBoardSocket>& sockets) const {
+    // Same primary as the engine picks: CAM_A if opened, else the lowest socket
+    dai::CameraBoardSocket primary = *std::min_element(sockets.begin(), sockets.end());
+    if (std::find(sockets.begin(), sockets.end(), dai::CameraBoardSocket::CAM_A) != sockets.end()) {
+        primary = dai::CameraBoardSocket::CAM_A;
+    }
+    bool device_jpeg = config_.format == ThumbnailFormat::JPEG && config_.encode_on_device;
+
+    std::vector<StreamDemand> demands;
+    for (auto socket : sockets) {
+        if (!config_.all_cameras && socket != primary) {
+            continue;
+        }
+        StreamDemand demand;
+        demand.name = "thumbnail_" + cameraSocketToString(socket);
+        demand.priority = 100;
+        if (device_jpeg) {
+            demand.fixed_mbps = static_cast<double>(config_.width) * config_.height * config_.fps *
+                                kJpegBytesPerPixel * 8.0 / 1e6;
+        } else {
+            // Raw NV12 crosses the link (host JPEG encodes after it)
+            demand.width = config_.width;
+            demand.height = config_.height;
+            demand.fps = config_.fps;
+            demand.bytes_per_pixel = 1.5f;
+        }
+        demands.push_back(std::move(demand));
+    }
+    return demands;
+}
+
+void ThumbnailHistory::configureSimulated(SimulatedSource& source) {
+    detach();
+    std::string name = cameraSocketToString(dai::CameraBoardSocket::CAM_A);
+    auto queue = source.addFrameOutput("thumbnails", config_.width, config_.height,
+                                       QueueConfig{4, false, QueuePolicy::LATEST_ONLY}, dai::ImgFrame::Type::NV12);
+    addSource(name, false, nullptr, std::move(queue));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    primary_ = name;
+}
+
+void ThumbnailHistory::addSource(const std::string& name, bool encoded, dai::Node::Output* output,
+                                 std::shared_ptr<dai::MessageQueue> simulated) {
+    Source source;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        source.stream = streamLocked(name);
+    }
+    source.encoded = encoded;
+    source.queue = std::make_unique<StreamQueue>("thumbnail_" + name, QueueConfig{4, false, QueuePolicy::LOSSLESS});
+    if (output) {
+        source.queue->open(*output);
+    } else {
+        source.queue->open(std::move(simulated));
+    }
+    sources_.push_back(std::move(source));
+}
+
+void ThumbnailHistory::detach() {
+    for (auto& source : sources_) {
+        source.queue->reset();
+    }
+    sources_.clear();
+}
+
+size_t ThumbnailHistory::streamLocked(const std::string& name) {
+    for (size_t i = 0; i < streams_.size(); ++i) {
+        if (streams_[i]->name == name) {
+            return i;
+        }
+    }
+    auto stream = std::make_unique<Stream>();
+    stream->name = name;
+    stream->index.reserve(config_.max_frames);
+    streams_.push_back(std::move(stream));
+    return streams_.size() - 1;
+}
+
+void ThumbnailHistory::poll() {
+    for (auto& source : sources_) {
+        if (source.encoded) {
+            while (auto encoded = source.queue->next<dai::EncodedFrame>()) {
+                if (!accept(source.stream, encoded->getTimestamp())) {
+                    continue;
+                }
+                const auto& data = encoded->getData();
+                insert(source.stream, encoded->getTimestamp(), encoded->getSequenceNum(), encoded->getWidth(),
+                       encoded->getHeight(), data.data(), data.size());
+            }
+            continue;
+        }
+
+        while (auto frame = source.queue->next<dai::ImgFrame>()) {
+            if (!accept(source.stream, frame->getTimestamp())) {
+                continue;
+            }
+            if (config_.format == ThumbnailFormat::JPEG) {
+                encodeOnHost(source.stream, std::move(frame));
+            } else {
+                const auto& data = frame->getData();
+                insert(source.stream, frame->getTimestamp(), frame->getSequenceNum(), frame->getWidth(),
+                       frame->getHeight(), data.data(), data.size());
+            }
+        }
+    }
+}
+
+bool ThumbnailHistory::accept(size_t stream, std::chrono::steady_clock::time_point timestamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stream& target = *streams_[stream];
+    if (target.last_kept.time_since_epoch().count() != 0 && timestamp < target.last_kept + min_interval_) {
+        stats_.skipped++;
+        return false;
+    }
+    target.last_kept = timestamp;
+    return true;
+}
+
+void ThumbnailHistory::encodeOnHost(size_t stream, std::shared_ptr<dai::ImgFrame> frame) {
+    TaskPool::Task task([this, stream, frame] {
+        TraceSpan span("thumbnail_encode", "thumbnails", frame->getSequenceNum());
+        try {
+            // Per worker, so encoding does not allocate once warm
+            thread_local std::vector<uint8_t> jpeg;
+            cv::Mat image = frame->getCvFrame();  // NV12 is converted to BGR here
+            if (!cv::imencode(".jpg", image, jpeg, {cv::IMWRITE_JPEG_QUALITY, config_.jpeg_quality})) {
+                std::cerr << "Thumbnail JPEG encoding failed" << std::endl;
+                return;
+            }
+            insert(stream, frame->getTimestamp(), frame->getSequenceNum(), static_cast<uint32_t>(image.cols),
+                   static_cast<uint32_t>(image.rows), jpeg.data(), jpeg.size());
+        } catch (const std::exception& e) {
+            std::cerr << "Thumbnail JPEG encoding failed: " << e.what() << std::endl;
+        }
+    });
+
+    if (!pool_) {
+        task();
+    } else if (!pool_->submit(kThumbnailStream + stream, std::move(task))) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.skipped++;
+    }
+}
+
+void ThumbnailHistory::insert(size_t stream, std::chrono::steady_clock::time_point timestamp, int64_t sequence,
+                              uint32_t width, uint32_t height, const uint8_t* data, size_t size) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Stream& target = *streams_[stream];
+    // Lookups rely on each index being in timestamp order
+    if (!target.index.empty() && timestamp < target.index.back().timestamp) {
+        stats_.skipped++;
+        return;
+    }
+    if (size == 0 || size > arena_.size()) {
+        stats_.oversized++;
+        return;
+    }
+
+    Entry entry;
+    entry.timestamp = timestamp;
+    entry.sequence = sequence;
+    entry.offset = reserveLocked(size);
+    entry.size = size;
+    entry.width = width;
+    entry.height = height;
+    std::memcpy(arena_.data() + entry.offset, data, size);
+
+    target.index.push_back(entry);
+    order_.push_back(stream);
+    stats_.stored++;
+    stats_.bytes += size;
+    insert_us_total_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t ThumbnailHistory::reserveLocked(size_t size) {
+    while (order_.size() >= config_.max_frames) {
+        evictOldestLocked();
+    }
+
+    // The arena is filled front to back, so the oldest thumbnail is the first
+    // one at or after write_ (or, if none is, the first in the arena)
+    auto oldestOffset = [this] { return streams_[order_.front()]->index.front().offset; };
+
+    if (write_ + size > arena_.size()) {
+        // No room before the end: what is stored there is the oldest, writing restarts at 0
+        while (!order_.empty() && oldestOffset() >= write_) {
+            evictOldestLocked();
+        }
+        write_ = 0;
+    }
+    while (!order_.empty() && oldestOffset() >= write_ && oldestOffset() < write_ + size) {
+        evictOldestLocked();
+    }
+
+    size_t offset = write_;
+    write_ += size;
+    return offset;
+}
+
+void ThumbnailHistory::evictOldestLocked() {
+    Stream& stream = *streams_[order_.front()];
+    stats_.bytes -= stream.index.front().size;
+    stats_.evicted++;
+    stream.index.pop_front();
+    order_.pop_front();
+}
+
+std::optional<Thumbnail> ThumbnailHistory::nearest(std::chrono::steady_clock::time_point time,
+                                                   const std::string& stream) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const std::string& name = stream.empty() ? primary_ : stream;
+    auto found = std::find_if(streams_.begin(), streams_.end(),
+                              [&name](const std::unique_ptr<Stream>& candidate) { return candidate->name == name; });
+    if (found == streams_.end() || (*found)->index.empty()) {
+        return std::nullopt;
+    }
+    const RingDeque<Entry>& index = (*found)->index;
+
+    // First thumbnail at or after `time`, then whichever neighbour is closer
+    size_t low = 0;
+    size_t high = index.size();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (index[mid].timestamp < time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    size_t best = low;
+    if (low == index.size() || (low > 0 && time - index[low - 1].timestamp < index[low].timestamp - time)) {
+        best = low - 1;
+    }
+
+    const Entry& entry = index[best];
+    Thumbnail thumbnail;
+    thumbnail.stream = name;
+    thumbnail.format = config_.format;
+    thumbnail.data.assign(arena_.begin() + static_cast<std::ptrdiff_t>(entry.offset),
+                          arena_.begin() + static_cast<std::ptrdiff_t>(entry.offset + entry.size));
+    thumbnail.width = entry.width;
+    thumbnail.height = entry.height;
+    thumbnail.sequence = entry.sequence;
+    thumbnail.timestamp = entry.timestamp;
+    return thumbnail;
+}
+
+std::vector<std::string> ThumbnailHistory::streams() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (const auto& stream : streams_) {
+        names.push_back(stream->name);
+    }
+    return names;
+}
+
+void ThumbnailHistory::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stream : streams_) {
+        stream->index.clear();
+    }
+    order_.clear();
+    write_ = 0;
+    stats_.bytes = 0;
+}
+
+ThumbnailStats ThumbnailHistory::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThumbnailStats stats = stats_;
+    stats.mean_insert_us = stats_.stored > 0 ? insert_us_total_ / static_cast<double>(stats_.stored) : 0.0;
+    for (const auto& stream : streams_) {
+        ThumbnailStreamStats entry;
+        entry.stream = stream->name;
+        entry.frames = static_cast<uint32_t>(stream->index.size());
+        if (!stream->index.empty()) {
+            entry.oldest = stream->index[0].timestamp;
+            entry.newest = stream->index[stream->index.size() - 1].timestamp;
+            entry.span_s = std::chrono::duration<double>(entry.newest - entry.oldest).count();
+        }
+        stats.streams.push_back(entry);
+    }
+    return stats;
+}
+
+} // namespace oak
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <depthai/depthai.hpp>
+#include <opencv2/opencv.hpp>
+#include "Types.h"
+#include "ModuleBase.h"
+#include "RingDeque.h"
+#include "StreamQueue.h"
+#include "TaskPool.h"
+#include "SimulatedSource.h"
+#include "LinkBudget.h"
+
+namespace oak {
+
+struct Thumbnail {
+    std::string stream;                  // Camera socket name, e.g. "CAM_A"
+    ThumbnailFormat format = ThumbnailFormat::JPEG;
+    std::vector<uint8_t> data;           // JPEG, or NV12 (width x height x 1.5 bytes)
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int64_t sequence = -1;
+    std::chrono::steady_clock::time_point timestamp;  // Device capture time on the host clock
+};
+
+// BGR image of a thumbnail; empty if it cannot be decoded
+cv::Mat decodeThumbnail(const Thumbnail& thumbnail);
+
+struct ThumbnailStreamStats {
+    std::string stream;
+    uint32_t frames = 0;                 // In the history right now
+    double span_s = 0.0;                 // Oldest to newest
+    std::chrono::steady_clock::time_point oldest;
+    std::chrono::steady_clock::time_point newest;
+};
+
+struct ThumbnailStats {
+    uint64_t stored = 0;
+    uint64_t evicted = 0;                // Made room for newer thumbnails
+    uint64_t skipped = 0;                // Above the configured fps, or out of order
+    uint64_t oversized = 0;              // Larger than the whole budget
+    uint64_t bytes = 0;                  // In the history right now
+    uint64_t budget_bytes = 0;
+    double mean_insert_us = 0.0;
+    std::vector<ThumbnailStreamStats> streams;
+};
+
+// Bounded, time-indexed history of small frames per camera, for "what did
+// the camera see 10 seconds ago" without a recording.
+//
+// Each pipeline gets a downscaled output per camera at a low frame rate,
+// JPEG-encoded on the device by default (a few KB per frame, a fixed load
+// in the link budget, see getStreamDemands). Thumbnails are copied into one
+// byte arena of memory_budget_kb used as a ring: an insert takes the space
+// after the newest thumbnail and evicts the oldest ones in its way,
+// whatever their camera, so memory stays fixed and inserts cost the same
+// however long the history is. Each camera keeps its own index in timestamp order, which
+// lookups binary-search.
+//
+// The history outlives pipelines: it is kept across module switches and
+// device reconnects, and a camera's entries just show the gap.
+class ThumbnailHistory {
+public:
+    ThumbnailHistory(const ThumbnailConfig& config, std::shared_ptr<TaskPool> pool);
+    ~ThumbnailHistory();
+
+    ThumbnailHistory(const ThumbnailHistory&) = delete;
+    ThumbnailHistory& operator=(const ThumbnailHistory&) = delete;
+
+    // Adds the thumbnail branches of a new pipeline; call before it starts
+    void configure(dai::Pipeline& pipeline, const CameraNodes& cameras, dai::CameraBoardSocket primary);
+    // Link load configure() will add for a pipeline on these cameras (fixed,
+    // never degraded by the link budget)
+    std::vector<StreamDemand> getStreamDemands(const std::vector<dai::CameraBoardSocket>& sockets) const;
+    // Device-less: thumbnails of the simulated source, encoded on the host
+    void configureSimulated(SimulatedSource& source);
+    // Pipeline stopped: closes its queues, keeps the history
+    void detach();
+
+    // Processing thread: moves new thumbnails into the history
+    void poll();
+
+    // Thumbnail closest to `time`; stream empty = the primary camera of the
+    // last pipeline. nullopt if the stream has no thumbnails.
+    std::optional<Thumbnail> nearest(std::chrono::steady_clock::time_point time,
+                                     const std::string& stream = "") const;
+    std::vector<std::string> streams() const;
+    void clear();
+
+    ThumbnailStats getStats() const;
+
+private:
+    // Where one thumbnail lives in the arena
+    struct Entry {
+        std::chrono::steady_clock::time_point timestamp;
+        int64_t sequence = -1;
+        size_t offset = 0;
+        size_t size = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    // Guarded by mutex_
+    struct Stream {
+        std::string name;
+        RingDeque<Entry> index;          // Timestamp order
+        std::chrono::steady_clock::time_point last_kept;
+    };
+
+    // One queue of the current pipeline
+    struct Source {
+        size_t stream = 0;               // Into streams_
+        std::unique_ptr<StreamQueue> queue;
+        bool encoded = false;            // Device JPEG (EncodedFrame) rather than ImgFrame
+    };
+
+    void addSource(const std::string& name, bool encoded, dai::Node::Output* output,
+                   std::shared_ptr<dai::MessageQueue> simulated);
+    size_t streamLocked(const std::string& name);
+    bool accept(size_t stream, std::chrono::steady_clock::time_point timestamp);
+    void insert(size_t stream, std::chrono::steady_clock::time_point timestamp, int64_t sequence,
+                uint32_t width, uint32_t height, const uint8_t* data, size_t size);
+    void encodeOnHost(size_t stream, std::shared_ptr<dai::ImgFrame> frame);
+    size_t reserveLocked(size_t size);
+    void evictOldestLocked();
+
+    ThumbnailConfig config_;
+    std::shared_ptr<TaskPool> pool_;
+    std::vector<Source> sources_;        // Processing thread only
+    std::chrono::steady_clock::duration min_interval_{0};
+
+    mutable std::mutex mutex_;
+    std::vector<uint8_t> arena_;
+    size_t write_ = 0;                   // Where the next thumbnail goes, if it fits before the end
+    RingDeque<size_t> order_;            // Stream of each stored thumbnail, oldest first (arena order)
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::string primary_;
+    ThumbnailStats stats_;
+    double insert_us_total_ = 0.0;
+};
+
+} // namespace oak
@@ -0,0 +1,210 @@
+#include "Trace.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace oak {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    int64_t begin_ns;
+    int64_t end_ns;
+    int64_t seq;
+};
+
+struct ThreadBuffer {
+    std::vector<TraceEvent> events;      // Fixed size, allocated once
+    std::atomic<size_t> count{0};        // Published with release ordering
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> retired{false};    // Owning thread has exited
+    std::string thread_name;             // Guarded by Registry::mutex
+    uint32_t tid = 0;
+};
+
+// Buffers of exited threads are kept so their spans can still be exported;
+// only the most recent ones are retained to bound memory across module switches.
+constexpr size_t kMaxRetiredBuffers = 8;
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::unordered_set<std::string> names;
+    size_t capacity = 1 << 16;
+    uint32_t next_tid = 1;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+void pruneRetiredLocked(Registry& reg) {
+    size_t retired = 0;
+    for (const auto& buffer : reg.buffers) {
+        retired += buffer->retired.load() ? 1 : 0;
+    }
+    for (auto it = reg.buffers.begin(); it != reg.buffers.end() && retired > kMaxRetiredBuffers;) {
+        if ((*it)->retired.load()) {
+            it = reg.buffers.erase(it);
+            --retired;
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Trivially destructible copy of the thread's buffer pointer for the hot path
+thread_local ThreadBuffer* tls_buffer = nullptr;
+
+struct ThreadHandle {
+    std::shared_ptr<ThreadBuffer> buffer;
+    std::string name;
+
+    ~ThreadHandle() {
+        if (buffer) {
+            buffer->retired = true;
+        }
+        tls_buffer = nullptr;
+    }
+};
+
+thread_local ThreadHandle tls_handle;
+
+ThreadBuffer* threadBuffer() {
+    if (tls_buffer) {
+        return tls_buffer;
+    }
+    if (!tls_handle.buffer) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.resize(reg.capacity);
+        buffer->tid = reg.next_tid++;
+        buffer->thread_name = tls_handle.name.empty()
+            ? "thread-" + std::to_string(buffer->tid) : tls_handle.name;
+        pruneRetiredLocked(reg);
+        reg.buffers.push_back(buffer);
+        tls_handle.buffer = buffer;
+    }
+    tls_buffer = tls_handle.buffer.get();
+    return tls_buffer;
+}
+
+void writeJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* p = text ? text : ""; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            out << '\\';
+        }
+        out << *p;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void Tracer::enable(size_t events_per_thread) {
+    {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.capacity = events_per_thread > 0 ? events_per_thread : 1;
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+    std::cout << "Tracing enabled (" << events_per_thread << " spans per thread)" << std::endl;
+}
+
+void Tracer::disable() {
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    tls_handle.name = name;
+    if (tls_handle.buffer) {
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        tls_handle.buffer->thread_name = name;
+    }
+}
+
+const char* Tracer::intern(const std::string& name) {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.names.insert(name).first->c_str();
+}
+
+void Tracer::record(const char* name, const char* category,
+                    int64_t begin_ns, int64_t end_ns, int64_t seq) {
+    ThreadBuffer* buffer = threadBuffer();
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= buffer->events.size()) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[index] = {name, category, begin_ns, end_ns, seq};
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool Tracer::writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    size_t written = 0;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for (const auto& buffer : reg.buffers) {
+        // Thread name metadata
+        out << (first ? "" : ",\n");
+        first = false;
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, buffer->thread_name.c_str());
+        out << "}}";
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& ev = buffer->events[i];
+            out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"name\":";
+            writeJsonString(out, ev.name);
+            out << ",\"cat\":";
+            writeJsonString(out, ev.category);
+            out << ",\"ts\":" << static_cast<double>(ev.begin_ns) / 1000.0
+                << ",\"dur\":" << static_cast<double>(ev.end_ns - ev.begin_ns) / 1000.0;
+            if (ev.seq >= 0) {
+                out << ",\"args\":{\"seq\":" << ev.seq << "}";
+            }
+            out << "}";
+        }
+        written += count;
+    }
+    out << "\n]}\n";
+
+    std::cout << "Trace written: " << path << " (" << written << " spans)" << std::endl;
+    return static_cast<bool>(out);
+}
+
+uint64_t Tracer::droppedEvents() {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : reg.buffers) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+} // namespace oak
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace oak {
+
+// Lightweight span tracer that exports Chrome/Perfetto trace JSON.
+//
+// Each thread records into its own preallocated buffer, so recording a span
+// takes no locks and does not allocate. When tracing is disabled a span costs
+// one predictable branch. Spans beyond a buffer's capacity are counted and
+// dropped rather than overwriting earlier ones.
+class Tracer {
+public:
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // Buffers are allocated lazily per thread with this capacity
+    static void enable(size_t events_per_thread = 1 << 16);
+    static void disable();
+
+    // Names the calling thread in the exported trace
+    static void setThreadName(const std::string& name);
+
+    // Returns a pointer that stays valid for the process lifetime, for span
+    // names built at runtime (string literals can be passed directly)
+    static const char* intern(const std::string& name);
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static int64_t toNs(std::chrono::steady_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+
+    // Records a completed span on the calling thread's buffer
+    static void record(const char* name, const char* category,
+                       int64_t begin_ns, int64_t end_ns, int64_t seq = -1);
+
+    // Writes every recorded span as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+    static bool writeChromeTrace(const std::string& path);
+
+    static uint64_t droppedEvents();
+
+private:
+    inline static std::atomic<bool> enabled_{false};
+};
+
+// RAII span: begins on construction, ends on destruction or end()
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* category = "engine", int64_t seq = -1)
+        : name_(name), category_(category), seq_(seq) {
+        if (Tracer::enabled()) {
+            begin_ns_ = Tracer::nowNs();
+        }
+    }
+
+    ~TraceSpan() { end(); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // Attach the frame sequence number once it is known
+    void setSequence(int64_t seq) { seq_ = seq; }
+
+    // Discard the span (e.g. a poll that found no frame)
+    void cancel() { begin_ns_ = -1; }
+
+    void end() {
+        if (begin_ns_ >= 0) {
+            Tracer::record(name_, category_, begin_ns_, Tracer::nowNs(), seq_);
+            begin_ns_ = -1;
+        }
+    }
+
+private:
+    const char* name_;
+    const char* category_;
+    int64_t seq_;
+    int64_t begin_ns_ = -1;
+};
+
+} // namespace oak
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <cstdint>
 #include <optional>
+#include <depthai/common/CameraBoardSocket.hpp>
 
 namespace oak {
 
@@ -10,7 +12,9 @@ enum class ModuleState {
     IDLE,
     PREVIEW,
     RECORD,
-    INFERENCE
+    INFERENCE,
+    DEPTH,
+    MULTI_CAMERA
 };
 
 enum class ResizeMode {
@@ -19,9 +23,118 @@ enum class ResizeMode {
     LETTERBOX
 };
 
+// Pixel format of colour streams sent to the host. NV12 is 1.5 bytes per
+// pixel instead of 3; frame callbacks then receive NV12 ImgFrames, and BGR
+// is produced on the host only where it is needed (see toBgr() in
+// FrameConvert.h, or ImgFrame::getCvFrame()).
+enum class FrameTransport {
+    BGR,
+    NV12
+};
+
+// How a host-side output queue hands messages to the module
+enum class QueuePolicy {
+    LATEST_ONLY,  // Drain the queue and keep only the newest message (lowest latency)
+    LOSSLESS      // Deliver every queued message in sequence order
+};
+
+// Per-stream queue quality-of-service settings
+// For end-to-end lossless delivery combine LOSSLESS with blocking = true,
+// which back-pressures the device instead of overwriting the oldest message.
+struct QueueConfig {
+    uint32_t depth = 8;
+    bool blocking = false;
+    QueuePolicy policy = QueuePolicy::LATEST_ONLY;
+    uint32_t drop_log_capacity = 256;  // Most recent drop events kept for inspection
+};
+
+// Scheduling for an engine-owned thread (see ThreadTuning.h)
+struct ThreadOptions {
+    std::vector<int> cpus;               // Allowed cores, empty = any
+    bool realtime = false;               // SCHED_FIFO (Linux: needs CAP_SYS_NICE or an rtprio limit)
+    int realtime_priority = 50;          // 1-99, used when realtime
+    std::optional<int> nice;             // -20 (highest) to 19, used when not realtime
+};
+
+// Host-generated frames in place of a device, for soak and load tests (see SimulatedSource.h)
+struct SimulationConfig {
+    bool enabled = false;
+    float fps = 0.0f;                    // 0 = full rate: as fast as the modules drain their queues
+    uint32_t detections_per_frame = 8;
+};
+
+// Full-resolution stills from the running camera (see SnapshotService.h)
+struct SnapshotConfig {
+    bool enabled = false;                // Adds a gated full-resolution branch to every pipeline
+    bool encode_on_device = true;        // MJPEG encoder on the device; otherwise JPEG on the host task pool
+    int jpeg_quality = 95;
+    uint32_t timeout_ms = 2000;          // Requests without a frame by then fail
+    uint32_t max_pending = 8;            // Outstanding requests before new ones fail
+    uint32_t simulated_width = 1920;     // Still size when EngineConfig::simulation is enabled
+    uint32_t simulated_height = 1080;
+};
+
+enum class ThumbnailFormat {
+    JPEG,   // Encoded on the device (MJPEG) or on the host task pool
+    NV12    // Raw 4:2:0, 1.5 bytes per pixel, no encoder involved
+};
+
+// Downscaled frame history for lookback queries (see ThumbnailHistory.h)
+struct ThumbnailConfig {
+    bool enabled = false;
+    uint32_t width = 320;
+    uint32_t height = 180;
+    float fps = 2.0f;                    // Thumbnails kept per second and camera
+    ThumbnailFormat format = ThumbnailFormat::JPEG;
+    bool encode_on_device = true;        // JPEG only: otherwise on the host task pool
+    int jpeg_quality = 70;
+    uint32_t memory_budget_kb = 32768;   // All cameras together; the oldest thumbnails make room
+    uint32_t max_frames = 8192;          // Index capacity, all cameras together
+    bool all_cameras = false;            // Every camera of the pipeline, not only the primary one
+};
+
+// What to do when the requested streams exceed the device link (see LinkBudget.h)
+enum class LinkBudgetPolicy {
+    REPORT,    // Print the plan, start as requested
+    REJECT,    // Refuse to start a module that does not fit
+    DEGRADE    // Lower format, fps, then resolution of low-priority streams until it fits
+};
+
+struct LinkBudgetConfig {
+    LinkBudgetPolicy policy = LinkBudgetPolicy::DEGRADE;
+    float capacity_mbps = 0.0f;          // 0 = estimate from the link (USB speed, or PoE)
+    float headroom = 0.75f;              // Fraction of the capacity the streams may use
+    bool keep_resolution = true;         // Degrade fps before resolution (false: the reverse)
+};
+
+// Device-loss detection and reconnect (see EngineManager::watchdogLoop)
+struct WatchdogConfig {
+    bool enabled = true;
+    uint32_t check_interval_ms = 100;    // Health check and rediscovery poll period
+    uint32_t heartbeat_timeout_ms = 1500; // No message on any module stream for this long = lost
+    uint32_t error_threshold = 3;        // Consecutive processing-loop exceptions = lost
+    uint32_t initial_backoff_ms = 100;   // After a failed connect attempt
+    uint32_t max_backoff_ms = 5000;
+    float backoff_multiplier = 2.0f;
+    uint32_t max_attempts = 0;           // Failed connects before giving up, 0 = keep trying
+    uint32_t recovery_timeout_ms = 0;    // Give up when not restored by then (device gone for good), 0 = never
+};
+
 struct EngineConfig {
     std::string device_id = "";  // Empty = auto-detect first device
-    bool use_poe = false;        // Use PoE connection
+    bool use_poe = false;        // Use PoE connection (sizes the link budget for gigabit Ethernet)
+    bool enable_tracing = false; // Record per-frame trace spans (see Trace.h)
+    uint32_t trace_events_per_thread = 1 << 16;
+    uint32_t worker_threads = 0;         // Host task pool size, 0 = cores - 1 (see TaskPool.h)
+    uint32_t max_stream_backlog = 64;    // Queued tasks per stream before new ones are dropped
+    ThreadOptions processing_thread;     // Frame intake loop
+    ThreadOptions pool_threads;          // Task pool workers (all share the cpu set)
+    ThreadOptions delivery_thread;       // Batched detection delivery
+    SimulationConfig simulation;         // Run modules without a device
+    SnapshotConfig snapshot;
+    ThumbnailConfig thumbnails;          // Kept across module switches and reconnects
+    LinkBudgetConfig link_budget;
+    WatchdogConfig watchdog;             // Device mode only
 };
 
 struct OutputConfig {
@@ -30,6 +143,9 @@ struct OutputConfig {
     float fps = 30.0f;
     ResizeMode resize_mode = ResizeMode::CROP;
     bool enable_undistortion = false;
+    FrameTransport transport = FrameTransport::BGR;
+    QueueConfig queue{8, false, QueuePolicy::LATEST_ONLY};
+    bool show_preview = true;            // OpenCV window on the host
 };
 
 struct CameraSettings {
@@ -52,23 +168,276 @@ struct RecordConfig {
     uint32_t height = 1080;
     float fps = 30.0f;
     int bitrate = 8000000; // 8 Mbps
+    uint32_t preview_width = 640;        // UI stream next to the recording
+    uint32_t preview_height = 360;
+    float preview_fps = 0.0f;            // 0 = recording fps
+    QueueConfig preview_queue{4, false, QueuePolicy::LATEST_ONLY};
+    bool show_preview = true;
     // Note: RecordVideo node only supports H264 encoding
 };
 
+// Host (CPU) inference backend used for replay and offline runs (see HostInference.h)
+struct HostInferenceConfig {
+    uint32_t threads = 0;                // Worker threads, 0 = hardware concurrency
+    uint32_t batch_size = 4;             // Frames per forward pass; falls back to 1 for fixed-batch models
+    uint32_t batch_timeout_ms = 10;      // Max wait for a full batch before running a partial one
+    uint32_t max_pending = 64;           // Queued frames before submit() blocks (backpressure)
+    float nms_threshold = 0.45f;
+    float mean[3] = {0.0f, 0.0f, 0.0f};  // Per-channel normalization: (pixel - mean) * scale
+    float scale[3] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+    bool swap_rb = true;                 // Feed RGB planes (YOLO ONNX exports expect RGB)
+    uint32_t latency_window = 512;       // Recent batches kept for latency percentiles
+    ThreadOptions worker_threads;        // Applied to every worker (see ThreadTuning.h)
+};
+
+// Skips detector work while the scene is static (see MotionGate.h)
+struct MotionGateConfig {
+    bool enabled = false;
+    uint32_t width = 160;                // Motion stream resolution; only luma is used
+    uint32_t height = 120;
+    uint8_t pixel_threshold = 20;        // Luma change that counts a pixel as changed
+    float min_changed_fraction = 0.002f; // Changed pixels that make a frame count as motion
+    uint32_t hold_ms = 2000;             // Keep detecting this long after the last motion
+    uint32_t idle_every_n = 0;           // While static: 0 = pause detection, N = run every Nth frame
+    QueueConfig queue{2, false, QueuePolicy::LATEST_ONLY};
+};
+
+// Runs the detector over overlapping tiles of a high-resolution stream (see TileMerger.h)
+struct TilingConfig {
+    bool enabled = false;
+    uint32_t source_width = 1920;        // High-resolution stream the tiles are cut from
+    uint32_t source_height = 1080;
+    float source_fps = 5.0f;             // Each frame costs one NN pass per tile
+    float tile_scale = 1.0f;             // Tile size in source pixels = NN input size * scale
+    float overlap = 0.15f;               // Minimum overlap of neighbouring tiles, fraction of the tile
+    bool include_full_frame = true;      // Also run the whole frame, letterboxed, for large objects
+    float iou_threshold = 0.5f;          // Cross-tile NMS
+    float containment_threshold = 0.7f;  // Also merge (into the union) when this much of the smaller
+                                         // box lies inside the other: objects cut by a tile edge
+};
+
+// DetectionNetwork resources (tuned by oak-tune, see InferenceProfile.h); 0 keeps the depthai default
+struct InferenceTuning {
+    int inference_threads = 0;
+    int nce_per_thread = 0;
+    int shaves_per_thread = 0;
+    int pool_frames = 0;                 // Output message pool of the network
+    int input_queue_size = 0;            // Frames queued in front of the network (blocking when set)
+
+    bool isDefault() const {
+        return inference_threads == 0 && nce_per_thread == 0 && shaves_per_thread == 0 &&
+               pool_frames == 0 && input_queue_size == 0;
+    }
+};
+
+// Per-detection crops cut from a high-resolution stream (see CropExtractor.h)
+struct CropConfig {
+    bool enabled = false;
+    uint32_t source_width = 1920;        // Stream the crops are cut from; give it the sensor's aspect
+    uint32_t source_height = 1080;
+    float source_fps = 0.0f;             // 0 = the detector's frame rate
+    FrameTransport source_transport = FrameTransport::NV12;  // Only the cropped regions are converted
+    uint32_t output_width = 224;         // Every crop is resized to this (e.g. a classifier input)
+    uint32_t output_height = 224;
+    bool keep_aspect = true;             // Letterbox into the output instead of stretching
+    float padding = 0.1f;                // Grow each box by this fraction of its size per side
+    uint32_t min_size = 16;              // Skip boxes smaller than this in source pixels
+    uint32_t max_crops = 32;             // Per message, highest confidence first
+    std::vector<uint32_t> labels;        // Labels to crop; empty = all
+    uint32_t workers = 0;                // Parallel crop tasks per message, 0 = task pool size
+    uint32_t buffer_pool = 64;           // Output buffers; crops are skipped while every one is held
+    uint32_t max_pending = 4;            // Messages being cropped at once; newer ones are dropped
+    uint32_t frame_history = 8;          // Source frames kept for matching detections
+    float match_tolerance_ms = 5.0f;     // Max device timestamp difference between detections and frame
+    uint32_t latency_window = 512;       // Recent crops kept for cost percentiles
+    QueueConfig source_queue{8, false, QueuePolicy::LOSSLESS};
+};
+
+// Where the cascade's per-object crops are cut
+enum class CascadeCropSource {
+    HOST,      // CropExtractor on the host from the crop source stream (any detector, tiled too)
+    DEVICE     // Script + ImageManip on the device; only the crops cross the link (untiled detectors)
+};
+
+// What the second network outputs per object
+enum class CascadeOutput {
+    CLASSIFICATION,  // Class scores: label = argmax, score = its probability
+    EMBEDDING        // Feature vector (re-identification), L2-normalized
+};
+
+// Second network run on every detected object (see CascadeClassifier.h).
+// Crop geometry (size, padding, labels, max_crops) comes from
+// InferenceConfig::crops, whose output size must be the network's input.
+struct CascadeConfig {
+    bool enabled = false;
+    std::string model_path;              // ONNX, run on the host with OpenCV DNN
+    CascadeCropSource crop_source = CascadeCropSource::HOST;
+    CascadeOutput output = CascadeOutput::CLASSIFICATION;
+    std::vector<std::string> labels;     // Class names, for display
+    bool apply_softmax = true;           // Outputs are logits (false if the model ends in softmax)
+    uint32_t threads = 1;                // Workers, each with its own network
+    uint32_t batch_size = 16;            // Crops per forward pass; falls back to 1 for fixed-batch models
+    uint32_t batch_timeout_ms = 5;       // Max wait for a full batch before running a partial one
+    uint32_t max_queued = 256;           // Crops waiting for the network; more are dropped
+    uint32_t result_timeout_ms = 500;    // Deliver a message with missing objects after this long
+    float mean[3] = {0.0f, 0.0f, 0.0f};  // Per-channel normalization: (pixel - mean) * scale
+    float scale[3] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+    bool swap_rb = true;
+    uint32_t latency_window = 512;       // Recent samples kept for percentiles
+    ThreadOptions worker_threads;        // Applied to every worker (see ThreadTuning.h)
+    QueueConfig crop_queue{16, false, QueuePolicy::LOSSLESS};  // Device crops
+};
+
 struct InferenceConfig {
     std::string model_path;
     uint32_t input_width = 640;
     uint32_t input_height = 640;
+    float input_fps = 30.0f;             // Camera rate feeding the network; with tiling, tiling.source_fps
     float confidence_threshold = 0.5f;
     bool sync_nn_with_preview = true;
+    QueueConfig preview_queue{4, false, QueuePolicy::LATEST_ONLY};
+    QueueConfig detection_queue{4, false, QueuePolicy::LOSSLESS};
+    bool show_preview = true;
+    uint32_t preview_width = 640;        // Display stream; detections are normalized, so any size works
+    uint32_t preview_height = 480;       // Ignored with tiling: follows the tiled stream's aspect
+    float preview_fps = 30.0f;
+    FrameTransport preview_transport = FrameTransport::BGR;  // The NN input stays on the device
+    MotionGateConfig motion_gate;
+    TilingConfig tiling;
+    CropConfig crops;
+    CascadeConfig cascade;               // Takes its crops from `crops`, enabled or not
+    HostInferenceConfig host;            // Only used by the host backend (ONNX model_path)
+    InferenceTuning tuning;
+    bool use_tuned_profile = true;       // With default tuning: load the model's saved profile, if any
+    std::string profile_directory = "profiles/";
+};
+
+// Batched delivery of detection messages to a consumer thread (see DetectionBatcher.h)
+struct DetectionBatchConfig {
+    uint32_t max_messages = 32;          // Deliver as soon as this many messages are collected
+    uint32_t window_ms = 500;            // ... or when the oldest collected message is this old
+    uint32_t queue_capacity = 256;       // Messages buffered while the consumer is busy
+};
+
+// Append-only memory-mapped detection store (see DetectionLog.h)
+struct DetectionLogConfig {
+    std::string directory = "detections/";
+    uint64_t segment_capacity = 1 << 20;  // Records per segment file (40 bytes each, allocated sparsely)
+    uint32_t index_stride = 1024;         // Records per sparse index entry
+};
+
+// Which point of a box stands for the object in zones, tripwires and the heatmap
+enum class AnchorPoint {
+    CENTER,
+    BOTTOM_CENTER    // Foot point, for people on the floor plane
+};
+
+// Coordinates are normalized to the detection frame, like ImgDetection boxes
+struct ZonePoint {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct ZoneConfig {
+    std::string name;
+    std::vector<ZonePoint> polygon;      // At least 3 points, either winding, may be concave
+    std::vector<uint32_t> labels;        // Labels counted; empty = all
+};
+
+// Counted when a track's anchor moves across the segment a -> b. Direction
+// +1 crosses from the left of a -> b to its right (image coordinates, y down).
+struct TripwireConfig {
+    std::string name;
+    ZonePoint a;
+    ZonePoint b;
+    std::vector<uint32_t> labels;        // Labels counted; empty = all
+};
+
+// Zone occupancy, line crossings and heatmap over detections (see ZoneAnalytics.h)
+struct AnalyticsConfig {
+    std::vector<ZoneConfig> zones;
+    std::vector<TripwireConfig> tripwires;
+    AnchorPoint anchor = AnchorPoint::BOTTOM_CENTER;
+    uint32_t grid_cols = 32;             // Spatial index cells over the frame
+    uint32_t grid_rows = 32;
+    uint32_t heatmap_width = 64;         // 0 = no heatmap
+    uint32_t heatmap_height = 36;
+    float heatmap_half_life_s = 0.0f;    // 0 = accumulate forever
+    uint32_t max_missed_frames = 15;     // A track unseen for this many frames has left its zones
+    float track_iou_threshold = 0.3f;    // Detections without track ids go through an IoU tracker
 };
 
+// Offline re-processing of recorded footage with the host backend (see BatchProcessor.h)
+struct BatchConfig {
+    std::string input_path = "recordings/";   // Directory of videos and/or image sequences
+    std::string output_path = "recordings/detections.oakb";
+    InferenceConfig inference;                // model_path must be an ONNX export
+    uint32_t decode_threads = 0;              // 0 = one per source, up to half the cores
+    uint32_t frame_stride = 1;                // Run inference on every Nth frame
+    float image_sequence_fps = 30.0f;         // Timestamps for image sequences
+    uint32_t sink_queue_size = 256;           // Results buffered between inference and writer
+    float track_iou_threshold = 0.3f;
+    uint32_t track_max_age = 15;              // Processed frames a track survives unmatched
+    ThreadOptions io_threads;                 // Decode and writer threads (see ThreadTuning.h)
+};
+
+struct DepthConfig {
+    uint32_t width = 1280;               // Mono sensor output resolution
+    uint32_t height = 800;
+    float fps = 30.0f;
+    bool align_to_rgb = false;           // Align depth to CAM_A instead of the right mono camera
+    bool left_right_check = true;
+    bool subpixel = true;
+    bool extended_disparity = false;
+    bool generate_point_cloud = true;    // Host-side point cloud from each depth frame
+    float min_depth_m = 0.2f;
+    float max_depth_m = 10.0f;
+    float voxel_size_m = 0.0f;           // 0 = no voxel-grid downsampling
+    QueueConfig depth_queue{4, false, QueuePolicy::LATEST_ONLY};
+};
+
+struct MultiCameraConfig {
+    std::vector<dai::CameraBoardSocket> sockets;  // Empty = all connected cameras
+    uint32_t width = 640;
+    uint32_t height = 400;
+    float fps = 30.0f;
+    float sync_tolerance_ms = 5.0f;      // Max device timestamp spread within a frameset
+    uint32_t sync_buffer_size = 16;      // Per-socket frames held while waiting for partners
+    QueueConfig queue{8, false, QueuePolicy::LOSSLESS};
+};
+
+inline std::string cameraSocketToString(dai::CameraBoardSocket socket) {
+    int index = static_cast<int>(socket);
+    if (index < 0) {
+        return "AUTO";
+    }
+    return std::string("CAM_") + static_cast<char>('A' + index);
+}
+
+inline std::string queuePolicyToString(QueuePolicy policy) {
+    switch (policy) {
+        case QueuePolicy::LATEST_ONLY: return "LATEST_ONLY";
+        case QueuePolicy::LOSSLESS:    return "LOSSLESS";
+        default:                       return "UNKNOWN";
+    }
+}
+
+inline std::string frameTransportToString(FrameTransport transport) {
+    switch (transport) {
+        case FrameTransport::BGR:  return "BGR";
+        case FrameTransport::NV12: return "NV12";
+        default:                   return "UNKNOWN";
+    }
+}
+
 inline std::string moduleStateToString(ModuleState state) {
     switch (state) {
         case ModuleState::IDLE:      return "IDLE";
         case ModuleState::PREVIEW:   return "PREVIEW";
         case ModuleState::RECORD:    return "RECORD";
         case ModuleState::INFERENCE: return "INFERENCE";
+        case ModuleState::DEPTH:     return "DEPTH";
+        case ModuleState::MULTI_CAMERA: return "MULTI_CAMERA";
         default:                     return "UNKNOWN";
     }
 }
@@ -77,6 +446,8 @@ inline ModuleState moduleStateFromString(const std::string& str) {
     if (str == "PREVIEW")   return ModuleState::PREVIEW;
     if (str == "RECORD")    return ModuleState::RECORD;
     if (str == "INFERENCE") return ModuleState::INFERENCE;
+    if (str == "DEPTH")     return ModuleState::DEPTH;
+    if (str == "MULTI_CAMERA") return ModuleState::MULTI_CAMERA;
     return ModuleState::IDLE;
 }
 
@@ -3,15 +3,164 @@
 #include <chrono>
 #include <csignal>
 #include <atomic>
+#include <string>
+#include <algorithm>
+#include <fstream>
 
 #include "engine/EngineManager.h"
 #include "engine/Types.h"
+#include "engine/DetectionLog.h"
+#include "engine/TaskPool.h"
+#include "engine/ThreadTuning.h"
+#include "processing/BatchProcessor.h"
+#include "processing/TileMerger.h"
+#include "processing/Serializers.h"
+#include "processing/PointCloud.h"
+#include "processing/FramePreprocessor.h"
 
 std::atomic<bool> g_running{true};
+std::atomic<oak::BatchProcessor*> g_batch{nullptr};
 
 void signalHandler(int signum) {
     std::cout << "\nInterrupt signal (" << signum << ") received." << std::endl;
     g_running = false;
+    if (auto* batch = g_batch.load()) {
+        batch->cancel();
+    }
+}
+
+// Offline mode: re-run detection over recordings on the host, no device needed
+int runBatch(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " --batch <input_dir> <model.onnx> [output_file]" << std::endl;
+        return 1;
+    }
+
+    oak::BatchConfig batchConfig;
+    batchConfig.input_path = argv[2];
+    batchConfig.inference.model_path = argv[3];
+    batchConfig.inference.input_width = 640;
+    batchConfig.inference.input_height = 640;
+    batchConfig.inference.confidence_threshold = 0.5f;
+    if (argc > 4) {
+        batchConfig.output_path = argv[4];
+    }
+
+    oak::BatchProcessor batch(batchConfig);
+    g_batch = &batch;
+    bool ok = batch.run();
+    g_batch = nullptr;
+    return ok ? 0 : 1;
+}
+
+// Host cost of merging tiled detections, no device needed
+int runTileBenchmark(int argc, char* argv[]) {
+    oak::TilingConfig tiling;
+    if (argc > 3) {
+        tiling.source_width = static_cast<uint32_t>(std::stoul(argv[2]));
+        tiling.source_height = static_cast<uint32_t>(std::stoul(argv[3]));
+    }
+    uint32_t perTile = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 16;
+
+    for (uint32_t detections : {perTile / 4, perTile, perTile * 4}) {
+        auto result = oak::benchmarkTileMerge(tiling, 640, 640, std::max(detections, 1u), 20000);
+        std::cout << tiling.source_width << "x" << tiling.source_height << ", " << result.tiles << " tiles, "
+                  << result.detections_per_tile << " detections/tile: mean " << result.mean_us << " us, p50 "
+                  << result.p50_us << " us, p99 " << result.p99_us << " us, max " << result.max_us
+                  << " us per frame" << std::endl;
+    }
+    return 0;
+}
+
+// Per-message cost of the detection serializers, no device needed
+int runSerializerBenchmark(int argc, char* argv[]) {
+    uint32_t messages = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 200000;
+    for (uint32_t detections : {1u, 10u, 50u}) {
+        auto result = oak::benchmarkSerializers(detections, messages);
+        std::cout << detections << " detections/message: binary " << result.binary_ns << " ns ("
+                  << result.binary_bytes << " B, " << 1e3 / result.binary_ns << " M msg/s), JSON "
+                  << result.json_ns << " ns (" << result.json_bytes << " B, " << 1e3 / result.json_ns
+                  << " M msg/s), ostringstream " << result.stream_json_ns << " ns";
+        if (oak::AllocationCounter::enabled()) {
+            std::cout << ", allocations/message " << result.binary_allocations << " binary, "
+                      << result.json_allocations << " JSON";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+// Per-frame cost of zone/tripwire analytics on synthetic tracks, grid index vs none
+int runZoneBenchmark(int argc, char* argv[]) {
+    uint32_t tracks = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 50;
+    uint32_t frames = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 20000;
+    for (uint32_t zones : {10u, 100u, 500u}) {
+        for (uint32_t grid : {32u, 1u}) {
+            auto result = oak::benchmarkZoneAnalytics(zones, zones / 2, tracks, frames, grid);
+            std::cout << zones << " zones, " << result.tripwires << " tripwires, " << tracks << " tracks, grid "
+                      << grid << "x" << grid << ": mean " << result.mean_us << " us (first half "
+                      << result.first_half_mean_us << ", second half " << result.second_half_mean_us << "), p99 "
+                      << result.p99_us << " us, max " << result.max_us << " us per frame, "
+                      << result.candidates_per_object << " tests/object, " << result.events_per_frame
+                      << " events/frame" << std::endl;
+        }
+    }
+    return 0;
+}
+
+// Host cost of depth -> point cloud (SIMD vs scalar) and voxel downsampling, no device needed
+int runPointCloudBenchmark(int argc, char* argv[]) {
+    uint32_t width = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[2])) : 640;
+    uint32_t height = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 400;
+    uint32_t frames = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 500;
+    auto result = oak::benchmarkPointCloud(width, height, frames);
+    std::cout << width << "x" << height << ": generate " << result.generate_us << " us (" << result.backend
+              << ", p99 " << result.generate_p99_us << " us), scalar " << result.scalar_generate_us
+              << " us, voxel grid " << result.voxel_us << " us per frame; " << result.mean_points << " points -> "
+              << result.mean_voxels << " voxels" << std::endl;
+    return 0;
+}
+
+// Task pool throughput, and a check that every stream runs in order and one task at a time
+int runTaskPoolBenchmark(int argc, char* argv[]) {
+    uint32_t threads = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 4;
+    uint32_t streams = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 8;
+    uint32_t tasks = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 20000;
+    auto result = oak::stressTaskPool(threads, streams, tasks);
+    std::cout << streams << " streams x " << tasks << " tasks on " << threads << " workers: " << result.tasks
+              << " run in " << result.elapsed_ms << " ms (" << result.tasks_per_second << " tasks/s, "
+              << result.stolen << " stolen, " << result.retries << " full-backlog retries), "
+              << result.order_violations << " order and " << result.overlap_violations << " overlap violations"
+              << std::endl;
+    return result.order_violations == 0 && result.overlap_violations == 0 ? 0 : 1;
+}
+
+// Append and query cost of the detection log, no device needed
+int runDetectionLogBenchmark(int argc, char* argv[]) {
+    uint32_t messages = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 100000;
+    uint32_t perMessage = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 3;
+    auto result = oak::benchmarkDetectionLog(messages, perMessage, 200);
+    std::cout << result.records << " records in " << result.segments << " segments: append "
+              << result.append_ns << " ns per message (p99 " << result.append_p99_ns << " ns), one-label query "
+              << result.label_query_us << " us (" << result.label_query_matches << " matches), 1 s window query "
+              << result.window_query_us << " us (" << result.window_query_matches << " matches)" << std::endl;
+    return 0;
+}
+
+// Host preprocessing kernels against the OpenCV calls they replace, no device needed
+int runPreprocessBenchmark(int argc, char* argv[]) {
+    uint32_t width = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[2])) : 1920;
+    uint32_t height = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 1080;
+    uint32_t frames = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 200;
+    auto result = oak::benchmarkPreprocess(width, height, 640, 640, frames);
+    std::cout << result.source_width << "x" << result.source_height << " -> " << result.input_width << "x"
+              << result.input_height << " (" << result.backend << "), us per frame, ours vs OpenCV:" << std::endl
+              << "  NV12 -> BGR  " << result.nv12_us << " vs " << result.opencv_nv12_us << " (max diff "
+              << result.nv12_max_diff << ")" << std::endl
+              << "  letterbox    " << result.letterbox_us << " vs " << result.opencv_letterbox_us << " (max diff "
+              << result.letterbox_max_diff << ")" << std::endl
+              << "  planar float " << result.planar_us << " vs " << result.opencv_planar_us << std::endl;
+    return 0;
 }
 
 void printUsage() {
@@ -21,7 +170,13 @@ void printUsage() {
     std::cout << "  p - Start Preview" << std::endl;
     std::cout << "  r - Start Recording" << std::endl;
     std::cout << "  i - Start Inference (requires model)" << std::endl;
+    std::cout << "  d - Start Stereo Depth" << std::endl;
+    std::cout << "  m - Start Synchronized Multi-Camera Capture" << std::endl;
     std::cout << "  s - Stop current module" << std::endl;
+    std::cout << "  c - Capture a full-resolution snapshot (JPEG, needs snapshots enabled)" << std::endl;
+    std::cout << "  l - Save the thumbnail from 10 s ago (needs thumbnails enabled)" << std::endl;
+    std::cout << "  t - Start tracing / write trace to oak_trace.json" << std::endl;
+    std::cout << "  j - Measure thread wake-up jitter (default vs configured)" << std::endl;
     std::cout << "  q - Quit" << std::endl;
     std::cout << "  ? - Show this help" << std::endl;
     std::cout << std::endl;
@@ -33,6 +188,101 @@ void printStatus(oak::EngineManager& engine) {
     std::cout << "Device ID: " << engine.getDeviceId() << std::endl;
     std::cout << "State: " << oak::moduleStateToString(engine.getState()) << std::endl;
     std::cout << "Active Module: " << engine.getActiveModuleName() << std::endl;
+    for (const auto& stats : engine.getQueueStats()) {
+        std::cout << "Queue " << stats.name << " (" << oak::queuePolicyToString(stats.config.policy)
+                  << "): delivered " << stats.delivered
+                  << ", gap drops " << stats.gap_dropped
+                  << ", drained " << stats.drained
+                  << ", " << (stats.received > 0 ? stats.received_bytes / stats.received / 1024 : 0) << " KiB/msg"
+                  << ", interval " << stats.interval_mean_ms << " ms (jitter "
+                  << stats.interval_jitter_ms << " ms, max " << stats.interval_max_ms << " ms)" << std::endl;
+    }
+    if (auto sync = engine.getSyncStats()) {
+        std::cout << "Sync: " << sync->framesets << " framesets, "
+                  << sync->sync_misses << " misses, mean skew "
+                  << sync->mean_skew_us << " us, max skew " << sync->max_skew_us << " us" << std::endl;
+    }
+    if (auto gate = engine.getMotionGateStats()) {
+        std::cout << "Motion gate: " << (gate->active ? "motion" : "static") << ", "
+                  << gate->processed << " processed (" << gate->processed_ratio * 100.0 << "%), "
+                  << gate->gated << " gated (" << gate->gated_ratio * 100.0 << "%)" << std::endl;
+    }
+    if (auto tiling = engine.getTileMergeStats()) {
+        std::cout << "Tiling: " << tiling->frames << " frames x " << tiling->tiles << " tiles, "
+                  << tiling->incomplete_frames << " incomplete, " << tiling->input_detections << " -> "
+                  << tiling->output_detections << " detections, merge " << tiling->mean_merge_us
+                  << " us mean (max " << tiling->max_merge_us << " us)" << std::endl;
+    }
+    if (auto crops = engine.getCropStats()) {
+        std::cout << "Crops: " << crops->crops << " from " << crops->messages << " messages, "
+                  << crops->unmatched << " unmatched, " << crops->skipped_pool << " out of buffers ("
+                  << crops->buffers << "), " << crops->mean_crop_us << " us mean, " << crops->p95_crop_us
+                  << " us p95 per crop, " << crops->mean_latency_us << " us per message" << std::endl;
+    }
+    if (auto cascade = engine.getCascadeStats()) {
+        auto stage = [](const char* name, const oak::CascadeStageStats& stats) {
+            std::cout << "  " << name << ": " << stats.items << " (" << stats.items_per_second << "/s), "
+                      << stats.dropped << " dropped, queued " << stats.queued << " (max " << stats.max_queued
+                      << "), wait " << stats.mean_wait_ms << " ms (p95 " << stats.p95_wait_ms << "), service "
+                      << stats.mean_service_ms << " ms (p95 " << stats.p95_service_ms << ")" << std::endl;
+        };
+        std::cout << "Cascade: batch " << cascade->mean_batch_size << "/" << cascade->batch_size << ", "
+                  << cascade->incomplete_messages << " incomplete, latency " << cascade->mean_latency_ms
+                  << " ms (p95 " << cascade->p95_latency_ms << ")" << std::endl;
+        stage("detect", cascade->detect);
+        stage("crop", cascade->crop);
+        stage("classify", cascade->classify);
+    }
+    if (auto snapshots = engine.getSnapshotStats(); snapshots && snapshots->requested > 0) {
+        std::cout << "Snapshots: " << snapshots->completed << "/" << snapshots->requested << " ("
+                  << snapshots->failed << " failed), latency " << snapshots->mean_latency_ms
+                  << " ms mean, " << snapshots->max_latency_ms << " ms max" << std::endl;
+    }
+    if (auto analytics = engine.getAnalyticsStats(); analytics && analytics->frames > 0) {
+        std::cout << "Analytics: " << analytics->active_tracks << " tracks, " << analytics->events << " events, "
+                  << analytics->mean_candidates << " tests/object, " << analytics->mean_update_us
+                  << " us per message (max " << analytics->max_update_us << ")" << std::endl;
+    }
+    if (auto thumbnails = engine.getThumbnailStats()) {
+        uint32_t frames = 0;
+        double span_s = 0.0;
+        for (const auto& stream : thumbnails->streams) {
+            frames += stream.frames;
+            span_s = std::max(span_s, stream.span_s);
+        }
+        std::cout << "Thumbnails: " << frames << " frames over " << span_s << " s, "
+                  << thumbnails->bytes / 1024 << "/" << thumbnails->budget_bytes / 1024 << " KiB, "
+                  << thumbnails->mean_insert_us << " us per insert" << std::endl;
+    }
+    if (auto recovery = engine.getRecoveryStats(); recovery && recovery->losses > 0) {
+        std::cout << "Recovery: " << recovery->recoveries << "/" << recovery->losses << " device losses recovered"
+                  << (recovery->recovering ? " (recovering)" : "") << ", last " << recovery->last_total_ms
+                  << " ms (" << recovery->last_reason << "), mean " << recovery->mean_total_ms << " ms, max "
+                  << recovery->max_total_ms << " ms" << std::endl;
+    }
+    if (auto plan = engine.getLinkPlan()) {
+        int degraded = 0;
+        for (const auto& stream : plan->streams) {
+            degraded += stream.degraded() ? 1 : 0;
+        }
+        std::cout << "Link: " << plan->capacity.link << ", " << plan->planned_mbps << " of "
+                  << plan->budget_mbps << " Mbps budget planned, " << degraded << "/"
+                  << plan->streams.size() << " streams degraded" << std::endl;
+    }
+    if (auto pool = engine.getTaskPoolStats()) {
+        std::cout << "Task pool: " << pool->threads << " workers, " << pool->executed << " tasks, "
+                  << pool->stolen << " stolen, " << pool->dropped << " dropped" << std::endl;
+    }
+    if (auto allocations = engine.getAllocationStats(); allocations && oak::AllocationCounter::enabled()) {
+        std::cout << "Frame path allocations: " << allocations->steady_allocations_per_frame
+                  << "/frame after warm-up (" << allocations->steady_frames << " frames, "
+                  << allocations->allocations << " in total)" << std::endl;
+    }
+    if (auto batches = engine.getDetectionBatchStats()) {
+        std::cout << "Detection batches: " << batches->batches << " (mean "
+                  << batches->mean_batch_messages << " messages), dropped " << batches->dropped
+                  << ", consumer " << batches->mean_delivery_ms << " ms/batch" << std::endl;
+    }
     std::cout << "--------------\n" << std::endl;
 }
 
@@ -45,6 +295,31 @@ int main(int argc, char* argv[]) {
     std::cout << "Using DepthAI V3 API" << std::endl;
     std::cout << "=================================" << std::endl;
 
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-tiles") {
+        return runTileBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-serialize") {
+        return runSerializerBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-zones") {
+        return runZoneBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-preprocess") {
+        return runPreprocessBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-pointcloud") {
+        return runPointCloudBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-taskpool") {
+        return runTaskPoolBenchmark(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--bench-detection-log") {
+        return runDetectionLogBenchmark(argc, argv);
+    }
+
     // Get engine instance
     auto& engine = oak::EngineManager::getInstance();
 
@@ -52,6 +327,12 @@ int main(int argc, char* argv[]) {
     oak::EngineConfig config;
     // config.device_id = "";  // Auto-detect
     // config.use_poe = true;  // Uncomment for PoE devices
+    // config.processing_thread.cpus = {2};            // Pin frame intake to core 2
+    // config.processing_thread.realtime = true;       // SCHED_FIFO (needs CAP_SYS_NICE)
+    // config.pool_threads.cpus = {3, 4, 5};
+    // config.delivery_thread.nice = 10;
+    // config.snapshot.enabled = true;                 // Full-resolution stills for 'c'
+    // config.thumbnails.enabled = true;               // Lookback history for 'l'
 
     // Check for command line device ID
     if (argc > 1) {
@@ -75,12 +356,33 @@ int main(int argc, char* argv[]) {
         // For example: streaming to network, saving frames, etc.
     });
 
+    // Optionally persist inference results to the append-only detection log in detections/
+    bool persistDetections = false;  // Set to true to keep every detection on disk
+    oak::DetectionLog detectionLog;
+    if (persistDetections) {
+        detectionLog.open();
+    }
+
     // Set detection callback (optional - for inference results)
-    engine.setDetectionCallback([](std::shared_ptr<dai::ImgDetections> detections) {
+    // Callbacks for one stream run one at a time, so a buffer can be shared
+    std::string detectionJson;
+    engine.setDetectionCallback([&detectionLog, &detectionJson, persistDetections](std::shared_ptr<dai::ImgDetections> detections) {
         // Process detections here
         // For example: sending to REST API, logging, etc.
+        if (persistDetections) {
+            detectionLog.append(*detections);
+        }
+
+        // JSON without per-message allocations (see processing/Serializers.h)
+        detectionJson.clear();
+        oak::writeDetectionsJson(*detections, 0, detectionJson);
+        // post(detectionJson);
     });
 
+    // Batched detection callback (optional - runs on its own thread), e.g. one
+    // REST request per batch instead of per frame:
+    // engine.setDetectionBatchCallback([](const oak::DetectionBatch& batch) { post(batch); });
+
     // Interactive loop
     while (g_running) {
         std::cout << "Enter command (? for help): ";
@@ -102,6 +404,7 @@ int main(int argc, char* argv[]) {
                 previewConfig.height = 720;
                 previewConfig.fps = 30.0f;
                 previewConfig.resize_mode = oak::ResizeMode::CROP;
+                // previewConfig.transport = oak::FrameTransport::NV12;  // Half the USB bandwidth
                 
                 if (engine.startPreview(previewConfig)) {
                     std::cout << "Preview started. Press 'q' in window or 's' here to stop." << std::endl;
@@ -147,6 +450,9 @@ int main(int argc, char* argv[]) {
                 inferConfig.input_width = 640;
                 inferConfig.input_height = 640;
                 inferConfig.confidence_threshold = 0.5f;
+                // inferConfig.motion_gate.enabled = true;   // Skip the NN on static scenes
+                // inferConfig.motion_gate.idle_every_n = 15; // Still run every 15th frame when static
+                // inferConfig.tiling.enabled = true;        // Small objects: 1080p tiles + full frame
                 
                 if (engine.startInference(inferConfig)) {
                     std::cout << "Inference started. Press 'q' in window or 's' here to stop." << std::endl;
@@ -156,6 +462,40 @@ int main(int argc, char* argv[]) {
                 break;
             }
             
+            case 'd':
+            case 'D': {
+                std::cout << "Starting stereo depth..." << std::endl;
+                oak::DepthConfig depthConfig;
+                depthConfig.width = 1280;
+                depthConfig.height = 800;
+                depthConfig.fps = 30.0f;
+                depthConfig.voxel_size_m = 0.02f;  // 2 cm voxels
+
+                if (engine.startDepth(depthConfig)) {
+                    std::cout << "Depth started. Press 'q' in window or 's' here to stop." << std::endl;
+                } else {
+                    std::cout << "Failed to start depth" << std::endl;
+                }
+                break;
+            }
+
+            case 'm':
+            case 'M': {
+                std::cout << "Starting multi-camera capture..." << std::endl;
+                oak::MultiCameraConfig multiConfig;  // All connected cameras
+                multiConfig.width = 640;
+                multiConfig.height = 400;
+                multiConfig.fps = 30.0f;
+                multiConfig.sync_tolerance_ms = 5.0f;
+
+                if (engine.startMultiCamera(multiConfig)) {
+                    std::cout << "Multi-camera capture started. Press 'q' in window or 's' here to stop." << std::endl;
+                } else {
+                    std::cout << "Failed to start multi-camera capture" << std::endl;
+                }
+                break;
+            }
+
             case 's':
             case 'S':
                 std::cout << "Stopping module..." << std::endl;
@@ -163,6 +503,65 @@ int main(int argc, char* argv[]) {
                 std::cout << "Module stopped" << std::endl;
                 break;
             
+            case 'c':
+            case 'C': {
+                // The active module keeps streaming while the still is taken
+                auto pending = engine.captureSnapshot();
+                try {
+                    auto snapshot = pending.get();
+                    std::string path = "snapshot_" + std::to_string(snapshot.sequence) + ".jpg";
+                    std::ofstream file(path, std::ios::binary);
+                    file.write(reinterpret_cast<const char*>(snapshot.jpeg.data()),
+                               static_cast<std::streamsize>(snapshot.jpeg.size()));
+                    std::cout << "Snapshot " << snapshot.width << "x" << snapshot.height << " ("
+                              << snapshot.jpeg.size() / 1024 << " KiB) in " << snapshot.latency_ms
+                              << " ms -> " << path << std::endl;
+                } catch (const std::exception& e) {
+                    std::cout << "Snapshot failed: " << e.what() << std::endl;
+                }
+                break;
+            }
+
+            case 'l':
+            case 'L': {
+                auto thumbnail = engine.getThumbnail(std::chrono::steady_clock::now() - std::chrono::seconds(10));
+                if (!thumbnail) {
+                    std::cout << "No thumbnail history" << std::endl;
+                    break;
+                }
+                double age_s = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                             thumbnail->timestamp).count();
+                std::string path = "lookback_" + std::to_string(thumbnail->sequence) + ".jpg";
+                cv::imwrite(path, oak::decodeThumbnail(*thumbnail));
+                std::cout << "Thumbnail " << thumbnail->stream << " from " << age_s << " s ago -> " << path
+                          << std::endl;
+                break;
+            }
+
+            case 't':
+            case 'T':
+                if (!engine.isTracingEnabled()) {
+                    engine.setTracingEnabled(true);
+                    std::cout << "Tracing started. Press 't' again to write the trace." << std::endl;
+                } else {
+                    engine.writeTrace("oak_trace.json");
+                    std::cout << "Open oak_trace.json in ui.perfetto.dev or chrome://tracing" << std::endl;
+                }
+                break;
+
+            case 'j':
+            case 'J': {
+                std::cout << "Measuring wake-up jitter (2 x 2 s)..." << std::endl;
+                auto print = [](const char* label, const oak::JitterStats& jitter) {
+                    std::cout << label << ": " << jitter.samples << " wake-ups, mean "
+                              << jitter.mean_us << " us, p50 " << jitter.p50_us << " us, p99 "
+                              << jitter.p99_us << " us, max " << jitter.max_us << " us" << std::endl;
+                };
+                print("Default    ", oak::measureWakeupJitter({}, std::chrono::seconds(2)));
+                print("Processing ", oak::measureWakeupJitter(config.processing_thread, std::chrono::seconds(2)));
+                break;
+            }
+
             case 'q':
             case 'Q':
                 g_running = false;
@@ -0,0 +1,230 @@
+#include "DepthModule.h"
+#include "../processing/Simd.h"
+#include <algorithm>
+#include <iostream>
+
+namespace oak {
+
+// Task pool streams (per module)
+enum : uint64_t { kFrameStream, kPointCloudStream };
+
+DepthModule::DepthModule(const DepthConfig& config)
+    : config_(config), depth_queue_("depth", config.depth_queue) {
+}
+
+std::vector<dai::CameraBoardSocket> DepthModule::getRequiredSockets() const {
+    std::vector<dai::CameraBoardSocket> sockets = {dai::CameraBoardSocket::CAM_B,
+                                                   dai::CameraBoardSocket::CAM_C};
+    if (config_.align_to_rgb) {
+        sockets.push_back(dai::CameraBoardSocket::CAM_A);
+    }
+    return sockets;
+}
+
+bool DepthModule::configure(dai::Pipeline& pipeline,
+                            std::shared_ptr<dai::node::Camera> camera) {
+    // Single-camera entry point: build the stereo pair here
+    CameraNodes cameras;
+    for (auto socket : {dai::CameraBoardSocket::CAM_B, dai::CameraBoardSocket::CAM_C}) {
+        auto node = pipeline.create<dai::node::Camera>();
+        node->build(socket);
+        cameras[socket] = node;
+    }
+    if (camera) {
+        cameras[dai::CameraBoardSocket::CAM_A] = camera;
+    }
+    return configureCameras(pipeline, cameras);
+}
+
+bool DepthModule::configureCameras(dai::Pipeline& pipeline, const CameraNodes& cameras) {
+    try {
+        auto leftIt = cameras.find(dai::CameraBoardSocket::CAM_B);
+        auto rightIt = cameras.find(dai::CameraBoardSocket::CAM_C);
+        if (leftIt == cameras.end() || rightIt == cameras.end()) {
+            std::cerr << "DepthModule: stereo pair (CAM_B/CAM_C) not available" << std::endl;
+            return false;
+        }
+        auto left = leftIt->second;
+        auto right = rightIt->second;
+
+        auto* leftOutput = left->requestOutput(
+            {config_.width, config_.height},
+            std::nullopt,
+            dai::ImgResizeMode::CROP,
+            config_.fps
+        );
+        auto* rightOutput = right->requestOutput(
+            {config_.width, config_.height},
+            std::nullopt,
+            dai::ImgResizeMode::CROP,
+            config_.fps
+        );
+
+        auto stereo = pipeline.create<dai::node::StereoDepth>();
+        stereo->build(*leftOutput, *rightOutput, dai::node::StereoDepth::PresetMode::DEFAULT);
+        stereo->setLeftRightCheck(config_.left_right_check);
+        stereo->setSubpixel(config_.subpixel);
+        stereo->setExtendedDisparity(config_.extended_disparity);
+
+        // Depth is in the rectified right camera frame unless aligned to RGB
+        dai::CameraBoardSocket alignSocket = dai::CameraBoardSocket::CAM_C;
+        if (config_.align_to_rgb && cameras.count(dai::CameraBoardSocket::CAM_A)) {
+            alignSocket = dai::CameraBoardSocket::CAM_A;
+            stereo->setDepthAlign(alignSocket);
+            stereo->setOutputSize(static_cast<int>(config_.width), static_cast<int>(config_.height));
+        }
+
+        depth_queue_.open(stereo->depth);
+
+        // Intrinsics for the ray tables; rescaled later if the frame size differs
+        if (config_.generate_point_cloud) {
+            auto device = pipeline.getDefaultDevice();
+            if (device) {
+                auto calib = device->readCalibration();
+                auto k = calib.getCameraIntrinsics(alignSocket,
+                                                   static_cast<int>(config_.width),
+                                                   static_cast<int>(config_.height));
+                if (k.size() == 3 && k[0].size() == 3 && k[1].size() == 3) {
+                    intrinsics_.fx = k[0][0];
+                    intrinsics_.fy = k[1][1];
+                    intrinsics_.cx = k[0][2];
+                    intrinsics_.cy = k[1][2];
+                    intrinsics_.width = config_.width;
+                    intrinsics_.height = config_.height;
+                }
+            }
+            if (!intrinsics_.valid()) {
+                std::cerr << "DepthModule: no calibration available, point clouds disabled" << std::endl;
+                config_.generate_point_cloud = false;
+            }
+        }
+
+        std::cout << "DepthModule configured: " << config_.width << "x" << config_.height
+                  << " @ " << config_.fps << " fps, point cloud "
+                  << (config_.generate_point_cloud ? simdBackendName() : "off") << std::endl;
+
+        return true;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to configure DepthModule: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<StreamDemand> DepthModule::getStreamDemands() const {
+    // Only depth crosses the link; the mono streams stay on the device
+    StreamDemand depth;
+    depth.name = "depth";
+    depth.width = config_.width;
+    depth.height = config_.height;
+    depth.fps = config_.fps;
+    depth.bytes_per_pixel = 2.0f;        // RAW16 millimetres
+    depth.min_fps = std::min(config_.fps, 10.0f);
+    depth.min_width = std::min(config_.width, 640u);  // 640x400 is the smallest mono sensor mode
+    return {depth};
+}
+
+void DepthModule::applyStreamPlan(const std::vector<PlannedStream>& streams) {
+    for (const auto& stream : streams) {
+        if (stream.requested.name == "depth") {
+            config_.width = stream.planned.width;
+            config_.height = stream.planned.height;
+            config_.fps = stream.planned.fps;
+        }
+    }
+}
+
+void DepthModule::process() {
+    if (!depth_queue_.isOpen()) {
+        return;
+    }
+
+    auto depthFrame = depth_queue_.next<dai::ImgFrame>();
+    if (!depthFrame) {
+        return;
+    }
+
+    int64_t seq = depthFrame->getSequenceNum();
+    TraceSpan processSpan("process", "DepthModule", seq);
+    markFrame();
+
+    if (auto callback = frameCallback()) {
+        runOnStream(kFrameStream, [callback, depthFrame, seq] {
+            TraceSpan span("frame_callback", "DepthModule", seq);
+            (*callback)(depthFrame);
+        });
+    }
+
+    // RAW16 depth in millimeters, wrapped without a copy
+    cv::Mat depth = depthFrame->getFrame();
+    if (depth.empty()) {
+        return;
+    }
+
+    // Point clouds are built on the task pool; the stream keeps the
+    // generator and output buffers to one frame at a time
+    if (config_.generate_point_cloud && point_cloud_callback_) {
+        runOnStream(kPointCloudStream, [this, depthFrame, seq] {
+            buildPointCloud(depthFrame->getFrame(), seq);
+        });
+    }
+
+    if (show_preview_) {
+        TraceSpan span("imshow", "DepthModule", seq);
+        showDepth(depth);
+    }
+}
+
+void DepthModule::buildPointCloud(const cv::Mat& depth, int64_t seq) {
+    auto cols = static_cast<uint32_t>(depth.cols);
+    auto rows = static_cast<uint32_t>(depth.rows);
+    if (cols != intrinsics_.width || rows != intrinsics_.height) {
+        generator_.setIntrinsics(intrinsics_.scaled(cols, rows));
+    } else {
+        generator_.setIntrinsics(intrinsics_);
+    }
+
+    TraceSpan generateSpan("point_cloud", "DepthModule", seq);
+    generator_.generate(depth.ptr<uint16_t>(), depth.step / sizeof(uint16_t),
+                        config_.min_depth_m, config_.max_depth_m, cloud_);
+    cloud_.sequence_num = seq;
+    generateSpan.end();
+
+    const PointCloud* result = &cloud_;
+    if (config_.voxel_size_m > 0.0f) {
+        TraceSpan span("voxel_downsample", "DepthModule", seq);
+        voxel_grid_.downsample(cloud_, config_.voxel_size_m, downsampled_);
+        result = &downsampled_;
+    }
+
+    TraceSpan callbackSpan("point_cloud_callback", "DepthModule", seq);
+    point_cloud_callback_(*result);
+}
+
+void DepthModule::showDepth(const cv::Mat& depth) {
+    // Member buffers keep their allocation between frames
+    cv::normalize(depth, depth8_, 0, 255, cv::NORM_MINMAX, CV_8U);
+    cv::applyColorMap(depth8_, colored_, cv::COLORMAP_JET);
+
+    AllocationCounter::Exclude gui;
+    cv::imshow("Depth", colored_);
+
+    int key = cv::waitKey(1);
+    if (key == 'q' || key == 'Q' || key == 27) {
+        show_preview_ = false;
+        cv::destroyWindow("Depth");
+    }
+}
+
+void DepthModule::cleanup() {
+    if (show_preview_) {
+        cv::destroyAllWindows();
+    }
+    depth_queue_.reset();
+}
+
+std::vector<QueueStats> DepthModule::getQueueStats() const {
+    return {depth_queue_.getStats()};
+}
+
+} // namespace oak
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../engine/ModuleBase.h"
+#include "../engine/Types.h"
+#include "../processing/PointCloud.h"
+#include <opencv2/opencv.hpp>
+
+namespace oak {
+
+class DepthModule : public ModuleBase {
+public:
+    explicit DepthModule(const DepthConfig& config);
+    ~DepthModule() override = default;
+
+    // Runs on the CAM_B/CAM_C mono pair; CAM_A is only requested as the
+    // alignment target when align_to_rgb is set.
+    bool configure(dai::Pipeline& pipeline,
+                  std::shared_ptr<dai::node::Camera> camera) override;
+    bool configureCameras(dai::Pipeline& pipeline, const CameraNodes& cameras) override;
+    std::vector<dai::CameraBoardSocket> getRequiredSockets() const override;
+
+    std::string getName() const override { return "DepthModule"; }
+    ModuleState getStateType() const override { return ModuleState::DEPTH; }
+
+    std::vector<StreamDemand> getStreamDemands() const override;
+    void applyStreamPlan(const std::vector<PlannedStream>& streams) override;
+
+    void process() override;
+    void cleanup() override;
+    std::vector<QueueStats> getQueueStats() const override;
+
+    void setPointCloudCallback(PointCloudCallback callback) { point_cloud_callback_ = callback; }
+
+private:
+    void buildPointCloud(const cv::Mat& depth, int64_t seq);
+    void showDepth(const cv::Mat& depth);
+
+    DepthConfig config_;
+    StreamQueue depth_queue_;
+
+    CameraIntrinsics intrinsics_;        // Calibrated at the configured resolution
+    PointCloudGenerator generator_;
+    VoxelGrid voxel_grid_;
+    PointCloud cloud_;
+    PointCloud downsampled_;
+
+    PointCloudCallback point_cloud_callback_;
+    bool show_preview_ = true;
+    cv::Mat depth8_;                     // Display buffers, reused per frame
+    cv::Mat colored_;
+};
+
+} // namespace oak
@@ -1,6 +1,10 @@
 #include "InferenceModule.h"
+#include "../processing/FrameConvert.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstdio>
 
 namespace oak {
 
@@ -20,8 +24,187 @@ static const std::vector<std::string> COCO_LABELS = {
     "toothbrush"
 };
 
+// Task pool streams (per module)
+enum : uint64_t { kFrameStream, kDetectionStream, kCropStream };
+
+// Link budget estimate for one ImgDetections message (a few dozen detections)
+constexpr double kDetectionMessageBytes = 2048.0;
+
+// Device side of the motion gate: forwards detector input frames according
+// to the mode the host sends (0 = paused, 1 = every frame, N = every Nth).
+// The last frame dropped while closed is held back and sent as soon as the
+// gate opens, so detection resumes without waiting for the next camera
+// frame. Every {REPORT} frames and on each mode change it reports how many
+// frames it forwarded and dropped (two little-endian uint32) on 'stats'.
+static const char* kMotionGateScript = R"(
+import time
+mode = 1
+count = 0
+frames = 0
+processed = 0
+gated = 0
+reports = 0
+held = None
+
+def report():
+    global reports
+    data = processed.to_bytes(4, 'little') + gated.to_bytes(4, 'little')
+    buf = Buffer(len(data))
+    buf.setData(list(data))
+    buf.setSequenceNum(reports)
+    node.io['stats'].send(buf)
+    reports += 1
+
+while True:
+    gate = node.io['gate'].tryGet()
+    if gate is not None:
+        mode = gate.getData()[0]
+        count = 0
+        if mode == 1 and held is not None:
+            node.io['out'].send(held)
+            processed += 1
+            gated -= 1
+        held = None
+        report()
+    frame = node.io['frames'].tryGet()
+    if frame is None:
+        time.sleep(0.001)
+        continue
+    if mode == 1 or (mode > 1 and count % mode == 0):
+        node.io['out'].send(frame)
+        processed += 1
+        held = None
+    else:
+        gated += 1
+        held = frame
+    count += 1
+    frames += 1
+    if frames % {REPORT} == 0:
+        report()
+)";
+
+// Frames between the gate script's count reports
+constexpr uint32_t kGateReportFrames = 30;
+
+// Device side of tiling: cuts each frame into the tiles listed in {TILES}
+// via an ImageManip, numbering tile messages frame * stride + tile. Frames
+// are counted here rather than taken from the camera, so a lost tile shows
+// up as a gap on the host while frames skipped for lack of NN time do not.
+// Messages pass between device nodes by reference, so the number goes on
+// each ImageManip output (routed back through the script, one tile at a
+// time) rather than on the frame all tiles share.
+static const char* kTilingScript = R"(
+tiles = [{TILES}]
+frame_count = 0
+while True:
+    frame = node.io['frames'].get()
+    for i, (x, y, w, h) in enumerate(tiles):
+        cfg = ImageManipConfig()
+        cfg.addCrop(x, y, w, h)
+        cfg.setOutputSize({WIDTH}, {HEIGHT}, ImageManipConfig.ResizeMode.LETTERBOX)
+        cfg.setFrameType(ImgFrame.Type.BGR888i)
+        node.io['config'].send(cfg)
+        node.io['image'].send(frame)
+        tile = node.io['tiles'].get()
+        tile.setSequenceNum(frame_count * {STRIDE} + i)
+        node.io['out'].send(tile)
+    frame_count += 1
+)";
+
+// Device side of cascade crops: pairs each detection message with the
+// high-resolution frame of the same capture and cuts the first {MAX}
+// detections (with a label in {LABELS}, empty = all) out of it via an
+// ImageManip. Crop messages are numbered detections * stride + index; as
+// with tiling, the number goes on each ImageManip output (routed back
+// through the script) since every crop of a frame shares the frame object.
+// Boxes arrive relative to the letterboxed NN input, whose content spans
+// {CW} x {CH} of it from ({OX}, {OY}).
+static const char* kCascadeCropScript = R"(
+import time
+labels = [{LABELS}]
+frames = []
+while True:
+    dets = node.io['detections'].get()
+    ts = dets.getTimestampDevice()
+    match = None
+    match_index = 0
+    for attempt in range(100):
+        frame = node.io['frames'].tryGet()
+        while frame is not None:
+            frames.append(frame)
+            frame = node.io['frames'].tryGet()
+        frames = frames[-{HISTORY}:]
+        for j, f in enumerate(frames):
+            if abs((f.getTimestampDevice() - ts).total_seconds()) * 1000.0 <= {TOLERANCE}:
+                match = f
+                match_index = j
+        if match is not None or (frames and frames[-1].getTimestampDevice() > ts):
+            break
+        time.sleep(0.002)
+    if match is None:
+        continue
+    # Later detections belong to later captures
+    frames = frames[match_index + 1:]
+    w = match.getWidth()
+    h = match.getHeight()
+    seq = dets.getSequenceNum()
+    count = 0
+    for i, det in enumerate(dets.detections):
+        if count >= {MAX} or i >= {STRIDE}:
+            break
+        if labels and det.label not in labels:
+            continue
+        xmin = (det.xmin - {OX}) / {CW}
+        xmax = (det.xmax - {OX}) / {CW}
+        ymin = (det.ymin - {OY}) / {CH}
+        ymax = (det.ymax - {OY}) / {CH}
+        pad_x = (xmax - xmin) * {PADDING}
+        pad_y = (ymax - ymin) * {PADDING}
+        x1 = int(max(0.0, xmin - pad_x) * w) & ~1
+        y1 = int(max(0.0, ymin - pad_y) * h) & ~1
+        x2 = min(w, (int(min(1.0, xmax + pad_x) * w) + 1) & ~1)
+        y2 = min(h, (int(min(1.0, ymax + pad_y) * h) + 1) & ~1)
+        x2 = max(x2, min(w, x1 + 2))
+        y2 = max(y2, min(h, y1 + 2))
+        cfg = ImageManipConfig()
+        cfg.addCrop(x1, y1, x2 - x1, y2 - y1)
+        cfg.setOutputSize({WIDTH}, {HEIGHT}, ImageManipConfig.ResizeMode.{RESIZE})
+        cfg.setFrameType(ImgFrame.Type.BGR888i)
+        node.io['config'].send(cfg)
+        node.io['image'].send(match)
+        crop = node.io['crops'].get()
+        crop.setSequenceNum(seq * {STRIDE} + i)
+        node.io['out'].send(crop)
+        count += 1
+)";
+
+static void replaceAll(std::string& text, const std::string& key, const std::string& value) {
+    for (size_t pos = text.find(key); pos != std::string::npos; pos = text.find(key, pos + value.size())) {
+        text.replace(pos, key.size(), value);
+    }
+}
+
 InferenceModule::InferenceModule(const InferenceConfig& config) 
-    : config_(config), labels_(COCO_LABELS) {
+    : config_(config),
+      preview_queue_("inference_preview", config.preview_queue),
+      detection_queue_("detections", config.detection_queue),
+      motion_queue_("motion", config.motion_gate.queue),
+      gate_stats_queue_("gate_stats", QueueConfig{4, false, QueuePolicy::LATEST_ONLY}),
+      crop_queue_("crop_source", config.crops.source_queue),
+      cascade_crop_queue_("cascade_crops", config.cascade.crop_queue),
+      labels_(COCO_LABELS),
+      show_preview_(config.show_preview) {
+    if (config_.cascade.enabled) {
+        // Tile detections are merged on the host, so the device cannot crop them
+        if (config_.cascade.crop_source == CascadeCropSource::DEVICE && config_.tiling.enabled) {
+            std::cerr << "InferenceModule cascade: device crops need an untiled detector, cropping on the host"
+                      << std::endl;
+            config_.cascade.crop_source = CascadeCropSource::HOST;
+        }
+        if (config_.cascade.crop_source == CascadeCropSource::HOST) {
+            config_.crops.enabled = true;
+        }
+    }
 }
 
 bool InferenceModule::configure(dai::Pipeline& pipeline,
@@ -29,13 +212,51 @@ bool InferenceModule::configure(dai::Pipeline& pipeline,
     try {
         // V3 API: Request camera output sized for neural network input
         // Note: Camera resizer only supports BGR888i (interleaved), not BGR888p (planar)
-        auto* nnInput = camera->requestOutput(
-            {config_.input_width, config_.input_height},
-            dai::ImgFrame::Type::BGR888i,
-            dai::ImgResizeMode::LETTERBOX,  // Preserve aspect ratio for NN
-            30.0f,
-            false
-        );
+        // With tiling the network is fed crops of a high-resolution stream instead
+        auto* nnInput = config_.tiling.enabled
+            ? camera->requestOutput(
+                  {config_.tiling.source_width, config_.tiling.source_height},
+                  dai::ImgFrame::Type::NV12,
+                  dai::ImgResizeMode::CROP,
+                  config_.tiling.source_fps,
+                  false)
+            : camera->requestOutput(
+                  {config_.input_width, config_.input_height},
+                  dai::ImgFrame::Type::BGR888i,
+                  dai::ImgResizeMode::LETTERBOX,  // Preserve aspect ratio for NN
+                  config_.input_fps,
+                  false);
+
+        // Motion gate: a Script node between camera and network drops frames
+        // while the host sees a static scene
+        dai::Node::Output* nnSource = nnInput;
+        if (config_.motion_gate.enabled) {
+            auto script = pipeline.create<dai::node::Script>();
+            std::string gateScript = kMotionGateScript;
+            replaceAll(gateScript, "{REPORT}", std::to_string(kGateReportFrames));
+            script->setScript(gateScript);
+            script->inputs["frames"].setBlocking(false);
+            script->inputs["frames"].setMaxSize(1);
+            nnInput->link(script->inputs["frames"]);
+            gate_queue_ = script->inputs["gate"].createInputQueue();
+            nnSource = &script->outputs["out"];
+            gate_stats_queue_.open(script->outputs["stats"]);
+
+            // Tiny NV12 stream; the host only reads its luma plane
+            auto* motionOutput = camera->requestOutput(
+                {config_.motion_gate.width, config_.motion_gate.height},
+                dai::ImgFrame::Type::NV12,
+                dai::ImgResizeMode::STRETCH,
+                nnInputFps(),
+                false
+            );
+            motion_queue_.open(*motionOutput);
+            motion_gate_ = std::make_unique<MotionGate>(config_.motion_gate);
+        }
+
+        if (config_.tiling.enabled) {
+            nnSource = buildTiling(pipeline, *nnSource);
+        }
 
         // Create detection network node
         // V3 API supports NNArchive for model loading
@@ -46,28 +267,61 @@ bool InferenceModule::configure(dai::Pipeline& pipeline,
             config_.model_path.find(".tar") != std::string::npos) {
             // Use NNArchive for packaged models
             dai::NNArchive archive(config_.model_path);
-            detectionNetwork->build(*nnInput, archive);
+            detectionNetwork->build(*nnSource, archive);
         } else {
             // Use blob path directly
             detectionNetwork->setBlobPath(config_.model_path);
-            nnInput->link(detectionNetwork->input);
+            nnSource->link(detectionNetwork->input);
         }
         
         detectionNetwork->setConfidenceThreshold(config_.confidence_threshold);
+        if (tile_merger_) {
+            // A whole frame of tiles waits in front of the network and two
+            // inference threads overlap, so the NN never idles between tiles
+            detectionNetwork->input.setBlocking(true);
+            detectionNetwork->input.setMaxSize(static_cast<int>(tile_merger_->tileCount()));
+            detectionNetwork->setNumInferenceThreads(2);
+        }
+        applyTuning(*detectionNetwork);
 
         // Create output queues
-        detection_queue_ = detectionNetwork->out.createOutputQueue(4, false);
+        detection_queue_.open(detectionNetwork->out);
+
+        if (config_.cascade.enabled) {
+            if (!createCascade()) {
+                return false;
+            }
+            if (config_.cascade.crop_source == CascadeCropSource::DEVICE) {
+                buildDeviceCrops(pipeline, camera, detectionNetwork->out);
+            }
+        }
+
+        // Crops are cut on the host from a stream of the same captures;
+        // untiled detections are relative to the letterboxed NN input
+        if (config_.crops.enabled) {
+            auto* cropOutput = camera->requestOutput(
+                {config_.crops.source_width, config_.crops.source_height},
+                transportFrameType(config_.crops.source_transport),
+                dai::ImgResizeMode::CROP,
+                cropSourceFps(),
+                false
+            );
+            crop_queue_.open(*cropOutput);
+            createCropExtractor(!config_.tiling.enabled);
+        }
 
         // Create preview output for visualization
         // Note: Camera resizer only supports BGR888i (interleaved), not BGR888p (planar)
+        // Tiled detections are in full-frame coordinates, so the preview then
+        // gets the high-resolution stream's field of view
         auto* previewOutput = camera->requestOutput(
-            {640, 480},
-            dai::ImgFrame::Type::BGR888i,
-            dai::ImgResizeMode::LETTERBOX,
-            30.0f,
+            {config_.preview_width, previewHeight()},
+            transportFrameType(config_.preview_transport),
+            config_.tiling.enabled ? dai::ImgResizeMode::CROP : dai::ImgResizeMode::LETTERBOX,
+            config_.preview_fps,
             false
         );
-        preview_queue_ = previewOutput->createOutputQueue(4, false);
+        preview_queue_.open(*previewOutput);
 
         std::cout << "InferenceModule configured: " << config_.model_path << std::endl;
         std::cout << "Input size: " << config_.input_width << "x" << config_.input_height << std::endl;
@@ -80,39 +334,205 @@ bool InferenceModule::configure(dai::Pipeline& pipeline,
     }
 }
 
+dai::Node::Output* InferenceModule::buildTiling(dai::Pipeline& pipeline, dai::Node::Output& source) {
+    createTileMerger();
+    const auto& tiles = tile_merger_->tiles();
+
+    std::ostringstream list;
+    for (const auto& tile : tiles) {
+        list << "(" << tile.x << ", " << tile.y << ", " << tile.width << ", " << tile.height << "), ";
+    }
+    std::string code = kTilingScript;
+    replaceAll(code, "{TILES}", list.str());
+    replaceAll(code, "{WIDTH}", std::to_string(config_.input_width));
+    replaceAll(code, "{HEIGHT}", std::to_string(config_.input_height));
+    replaceAll(code, "{STRIDE}", std::to_string(TileMerger::kSequenceStride));
+
+    auto script = pipeline.create<dai::node::Script>();
+    script->setScript(code);
+    // Frames arriving while a frame's tiles are still queued are dropped here
+    script->inputs["frames"].setBlocking(false);
+    script->inputs["frames"].setMaxSize(1);
+    source.link(script->inputs["frames"]);
+
+    auto manip = pipeline.create<dai::node::ImageManip>();
+    manip->inputConfig.setWaitForMessage(true);  // One config per image
+    manip->setMaxOutputFrameSize(static_cast<int>(config_.input_width * config_.input_height * 3));
+    manip->setNumFramesPool(static_cast<int>(tiles.size()) + 2);
+    script->outputs["config"].link(manip->inputConfig);
+    script->outputs["image"].link(manip->inputImage);
+    // Each crop comes back to be numbered before it goes to the network
+    script->inputs["tiles"].setBlocking(true);
+    script->inputs["tiles"].setMaxSize(1);
+    manip->out.link(script->inputs["tiles"]);
+
+    std::cout << "Tiling: " << tiles.size() << " tiles per " << config_.tiling.source_width << "x"
+              << config_.tiling.source_height << " frame" << std::endl;
+    return &script->outputs["out"];
+}
+
+void InferenceModule::createTileMerger() {
+    auto tiles = computeTiles(config_.tiling.source_width, config_.tiling.source_height,
+                              config_.input_width, config_.input_height, config_.tiling);
+    tile_merger_ = std::make_unique<TileMerger>(std::move(tiles), config_.tiling.source_width,
+                                                config_.tiling.source_height, config_.tiling);
+    detection_queue_.setSequenceStride(TileMerger::kSequenceStride,
+                                       static_cast<int64_t>(tile_merger_->tileCount()));
+    // Merged messages return to the pool when consumers release them
+    merging_.reset();
+    merged_pool_ = std::make_unique<ObjectPool<dai::ImgDetections>>(SIZE_MAX, [] {
+        auto message = std::make_unique<dai::ImgDetections>();
+        message->detections.reserve(256);
+        return message;
+    });
+}
+
+bool InferenceModule::configureSimulated(SimulatedSource& source) {
+    // Detections come from the source instead of a network; no model is loaded
+    uint32_t tiles = 1;
+    if (config_.tiling.enabled) {
+        try {
+            createTileMerger();
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to configure InferenceModule tiling: " << e.what() << std::endl;
+            return false;
+        }
+        tiles = static_cast<uint32_t>(tile_merger_->tileCount());
+    }
+    detection_queue_.open(source.addDetectionOutput("detections", config_.detection_queue, tiles));
+    preview_queue_.open(source.addFrameOutput("inference_preview", config_.preview_width, previewHeight(), config_.preview_queue,
+                                              transportFrameType(config_.preview_transport)));
+    if (config_.cascade.enabled) {
+        // No device to crop on
+        if (config_.cascade.crop_source == CascadeCropSource::DEVICE) {
+            config_.cascade.crop_source = CascadeCropSource::HOST;
+            config_.crops.enabled = true;
+        }
+        if (!createCascade()) {
+            return false;
+        }
+    }
+    if (config_.crops.enabled) {
+        crop_queue_.open(source.addFrameOutput("crop_source", config_.crops.source_width, config_.crops.source_height,
+                                               config_.crops.source_queue,
+                                               transportFrameType(config_.crops.source_transport)));
+        createCropExtractor(false);
+    }
+    if (config_.motion_gate.enabled) {
+        // Without a device script the gate drops detection messages on the host
+        motion_queue_.open(source.addFrameOutput("motion", config_.motion_gate.width, config_.motion_gate.height,
+                                                 config_.motion_gate.queue, dai::ImgFrame::Type::GRAY8));
+        motion_gate_ = std::make_unique<MotionGate>(config_.motion_gate);
+    }
+    std::cout << "InferenceModule configured (simulated)" << std::endl;
+    return true;
+}
+
 void InferenceModule::process() {
-    cv::Mat frame;
-    std::vector<dai::ImgDetection> detections;
+    bool got_frame = false;
+    std::shared_ptr<dai::ImgDetections> detectionsMsg;
+    int64_t seq = -1;
+    TraceSpan processSpan("process", "InferenceModule");
+
+    // Motion first, so a frame with new motion reopens the gate right away
+    if (motion_gate_ && motion_queue_.isOpen()) {
+        if (auto motionFrame = motion_queue_.next<dai::ImgFrame>()) {
+            updateMotionGate(*motionFrame);
+        }
+        // What the device script actually forwarded, for the processed/gated counts
+        if (auto counts = gate_stats_queue_.next<dai::Buffer>()) {
+            const auto& data = counts->getData();
+            if (data.size() >= 8) {
+                auto word = [&](size_t offset) {
+                    return static_cast<uint32_t>(data[offset]) | static_cast<uint32_t>(data[offset + 1]) << 8 |
+                           static_cast<uint32_t>(data[offset + 2]) << 16 |
+                           static_cast<uint32_t>(data[offset + 3]) << 24;
+                };
+                motion_gate_->setDeviceCounts(word(0), word(4));
+            }
+        }
+    }
     
     // Get preview frame
-    if (preview_queue_) {
-        auto previewFrame = preview_queue_->tryGet<dai::ImgFrame>();
+    if (preview_queue_.isOpen()) {
+        auto previewFrame = preview_queue_.next<dai::ImgFrame>();
         if (previewFrame) {
-            frame = previewFrame->getCvFrame();
+            got_frame = true;
+            seq = previewFrame->getSequenceNum();
+            markFrame();
+            if (show_preview_) {
+                // Copied into a reused buffer: the overlay must not touch the
+                // message, which the frame callback may be reading
+                TraceSpan span("copyFrame", "InferenceModule", seq);
+                cv::Mat bgr = toBgr(*previewFrame, display_frame_);  // NV12 lands in display_frame_ directly
+                if (bgr.data != display_frame_.data) {
+                    bgr.copyTo(display_frame_);
+                }
+            }
             
-            if (frame_callback_) {
-                frame_callback_(previewFrame);
+            if (auto callback = frameCallback()) {
+                runOnStream(kFrameStream, [callback, previewFrame, seq] {
+                    TraceSpan span("frame_callback", "InferenceModule", seq);
+                    (*callback)(previewFrame);
+                });
             }
         }
     }
 
+    // Crop source frames before detections, so a message finds its frame
+    if (crop_extractor_ && crop_queue_.isOpen()) {
+        while (auto cropFrame = crop_queue_.next<dai::ImgFrame>()) {
+            crop_extractor_->addFrame(std::move(cropFrame));
+        }
+    }
+
     // Get detections
-    if (detection_queue_) {
-        auto detectionsMsg = detection_queue_->tryGet<dai::ImgDetections>();
+    if (detection_queue_.isOpen() && tile_merger_) {
+        // Drained so a frame's tiles are merged as soon as the last one lands
+        while (auto tileMsg = detection_queue_.next<dai::ImgDetections>()) {
+            if (auto merged = mergeTile(*tileMsg)) {
+                detectionsMsg = merged;
+                deliverDetections(merged);
+            }
+        }
+    } else if (detection_queue_.isOpen()) {
+        detectionsMsg = detection_queue_.next<dai::ImgDetections>();
         if (detectionsMsg) {
-            detections = detectionsMsg->detections;
-            
-            if (detection_callback_) {
-                detection_callback_(detectionsMsg);
+            deliverDetections(detectionsMsg);
+        }
+    }
+    if (detectionsMsg && !gate_queue_ && !gate_run_) {
+        detectionsMsg.reset();  // Host-side gating (simulated source)
+    }
+
+    // Device crops after their detections, which open the cascade message
+    if (cascade_) {
+        if (cascade_crop_queue_.isOpen()) {
+            while (auto crop = cascade_crop_queue_.next<dai::ImgFrame>()) {
+                device_crops_.push_back(std::move(crop));
             }
+            submitDeviceCrops();
         }
+        cascade_->expire();
+    }
+
+    if (!got_frame && !detectionsMsg) {
+        processSpan.cancel();
+    } else {
+        processSpan.setSequence(seq);
     }
 
     // Display with detections overlay
-    if (!frame.empty() && show_preview_) {
-        drawDetections(frame, detections);
+    if (got_frame && show_preview_) {
+        {
+            TraceSpan span("drawDetections", "InferenceModule", seq);
+            static const std::vector<dai::ImgDetection> kNoDetections;
+            drawDetections(display_frame_, detectionsMsg ? detectionsMsg->detections : kNoDetections);
+        }
         
-        cv::imshow("Inference", frame);
+        TraceSpan displaySpan("imshow", "InferenceModule", seq);
+        AllocationCounter::Exclude gui;
+        cv::imshow("Inference", display_frame_);
         
         int key = cv::waitKey(1);
         if (key == 'q' || key == 'Q' || key == 27) {
@@ -122,8 +542,381 @@ void InferenceModule::process() {
     }
 }
 
+void InferenceModule::applyTuning(dai::node::DetectionNetwork& network) {
+    const auto& tuning = config_.tuning;
+    if (tuning.isDefault()) {
+        return;
+    }
+    if (tuning.inference_threads > 0) {
+        network.setNumInferenceThreads(tuning.inference_threads);
+    }
+    if (tuning.nce_per_thread > 0) {
+        network.setNumNCEPerInferenceThread(tuning.nce_per_thread);
+    }
+    if (tuning.shaves_per_thread > 0) {
+        network.setNumShavesPerInferenceThread(tuning.shaves_per_thread);
+    }
+    if (tuning.pool_frames > 0) {
+        network.setNumPoolFrames(tuning.pool_frames);
+    }
+    if (tuning.input_queue_size > 0) {
+        network.input.setBlocking(true);
+        network.input.setMaxSize(tuning.input_queue_size);
+    }
+    std::cout << "InferenceModule tuning: " << tuning.inference_threads << " threads, "
+              << tuning.nce_per_thread << " NCE, " << tuning.shaves_per_thread << " shaves per thread, pool "
+              << tuning.pool_frames << ", input queue " << tuning.input_queue_size << " (0 = default)" << std::endl;
+}
+
+void InferenceModule::deliverDetections(const std::shared_ptr<dai::ImgDetections>& detections) {
+    if (!gate_queue_ && !gate_run_) {
+        return;  // Host-side gating (simulated source)
+    }
+    if (crop_extractor_) {
+        crop_extractor_->addDetections(detections);
+    }
+    if (cascade_ && cascade_crop_queue_.isOpen()) {
+        beginCascade(detections);
+    }
+    if (auto callback = detectionCallback()) {
+        runOnStream(kDetectionStream, [callback, detections] {
+            TraceSpan span("detection_callback", "InferenceModule", detections->getSequenceNum());
+            (*callback)(detections);
+        });
+    }
+}
+
+std::shared_ptr<dai::ImgDetections> InferenceModule::mergeTile(const dai::ImgDetections& tile) {
+    // A pooled message; the pool only grows while consumers lag
+    if (!merging_) {
+        merging_ = merged_pool_->acquire();
+    }
+
+    int64_t frame = -1;
+    if (!tile_merger_->add(tile.getSequenceNum(), tile.detections, merging_->detections, frame)) {
+        return nullptr;
+    }
+    TraceSpan span("merge_tiles", "InferenceModule", frame);
+    merging_->setSequenceNum(frame);
+    merging_->setTimestamp(tile.getTimestamp());
+    merging_->setTimestampDevice(tile.getTimestampDevice());
+    return std::move(merging_);
+}
+
+void InferenceModule::createCropExtractor(bool letterboxed) {
+    if (config_.tiling.enabled &&
+        config_.crops.source_width * config_.tiling.source_height !=
+            config_.crops.source_height * config_.tiling.source_width) {
+        std::cerr << "InferenceModule crops: source aspect differs from the tiled stream's, crops will be offset"
+                  << std::endl;
+    }
+    crop_extractor_ = std::make_unique<CropExtractor>(config_.crops, task_pool_, poolStream(kCropStream));
+    crop_extractor_->setDetectionSpace(config_.input_width, config_.input_height, letterboxed);
+    crop_extractor_->setCallback(cropDelivery());
+    std::cout << "Crops: " << config_.crops.output_width << "x" << config_.crops.output_height << " from "
+              << config_.crops.source_width << "x" << config_.crops.source_height << " @ " << cropSourceFps()
+              << " fps" << std::endl;
+}
+
+float InferenceModule::cropSourceFps() const {
+    if (config_.crops.source_fps > 0.0f) {
+        return config_.crops.source_fps;
+    }
+    // One source frame per detector frame
+    return nnInputFps();
+}
+
+float InferenceModule::nnInputFps() const {
+    return config_.tiling.enabled ? config_.tiling.source_fps : config_.input_fps;
+}
+
+void InferenceModule::setCropCallback(CropCallback callback) {
+    crop_callback_ = callback;
+    if (crop_extractor_) {
+        crop_extractor_->setCallback(cropDelivery());
+    }
+}
+
+CropCallback InferenceModule::cropDelivery() const {
+    if (!cascade_ || config_.cascade.crop_source != CascadeCropSource::HOST) {
+        return crop_callback_;
+    }
+    // Crops go to the cascade first; the user callback sees the same set
+    auto user = crop_callback_;
+    CascadeClassifier* cascade = cascade_.get();
+    return [user, cascade](const CropSet& set) {
+        cascade->addCrops(set);
+        if (user) {
+            user(set);
+        }
+    };
+}
+
+bool InferenceModule::createCascade() {
+    cascade_ = std::make_unique<CascadeClassifier>(config_.cascade, config_.crops.output_width,
+                                                   config_.crops.output_height);
+    cascade_->setCallback(cascade_callback_);
+    if (!cascade_->start()) {
+        cascade_.reset();
+        std::cerr << "Failed to configure InferenceModule cascade" << std::endl;
+        return false;
+    }
+    std::cout << "Cascade: " << config_.cascade.model_path << " on "
+              << (config_.cascade.crop_source == CascadeCropSource::DEVICE ? "device" : "host") << " crops"
+              << std::endl;
+    return true;
+}
+
+void InferenceModule::buildDeviceCrops(dai::Pipeline& pipeline, std::shared_ptr<dai::node::Camera> camera,
+                                       dai::Node::Output& detections) {
+    const auto& crops = config_.crops;
+    auto* source = camera->requestOutput(
+        {crops.source_width, crops.source_height},
+        dai::ImgFrame::Type::NV12,
+        dai::ImgResizeMode::CROP,
+        cropSourceFps(),
+        false
+    );
+
+    // Where the source's field of view sits in the letterboxed NN input
+    float scale = std::min(static_cast<float>(config_.input_width) / crops.source_width,
+                           static_cast<float>(config_.input_height) / crops.source_height);
+    float content_w = crops.source_width * scale / config_.input_width;
+    float content_h = crops.source_height * scale / config_.input_height;
+
+    std::ostringstream labels;
+    for (uint32_t label : crops.labels) {
+        labels << label << ", ";
+    }
+    std::string code = kCascadeCropScript;
+    replaceAll(code, "{LABELS}", labels.str());
+    replaceAll(code, "{HISTORY}", std::to_string(std::max(crops.frame_history, 1u)));
+    replaceAll(code, "{TOLERANCE}", std::to_string(crops.match_tolerance_ms));
+    replaceAll(code, "{MAX}", std::to_string(crops.max_crops));
+    replaceAll(code, "{STRIDE}", std::to_string(TileMerger::kSequenceStride));
+    replaceAll(code, "{OX}", std::to_string((1.0f - content_w) * 0.5f));
+    replaceAll(code, "{OY}", std::to_string((1.0f - content_h) * 0.5f));
+    replaceAll(code, "{CW}", std::to_string(content_w));
+    replaceAll(code, "{CH}", std::to_string(content_h));
+    replaceAll(code, "{PADDING}", std::to_string(crops.padding));
+    replaceAll(code, "{WIDTH}", std::to_string(crops.output_width));
+    replaceAll(code, "{HEIGHT}", std::to_string(crops.output_height));
+    replaceAll(code, "{RESIZE}", crops.keep_aspect ? "LETTERBOX" : "STRETCH");
+
+    auto script = pipeline.create<dai::node::Script>();
+    script->setScript(code);
+    script->inputs["frames"].setBlocking(false);
+    script->inputs["frames"].setMaxSize(static_cast<int>(std::max(crops.frame_history, 1u)));
+    script->inputs["detections"].setBlocking(false);
+    script->inputs["detections"].setMaxSize(4);
+    source->link(script->inputs["frames"]);
+    detections.link(script->inputs["detections"]);
+
+    auto manip = pipeline.create<dai::node::ImageManip>();
+    manip->inputConfig.setWaitForMessage(true);  // One config per image
+    manip->setMaxOutputFrameSize(static_cast<int>(crops.output_width * crops.output_height * 3));
+    manip->setNumFramesPool(static_cast<int>(std::min(crops.max_crops, 16u)) + 2);
+    script->outputs["config"].link(manip->inputConfig);
+    script->outputs["image"].link(manip->inputImage);
+    // Each crop comes back to be numbered before it goes to the host
+    script->inputs["crops"].setBlocking(true);
+    script->inputs["crops"].setMaxSize(1);
+    manip->out.link(script->inputs["crops"]);
+
+    cascade_crop_queue_.open(script->outputs["out"]);
+    // Frames have as many crops as objects, or none
+    cascade_crop_queue_.setSequenceStride(TileMerger::kSequenceStride, 0);
+}
+
+void InferenceModule::beginCascade(const std::shared_ptr<dai::ImgDetections>& detections) {
+    // The detections the device script crops: the first max_crops with a wanted label
+    const auto& crops = config_.crops;
+    cascade_indices_.clear();
+    for (uint32_t i = 0; i < detections->detections.size(); ++i) {
+        if (cascade_indices_.size() >= crops.max_crops || i >= TileMerger::kSequenceStride) {
+            break;
+        }
+        uint32_t label = detections->detections[i].label;
+        if (crops.labels.empty() || std::find(crops.labels.begin(), crops.labels.end(), label) != crops.labels.end()) {
+            cascade_indices_.push_back(i);
+        }
+    }
+    last_cascade_seq_ = detections->getSequenceNum();
+    cascade_->beginMessage(detections, cascade_indices_);
+}
+
+void InferenceModule::submitDeviceCrops() {
+    // A crop can overtake its detections on the link; it is retried until
+    // they have been seen
+    for (size_t n = device_crops_.size(); n > 0; --n) {
+        auto crop = std::move(device_crops_.front());
+        device_crops_.pop_front();
+
+        int64_t seq = crop->getSequenceNum();
+        int64_t parent = seq / TileMerger::kSequenceStride;
+        auto index = static_cast<uint32_t>(seq % TileMerger::kSequenceStride);
+        size_t stride = crop->getStride() > 0 ? crop->getStride() : crop->getWidth() * 3;
+        cv::Mat image(static_cast<int>(crop->getHeight()), static_cast<int>(crop->getWidth()), CV_8UC3,
+                      crop->getData().data(), stride);
+        if (cascade_->submit(parent, index, image, crop) == CascadeClassifier::Submit::UNKNOWN &&
+            parent > last_cascade_seq_) {
+            device_crops_.push_back(std::move(crop));
+        }
+    }
+}
+
+void InferenceModule::setCascadeCallback(CascadeCallback callback) {
+    cascade_callback_ = callback;
+    if (cascade_) {
+        cascade_->setCallback(callback);
+    }
+}
+
+std::optional<CascadeStats> InferenceModule::getCascadeStats() const {
+    if (!cascade_) {
+        return std::nullopt;
+    }
+    return cascade_->getStats();
+}
+
+std::optional<CropStats> InferenceModule::getCropStats() const {
+    if (!crop_extractor_) {
+        return std::nullopt;
+    }
+    return crop_extractor_->getStats();
+}
+
+std::optional<TileMergeStats> InferenceModule::getTileMergeStats() const {
+    if (!tile_merger_) {
+        return std::nullopt;
+    }
+    return tile_merger_->getStats();
+}
+
+void InferenceModule::updateMotionGate(dai::ImgFrame& frame) {
+    TraceSpan span("motion_gate", "InferenceModule", frame.getSequenceNum());
+    // NV12 and GRAY8 both start with the luma plane
+    size_t stride = frame.getStride() > 0 ? frame.getStride() : frame.getWidth();
+    auto decision = motion_gate_->update(frame.getData().data(), frame.getWidth(), frame.getHeight(),
+                                         stride, std::chrono::steady_clock::now());
+    gate_run_ = decision.run;
+
+    if (decision.mode_changed && gate_queue_) {
+        auto message = std::make_shared<dai::Buffer>();
+        message->setData(std::vector<uint8_t>{decision.mode});
+        gate_queue_->send(message);
+    }
+}
+
+uint32_t InferenceModule::previewHeight() const {
+    if (!config_.tiling.enabled || config_.tiling.source_width == 0) {
+        return config_.preview_height;
+    }
+    return (config_.preview_width * config_.tiling.source_height / config_.tiling.source_width) & ~1u;
+}
+
+std::vector<StreamDemand> InferenceModule::getStreamDemands() const {
+    std::vector<StreamDemand> demands;
+
+    StreamDemand preview;
+    preview.name = "inference_preview";
+    preview.width = config_.preview_width;
+    preview.height = previewHeight();
+    preview.fps = config_.preview_fps;
+    preview.bytes_per_pixel = config_.preview_transport == FrameTransport::NV12 ? 1.5f : 3.0f;
+    preview.can_use_nv12 = true;         // Converted for display in process()
+    preview.min_fps = std::min(config_.preview_fps, 5.0f);
+    preview.min_width = std::min(config_.preview_width, 320u);
+    demands.push_back(preview);
+
+    // Detection messages are small; one per NN pass, i.e. per tile when tiling
+    float passes = config_.input_fps;
+    if (config_.tiling.enabled) {
+        try {
+            passes = config_.tiling.source_fps *
+                     static_cast<float>(computeTiles(config_.tiling.source_width, config_.tiling.source_height,
+                                                     config_.input_width, config_.input_height,
+                                                     config_.tiling).size());
+        } catch (const std::exception&) {
+            // Reported by configure()
+        }
+    }
+    StreamDemand detections;
+    detections.name = "detections";
+    detections.fixed_mbps = passes * kDetectionMessageBytes * 8.0 / 1e6;
+    detections.priority = 10;
+    demands.push_back(detections);
+
+    if (config_.motion_gate.enabled) {
+        StreamDemand motion;
+        motion.name = "motion";
+        motion.width = config_.motion_gate.width;
+        motion.height = config_.motion_gate.height;
+        motion.fps = nnInputFps();
+        motion.bytes_per_pixel = 1.5f;
+        motion.priority = 10;
+        demands.push_back(motion);
+    }
+
+    if (config_.crops.enabled) {
+        // Fps follows the detector; only the size may give
+        StreamDemand crops;
+        crops.name = "crop_source";
+        crops.width = config_.crops.source_width;
+        crops.height = config_.crops.source_height;
+        crops.fps = cropSourceFps();
+        crops.bytes_per_pixel = config_.crops.source_transport == FrameTransport::NV12 ? 1.5f : 3.0f;
+        crops.can_use_nv12 = true;
+        crops.min_width = std::min(config_.crops.source_width, 640u);
+        crops.priority = 5;
+        demands.push_back(crops);
+    }
+
+    if (config_.cascade.enabled && config_.cascade.crop_source == CascadeCropSource::DEVICE) {
+        // Only the crops cross the link; budgeted for a few objects per frame
+        StreamDemand crops;
+        crops.name = "cascade_crops";
+        crops.fixed_mbps = cropSourceFps() * std::min(config_.crops.max_crops, 8u) *
+                           config_.crops.output_width * config_.crops.output_height * 3.0 * 8.0 / 1e6;
+        crops.priority = 5;
+        demands.push_back(crops);
+    }
+    return demands;
+}
+
+void InferenceModule::applyStreamPlan(const std::vector<PlannedStream>& streams) {
+    for (const auto& stream : streams) {
+        if (stream.requested.name == "crop_source") {
+            config_.crops.source_width = stream.planned.width;
+            config_.crops.source_height = stream.planned.height;
+            if (stream.switchedToNv12()) {
+                config_.crops.source_transport = FrameTransport::NV12;
+            }
+            continue;
+        }
+        if (stream.requested.name != "inference_preview") {
+            continue;
+        }
+        config_.preview_width = stream.planned.width;
+        config_.preview_height = stream.planned.height;
+        config_.preview_fps = stream.planned.fps;
+        if (stream.switchedToNv12()) {
+            config_.preview_transport = FrameTransport::NV12;
+        }
+    }
+}
+
+std::optional<MotionGateStats> InferenceModule::getMotionGateStats() const {
+    if (!motion_gate_) {
+        return std::nullopt;
+    }
+    return motion_gate_->getStats();
+}
+
 void InferenceModule::drawDetections(cv::Mat& frame, 
                                      const std::vector<dai::ImgDetection>& detections) {
+    // Text goes through text_, whose capacity is reused from frame to frame
+    char number[32];
     for (const auto& det : detections) {
         // Calculate bounding box coordinates
         int x1 = static_cast<int>(det.xmin * frame.cols);
@@ -137,13 +930,15 @@ void InferenceModule::drawDetections(cv::Mat& frame,
         x2 = std::max(0, std::min(x2, frame.cols - 1));
         y2 = std::max(0, std::min(y2, frame.rows - 1));
 
-        // Get label
-        std::string label;
+        // Label and confidence
         if (det.label < labels_.size()) {
-            label = labels_[det.label];
+            text_.assign(labels_[det.label]);
         } else {
-            label = "Class " + std::to_string(det.label);
+            std::snprintf(number, sizeof(number), "Class %u", det.label);
+            text_.assign(number);
         }
+        std::snprintf(number, sizeof(number), " %d%%", static_cast<int>(det.confidence * 100));
+        text_.append(number);
 
         // Generate color based on label
         cv::Scalar color(
@@ -156,9 +951,8 @@ void InferenceModule::drawDetections(cv::Mat& frame,
         cv::rectangle(frame, cv::Point(x1, y1), cv::Point(x2, y2), color, 2);
 
         // Draw label background
-        std::string text = label + " " + std::to_string(static_cast<int>(det.confidence * 100)) + "%";
         int baseline;
-        cv::Size textSize = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseline);
+        cv::Size textSize = cv::getTextSize(text_, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseline);
         
         cv::rectangle(frame, 
                      cv::Point(x1, y1 - textSize.height - 5),
@@ -166,13 +960,14 @@ void InferenceModule::drawDetections(cv::Mat& frame,
                      color, cv::FILLED);
 
         // Draw label text
-        cv::putText(frame, text, cv::Point(x1 + 2, y1 - 3),
+        cv::putText(frame, text_, cv::Point(x1 + 2, y1 - 3),
                    cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
     }
 
     // Draw detection count
-    std::string count_text = "Detections: " + std::to_string(detections.size());
-    cv::putText(frame, count_text, cv::Point(10, 25),
+    std::snprintf(number, sizeof(number), "Detections: %zu", detections.size());
+    text_.assign(number);
+    cv::putText(frame, text_, cv::Point(10, 25),
                cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
 }
 
@@ -183,6 +978,51 @@ void InferenceModule::cleanup() {
     
     preview_queue_.reset();
     detection_queue_.reset();
+    motion_queue_.reset();
+    gate_stats_queue_.reset();
+    crop_queue_.reset();
+    cascade_crop_queue_.reset();
+    device_crops_.clear();
+    gate_queue_.reset();
+
+    if (tile_merger_) {
+        auto stats = tile_merger_->getStats();
+        std::cout << "InferenceModule tiling: " << stats.frames << " frames of " << stats.tiles << " tiles ("
+                  << stats.incomplete_frames << " incomplete), merge " << stats.mean_merge_us << " us mean, "
+                  << stats.max_merge_us << " us max" << std::endl;
+    }
+    if (cascade_) {
+        cascade_->stop();
+    }
+    if (crop_extractor_) {
+        auto stats = crop_extractor_->getStats();
+        std::cout << "InferenceModule crops: " << stats.crops << " crops from " << stats.messages << " messages ("
+                  << stats.unmatched << " unmatched, " << stats.skipped_pool << " skipped for buffers), "
+                  << stats.mean_crop_us << " us mean, " << stats.p95_crop_us << " us p95 per crop" << std::endl;
+    }
+    if (motion_gate_) {
+        auto stats = motion_gate_->getStats();
+        std::cout << "InferenceModule motion gate: " << stats.processed << " processed, "
+                  << stats.gated << " gated (" << stats.gated_ratio * 100.0 << "%)" << std::endl;
+    }
+}
+
+void InferenceModule::drainDetectionCallbacks() {
+    drainStream(kDetectionStream);
+}
+
+std::vector<QueueStats> InferenceModule::getQueueStats() const {
+    std::vector<QueueStats> stats{preview_queue_.getStats(), detection_queue_.getStats()};
+    if (motion_gate_) {
+        stats.push_back(motion_queue_.getStats());
+    }
+    if (crop_extractor_) {
+        stats.push_back(crop_queue_.getStats());
+    }
+    if (cascade_crop_queue_.isOpen()) {
+        stats.push_back(cascade_crop_queue_.getStats());
+    }
+    return stats;
 }
 
 } // namespace oak
@@ -2,6 +2,13 @@
 
 #include "../engine/ModuleBase.h"
 #include "../engine/Types.h"
+#include "../processing/MotionGate.h"
+#include "../processing/TileMerger.h"
+#include "../processing/CropExtractor.h"
+#include "../processing/CascadeClassifier.h"
+#include "../engine/RingDeque.h"
+#include "../engine/ObjectPool.h"
+#include <optional>
 #include <opencv2/opencv.hpp>
 
 namespace oak {
@@ -17,19 +24,84 @@ public:
     std::string getName() const override { return "InferenceModule"; }
     ModuleState getStateType() const override { return ModuleState::INFERENCE; }
     
+    bool configureSimulated(SimulatedSource& source) override;
+
+    std::vector<StreamDemand> getStreamDemands() const override;
+    void applyStreamPlan(const std::vector<PlannedStream>& streams) override;
+
     void process() override;
     void cleanup() override;
+    std::vector<QueueStats> getQueueStats() const override;
+    void drainDetectionCallbacks() override;
+
+    // Present when config.motion_gate.enabled
+    std::optional<MotionGateStats> getMotionGateStats() const;
+    // Present when config.tiling.enabled
+    std::optional<TileMergeStats> getTileMergeStats() const;
+    // Present when config.crops.enabled
+    std::optional<CropStats> getCropStats() const;
+
+    // Present when config.cascade.enabled
+    std::optional<CascadeStats> getCascadeStats() const;
+
+    // Crops of each detection message (config.crops), on the task pool
+    void setCropCallback(CropCallback callback);
+    // Detections merged with the second network's results (config.cascade)
+    void setCascadeCallback(CascadeCallback callback);
 
 private:
+    uint32_t previewHeight() const;
+    void applyTuning(dai::node::DetectionNetwork& network);
+    dai::Node::Output* buildTiling(dai::Pipeline& pipeline, dai::Node::Output& source);
+    void createTileMerger();
+    void createCropExtractor(bool letterboxed);
+    float nnInputFps() const;
+    float cropSourceFps() const;
+    CropCallback cropDelivery() const;
+    bool createCascade();
+    void buildDeviceCrops(dai::Pipeline& pipeline, std::shared_ptr<dai::node::Camera> camera,
+                          dai::Node::Output& detections);
+    void beginCascade(const std::shared_ptr<dai::ImgDetections>& detections);
+    void submitDeviceCrops();
+    // Returns the merged frame once its last tile arrives
+    std::shared_ptr<dai::ImgDetections> mergeTile(const dai::ImgDetections& tile);
+    void deliverDetections(const std::shared_ptr<dai::ImgDetections>& detections);
+    void updateMotionGate(dai::ImgFrame& frame);
     void drawDetections(cv::Mat& frame, 
                        const std::vector<dai::ImgDetection>& detections);
 
     InferenceConfig config_;
-    std::shared_ptr<dai::MessageQueue> preview_queue_;
-    std::shared_ptr<dai::MessageQueue> detection_queue_;
+    StreamQueue preview_queue_;
+    StreamQueue detection_queue_;
+    StreamQueue motion_queue_;
+    StreamQueue gate_stats_queue_;       // Forwarded/dropped counts from the gate script
+    StreamQueue crop_queue_;
+    StreamQueue cascade_crop_queue_;
+
+    std::unique_ptr<MotionGate> motion_gate_;
+    std::shared_ptr<dai::InputQueue> gate_queue_;  // Mode updates for the device script
+    bool gate_run_ = true;
+
+    std::unique_ptr<TileMerger> tile_merger_;
+    std::unique_ptr<ObjectPool<dai::ImgDetections>> merged_pool_;
+    std::shared_ptr<dai::ImgDetections> merging_;  // Receives the next merged frame
+
+    // Declared first: the crop extractor feeds the cascade until it is destroyed
+    std::unique_ptr<CascadeClassifier> cascade_;
+    CascadeCallback cascade_callback_;
+    RingDeque<std::shared_ptr<dai::ImgFrame>> device_crops_;  // Waiting for their detections
+    std::vector<uint32_t> cascade_indices_;
+    int64_t last_cascade_seq_ = -1;
+
+    std::unique_ptr<CropExtractor> crop_extractor_;
+    CropCallback crop_callback_;
     
     std::vector<std::string> labels_;
-    bool show_preview_ = true;
+    bool show_preview_;
+
+    // Reused every frame so the steady-state path does not allocate
+    cv::Mat display_frame_;
+    std::string text_;
 };
 
 } // namespace oak
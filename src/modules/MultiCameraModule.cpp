@@ -0,0 +1,165 @@
+#include "MultiCameraModule.h"
+#include <algorithm>
+#include <iostream>
+
+namespace oak {
+
+// Task pool streams (per module). Frames of every socket share one stream,
+// so the frame callback runs one call at a time like in the other modules.
+enum : uint64_t { kFrameStream, kFrameSetStream };
+
+MultiCameraModule::MultiCameraModule(const MultiCameraConfig& config)
+    : config_(config),
+      synchronizer_(config.sockets,
+                    std::chrono::microseconds(static_cast<int64_t>(config.sync_tolerance_ms * 1000.0f)),
+                    config.sync_buffer_size) {
+    for (auto socket : config_.sockets) {
+        queues_.push_back(std::make_unique<StreamQueue>(cameraSocketToString(socket), config_.queue));
+    }
+}
+
+bool MultiCameraModule::configure(dai::Pipeline& pipeline,
+                                  std::shared_ptr<dai::node::Camera> camera) {
+    // Single-camera entry point: only usable when CAM_A is the sole socket
+    CameraNodes cameras;
+    if (camera) {
+        cameras[dai::CameraBoardSocket::CAM_A] = camera;
+    }
+    return configureCameras(pipeline, cameras);
+}
+
+bool MultiCameraModule::configureCameras(dai::Pipeline& pipeline, const CameraNodes& cameras) {
+    (void)pipeline;
+
+    try {
+        for (size_t i = 0; i < config_.sockets.size(); ++i) {
+            auto it = cameras.find(config_.sockets[i]);
+            if (it == cameras.end() || !it->second) {
+                std::cerr << "MultiCameraModule: no camera node for "
+                          << cameraSocketToString(config_.sockets[i]) << std::endl;
+                return false;
+            }
+
+            // Native sensor type (color or mono); converted on the host when displayed
+            auto* output = it->second->requestOutput(
+                {config_.width, config_.height},
+                std::nullopt,
+                dai::ImgResizeMode::CROP,
+                config_.fps
+            );
+            queues_[i]->open(*output);
+        }
+
+        std::cout << "MultiCameraModule configured: " << config_.sockets.size() << " cameras, "
+                  << config_.width << "x" << config_.height << " @ " << config_.fps
+                  << " fps, sync tolerance " << config_.sync_tolerance_ms << " ms" << std::endl;
+
+        return true;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to configure MultiCameraModule: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<StreamDemand> MultiCameraModule::getStreamDemands() const {
+    // Native NV12 or GRAY8; sized as NV12. All sockets degrade together
+    // since the frameset is only as fast as its slowest stream.
+    std::vector<StreamDemand> demands;
+    for (auto socket : config_.sockets) {
+        StreamDemand camera;
+        camera.name = cameraSocketToString(socket);
+        camera.width = config_.width;
+        camera.height = config_.height;
+        camera.fps = config_.fps;
+        camera.bytes_per_pixel = 1.5f;
+        camera.min_fps = std::min(config_.fps, 10.0f);
+        camera.min_width = std::min(config_.width, 320u);
+        demands.push_back(camera);
+    }
+    return demands;
+}
+
+void MultiCameraModule::applyStreamPlan(const std::vector<PlannedStream>& streams) {
+    // One resolution and rate for every socket: the most degraded one
+    for (const auto& stream : streams) {
+        config_.width = std::min(config_.width, stream.planned.width);
+        config_.height = std::min(config_.height, stream.planned.height);
+        config_.fps = std::min(config_.fps, stream.planned.fps);
+    }
+}
+
+void MultiCameraModule::process() {
+    // Move everything that arrived into the per-socket sync buffers
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        if (!queues_[i]->isOpen()) {
+            continue;
+        }
+        while (auto frame = queues_[i]->next<dai::ImgFrame>()) {
+            markFrame();
+            if (auto callback = frameCallback()) {
+                runOnStream(kFrameStream, [callback, frame] { (*callback)(frame); });
+            }
+            synchronizer_.push(i, std::move(frame));
+            if (config_.queue.policy == QueuePolicy::LATEST_ONLY) {
+                break;
+            }
+        }
+    }
+
+    synchronizer_.poll([this](const FrameSet& frameset) { onFrameSet(frameset); });
+}
+
+void MultiCameraModule::onFrameSet(const FrameSet& frameset) {
+    int64_t seq = frameset.frames.empty() ? -1 : frameset.frames.front()->getSequenceNum();
+    TraceSpan processSpan("frameset", "MultiCameraModule", seq);
+
+    if (frameset_callback_) {
+        runOnStream(kFrameSetStream, [this, frameset, seq] {
+            TraceSpan span("frameset_callback", "MultiCameraModule", seq);
+            frameset_callback_(frameset);
+        });
+    }
+
+    if (!show_preview_) {
+        return;
+    }
+
+    // Native NV12/GRAY8 frames are converted for display only
+    AllocationCounter::Exclude gui;
+    for (size_t i = 0; i < frameset.frames.size(); ++i) {
+        cv::Mat frame = frameset.frames[i]->getCvFrame();
+        cv::imshow(cameraSocketToString(frameset.sockets[i]), frame);
+    }
+
+    int key = cv::waitKey(1);
+    if (key == 'q' || key == 'Q' || key == 27) {
+        show_preview_ = false;
+        cv::destroyAllWindows();
+    }
+}
+
+void MultiCameraModule::cleanup() {
+    if (show_preview_) {
+        cv::destroyAllWindows();
+    }
+    for (auto& queue : queues_) {
+        queue->reset();
+    }
+
+    auto stats = synchronizer_.getStats();
+    std::cout << "MultiCameraModule: " << stats.framesets << " framesets, "
+              << stats.sync_misses << " sync misses, "
+              << stats.overflow_drops << " overflow drops, max skew "
+              << stats.max_skew_us << " us" << std::endl;
+}
+
+std::vector<QueueStats> MultiCameraModule::getQueueStats() const {
+    std::vector<QueueStats> stats;
+    for (const auto& queue : queues_) {
+        stats.push_back(queue->getStats());
+    }
+    return stats;
+}
+
+} // namespace oak
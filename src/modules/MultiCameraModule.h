@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../engine/ModuleBase.h"
+#include "../engine/Types.h"
+#include "../engine/FrameSynchronizer.h"
+#include <opencv2/opencv.hpp>
+
+namespace oak {
+
+// Captures one stream per requested socket and delivers them as
+// timestamp-synchronized framesets.
+class MultiCameraModule : public ModuleBase {
+public:
+    explicit MultiCameraModule(const MultiCameraConfig& config);
+    ~MultiCameraModule() override = default;
+
+    bool configure(dai::Pipeline& pipeline,
+                  std::shared_ptr<dai::node::Camera> camera) override;
+    bool configureCameras(dai::Pipeline& pipeline, const CameraNodes& cameras) override;
+    std::vector<dai::CameraBoardSocket> getRequiredSockets() const override { return config_.sockets; }
+
+    std::string getName() const override { return "MultiCameraModule"; }
+    ModuleState getStateType() const override { return ModuleState::MULTI_CAMERA; }
+
+    std::vector<StreamDemand> getStreamDemands() const override;
+    void applyStreamPlan(const std::vector<PlannedStream>& streams) override;
+
+    void process() override;
+    void cleanup() override;
+    std::vector<QueueStats> getQueueStats() const override;
+
+    void setFrameSetCallback(FrameSetCallback callback) { frameset_callback_ = callback; }
+    SyncStats getSyncStats() const { return synchronizer_.getStats(); }
+
+private:
+    void onFrameSet(const FrameSet& frameset);
+
+    MultiCameraConfig config_;
+    std::vector<std::unique_ptr<StreamQueue>> queues_;  // Parallel to config_.sockets
+    FrameSynchronizer synchronizer_;
+
+    FrameSetCallback frameset_callback_;
+    bool show_preview_ = true;
+};
+
+} // namespace oak
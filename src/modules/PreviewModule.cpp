@@ -1,10 +1,15 @@
 #include "PreviewModule.h"
+#include "../processing/FrameConvert.h"
+#include <algorithm>
 #include <iostream>
 
 namespace oak {
 
+// Task pool streams (per module)
+enum : uint64_t { kFrameStream };
+
 PreviewModule::PreviewModule(const OutputConfig& config) 
-    : config_(config) {
+    : config_(config), output_queue_("preview", config.queue), show_preview_(config.show_preview) {
 }
 
 bool PreviewModule::configure(dai::Pipeline& pipeline,
@@ -27,21 +32,21 @@ bool PreviewModule::configure(dai::Pipeline& pipeline,
                 resize_mode = dai::ImgResizeMode::CROP;
         }
 
-        // Request BGR output for OpenCV compatibility
+        // Request BGR output for OpenCV compatibility, or NV12 to halve the link load
         // Note: Camera resizer only supports BGR888i (interleaved), not BGR888p (planar)
         auto* output = camera->requestOutput(
             {config_.width, config_.height},
-            dai::ImgFrame::Type::BGR888i,
+            transportFrameType(config_.transport),
             resize_mode,
             config_.fps,
             config_.enable_undistortion
         );
 
         // V3 API: Create output queue directly from node output
-        output_queue_ = output->createOutputQueue(8, false);
+        output_queue_.open(*output);
 
         std::cout << "PreviewModule configured: " << config_.width << "x" << config_.height 
-                  << " @ " << config_.fps << " fps" << std::endl;
+                  << " @ " << config_.fps << " fps, " << frameTransportToString(config_.transport) << std::endl;
 
         return true;
 
@@ -51,23 +56,71 @@ bool PreviewModule::configure(dai::Pipeline& pipeline,
     }
 }
 
+bool PreviewModule::configureSimulated(SimulatedSource& source) {
+    output_queue_.open(source.addFrameOutput("preview", config_.width, config_.height, config_.queue,
+                                             transportFrameType(config_.transport)));
+    std::cout << "PreviewModule configured (simulated): " << config_.width << "x" << config_.height << std::endl;
+    return true;
+}
+
+std::vector<StreamDemand> PreviewModule::getStreamDemands() const {
+    StreamDemand preview;
+    preview.name = "preview";
+    preview.width = config_.width;
+    preview.height = config_.height;
+    preview.fps = config_.fps;
+    preview.bytes_per_pixel = config_.transport == FrameTransport::NV12 ? 1.5f : 3.0f;
+    preview.can_use_nv12 = true;         // Converted for display in process()
+    preview.min_fps = std::min(config_.fps, 10.0f);
+    preview.min_width = std::min(config_.width, 640u);
+    return {preview};
+}
+
+void PreviewModule::applyStreamPlan(const std::vector<PlannedStream>& streams) {
+    for (const auto& stream : streams) {
+        if (stream.requested.name != "preview") {
+            continue;
+        }
+        config_.width = stream.planned.width;
+        config_.height = stream.planned.height;
+        config_.fps = stream.planned.fps;
+        if (stream.switchedToNv12()) {
+            config_.transport = FrameTransport::NV12;
+        }
+    }
+}
+
 void PreviewModule::process() {
-    if (!output_queue_) {
+    if (!output_queue_.isOpen()) {
         return;
     }
 
-    // Try to get frame (non-blocking)
-    auto imgFrame = output_queue_->tryGet<dai::ImgFrame>();
+    TraceSpan processSpan("process", "PreviewModule");
+
+    // Try to get frame (non-blocking, policy decides latest vs. in-order)
+    auto imgFrame = output_queue_.next<dai::ImgFrame>();
     
     if (imgFrame) {
-        // Call callback if set
-        if (frame_callback_) {
-            frame_callback_(imgFrame);
+        int64_t seq = imgFrame->getSequenceNum();
+        processSpan.setSequence(seq);
+        markFrame();
+
+        // Call callback if set (on the task pool, in frame order)
+        if (auto callback = frameCallback()) {
+            runOnStream(kFrameStream, [callback, imgFrame, seq] {
+                TraceSpan span("frame_callback", "PreviewModule", seq);
+                (*callback)(imgFrame);
+            });
         }
 
         // Display preview
         if (show_preview_) {
-            cv::Mat frame = imgFrame->getCvFrame();
+            // BGR888i wrapped in place (imshow only reads it); NV12 is
+            // converted here, the only place that needs BGR
+            cv::Mat frame = toBgr(*imgFrame, display_bgr_);
+
+            TraceSpan displaySpan("imshow", "PreviewModule", seq);
+            AllocationCounter::Exclude gui;
             cv::imshow("OAK Preview", frame);
             
             int key = cv::waitKey(1);
@@ -76,6 +129,8 @@ void PreviewModule::process() {
                 cv::destroyWindow("OAK Preview");
             }
         }
+    } else {
+        processSpan.cancel();
     }
 }
 
@@ -86,4 +141,8 @@ void PreviewModule::cleanup() {
     output_queue_.reset();
 }
 
+std::vector<QueueStats> PreviewModule::getQueueStats() const {
+    return {output_queue_.getStats()};
+}
+
 } // namespace oak
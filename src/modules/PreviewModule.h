@@ -17,13 +17,20 @@ public:
     std::string getName() const override { return "PreviewModule"; }
     ModuleState getStateType() const override { return ModuleState::PREVIEW; }
     
+    bool configureSimulated(SimulatedSource& source) override;
+
+    std::vector<StreamDemand> getStreamDemands() const override;
+    void applyStreamPlan(const std::vector<PlannedStream>& streams) override;
+
     void process() override;
     void cleanup() override;
+    std::vector<QueueStats> getQueueStats() const override;
 
 private:
     OutputConfig config_;
-    std::shared_ptr<dai::MessageQueue> output_queue_;
-    bool show_preview_ = true;
+    StreamQueue output_queue_;
+    bool show_preview_;
+    cv::Mat display_bgr_;                // NV12 transport: converted frame, reused
 };
 
 } // namespace oak
@@ -1,15 +1,21 @@
 
 #include "RecordModule.h"
+#include <algorithm>
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <cstdio>
 #include <filesystem>
 
 namespace oak {
 
+// Task pool streams (per module)
+enum : uint64_t { kFrameStream };
+
 RecordModule::RecordModule(const RecordConfig& config) 
-    : config_(config) {
+    : config_(config), preview_queue_("record_preview", config.preview_queue),
+      show_preview_(config.show_preview) {
 }
 
 bool RecordModule::configure(dai::Pipeline& pipeline,
@@ -56,13 +62,13 @@ bool RecordModule::configure(dai::Pipeline& pipeline,
 
         // Separate preview stream for UI (lower res, doesn't affect recording)
         auto* previewOutput = camera->requestOutput(
-            {640, 360},
+            {config_.preview_width, config_.preview_height},
             dai::ImgFrame::Type::BGR888i,
             dai::ImgResizeMode::CROP,
-            config_.fps,
+            previewFps(),
             false
         );
-        preview_queue_ = previewOutput->createOutputQueue(4, false);
+        preview_queue_.open(*previewOutput);
 
         start_time_ = std::chrono::steady_clock::now();
 
@@ -77,30 +83,93 @@ bool RecordModule::configure(dai::Pipeline& pipeline,
     }
 }
 
+bool RecordModule::configureSimulated(SimulatedSource& source) {
+    // Encoding and file writing happen on the device; only the host side is simulated
+    preview_queue_.open(source.addFrameOutput("record_preview", config_.preview_width, config_.preview_height,
+                                              config_.preview_queue));
+    start_time_ = std::chrono::steady_clock::now();
+    std::cout << "RecordModule configured (simulated, no file is written)" << std::endl;
+    return true;
+}
+
+float RecordModule::previewFps() const {
+    return config_.preview_fps > 0.0f ? config_.preview_fps : config_.fps;
+}
+
+std::vector<StreamDemand> RecordModule::getStreamDemands() const {
+    // The H264 stream is what the recording is for; only the preview gives way
+    StreamDemand video;
+    video.name = "record_h264";
+    video.fixed_mbps = config_.bitrate / 1e6;
+    video.priority = 10;
+
+    StreamDemand preview;
+    preview.name = "record_preview";
+    preview.width = config_.preview_width;
+    preview.height = config_.preview_height;
+    preview.fps = previewFps();
+    preview.bytes_per_pixel = 3.0f;      // Drawn on in place, so stays BGR
+    preview.min_fps = std::min(previewFps(), 5.0f);
+    preview.min_width = std::min(config_.preview_width, 320u);
+    return {video, preview};
+}
+
+void RecordModule::applyStreamPlan(const std::vector<PlannedStream>& streams) {
+    for (const auto& stream : streams) {
+        if (stream.requested.name != "record_preview") {
+            continue;
+        }
+        config_.preview_width = stream.planned.width;
+        config_.preview_height = stream.planned.height;
+        config_.preview_fps = stream.planned.fps;
+    }
+}
+
 void RecordModule::process() {
     // Only handle preview - recording happens on-device automatically
-    if (preview_queue_ && show_preview_) {
-        auto previewFrame = preview_queue_->tryGet<dai::ImgFrame>();
+    if (preview_queue_.isOpen()) {
+        auto previewFrame = preview_queue_.next<dai::ImgFrame>();
         if (previewFrame) {
-            if (frame_callback_) {
-                frame_callback_(previewFrame);
+            int64_t seq = previewFrame->getSequenceNum();
+            TraceSpan processSpan("process", "RecordModule", seq);
+            markFrame();
+
+            if (auto callback = frameCallback()) {
+                runOnStream(kFrameStream, [callback, previewFrame, seq] {
+                    TraceSpan span("frame_callback", "RecordModule", seq);
+                    (*callback)(previewFrame);
+                });
+            }
+
+            if (!show_preview_) {
+                return;
             }
 
-            cv::Mat frame = previewFrame->getCvFrame();
+            // Copied into a reused buffer so the overlay leaves the message untouched
+            TraceSpan convertSpan("copyFrame", "RecordModule", seq);
+            previewFrame->getFrame().copyTo(display_frame_);
+            cv::Mat& frame = display_frame_;
+            convertSpan.end();
             
+            TraceSpan overlaySpan("overlay", "RecordModule", seq);
             // Recording indicator
             cv::circle(frame, cv::Point(30, 30), 15, cv::Scalar(0, 0, 255), -1);
             cv::putText(frame, "REC", cv::Point(50, 38), 
                        cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 0, 255), 2);
             
-            // Elapsed time
+            // Elapsed time, formatted into the reused text_ buffer
             auto elapsed = std::chrono::steady_clock::now() - start_time_;
             auto secs = std::chrono::duration_cast<std::chrono::seconds>(elapsed).count();
-            std::string time_text = "Time: " + std::to_string(secs / 60) + ":" + 
-                                    (secs % 60 < 10 ? "0" : "") + std::to_string(secs % 60);
-            cv::putText(frame, time_text, cv::Point(10, frame.rows - 20),
+            char time_text[32];
+            std::snprintf(time_text, sizeof(time_text), "Time: %lld:%02lld",
+                          static_cast<long long>(secs / 60), static_cast<long long>(secs % 60));
+            text_.assign(time_text);
+            cv::putText(frame, text_, cv::Point(10, frame.rows - 20),
                        cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255), 1);
+            overlaySpan.end();
 
+            TraceSpan displaySpan("imshow", "RecordModule", seq);
+            AllocationCounter::Exclude gui;
             cv::imshow("Recording Preview", frame);
             
             int key = cv::waitKey(1);
@@ -118,7 +187,13 @@ void RecordModule::cleanup() {
     }
     preview_queue_.reset();
     
-    std::cout << "Recording saved: " << output_file_path_ << std::endl;
+    if (!output_file_path_.empty()) {
+        std::cout << "Recording saved: " << output_file_path_ << std::endl;
+    }
+}
+
+std::vector<QueueStats> RecordModule::getQueueStats() const {
+    return {preview_queue_.getStats()};
 }
 
 } // namespace oak
\ No newline at end of file
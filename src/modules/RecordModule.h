@@ -18,17 +18,29 @@ public:
     std::string getName() const override { return "RecordModule"; }
     ModuleState getStateType() const override { return ModuleState::RECORD; }
     
+    bool configureSimulated(SimulatedSource& source) override;
+
+    std::vector<StreamDemand> getStreamDemands() const override;
+    void applyStreamPlan(const std::vector<PlannedStream>& streams) override;
+
     void process() override;
     void cleanup() override;
+    std::vector<QueueStats> getQueueStats() const override;
 
     std::string getOutputFilePath() const { return output_file_path_; }
 
 private:
+    float previewFps() const;
+
     RecordConfig config_;
-    std::shared_ptr<dai::MessageQueue> preview_queue_;
+    StreamQueue preview_queue_;
     std::string output_file_path_;
-    bool show_preview_ = true;
+    bool show_preview_;
     std::chrono::steady_clock::time_point start_time_;
+
+    // Reused every frame so the steady-state path does not allocate
+    cv::Mat display_frame_;
+    std::string text_;
 };
 
 } // namespace oak
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "BatchProcessor.h"
+#include "../engine/ThreadTuning.h"
+#include "../engine/Trace.h"
+#include "IouTracker.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <cmath>
+#include <cctype>
+
+namespace oak {
+
+namespace {
+
+constexpr uint32_t kFormatVersion = 1;
+
+bool hasExtension(const std::filesystem::path& path, std::initializer_list<const char*> extensions) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const char* candidate : extensions) {
+        if (ext == candidate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isVideo(const std::filesystem::path& path) {
+    return hasExtension(path, {".mp4", ".avi", ".mkv", ".mov"});
+}
+
+bool isImage(const std::filesystem::path& path) {
+    return hasExtension(path, {".jpg", ".jpeg", ".png", ".bmp"});
+}
+
+// Little-endian on every platform we build for, so values are written as-is
+template <typename T>
+void put(std::vector<char>& buffer, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+uint16_t quantize(float value) {
+    return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+} // namespace
+
+BatchProcessor::BatchProcessor(const BatchConfig& config)
+    : config_(config),
+      sink_queue_(config.sink_queue_size) {
+}
+
+BatchProcessor::~BatchProcessor() {
+    cancel();
+    for (auto& thread : decode_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    if (inference_) {
+        inference_->stop();
+    }
+    inference_done_ = true;
+    if (sink_thread_.joinable()) {
+        sink_thread_.join();
+    }
+}
+
+std::vector<BatchSource> BatchProcessor::findSources(const std::string& input_path) {
+    namespace fs = std::filesystem;
+    std::vector<BatchSource> sources;
+
+    std::error_code ec;
+    fs::path root(input_path);
+    if (fs::is_regular_file(root, ec)) {
+        if (isVideo(root)) {
+            sources.push_back({root.string(), true, {}});
+        }
+        return sources;
+    }
+
+    std::map<std::string, std::vector<std::string>> sequences;  // Directory -> frames
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        const auto& path = it->path();
+        if (isVideo(path)) {
+            sources.push_back({path.string(), true, {}});
+        } else if (isImage(path)) {
+            sequences[path.parent_path().string()].push_back(path.string());
+        }
+    }
+    if (ec) {
+        std::cerr << "Failed to scan " << input_path << ": " << ec.message() << std::endl;
+    }
+
+    // Deterministic order, so source indices in the output are reproducible
+    std::sort(sources.begin(), sources.end(),
+              [](const BatchSource& a, const BatchSource& b) { return a.path < b.path; });
+    for (auto& [directory, images] : sequences) {
+        std::sort(images.begin(), images.end());
+        sources.push_back({directory, false, std::move(images)});
+    }
+    return sources;
+}
+
+bool BatchProcessor::run() {
+    sources_ = findSources(config_.input_path);
+    if (sources_.empty()) {
+        std::cerr << "No videos or image sequences found in " << config_.input_path << std::endl;
+        return false;
+    }
+
+    output_.open(config_.output_path, std::ios::binary | std::ios::trunc);
+    if (!output_) {
+        std::cerr << "Failed to open batch output: " << config_.output_path << std::endl;
+        return false;
+    }
+    writeHeader();
+
+    inference_ = std::make_unique<HostInference>(config_.inference);
+    inference_->setDetectionCallback([this](std::shared_ptr<dai::ImgDetections> detections) {
+        // Back-pressure the inference workers while the writer catches up
+        while (!sink_queue_.tryPush(detections)) {
+            std::this_thread::yield();
+        }
+    });
+    if (!inference_->start()) {
+        output_.close();
+        return false;
+    }
+
+    uint32_t threads = config_.decode_threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+    threads = std::min<uint32_t>(threads, static_cast<uint32_t>(sources_.size()));
+
+    std::cout << "Batch processing " << sources_.size() << " sources from " << config_.input_path
+              << " (" << threads << " decode threads)" << std::endl;
+
+    start_time_ = std::chrono::steady_clock::now();
+    inference_done_ = false;
+    next_source_ = 0;
+    sink_thread_ = std::thread(&BatchProcessor::sinkLoop, this);
+    for (uint32_t i = 0; i < threads; ++i) {
+        decode_threads_.emplace_back(&BatchProcessor::decodeLoop, this);
+    }
+
+    // Drain stage by stage: decode, then inference, then the writer
+    for (auto& thread : decode_threads_) {
+        thread.join();
+    }
+    decode_threads_.clear();
+    inference_->stop();
+    inference_done_ = true;
+    sink_thread_.join();
+
+    end_time_ = std::chrono::steady_clock::now();
+    output_.close();
+
+    auto stats = getStats();
+    std::cout << "Batch complete: " << stats.frames_decoded << " frames, "
+              << stats.detections << " detections, " << stats.tracks << " tracks in "
+              << stats.elapsed_s << " s (" << stats.fps << " fps) -> " << config_.output_path << std::endl;
+    std::cout << "Inference: batch " << stats.inference.batch_size << " x " << stats.inference.threads
+              << " threads, batch latency mean " << stats.inference.mean_batch_ms << " ms, p95 "
+              << stats.inference.p95_batch_ms << " ms" << std::endl;
+    return stats.failed_sources < stats.sources;
+}
+
+void BatchProcessor::decodeLoop() {
+    configureCurrentThread("batch-decode", config_.io_threads);
+
+    uint32_t index;
+    while (!cancelled_ && (index = next_source_.fetch_add(1)) < sources_.size()) {
+        decodeSource(index);
+    }
+}
+
+void BatchProcessor::decodeSource(uint32_t source_index) {
+    const auto& source = sources_[source_index];
+    const uint32_t stride = std::max(config_.frame_stride, 1u);
+    uint64_t submitted = 0;
+
+    auto submit = [&](cv::Mat&& image, uint32_t frame, double fps) {
+        auto offset = std::chrono::microseconds(
+            fps > 0.0 ? std::llround(static_cast<double>(frame) * 1e6 / fps) : 0);
+        std::chrono::steady_clock::time_point timestamp(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+        if (inference_->submit(std::move(image), packSequence(source_index, frame), timestamp)) {
+            submitted++;
+            frames_decoded_++;
+        }
+    };
+
+    if (source.is_video) {
+        cv::VideoCapture capture(source.path);
+        if (!capture.isOpened()) {
+            std::cerr << "Failed to open " << source.path << std::endl;
+            failed_sources_++;
+            return;
+        }
+        double fps = capture.get(cv::CAP_PROP_FPS);
+
+        for (uint32_t frame = 0; !cancelled_; ++frame) {
+            // Skipped frames are only demuxed/decoded, not converted
+            if (frame % stride != 0) {
+                if (!capture.grab()) {
+                    break;
+                }
+                continue;
+            }
+
+            cv::Mat image;
+            {
+                TraceSpan span("decode", "BatchProcessor", frame);
+                if (!capture.read(image)) {
+                    break;
+                }
+            }
+            submit(std::move(image), frame, fps);
+        }
+    } else {
+        for (uint32_t frame = 0; frame < source.images.size() && !cancelled_; frame += stride) {
+            cv::Mat image;
+            {
+                TraceSpan span("decode", "BatchProcessor", frame);
+                image = cv::imread(source.images[frame], cv::IMREAD_COLOR);
+            }
+            if (image.empty()) {
+                std::cerr << "Failed to read " << source.images[frame] << std::endl;
+                continue;
+            }
+            submit(std::move(image), frame, config_.image_sequence_fps);
+        }
+    }
+
+    std::cout << "Decoded " << source.path << ": " << submitted << " frames" << std::endl;
+}
+
+void BatchProcessor::sinkLoop() {
+    configureCurrentThread("batch-sink", config_.io_threads);
+
+    const uint32_t stride = std::max(config_.frame_stride, 1u);
+    std::vector<IouTracker> trackers(sources_.size(),
+                                     IouTracker(config_.track_iou_threshold, config_.track_max_age * stride));
+    std::vector<uint32_t> track_ids;
+    std::vector<char> record;
+    uint32_t next_track_id = 1;
+
+    while (true) {
+        std::shared_ptr<dai::ImgDetections> message;
+        if (!sink_queue_.tryPop(message)) {
+            if (inference_done_.load() && sink_queue_.empty()) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        auto sequence = static_cast<uint64_t>(message->getSequenceNum());
+        auto source = static_cast<uint32_t>(sequence >> 32);
+        auto frame = static_cast<uint32_t>(sequence & 0xffffffffu);
+        if (source >= trackers.size()) {
+            continue;
+        }
+
+        TraceSpan span("sink", "BatchProcessor", frame);
+        const auto& detections = message->detections;
+        trackers[source].update(frame, detections, track_ids, next_track_id);
+        if (detections.empty()) {
+            continue;
+        }
+
+        auto timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            message->getTimestamp().time_since_epoch()).count();
+        auto count = static_cast<uint16_t>(std::min<size_t>(detections.size(), UINT16_MAX));
+
+        record.clear();
+        put<uint32_t>(record, source);
+        put<uint32_t>(record, frame);
+        put<int64_t>(record, timestamp_us);
+        put<uint16_t>(record, count);
+        for (uint16_t i = 0; i < count; ++i) {
+            const auto& det = detections[i];
+            put<uint32_t>(record, track_ids[i]);
+            put<uint16_t>(record, static_cast<uint16_t>(det.label));
+            put<uint16_t>(record, quantize(det.confidence));
+            put<uint16_t>(record, quantize(det.xmin));
+            put<uint16_t>(record, quantize(det.ymin));
+            put<uint16_t>(record, quantize(det.xmax));
+            put<uint16_t>(record, quantize(det.ymax));
+        }
+        output_.write(record.data(), static_cast<std::streamsize>(record.size()));
+
+        frames_written_++;
+        detections_ += count;
+    }
+
+    tracks_ = next_track_id - 1;
+}
+
+void BatchProcessor::writeHeader() {
+    std::vector<char> header = {'O', 'A', 'K', 'B'};
+    put<uint32_t>(header, kFormatVersion);
+    put<uint32_t>(header, static_cast<uint32_t>(sources_.size()));
+    for (const auto& source : sources_) {
+        auto length = static_cast<uint16_t>(std::min<size_t>(source.path.size(), UINT16_MAX));
+        put<uint16_t>(header, length);
+        header.insert(header.end(), source.path.begin(), source.path.begin() + length);
+    }
+    output_.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+BatchStats BatchProcessor::getStats() const {
+    BatchStats stats;
+    stats.sources = static_cast<uint32_t>(sources_.size());
+    stats.failed_sources = failed_sources_.load();
+    stats.frames_decoded = frames_decoded_.load();
+    stats.frames_written = frames_written_.load();
+    stats.detections = detections_.load();
+    stats.tracks = tracks_.load();
+
+    auto end = end_time_ > start_time_ ? end_time_ : std::chrono::steady_clock::now();
+    stats.elapsed_s = std::chrono::duration<double>(end - start_time_).count();
+    stats.fps = stats.elapsed_s > 0.0 ? static_cast<double>(stats.frames_decoded) / stats.elapsed_s : 0.0;
+    if (inference_) {
+        stats.inference = inference_->getStats();
+    }
+    return stats;
+}
+
+} // namespace oak
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+#include "../engine/SpscRing.h"
+#include "HostInference.h"
+
+namespace oak {
+
+struct BatchSource {
+    std::string path;                    // Video file, or directory of an image sequence
+    bool is_video = true;
+    std::vector<std::string> images;     // Sorted frame files for image sequences
+};
+
+struct BatchStats {
+    uint32_t sources = 0;
+    uint32_t failed_sources = 0;         // Could not be opened
+    uint64_t frames_decoded = 0;         // Frames sent to inference (after frame_stride)
+    uint64_t frames_written = 0;         // Frames with at least one detection
+    uint64_t detections = 0;
+    uint64_t tracks = 0;
+    double elapsed_s = 0.0;
+    double fps = 0.0;                    // Decoded frames per second, end to end
+    HostInferenceStats inference;
+};
+
+// Runs the host inference backend over a directory of recordings as fast as
+// the machine allows, with no real-time pacing. Three pipelined stages:
+//   decode    - one thread per source (up to decode_threads), VideoCapture/imread
+//   inference - HostInference worker pool, batched
+//   sink      - single writer thread: IoU tracking and the output file
+// Stages are connected by bounded queues, so a slow stage back-pressures the
+// ones before it instead of buffering whole videos in memory.
+//
+// Output file (little-endian):
+//   header : "OAKB", u32 version, u32 source_count, per source u16 length + path
+//   records: u32 source, u32 frame, i64 timestamp_us, u16 count, then count x
+//            { u32 track_id, u16 label, u16 confidence, u16 xmin, ymin, xmax, ymax }
+// Confidence and coordinates are normalized to the source frame and stored
+// as value * 65535. Frames without detections are not written.
+class BatchProcessor {
+public:
+    explicit BatchProcessor(const BatchConfig& config);
+    ~BatchProcessor();
+
+    BatchProcessor(const BatchProcessor&) = delete;
+    BatchProcessor& operator=(const BatchProcessor&) = delete;
+
+    // Process every source under input_path; blocks until the output is written
+    bool run();
+
+    // Stop early (e.g. from a signal handler); run() returns after draining
+    void cancel() { cancelled_ = true; }
+
+    BatchStats getStats() const;
+
+    // Videos (.mp4/.avi/.mkv/.mov) are one source each; images are grouped by directory
+    static std::vector<BatchSource> findSources(const std::string& input_path);
+
+private:
+    void decodeLoop();
+    void decodeSource(uint32_t source_index);
+    void sinkLoop();
+    void writeHeader();
+
+    static int64_t packSequence(uint32_t source, uint32_t frame) {
+        return static_cast<int64_t>((static_cast<uint64_t>(source) << 32) | frame);
+    }
+
+    BatchConfig config_;
+    std::vector<BatchSource> sources_;
+    std::unique_ptr<HostInference> inference_;
+
+    std::vector<std::thread> decode_threads_;
+    std::atomic<uint32_t> next_source_{0};
+    std::atomic<bool> cancelled_{false};
+
+    // Inference -> sink; the detection callback is serialized, so one producer at a time
+    SpscRing<std::shared_ptr<dai::ImgDetections>> sink_queue_;
+    std::atomic<bool> inference_done_{false};
+    std::thread sink_thread_;
+    std::ofstream output_;
+
+    std::atomic<uint32_t> failed_sources_{0};
+    std::atomic<uint64_t> frames_decoded_{0};
+    std::atomic<uint64_t> frames_written_{0};
+    std::atomic<uint64_t> detections_{0};
+    std::atomic<uint64_t> tracks_{0};
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point end_time_;
+};
+
+} // namespace oak
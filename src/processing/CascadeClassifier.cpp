@@ -0,0 +1,422 @@
+#include "CascadeClassifier.h"
+#include "ImageKernels.h"
+#include "../engine/Trace.h"
+#include "../engine/SampleStats.h"
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+namespace oak {
+
+void CascadeClassifier::Window::add(double value) {
+    values[head] = value;
+    head = (head + 1) % values.size();
+    ++count;
+}
+
+void CascadeClassifier::Window::summarize(double& mean, double& p95) const {
+    size_t samples = static_cast<size_t>(std::min<uint64_t>(count, values.size()));
+    if (samples == 0) {
+        return;
+    }
+    std::vector<double> sorted(values.begin(), values.begin() + samples);
+    SampleSummary summary = summarizeSamples(sorted);
+    mean = summary.mean;
+    p95 = summary.p95;
+}
+
+CascadeClassifier::CascadeClassifier(const CascadeConfig& config, uint32_t input_width, uint32_t input_height)
+    : config_(config),
+      input_width_(input_width),
+      input_height_(input_height) {
+    size_t window = std::max(config_.latency_window, 1u);
+    for (Window* w : {&crop_wait_, &crop_service_, &classify_wait_, &batch_ms_, &latency_}) {
+        w->values.assign(window, 0.0);
+    }
+}
+
+CascadeClassifier::~CascadeClassifier() {
+    stop();
+}
+
+bool CascadeClassifier::start() {
+    if (running_) {
+        return true;
+    }
+
+    uint32_t threads = std::max(config_.threads, 1u);
+    uint32_t batch_size = std::max(config_.batch_size, 1u);
+    workers_.clear();
+    workers_.resize(threads);
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_ = CascadeStats{};
+    }
+
+    DnnPoolOptions options;
+    options.model_path = config_.model_path;
+    options.name = "CascadeClassifier";
+    options.thread_name = "cascade";
+    options.threads = threads;
+    options.batch_size = batch_size;
+    options.batch_timeout_ms = config_.batch_timeout_ms;
+    options.input_width = input_width_;
+    options.input_height = input_height_;
+    options.thread_options = config_.worker_threads;
+
+    DnnWorkerPool<Job>::Handlers handlers;
+    handlers.fill = [this](size_t worker, size_t, Job& job, float* tensor) {
+        const cv::Mat* input = &job.crop;
+        if (input->cols != static_cast<int>(input_width_) || input->rows != static_cast<int>(input_height_)) {
+            cv::Mat& resized = workers_[worker].resized;
+            cv::resize(*input, resized, cv::Size(static_cast<int>(input_width_), static_cast<int>(input_height_)));
+            input = &resized;
+        }
+        hwcToChwFloat(input->data, input->step, input_width_, input_height_,
+                      config_.mean, config_.scale, config_.swap_rb, tensor);
+    };
+    handlers.done = [this](size_t worker, std::vector<Job>& batch, const cv::Mat& output,
+                           std::chrono::steady_clock::time_point start) {
+        finishBatch(workers_[worker], batch, output, start);
+    };
+    handlers.failed = [this](Job& job, const std::exception&) {
+        complete(job.message, job.slot, nullptr);
+    };
+    handlers.sequence = [](const Job& job) { return job.message->result.sequence; };
+
+    if (!pool_.start(options, std::move(handlers))) {
+        workers_.clear();
+        return false;
+    }
+    running_ = true;
+
+    std::cout << "CascadeClassifier started: " << config_.model_path << " (" << threads << " threads, batch "
+              << batch_size << ", " << input_width_ << "x" << input_height_ << " crops)" << std::endl;
+    return true;
+}
+
+void CascadeClassifier::stop() {
+    if (!running_) {
+        return;
+    }
+
+    // Workers drain the queue before exiting
+    pool_.stop();
+    workers_.clear();
+    running_ = false;
+
+    {
+        std::unique_lock<std::mutex> lock(delivery_mutex_);
+        deliverReady(lock, true);
+    }
+
+    auto stats = getStats();
+    std::cout << "CascadeClassifier stopped: " << stats.classify.items << " objects from " << stats.detect.items
+              << " messages in " << stats.batches << " batches (mean " << stats.mean_batch_size << "), "
+              << stats.incomplete_messages << " incomplete, latency p95 " << stats.p95_latency_ms << " ms"
+              << std::endl;
+}
+
+void CascadeClassifier::setCallback(CascadeCallback callback) {
+    auto shared = callback ? std::make_shared<const CascadeCallback>(std::move(callback)) : nullptr;
+    std::lock_guard<std::mutex> lock(delivery_mutex_);
+    callback_ = std::move(shared);
+}
+
+void CascadeClassifier::beginMessage(std::shared_ptr<dai::ImgDetections> detections,
+                                     const std::vector<uint32_t>& indices) {
+    if (!running_ || indices.empty()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(delivery_mutex_);
+    // Back in the pool once delivered and out of the workers' jobs
+    std::shared_ptr<Message> message = message_pool_.acquire();
+
+    auto& result = message->result;
+    result.sequence = detections->getSequenceNum();
+    result.objects.resize(indices.size());
+    for (size_t slot = 0; slot < indices.size(); ++slot) {
+        auto& object = result.objects[slot];
+        object.index = indices[slot];
+        object.detection = detections->detections[indices[slot]];
+        object.valid = false;
+        object.label = -1;
+        object.score = 0.0f;
+        object.values.clear();
+    }
+    result.detections = std::move(detections);
+    message->submitted.assign(indices.size(), 0);
+    message->delivered = false;
+    message->remaining = static_cast<uint32_t>(indices.size());
+    message->awaiting = message->remaining;
+    message->start = now;
+    open_.push_back(std::move(message));
+
+    {
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        if (stats_.detect.items++ == 0) {
+            first_message_ = now;
+        }
+        stats_.detect.queued = static_cast<uint32_t>(open_.size());
+        stats_.detect.max_queued = std::max(stats_.detect.max_queued, stats_.detect.queued);
+        stats_.crop.queued += static_cast<uint32_t>(indices.size());
+        stats_.crop.max_queued = std::max(stats_.crop.max_queued, stats_.crop.queued);
+    }
+    deliverReady(lock, false);
+}
+
+CascadeClassifier::Submit CascadeClassifier::submit(int64_t sequence, uint32_t index, const cv::Mat& crop,
+                                                    std::shared_ptr<void> holder, double crop_ms) {
+    auto now = std::chrono::steady_clock::now();
+    std::shared_ptr<Message> message;
+    uint32_t slot = 0;
+    {
+        std::lock_guard<std::mutex> lock(delivery_mutex_);
+        // Newest first: crops arrive for recent messages
+        for (auto it = open_.rbegin(); it != open_.rend() && !message; ++it) {
+            if ((*it)->result.sequence != sequence) {
+                continue;
+            }
+            const auto& objects = (*it)->result.objects;
+            for (uint32_t i = 0; i < objects.size(); ++i) {
+                if (objects[i].index == index && !(*it)->submitted[i]) {
+                    message = *it;
+                    slot = i;
+                    break;
+                }
+            }
+        }
+        if (!message) {
+            return Submit::UNKNOWN;
+        }
+        message->submitted[slot] = 1;
+        --message->awaiting;
+    }
+
+    double since_start_ms = std::chrono::duration<double, std::milli>(now - message->start).count();
+    bool queued = pool_.tryPush({message, slot, crop, std::move(holder), now}, config_.max_queued);
+    {
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        if (stats_.crop.items++ == 0) {
+            first_crop_ = now;
+        }
+        stats_.crop.queued = stats_.crop.queued > 0 ? stats_.crop.queued - 1 : 0;
+        crop_wait_.add(std::max(0.0, since_start_ms - crop_ms));
+        crop_service_.add(crop_ms);
+        if (queued) {
+            stats_.classify.max_queued = std::max(stats_.classify.max_queued,
+                                                  static_cast<uint32_t>(pool_.pending()));
+        } else {
+            ++stats_.classify.dropped;
+        }
+    }
+
+    if (!queued) {
+        complete(message, slot, nullptr);
+        return Submit::DROPPED;
+    }
+    return Submit::QUEUED;
+}
+
+void CascadeClassifier::addCrops(const CropSet& set) {
+    std::vector<uint32_t>& indices = crop_indices_;
+    indices.clear();
+    for (const auto& crop : set.crops) {
+        indices.push_back(crop.index);
+    }
+    beginMessage(set.detections, indices);
+    for (const auto& crop : set.crops) {
+        submit(set.sequence, crop.index, *crop.image, crop.image, crop.cost_us / 1000.0);
+    }
+}
+
+void CascadeClassifier::expire() {
+    std::unique_lock<std::mutex> lock(delivery_mutex_);
+    deliverReady(lock, false);
+}
+
+void CascadeClassifier::finishBatch(Worker& worker, std::vector<Job>& batch, const cv::Mat& output,
+                                    std::chrono::steady_clock::time_point start) {
+    const int count = static_cast<int>(batch.size());
+
+    // One row of outputs per crop, whatever the trailing shape ([N, C] or [N, C, 1, 1])
+    size_t row_size = output.total() / static_cast<size_t>(count);
+    const float* rows = output.ptr<float>();
+    if (worker.decoded.size() < batch.size()) {
+        worker.decoded.resize(batch.size());
+    }
+    {
+        TraceSpan span("decode", "CascadeClassifier", batch.front().message->result.sequence);
+        for (int i = 0; i < count; ++i) {
+            decode(rows + row_size * i, row_size, worker.decoded[i]);
+        }
+    }
+
+    double batch_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        if (stats_.classify.items == 0) {
+            first_result_ = start;
+        }
+        stats_.classify.items += batch.size();
+        ++stats_.batches;
+        total_batch_items_ += static_cast<double>(batch.size());
+        batch_ms_.add(batch_ms);
+        for (const auto& job : batch) {
+            classify_wait_.add(std::chrono::duration<double, std::milli>(start - job.queued).count());
+        }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        complete(batch[i].message, batch[i].slot, &worker.decoded[i]);
+    }
+}
+
+void CascadeClassifier::decode(const float* row, size_t size, ObjectResult& object) const {
+    object.valid = false;
+    object.label = -1;
+    object.score = 0.0f;
+    object.values.assign(row, row + size);
+    if (config_.output == CascadeOutput::EMBEDDING) {
+        double norm = 0.0;
+        for (float value : object.values) {
+            norm += static_cast<double>(value) * value;
+        }
+        if (norm > 0.0) {
+            float inverse = static_cast<float>(1.0 / std::sqrt(norm));
+            for (float& value : object.values) {
+                value *= inverse;
+            }
+        }
+        object.valid = true;
+        return;
+    }
+
+    if (config_.apply_softmax && size > 0) {
+        float peak = *std::max_element(object.values.begin(), object.values.end());
+        double sum = 0.0;
+        for (float& value : object.values) {
+            value = std::exp(value - peak);
+            sum += value;
+        }
+        for (float& value : object.values) {
+            value = static_cast<float>(value / sum);
+        }
+    }
+    auto best = std::max_element(object.values.begin(), object.values.end());
+    if (best != object.values.end()) {
+        object.label = static_cast<int32_t>(best - object.values.begin());
+        object.score = *best;
+        object.valid = true;
+    }
+}
+
+void CascadeClassifier::complete(const std::shared_ptr<Message>& message, uint32_t slot, ObjectResult* result) {
+    std::unique_lock<std::mutex> lock(delivery_mutex_);
+    if (message->delivered) {
+        return;  // Timed out; the result came too late
+    }
+    if (result) {
+        // Swapped, so the worker's scratch takes over the slot's old capacity
+        auto& object = message->result.objects[slot];
+        object.valid = result->valid;
+        object.label = result->label;
+        object.score = result->score;
+        object.values.swap(result->values);
+    }
+    --message->remaining;
+    deliverReady(lock, false);
+}
+
+void CascadeClassifier::deliverReady(std::unique_lock<std::mutex>& lock, bool flush) {
+    if (delivering_) {
+        // The delivering thread picks up whatever became due, and the flush
+        flush_requested_ = flush_requested_ || flush;
+        return;
+    }
+    delivering_ = true;
+
+    auto timeout = std::chrono::milliseconds(config_.result_timeout_ms);
+    std::vector<std::shared_ptr<Message>>& ready = ready_;
+    while (true) {
+        flush = flush || flush_requested_;
+        flush_requested_ = false;
+
+        // In message order: a slow message holds back the ones behind it
+        auto now = std::chrono::steady_clock::now();
+        ready.clear();
+        while (!open_.empty()) {
+            auto& message = open_.front();
+            if (message->remaining > 0 && !flush && now - message->start < timeout) {
+                break;
+            }
+
+            auto& result = message->result;
+            result.complete = message->remaining == 0;
+            result.latency_ms = std::chrono::duration<double, std::milli>(now - message->start).count();
+            {
+                std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+                latency_.add(result.latency_ms);
+                if (!result.complete) {
+                    ++stats_.incomplete_messages;
+                }
+                // Crops that never arrived
+                stats_.crop.dropped += message->awaiting;
+                stats_.crop.queued = stats_.crop.queued > message->awaiting ? stats_.crop.queued - message->awaiting : 0;
+                stats_.detect.queued = static_cast<uint32_t>(open_.size() - 1);
+            }
+            // Late results are discarded from here on, so the result is stable during the callback
+            message->awaiting = 0;
+            message->delivered = true;
+            ready.push_back(std::move(message));
+            open_.pop_front();
+        }
+        if (ready.empty()) {
+            break;
+        }
+
+        auto callback = callback_;
+        lock.unlock();
+        for (auto& message : ready) {
+            if (callback) {
+                TraceSpan span("cascade_callback", "CascadeClassifier", message->result.sequence);
+                (*callback)(message->result);
+            }
+            // The message is reused once no job holds it
+            message->result.detections.reset();
+            message.reset();
+        }
+        lock.lock();
+    }
+    delivering_ = false;
+}
+
+CascadeStats CascadeClassifier::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    CascadeStats stats = stats_;
+    auto now = std::chrono::steady_clock::now();
+    auto rate = [now](uint64_t items, std::chrono::steady_clock::time_point first) {
+        double elapsed_s = std::chrono::duration<double>(now - first).count();
+        return items > 0 && elapsed_s > 0.0 ? static_cast<double>(items) / elapsed_s : 0.0;
+    };
+    stats.detect.items_per_second = rate(stats.detect.items, first_message_);
+    stats.crop.items_per_second = rate(stats.crop.items, first_crop_);
+    stats.classify.items_per_second = rate(stats.classify.items, first_result_);
+
+    stats.batch_size = pool_.batchSize();
+    stats.classify.queued = static_cast<uint32_t>(pool_.pending());
+    if (stats.batches > 0) {
+        stats.mean_batch_size = total_batch_items_ / static_cast<double>(stats.batches);
+    }
+    crop_wait_.summarize(stats.crop.mean_wait_ms, stats.crop.p95_wait_ms);
+    crop_service_.summarize(stats.crop.mean_service_ms, stats.crop.p95_service_ms);
+    classify_wait_.summarize(stats.classify.mean_wait_ms, stats.classify.p95_wait_ms);
+    batch_ms_.summarize(stats.classify.mean_service_ms, stats.classify.p95_service_ms);
+    latency_.summarize(stats.mean_latency_ms, stats.p95_latency_ms);
+    return stats;
+}
+
+} // namespace oak
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <depthai/depthai.hpp>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+#include "CropExtractor.h"
+#include "DnnWorkerPool.h"
+#include "../engine/ObjectPool.h"
+
+namespace oak {
+
+// Second-stage result for one detected object
+struct ObjectResult {
+    uint32_t index = 0;                  // Parent detection in the first-stage message
+    dai::ImgDetection detection;
+    bool valid = false;                  // False when the crop or its forward pass was lost
+    int32_t label = -1;                  // CLASSIFICATION: best class
+    float score = 0.0f;                  // CLASSIFICATION: its probability
+    std::vector<float> values;           // Class probabilities, or the L2-normalized embedding
+};
+
+// First-stage detections with the second-stage result of each cropped
+// object. Valid for the duration of the callback.
+struct CascadeResult {
+    int64_t sequence = -1;
+    std::shared_ptr<dai::ImgDetections> detections;
+    std::vector<ObjectResult> objects;   // Cropped detections only, in crop order
+    bool complete = true;                // Every object has a result
+    double latency_ms = 0.0;             // First-stage message seen -> result delivered
+};
+
+using CascadeCallback = std::function<void(const CascadeResult&)>;
+
+// Throughput and queueing of one cascade stage
+struct CascadeStageStats {
+    uint64_t items = 0;                  // Messages (detect) or objects (crop, classify)
+    double items_per_second = 0.0;       // Since the first item
+    uint64_t dropped = 0;
+    uint32_t queued = 0;                 // Waiting for the stage right now
+    uint32_t max_queued = 0;
+    double mean_wait_ms = 0.0;           // Between entering the stage and its work starting
+    double p95_wait_ms = 0.0;
+    double mean_service_ms = 0.0;        // Work per item
+    double p95_service_ms = 0.0;
+};
+
+struct CascadeStats {
+    // detect: first-stage messages that had objects to crop; queued = awaiting results
+    // crop: objects from message to crop ready (device crops: including the transfer)
+    // classify: objects from crop ready to result; service is per batch
+    CascadeStageStats detect;
+    CascadeStageStats crop;
+    CascadeStageStats classify;
+    uint32_t batch_size = 0;             // Effective (1 if the model has a fixed batch)
+    uint64_t batches = 0;
+    double mean_batch_size = 0.0;
+    uint64_t incomplete_messages = 0;    // Delivered after result_timeout_ms with objects missing
+    double mean_latency_ms = 0.0;        // Per message, first stage to delivery
+    double p95_latency_ms = 0.0;
+};
+
+// Runs a second network over the objects of each detection message:
+// attributes, fine-grained classes or re-identification embeddings.
+//
+// A message is opened with the detections that will be cropped; their crops
+// arrive separately (from CropExtractor on the host, or from the device) and
+// are queued for a DnnWorkerPool. Workers take up to batch_size crops at
+// once, from any mix of messages, so objects of small messages still fill a
+// batch. Once every object of a message has a result (or result_timeout_ms
+// passed) the merged result is delivered, in message order, one callback at
+// a time and without holding the classifier's locks.
+class CascadeClassifier {
+public:
+    // Crops arrive at input_width x input_height (the crop output size)
+    CascadeClassifier(const CascadeConfig& config, uint32_t input_width, uint32_t input_height);
+    ~CascadeClassifier();
+
+    CascadeClassifier(const CascadeClassifier&) = delete;
+    CascadeClassifier& operator=(const CascadeClassifier&) = delete;
+
+    // Load the model on every worker and start the pool
+    bool start();
+    // Classify what is queued, deliver every open message, stop the workers
+    void stop();
+
+    void setCallback(CascadeCallback callback);
+
+    // Opens a message whose detections `indices` will be submitted
+    void beginMessage(std::shared_ptr<dai::ImgDetections> detections, const std::vector<uint32_t>& indices);
+
+    enum class Submit { QUEUED, DROPPED, UNKNOWN };
+    // One object's crop (BGR, input size). holder keeps the crop's memory
+    // alive until it is classified. UNKNOWN: no open message has this
+    // sequence and detection index (yet).
+    Submit submit(int64_t sequence, uint32_t index, const cv::Mat& crop, std::shared_ptr<void> holder,
+                  double crop_ms = 0.0);
+
+    // Host crops: opens the set's message and submits all of its crops.
+    // Called from one thread (the crop delivery stream).
+    void addCrops(const CropSet& set);
+
+    // Delivers messages whose results are overdue; call periodically
+    void expire();
+
+    bool isRunning() const { return running_.load(); }
+    CascadeStats getStats() const;
+
+private:
+    // Guarded by delivery_mutex_
+    struct Message {
+        CascadeResult result;
+        std::vector<uint8_t> submitted;  // Per object: its crop arrived
+        uint32_t remaining = 0;          // Objects without a result
+        uint32_t awaiting = 0;           // Objects without a crop
+        bool delivered = false;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    struct Job {
+        std::shared_ptr<Message> message;
+        uint32_t slot = 0;               // Into result.objects
+        cv::Mat crop;
+        std::shared_ptr<void> holder;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    // Per-worker scratch, indexed like the pool's workers
+    struct Worker {
+        cv::Mat resized;                 // For crops that are not at the input size
+        std::vector<ObjectResult> decoded;  // Per batch slot; swapped into the messages
+    };
+
+    // Recent samples for mean and p95
+    struct Window {
+        std::vector<double> values;
+        size_t head = 0;
+        uint64_t count = 0;
+        void add(double value);
+        void summarize(double& mean, double& p95) const;
+    };
+
+    void finishBatch(Worker& worker, std::vector<Job>& batch, const cv::Mat& output,
+                     std::chrono::steady_clock::time_point start);
+    void decode(const float* row, size_t size, ObjectResult& object) const;
+    // One object done; result = nullptr when it was lost
+    void complete(const std::shared_ptr<Message>& message, uint32_t slot, ObjectResult* result);
+    // Delivers the messages that are due, in order. Called with
+    // delivery_mutex_ held; releases it while the callback runs.
+    void deliverReady(std::unique_lock<std::mutex>& lock, bool flush);
+
+    CascadeConfig config_;
+    uint32_t input_width_;
+    uint32_t input_height_;
+
+    std::vector<Worker> workers_;
+    DnnWorkerPool<Job> pool_;            // After workers_, so its threads stop first
+    std::atomic<bool> running_{false};
+
+    // Open messages in arrival order, delivered from the front (guarded by delivery_mutex_)
+    std::mutex delivery_mutex_;
+    std::shared_ptr<const CascadeCallback> callback_;
+    std::deque<std::shared_ptr<Message>> open_;
+    bool delivering_ = false;            // A thread is running callbacks (without the lock)
+    bool flush_requested_ = false;       // stop() asked while another thread was delivering
+    std::vector<std::shared_ptr<Message>> ready_;         // Owned by the delivering thread
+    ObjectPool<Message> message_pool_;
+    std::vector<uint32_t> crop_indices_;                  // addCrops() scratch
+
+    mutable std::mutex stats_mutex_;
+    CascadeStats stats_;
+    Window crop_wait_;
+    Window crop_service_;
+    Window classify_wait_;
+    Window batch_ms_;
+    Window latency_;
+    double total_batch_items_ = 0.0;
+    std::chrono::steady_clock::time_point first_message_;
+    std::chrono::steady_clock::time_point first_crop_;
+    std::chrono::steady_clock::time_point first_result_;
+};
+
+} // namespace oak
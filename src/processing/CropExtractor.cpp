@@ -0,0 +1,374 @@
+#include "CropExtractor.h"
+#include "ImageKernels.h"
+#include "../engine/Trace.h"
+#include "../engine/SampleStats.h"
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+namespace oak {
+
+namespace {
+
+int64_t deviceMicros(const dai::Buffer& message) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        message.getTimestampDevice().time_since_epoch()).count();
+}
+
+} // namespace
+
+CropExtractor::CropExtractor(const CropConfig& config, std::shared_ptr<TaskPool> pool, uint64_t delivery_stream)
+    : config_(config),
+      pool_(std::move(pool)),
+      delivery_stream_(delivery_stream),
+      jobs_(std::max(config.max_pending, 1u)),
+      buffers_(config.buffer_pool, [this] {
+          return std::make_unique<cv::Mat>(static_cast<int>(config_.output_height),
+                                           static_cast<int>(config_.output_width), CV_8UC3);
+      }) {
+    config_.max_pending = std::max(config_.max_pending, 1u);
+    frames_.resize(std::max(config_.frame_history, 1u));
+    pending_.reserve(config_.max_pending);
+    order_.reserve(config_.max_crops);
+    crop_us_.assign(std::max(config_.latency_window, 1u), 0.0);
+}
+
+CropExtractor::~CropExtractor() {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cv_.wait(lock, [this] { return in_flight_.load(std::memory_order_acquire) == 0; });
+}
+
+void CropExtractor::setDetectionSpace(uint32_t width, uint32_t height, bool letterboxed) {
+    space_width_ = width;
+    space_height_ = height;
+    letterboxed_ = letterboxed;
+}
+
+void CropExtractor::setCallback(CropCallback callback) {
+    callback_ = std::move(callback);
+}
+
+void CropExtractor::addFrame(std::shared_ptr<dai::ImgFrame> frame) {
+    frames_[next_frame_] = std::move(frame);
+    next_frame_ = (next_frame_ + 1) % frames_.size();
+    resolvePending();
+}
+
+void CropExtractor::addDetections(std::shared_ptr<dai::ImgDetections> detections) {
+    if (!pending_.empty()) {
+        // Behind older messages still waiting for their frame
+        pending_.push_back(std::move(detections));
+    } else {
+        std::shared_ptr<dai::ImgFrame> frame;
+        switch (findFrame(*detections, frame)) {
+            case Match::FOUND:
+                start(std::move(detections), std::move(frame));
+                return;
+            case Match::WAIT:
+                pending_.push_back(std::move(detections));
+                break;
+            case Match::NONE: {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                ++stats_.unmatched;
+                return;
+            }
+        }
+    }
+    if (pending_.size() > config_.max_pending) {
+        pending_.pop_front();
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.unmatched;
+    }
+    resolvePending();
+}
+
+CropExtractor::Match CropExtractor::findFrame(const dai::ImgDetections& detections,
+                                              std::shared_ptr<dai::ImgFrame>& frame) const {
+    int64_t target = deviceMicros(detections);
+    int64_t tolerance = static_cast<int64_t>(config_.match_tolerance_ms * 1000.0f);
+    int64_t best = -1;
+    int64_t newest = INT64_MIN;
+    for (const auto& candidate : frames_) {
+        if (!candidate) {
+            continue;
+        }
+        int64_t time = deviceMicros(*candidate);
+        newest = std::max(newest, time);
+        int64_t diff = std::abs(time - target);
+        if (diff <= tolerance && (best < 0 || diff < best)) {
+            best = diff;
+            frame = candidate;
+        }
+    }
+    if (best >= 0) {
+        return Match::FOUND;
+    }
+    // The frame may still be on its way (the two queues are polled in turn)
+    return newest < target ? Match::WAIT : Match::NONE;
+}
+
+void CropExtractor::resolvePending() {
+    while (!pending_.empty()) {
+        std::shared_ptr<dai::ImgFrame> frame;
+        Match match = findFrame(*pending_.front(), frame);
+        if (match == Match::WAIT) {
+            return;
+        }
+        if (match == Match::FOUND) {
+            start(std::move(pending_.front()), std::move(frame));
+        } else {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            ++stats_.unmatched;
+        }
+        pending_.pop_front();
+    }
+}
+
+void CropExtractor::start(std::shared_ptr<dai::ImgDetections> detections, std::shared_ptr<dai::ImgFrame> frame) {
+    TraceSpan span("crop_plan", "CropExtractor", detections->getSequenceNum());
+    const auto& dets = detections->detections;
+
+    // Highest confidence first, within max_crops
+    order_.clear();
+    for (uint32_t i = 0; i < dets.size(); ++i) {
+        if (config_.labels.empty() ||
+            std::find(config_.labels.begin(), config_.labels.end(), dets[i].label) != config_.labels.end()) {
+            order_.push_back(i);
+        }
+    }
+    std::sort(order_.begin(), order_.end(),
+              [&dets](uint32_t a, uint32_t b) { return dets[a].confidence > dets[b].confidence; });
+    if (order_.size() > config_.max_crops) {
+        order_.resize(config_.max_crops);
+    }
+    if (order_.empty()) {
+        return;
+    }
+
+    std::shared_ptr<Job> job = jobs_.acquire();
+    if (!job) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.dropped_messages;
+        return;
+    }
+
+    auto& set = job->set;
+    set.crops.clear();
+    uint32_t width = frame->getWidth();
+    uint32_t height = frame->getHeight();
+    uint64_t small = 0;
+    uint64_t no_buffer = 0;
+    for (uint32_t index : order_) {
+        Crop crop;
+        crop.index = index;
+        crop.detection = dets[index];
+        if (!planCrop(crop.detection, width, height, crop)) {
+            ++small;
+            continue;
+        }
+        crop.image = buffers_.acquire();
+        if (!crop.image) {
+            ++no_buffer;
+            continue;
+        }
+        set.crops.push_back(std::move(crop));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.skipped_small += small;
+        stats_.skipped_pool += no_buffer;
+        stats_.buffers = static_cast<uint32_t>(buffers_.size());
+    }
+    if (set.crops.empty()) {
+        return;
+    }
+
+    set.sequence = detections->getSequenceNum();
+    set.detections = std::move(detections);
+    set.source = std::move(frame);
+    job->start = std::chrono::steady_clock::now();
+
+    uint32_t workers = config_.workers > 0 ? config_.workers : (pool_ ? pool_->size() : 1);
+    uint32_t tasks = std::max(1u, std::min(workers, static_cast<uint32_t>(set.crops.size())));
+    job->remaining.store(tasks, std::memory_order_relaxed);
+    in_flight_.fetch_add(tasks, std::memory_order_acq_rel);
+
+    std::shared_ptr<Job> shared = std::move(job);
+    for (uint32_t first = 0; first < tasks; ++first) {
+        if (!pool_ || !pool_->submit([this, shared, first, tasks] { runTask(shared, first, tasks); })) {
+            runTask(shared, first, tasks);  // No pool, or it is stopping
+        }
+    }
+}
+
+bool CropExtractor::planCrop(const dai::ImgDetection& det, uint32_t width, uint32_t height, Crop& crop) {
+    float xmin = det.xmin, ymin = det.ymin, xmax = det.xmax, ymax = det.ymax;
+
+    // Undo the detector's letterbox: the source's field of view is centred
+    // in the detector input, scaled to fit
+    if (letterboxed_ && space_width_ > 0 && space_height_ > 0) {
+        float scale = std::min(static_cast<float>(space_width_) / width, static_cast<float>(space_height_) / height);
+        float content_w = width * scale / space_width_;
+        float content_h = height * scale / space_height_;
+        float offset_x = (1.0f - content_w) * 0.5f;
+        float offset_y = (1.0f - content_h) * 0.5f;
+        xmin = (xmin - offset_x) / content_w;
+        xmax = (xmax - offset_x) / content_w;
+        ymin = (ymin - offset_y) / content_h;
+        ymax = (ymax - offset_y) / content_h;
+    }
+
+    float box_w = (xmax - xmin) * width;
+    float box_h = (ymax - ymin) * height;
+    float pad_x = box_w * config_.padding;
+    float pad_y = box_h * config_.padding;
+    int x1 = static_cast<int>(std::floor(std::max(0.0f, xmin * width - pad_x)));
+    int y1 = static_cast<int>(std::floor(std::max(0.0f, ymin * height - pad_y)));
+    int x2 = static_cast<int>(std::ceil(std::min(static_cast<float>(width), xmax * width + pad_x)));
+    int y2 = static_cast<int>(std::ceil(std::min(static_cast<float>(height), ymax * height + pad_y)));
+
+    // NV12 chroma is subsampled 2x2: keep the region on even pixels
+    if (config_.source_transport == FrameTransport::NV12) {
+        x1 &= ~1;
+        y1 &= ~1;
+        x2 = std::min(static_cast<int>(width) & ~1, (x2 + 1) & ~1);
+        y2 = std::min(static_cast<int>(height) & ~1, (y2 + 1) & ~1);
+    }
+    int min_size = static_cast<int>(std::max(config_.min_size, 2u));
+    if (x2 - x1 < min_size || y2 - y1 < min_size) {
+        return false;
+    }
+    crop.source_rect = cv::Rect(x1, y1, x2 - x1, y2 - y1);
+
+    int out_w = static_cast<int>(config_.output_width);
+    int out_h = static_cast<int>(config_.output_height);
+    if (config_.keep_aspect) {
+        double scale = std::min(static_cast<double>(out_w) / crop.source_rect.width,
+                                static_cast<double>(out_h) / crop.source_rect.height);
+        int content_w = std::clamp(static_cast<int>(std::lround(crop.source_rect.width * scale)), 1, out_w);
+        int content_h = std::clamp(static_cast<int>(std::lround(crop.source_rect.height * scale)), 1, out_h);
+        crop.content = cv::Rect((out_w - content_w) / 2, (out_h - content_h) / 2, content_w, content_h);
+    } else {
+        crop.content = cv::Rect(0, 0, out_w, out_h);
+    }
+    return true;
+}
+
+void CropExtractor::runTask(const std::shared_ptr<Job>& job, uint32_t first, uint32_t step) {
+    auto& set = job->set;
+    {
+        TraceSpan span("crop", "CropExtractor", set.sequence);
+        for (size_t i = first; i < set.crops.size(); i += step) {
+            cropOne(*set.source, set.crops[i]);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        for (size_t i = first; i < set.crops.size(); i += step) {
+            crop_us_[crop_head_] = set.crops[i].cost_us;
+            crop_head_ = (crop_head_ + 1) % crop_us_.size();
+            ++stats_.crops;
+        }
+    }
+
+    if (job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Last task of the message
+        in_flight_.fetch_add(1, std::memory_order_acq_rel);
+        if (!pool_ || !pool_->submit(delivery_stream_, [this, job] { deliver(job); finishTask(); })) {
+            deliver(job);
+            finishTask();
+        }
+    }
+    finishTask();
+}
+
+void CropExtractor::cropOne(dai::ImgFrame& frame, Crop& crop) {
+    auto start = std::chrono::steady_clock::now();
+    const cv::Rect& rect = crop.source_rect;
+    // Per worker; keeps its allocation between crops of similar size
+    thread_local cv::Mat scratch;
+
+    cv::Mat region;
+    uint8_t* data = frame.getData().data();
+    switch (frame.getType()) {
+        case dai::ImgFrame::Type::NV12: {
+            // Only the region is converted: both planes are addressed at its origin
+            size_t stride = frame.getStride() > 0 ? frame.getStride() : frame.getWidth();
+            size_t plane_height = frame.getPlaneHeight() > 0 ? frame.getPlaneHeight() : frame.getHeight();
+            const uint8_t* y = data + rect.y * stride + rect.x;
+            const uint8_t* uv = data + stride * plane_height + (rect.y / 2) * stride + rect.x;
+            scratch.create(rect.height, rect.width, CV_8UC3);
+            nv12ToBgr(y, stride, uv, stride, static_cast<uint32_t>(rect.width), static_cast<uint32_t>(rect.height),
+                      scratch.data, scratch.step);
+            region = scratch;
+            break;
+        }
+        case dai::ImgFrame::Type::BGR888i: {
+            size_t stride = frame.getStride() > 0 ? frame.getStride() : frame.getWidth() * 3;
+            region = cv::Mat(static_cast<int>(frame.getHeight()), static_cast<int>(frame.getWidth()), CV_8UC3,
+                             data, stride)(rect);
+            break;
+        }
+        default:
+            region = frame.getCvFrame()(rect);
+            break;
+    }
+
+    cv::Mat& out = *crop.image;
+    if (crop.content.size() != out.size()) {
+        out.setTo(cv::Scalar::all(0));
+    }
+    cv::Mat target = out(crop.content);
+    int interpolation = rect.width > crop.content.width ? cv::INTER_AREA : cv::INTER_LINEAR;
+    cv::resize(region, target, target.size(), 0.0, 0.0, interpolation);
+
+    crop.cost_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CropExtractor::deliver(const std::shared_ptr<Job>& job) {
+    auto& set = job->set;
+    set.latency_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - job->start).count();
+    if (callback_) {
+        TraceSpan span("crop_callback", "CropExtractor", set.sequence);
+        callback_(set);
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.messages;
+        ++latency_messages_;
+        latency_total_us_ += set.latency_us;
+    }
+    // Release the frame and the buffers the callback did not keep; the
+    // vector keeps its capacity for the next message
+    set.crops.clear();
+    set.detections.reset();
+    set.source.reset();
+}
+
+void CropExtractor::finishTask() {
+    if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        idle_cv_.notify_all();
+    }
+}
+
+CropStats CropExtractor::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    CropStats stats = stats_;
+    if (latency_messages_ > 0) {
+        stats.mean_latency_us = latency_total_us_ / static_cast<double>(latency_messages_);
+    }
+
+    size_t samples = static_cast<size_t>(std::min<uint64_t>(stats.crops, crop_us_.size()));
+    if (samples > 0) {
+        std::vector<double> costs(crop_us_.begin(), crop_us_.begin() + samples);
+        SampleSummary summary = summarizeSamples(costs);
+        stats.mean_crop_us = summary.mean;
+        stats.max_crop_us = summary.max;
+        stats.p50_crop_us = summary.p50;
+        stats.p95_crop_us = summary.p95;
+    }
+    return stats;
+}
+
+} // namespace oak
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+#include <depthai/depthai.hpp>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+#include "../engine/TaskPool.h"
+#include "../engine/RingDeque.h"
+#include "../engine/ObjectPool.h"
+
+namespace oak {
+
+struct Crop {
+    uint32_t index = 0;                  // Position in the message's detections
+    dai::ImgDetection detection;
+    cv::Rect source_rect;                // Padded box in source frame pixels
+    cv::Rect content;                    // Part of image holding the crop; the rest is letterbox
+    std::shared_ptr<cv::Mat> image;      // BGR at the output size; back to the pool once released
+    double cost_us = 0.0;                // Conversion + resize on the worker
+};
+
+// Crops of one detection message. Valid for the duration of the callback;
+// keep the image pointers (not the set) to hold on to crops.
+struct CropSet {
+    int64_t sequence = -1;               // Of the detection message
+    std::shared_ptr<dai::ImgDetections> detections;
+    std::shared_ptr<dai::ImgFrame> source;  // Frame the crops were cut from
+    std::vector<Crop> crops;             // Highest confidence first
+    double latency_us = 0.0;             // From the match to the last crop
+};
+
+using CropCallback = std::function<void(const CropSet&)>;
+
+struct CropStats {
+    uint64_t messages = 0;               // Detection messages cropped
+    uint64_t crops = 0;
+    uint64_t unmatched = 0;              // Messages without a source frame within the tolerance
+    uint64_t dropped_messages = 0;       // Arrived while max_pending messages were in flight
+    uint64_t skipped_small = 0;          // Boxes under min_size
+    uint64_t skipped_pool = 0;           // Boxes with no free output buffer
+    uint32_t buffers = 0;                // Output buffers allocated
+    double mean_crop_us = 0.0;           // Per crop, over the latency window
+    double p50_crop_us = 0.0;
+    double p95_crop_us = 0.0;
+    double max_crop_us = 0.0;
+    double mean_latency_us = 0.0;        // Per message, match to delivery
+};
+
+// Cuts the detected objects out of a high-resolution stream that runs next
+// to the detector, for a second-stage model or for storage.
+//
+// Detection messages are matched to source frames by device timestamp:
+// both streams come from the same camera captures, so a match is exact
+// unless the source runs at a lower rate. Frames are kept for the last
+// frame_history captures and detections wait (up to max_pending) for a frame
+// that has not arrived yet. Boxes are mapped from the detector's input to
+// source pixels, undoing the letterbox when the detector input had one.
+//
+// The crops of a message are spread over up to `workers` unordered tasks on
+// the task pool. NV12 sources are converted only inside each crop (nv12ToBgr
+// on the region's planes), then resized into pooled output buffers. The
+// set is delivered on the given task pool stream once its last crop is done,
+// so callbacks never run concurrently; sets that finish out of order are
+// delivered out of order (check sequence). Steady-state cropping does not
+// allocate once the pools have grown to the working size.
+class CropExtractor {
+public:
+    // pool = nullptr crops and delivers inline on the calling thread
+    CropExtractor(const CropConfig& config, std::shared_ptr<TaskPool> pool, uint64_t delivery_stream);
+    // Waits for the crops in flight
+    ~CropExtractor();
+
+    CropExtractor(const CropExtractor&) = delete;
+    CropExtractor& operator=(const CropExtractor&) = delete;
+
+    // Image the detection coordinates are normalized to (the detector input)
+    // and whether it letterboxes the source's field of view; by default the
+    // coordinates are taken as normalized to the source itself
+    void setDetectionSpace(uint32_t width, uint32_t height, bool letterboxed);
+    void setCallback(CropCallback callback);
+
+    // Processing thread
+    void addFrame(std::shared_ptr<dai::ImgFrame> frame);
+    void addDetections(std::shared_ptr<dai::ImgDetections> detections);
+
+    CropStats getStats() const;
+
+private:
+    struct Job {
+        CropSet set;
+        std::atomic<uint32_t> remaining{0};   // Tasks still cropping
+        std::chrono::steady_clock::time_point start;
+    };
+
+    enum class Match { FOUND, WAIT, NONE };
+    Match findFrame(const dai::ImgDetections& detections, std::shared_ptr<dai::ImgFrame>& frame) const;
+    void resolvePending();
+    void start(std::shared_ptr<dai::ImgDetections> detections, std::shared_ptr<dai::ImgFrame> frame);
+    bool planCrop(const dai::ImgDetection& det, uint32_t width, uint32_t height, Crop& crop);
+    void runTask(const std::shared_ptr<Job>& job, uint32_t first, uint32_t step);
+    void cropOne(dai::ImgFrame& frame, Crop& crop);
+    void deliver(const std::shared_ptr<Job>& job);
+    void finishTask();
+
+    CropConfig config_;
+    std::shared_ptr<TaskPool> pool_;
+    uint64_t delivery_stream_;
+    CropCallback callback_;
+
+    // Detector input; 0 = coordinates normalized to the source
+    uint32_t space_width_ = 0;
+    uint32_t space_height_ = 0;
+    bool letterboxed_ = false;
+
+    // Processing thread only
+    std::vector<std::shared_ptr<dai::ImgFrame>> frames_;  // Ring of recent source frames
+    size_t next_frame_ = 0;
+    RingDeque<std::shared_ptr<dai::ImgDetections>> pending_;
+    ObjectPool<Job> jobs_;                            // max_pending messages in flight
+    ObjectPool<cv::Mat> buffers_;                     // buffer_pool crop images
+    std::vector<uint32_t> order_;                     // Detection indices by confidence
+
+    std::atomic<uint32_t> in_flight_{0};  // Tasks submitted and not finished
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+
+    mutable std::mutex stats_mutex_;
+    CropStats stats_;
+    std::vector<double> crop_us_;        // Latency window ring
+    size_t crop_head_ = 0;
+    uint64_t latency_messages_ = 0;
+    double latency_total_us_ = 0.0;
+};
+
+} // namespace oak
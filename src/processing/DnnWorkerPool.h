@@ -0,0 +1,308 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+#include "../engine/Trace.h"
+#include "../engine/ThreadTuning.h"
+
+namespace oak {
+
+struct DnnPoolOptions {
+    std::string model_path;
+    const char* name = "DnnWorkerPool";  // Log prefix and trace category (a literal)
+    std::string thread_name = "dnn";     // Workers are <thread_name>-<index>
+    uint32_t threads = 1;
+    uint32_t batch_size = 1;
+    uint32_t batch_timeout_ms = 5;       // Max wait for a full batch before running a partial one
+    uint32_t input_width = 0;            // Network input; each job fills 3 planes of this size
+    uint32_t input_height = 0;
+    ThreadOptions thread_options;        // Applied to every worker
+};
+
+// Workers running one OpenCV DNN model over batches of queued jobs, shared
+// by the host-side networks (HostInference, CascadeClassifier).
+//
+// Each worker owns a cv::dnn::Net, which is not safe to share between
+// threads, and an NCHW float blob reused while the batch size holds. Workers
+// take up to batch_size jobs in submission order, giving a partial batch
+// batch_timeout_ms to fill. A model exported with a fixed batch dimension
+// may make the batched forward pass throw, but OpenCV mostly reshapes
+// around it instead, so the first batched pass is also checked against its
+// last job run alone. On either failure the pool drops to batch 1 for good
+// and reruns that batch one job at a time.
+//
+// The owner's handlers run on the worker threads: fill() writes one job's
+// input planes into its slot of the blob, done() takes the finished batch
+// and the network output (one row per job), failed() a job whose forward
+// pass threw on its own. Per-worker scratch is indexed by the worker
+// argument.
+template <typename Job>
+class DnnWorkerPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Handlers {
+        std::function<void(size_t worker, size_t slot, Job& job, float* tensor)> fill;
+        std::function<void(size_t worker, std::vector<Job>& batch, const cv::Mat& output,
+                           Clock::time_point start)> done;
+        std::function<void(Job& job, const std::exception& error)> failed;
+        std::function<int64_t(const Job& job)> sequence;  // For trace spans and logs
+    };
+
+    DnnWorkerPool() = default;
+    ~DnnWorkerPool() { stop(); }
+
+    DnnWorkerPool(const DnnWorkerPool&) = delete;
+    DnnWorkerPool& operator=(const DnnWorkerPool&) = delete;
+
+    // Loads the model on every worker and starts them; false (logged) if it cannot be loaded
+    bool start(const DnnPoolOptions& options, Handlers handlers) {
+        if (!workers_.empty()) {
+            return true;
+        }
+        options_ = options;
+        options_.threads = std::max(options_.threads, 1u);
+        handlers_ = std::move(handlers);
+
+        try {
+            for (uint32_t i = 0; i < options_.threads; ++i) {
+                auto worker = std::make_unique<Worker>();
+                worker->net = cv::dnn::readNet(options_.model_path);
+                if (worker->net.empty()) {
+                    throw std::runtime_error("could not load " + options_.model_path);
+                }
+                worker->net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+                worker->net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+                workers_.push_back(std::move(worker));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to start " << options_.name << ": " << e.what() << std::endl;
+            workers_.clear();
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.clear();
+            stopping_ = false;
+        }
+        batch_size_ = std::max(options_.batch_size, 1u);
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i]->thread = std::thread(&DnnWorkerPool::workerLoop, this, i);
+        }
+        return true;
+    }
+
+    // Runs everything queued, then joins the workers
+    void stop() {
+        if (workers_.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        queue_cv_.notify_all();
+        space_cv_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+        workers_.clear();
+    }
+
+    // Queues a job, waiting while max_pending are queued; false when the
+    // pool is not running. on_queued runs under the queue lock once the job
+    // is accepted, e.g. to number jobs in queue order.
+    bool push(Job job, size_t max_pending, const std::function<void(Job&)>& on_queued = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [&] { return stopping_ || pending_.size() < max_pending; });
+        if (stopping_) {
+            return false;
+        }
+        if (on_queued) {
+            on_queued(job);
+        }
+        pending_.push_back(std::move(job));
+        lock.unlock();
+        queue_cv_.notify_one();
+        return true;
+    }
+
+    // Queues a job unless max_pending are already queued or the pool is not running
+    bool tryPush(Job job, size_t max_pending) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ || pending_.size() >= max_pending) {
+                return false;
+            }
+            pending_.push_back(std::move(job));
+        }
+        queue_cv_.notify_one();
+        return true;
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_.size();
+    }
+
+    uint32_t batchSize() const { return batch_size_.load(); }
+    uint32_t threads() const { return options_.threads; }
+
+private:
+    struct Worker {
+        cv::dnn::Net net;
+        cv::Mat blob;                    // NCHW input tensor, reused while the batch size holds
+        std::thread thread;
+    };
+
+    void workerLoop(size_t index) {
+        configureCurrentThread(options_.thread_name + "-" + std::to_string(index), options_.thread_options);
+
+        std::vector<Job> batch;
+        while (nextBatch(batch)) {
+            runBatch(index, batch);
+            batch.clear();               // Releases the jobs' inputs
+        }
+    }
+
+    bool nextBatch(std::vector<Job>& batch) {
+        batch.clear();
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true) {
+            queue_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+
+            // Give a partial batch a short time to fill up, unless we are draining
+            size_t want = batch_size_.load();
+            if (pending_.size() < want && !stopping_) {
+                queue_cv_.wait_for(lock, std::chrono::milliseconds(options_.batch_timeout_ms),
+                                   [&] { return stopping_ || pending_.size() >= want; });
+            }
+
+            if (pending_.empty()) {
+                if (stopping_) {
+                    return false;
+                }
+                continue;  // Another worker took the jobs
+            }
+
+            size_t count = std::min(want, pending_.size());
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(pending_.front()));
+                pending_.pop_front();
+            }
+            lock.unlock();
+            space_cv_.notify_all();
+            return true;
+        }
+    }
+
+    void runBatch(size_t index, std::vector<Job>& batch) {
+        Worker& worker = *workers_[index];
+        auto start = Clock::now();
+        const int width = static_cast<int>(options_.input_width);
+        const int height = static_cast<int>(options_.input_height);
+        const int count = static_cast<int>(batch.size());
+        const size_t tensor_size = static_cast<size_t>(width) * height * 3;
+        int64_t first_seq = handlers_.sequence ? handlers_.sequence(batch.front()) : -1;
+
+        cv::Mat& blob = worker.blob;
+        blob.create(std::vector<int>{count, 3, height, width}, CV_32F);
+        {
+            TraceSpan span("preprocess", options_.name, first_seq);
+            for (int i = 0; i < count; ++i) {
+                handlers_.fill(index, static_cast<size_t>(i), batch[i], blob.ptr<float>() + tensor_size * i);
+            }
+        }
+
+        cv::Mat output;
+        try {
+            TraceSpan span("forward", options_.name, first_seq);
+            worker.net.setInput(blob);
+            output = worker.net.forward();
+            if (count > 1 && !batch_checked_.load()) {
+                checkBatchedOutput(worker, output, count, tensor_size);
+            }
+        } catch (const std::exception& e) {
+            if (count > 1) {
+                // Model was exported with a fixed batch dimension: switch the pool to batch 1
+                if (batch_size_.exchange(1) > 1) {
+                    std::cerr << options_.name << ": batched forward failed, falling back to batch 1 ("
+                              << e.what() << ")" << std::endl;
+                }
+                for (auto& job : batch) {
+                    std::vector<Job> single;
+                    single.push_back(std::move(job));
+                    runBatch(index, single);
+                }
+                return;
+            }
+            std::cerr << options_.name << ": forward failed for frame " << first_seq << ": " << e.what()
+                      << std::endl;
+            handlers_.failed(batch.front(), e);
+            return;
+        }
+
+        handlers_.done(index, batch, output, start);
+    }
+
+    // Throws unless the batched output holds one row per job, the last of
+    // which matches that job's input run on its own
+    void checkBatchedOutput(Worker& worker, cv::Mat& output, int count, size_t tensor_size) {
+        output = output.clone();         // The next forward pass may reuse its memory
+        const int width = static_cast<int>(options_.input_width);
+        const int height = static_cast<int>(options_.input_height);
+        cv::Mat& blob = worker.blob;
+        cv::Mat last(std::vector<int>{1, 3, height, width}, CV_32F,
+                     blob.ptr<float>() + tensor_size * static_cast<size_t>(count - 1));
+        worker.net.setInput(last);
+        cv::Mat single = worker.net.forward();
+
+        size_t row = single.total();
+        if (row == 0 || output.total() != row * static_cast<size_t>(count)) {
+            throw std::runtime_error("batched output has " + std::to_string(output.total()) + " values, expected " +
+                                     std::to_string(row) + " per job");
+        }
+        const float* expected = single.ptr<float>();
+        const float* actual = output.ptr<float>() + row * static_cast<size_t>(count - 1);
+        for (size_t i = 0; i < row; ++i) {
+            if (std::abs(actual[i] - expected[i]) > 1e-3f * std::max(1.0f, std::abs(expected[i]))) {
+                throw std::runtime_error("batched output differs from a single run");
+            }
+        }
+        batch_checked_ = true;
+    }
+
+    DnnPoolOptions options_;
+    Handlers handlers_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint32_t> batch_size_{1};
+    std::atomic<bool> batch_checked_{false};  // A batched pass matched single runs once
+
+    // Jobs waiting for a worker (guarded by mutex_)
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;   // Signals workers: jobs available or stopping
+    std::condition_variable space_cv_;   // Signals push(): room in the queue
+    std::deque<Job> pending_;
+    bool stopping_ = true;               // Until start()
+};
+
+} // namespace oak
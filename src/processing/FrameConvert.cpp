@@ -0,0 +1,29 @@
+#include "FrameConvert.h"
+#include "ImageKernels.h"
+
+namespace oak {
+
+cv::Mat toBgr(dai::ImgFrame& frame, cv::Mat& scratch) {
+    switch (frame.getType()) {
+        case dai::ImgFrame::Type::BGR888i:
+            return frame.getFrame();
+
+        case dai::ImgFrame::Type::NV12: {
+            uint32_t width = frame.getWidth();
+            uint32_t height = frame.getHeight();
+            size_t stride = frame.getStride() > 0 ? frame.getStride() : width;
+            // The UV plane follows the (possibly padded) Y plane
+            size_t planeHeight = frame.getPlaneHeight() > 0 ? frame.getPlaneHeight() : height;
+            const uint8_t* y = frame.getData().data();
+            scratch.create(static_cast<int>(height), static_cast<int>(width), CV_8UC3);
+            nv12ToBgr(y, stride, y + stride * planeHeight, stride, width, height, scratch.data, scratch.step);
+            return scratch;
+        }
+
+        default:
+            scratch = frame.getCvFrame();
+            return scratch;
+    }
+}
+
+} // namespace oak
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <depthai/depthai.hpp>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+
+namespace oak {
+
+// Camera output type for a host-bound colour stream
+inline dai::ImgFrame::Type transportFrameType(FrameTransport transport) {
+    return transport == FrameTransport::NV12 ? dai::ImgFrame::Type::NV12 : dai::ImgFrame::Type::BGR888i;
+}
+
+// BGR pixels of a frame received with either transport. BGR888i frames are
+// wrapped in place (no copy; the result aliases the message); NV12 frames
+// are converted into `scratch` with the SIMD nv12ToBgr kernel, which keeps
+// its allocation between calls of the same size. Other types go through
+// ImgFrame::getCvFrame().
+cv::Mat toBgr(dai::ImgFrame& frame, cv::Mat& scratch);
+
+} // namespace oak
@@ -0,0 +1,202 @@
+#include "FramePreprocessor.h"
+#include "Simd.h"
+#include "../engine/SampleStats.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace oak {
+
+FramePreprocessor::FramePreprocessor(uint32_t width, uint32_t height, ResizeMode mode)
+    : width_(width), height_(height), mode_(mode) {
+    output_.create(static_cast<int>(height_), static_cast<int>(width_), CV_8UC3);
+}
+
+const cv::Mat& FramePreprocessor::process(const cv::Mat& bgr) {
+    if (bgr.empty() || bgr.channels() != 3) {
+        return output_;
+    }
+
+    auto sw = static_cast<uint32_t>(bgr.cols);
+    auto sh = static_cast<uint32_t>(bgr.rows);
+    source_width_ = sw;
+    source_height_ = sh;
+
+    switch (mode_) {
+        case ResizeMode::LETTERBOX:
+            letterbox_ = resizer_.letterbox(bgr.data, sw, sh, bgr.step,
+                                            output_.data, width_, height_, output_.step);
+            break;
+
+        case ResizeMode::STRETCH:
+            resizer_.resize(bgr.data, sw, sh, bgr.step,
+                            output_.data, width_, height_, output_.step);
+            letterbox_ = LetterboxInfo{};
+            letterbox_.scale = static_cast<float>(width_) / static_cast<float>(sw);
+            letterbox_.content_width = width_;
+            letterbox_.content_height = height_;
+            break;
+
+        case ResizeMode::CROP:
+        default: {
+            // Center crop to the output aspect ratio, then resize
+            float scale = std::max(static_cast<float>(width_) / static_cast<float>(sw),
+                                   static_cast<float>(height_) / static_cast<float>(sh));
+            uint32_t cw = std::min(sw, static_cast<uint32_t>(static_cast<float>(width_) / scale + 0.5f));
+            uint32_t ch = std::min(sh, static_cast<uint32_t>(static_cast<float>(height_) / scale + 0.5f));
+            uint32_t cx = (sw - cw) / 2;
+            uint32_t cy = (sh - ch) / 2;
+            resizer_.resize(bgr.data + cy * bgr.step + static_cast<size_t>(cx) * 3, cw, ch, bgr.step,
+                            output_.data, width_, height_, output_.step);
+            // For CROP the offsets hold the crop origin in source pixels
+            letterbox_ = LetterboxInfo{};
+            letterbox_.scale = scale;
+            letterbox_.offset_x = cx;
+            letterbox_.offset_y = cy;
+            letterbox_.content_width = width_;
+            letterbox_.content_height = height_;
+            break;
+        }
+    }
+    return output_;
+}
+
+const cv::Mat& FramePreprocessor::processNv12(const uint8_t* y_plane, size_t y_stride,
+                                              const uint8_t* uv_plane, size_t uv_stride,
+                                              uint32_t width, uint32_t height) {
+    nv12_bgr_.create(static_cast<int>(height), static_cast<int>(width), CV_8UC3);
+    nv12ToBgr(y_plane, y_stride, uv_plane, uv_stride, width, height, nv12_bgr_.data, nv12_bgr_.step);
+    return process(nv12_bgr_);
+}
+
+void FramePreprocessor::toPlanar(std::vector<float>& out, const float mean[3], const float scale[3],
+                                 bool swap_rb) const {
+    out.resize(static_cast<size_t>(width_) * height_ * 3);
+    hwcToChwFloat(output_.data, output_.step, width_, height_, mean, scale, swap_rb, out.data());
+}
+
+void FramePreprocessor::mapToSource(float& xmin, float& ymin, float& xmax, float& ymax) const {
+    if (source_width_ == 0 || source_height_ == 0) {
+        return;
+    }
+
+    auto sw = static_cast<float>(source_width_);
+    auto sh = static_cast<float>(source_height_);
+
+    auto mapX = [&](float x) {
+        float px = x * static_cast<float>(width_);
+        float src = 0.0f;
+        if (mode_ == ResizeMode::LETTERBOX) {
+            src = (px - static_cast<float>(letterbox_.offset_x)) / letterbox_.scale;
+        } else if (mode_ == ResizeMode::STRETCH) {
+            src = x * sw;
+        } else {
+            src = px / letterbox_.scale + static_cast<float>(letterbox_.offset_x);
+        }
+        return std::clamp(src / sw, 0.0f, 1.0f);
+    };
+    auto mapY = [&](float y) {
+        float py = y * static_cast<float>(height_);
+        float src = 0.0f;
+        if (mode_ == ResizeMode::LETTERBOX) {
+            src = (py - static_cast<float>(letterbox_.offset_y)) / letterbox_.scale;
+        } else if (mode_ == ResizeMode::STRETCH) {
+            src = y * sh;
+        } else {
+            src = py / letterbox_.scale + static_cast<float>(letterbox_.offset_y);
+        }
+        return std::clamp(src / sh, 0.0f, 1.0f);
+    };
+
+    xmin = mapX(xmin);
+    xmax = mapX(xmax);
+    ymin = mapY(ymin);
+    ymax = mapY(ymax);
+}
+
+PreprocessBenchmark benchmarkPreprocess(uint32_t source_width, uint32_t source_height,
+                                        uint32_t input_width, uint32_t input_height, uint32_t frames) {
+    PreprocessBenchmark result;
+    result.source_width = source_width & ~1u;  // NV12 needs even sizes
+    result.source_height = source_height & ~1u;
+    result.input_width = input_width;
+    result.input_height = input_height;
+    result.backend = simdBackendName();
+    const int w = static_cast<int>(result.source_width);
+    const int h = static_cast<int>(result.source_height);
+    if (w == 0 || h == 0 || input_width == 0 || input_height == 0 || frames == 0) {
+        return result;
+    }
+
+    // Noise over the whole byte range, footroom and headroom included
+    std::mt19937 rng(11);
+    std::vector<uint8_t> nv12(static_cast<size_t>(w) * h * 3 / 2);
+    for (auto& value : nv12) {
+        value = static_cast<uint8_t>(rng());
+    }
+    cv::Mat nv12_mat(h * 3 / 2, w, CV_8UC1, nv12.data());
+    const uint8_t* uv = nv12.data() + static_cast<size_t>(w) * h;
+
+    FramePreprocessor preprocessor(input_width, input_height, ResizeMode::LETTERBOX);
+    cv::Mat bgr(h, w, CV_8UC3);
+    cv::Mat opencv_bgr, resized, boxed, blob;
+    std::vector<float> planar;
+    const float mean[3] = {0.0f, 0.0f, 0.0f};
+    const float scale[3] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+
+    std::vector<double> nv12_us, opencv_nv12_us, letterbox_us, opencv_letterbox_us, planar_us, opencv_planar_us;
+    for (auto* samples : {&nv12_us, &opencv_nv12_us, &letterbox_us, &opencv_letterbox_us, &planar_us,
+                          &opencv_planar_us}) {
+        samples->reserve(frames);
+    }
+    auto elapsedUs = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    for (uint32_t f = 0; f < frames; ++f) {
+        auto start = std::chrono::steady_clock::now();
+        nv12ToBgr(nv12.data(), static_cast<size_t>(w), uv, static_cast<size_t>(w),
+                  result.source_width, result.source_height, bgr.data, bgr.step);
+        nv12_us.push_back(elapsedUs(start));
+
+        start = std::chrono::steady_clock::now();
+        cv::cvtColor(nv12_mat, opencv_bgr, cv::COLOR_YUV2BGR_NV12);
+        opencv_nv12_us.push_back(elapsedUs(start));
+
+        start = std::chrono::steady_clock::now();
+        preprocessor.process(bgr);
+        letterbox_us.push_back(elapsedUs(start));
+
+        // Same content size and padding as ours
+        const LetterboxInfo& box = preprocessor.getLetterbox();
+        start = std::chrono::steady_clock::now();
+        cv::resize(bgr, resized, cv::Size(static_cast<int>(box.content_width), static_cast<int>(box.content_height)),
+                   0.0, 0.0, cv::INTER_LINEAR);
+        cv::copyMakeBorder(resized, boxed, static_cast<int>(box.offset_y),
+                           static_cast<int>(input_height - box.offset_y - box.content_height),
+                           static_cast<int>(box.offset_x),
+                           static_cast<int>(input_width - box.offset_x - box.content_width),
+                           cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+        opencv_letterbox_us.push_back(elapsedUs(start));
+
+        start = std::chrono::steady_clock::now();
+        preprocessor.toPlanar(planar, mean, scale, true);
+        planar_us.push_back(elapsedUs(start));
+
+        start = std::chrono::steady_clock::now();
+        blob = cv::dnn::blobFromImage(boxed, 1.0 / 255.0, cv::Size(), cv::Scalar(), true, false);
+        opencv_planar_us.push_back(elapsedUs(start));
+    }
+
+    result.nv12_us = summarizeSamples(nv12_us).mean;
+    result.opencv_nv12_us = summarizeSamples(opencv_nv12_us).mean;
+    result.letterbox_us = summarizeSamples(letterbox_us).mean;
+    result.opencv_letterbox_us = summarizeSamples(opencv_letterbox_us).mean;
+    result.planar_us = summarizeSamples(planar_us).mean;
+    result.opencv_planar_us = summarizeSamples(opencv_planar_us).mean;
+    result.nv12_max_diff = cv::norm(bgr, opencv_bgr, cv::NORM_INF);
+    result.letterbox_max_diff = cv::norm(preprocessor.getOutput(), boxed, cv::NORM_INF);
+    return result;
+}
+
+} // namespace oak
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+#include "ImageKernels.h"
+
+namespace oak {
+
+// Host equivalent of the device-side requestOutput() preprocessing used by
+// InferenceModule: brings an arbitrary BGR or NV12 frame to the network input
+// size with the same resize mode, producing BGR888i. Output buffers are
+// reused between frames.
+class FramePreprocessor {
+public:
+    FramePreprocessor(uint32_t width, uint32_t height, ResizeMode mode = ResizeMode::LETTERBOX);
+
+    // BGR888i input (e.g. cv::VideoCapture, getCvFrame())
+    const cv::Mat& process(const cv::Mat& bgr);
+
+    // NV12 input (e.g. raw camera or decoder output)
+    const cv::Mat& processNv12(const uint8_t* y_plane, size_t y_stride,
+                               const uint8_t* uv_plane, size_t uv_stride,
+                               uint32_t width, uint32_t height);
+
+    // Planar float tensor of the last output: (pixel - mean) * scale per channel
+    void toPlanar(std::vector<float>& out, const float mean[3], const float scale[3],
+                  bool swap_rb = false) const;
+
+    // Map a normalized box on the network input back to the source frame
+    void mapToSource(float& xmin, float& ymin, float& xmax, float& ymax) const;
+
+    const cv::Mat& getOutput() const { return output_; }
+    const LetterboxInfo& getLetterbox() const { return letterbox_; }
+
+private:
+    uint32_t width_;
+    uint32_t height_;
+    ResizeMode mode_;
+
+    BilinearResizer resizer_;
+    cv::Mat nv12_bgr_;         // Scratch for NV12 input
+    cv::Mat output_;
+    LetterboxInfo letterbox_;  // Also describes CROP/STRETCH as an affine map
+    uint32_t source_width_ = 0;
+    uint32_t source_height_ = 0;
+};
+
+struct PreprocessBenchmark {
+    uint32_t source_width = 0;
+    uint32_t source_height = 0;
+    uint32_t input_width = 0;
+    uint32_t input_height = 0;
+    const char* backend = "";            // SIMD path of the kernels
+    // Mean per frame, these kernels against the OpenCV calls they replace
+    double nv12_us = 0.0;
+    double opencv_nv12_us = 0.0;         // cv::cvtColor(COLOR_YUV2BGR_NV12)
+    double letterbox_us = 0.0;
+    double opencv_letterbox_us = 0.0;    // cv::resize(INTER_LINEAR) + cv::copyMakeBorder
+    double planar_us = 0.0;
+    double opencv_planar_us = 0.0;       // cv::dnn::blobFromImage
+    // Largest per-channel difference from the OpenCV output
+    double nv12_max_diff = 0.0;
+    double letterbox_max_diff = 0.0;
+};
+
+// Random full-range NV12 frames through NV12 -> BGR, letterbox and planar
+// float conversion, timed against OpenCV doing the same
+PreprocessBenchmark benchmarkPreprocess(uint32_t source_width, uint32_t source_height,
+                                        uint32_t input_width, uint32_t input_height, uint32_t frames);
+
+} // namespace oak
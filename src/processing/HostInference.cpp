@@ -0,0 +1,358 @@
+#include "HostInference.h"
+#include "ImageKernels.h"
+#include "../engine/Trace.h"
+#include "../engine/SampleStats.h"
+#include <algorithm>
+#include <iostream>
+
+namespace oak {
+
+HostInference::HostInference(const InferenceConfig& config)
+    : config_(config) {
+}
+
+HostInference::~HostInference() {
+    stop();
+}
+
+bool HostInference::start() {
+    if (running_) {
+        return true;
+    }
+
+    const auto& host = config_.host;
+    uint32_t threads = host.threads > 0 ? host.threads : std::thread::hardware_concurrency();
+    threads = std::max(threads, 1u);
+    uint32_t batch_size = std::max(host.batch_size, 1u);
+
+    workers_.clear();
+    workers_.resize(threads);
+    for (auto& worker : workers_) {
+        for (uint32_t slot = 0; slot < batch_size; ++slot) {
+            worker.preprocessors.push_back(std::make_unique<FramePreprocessor>(
+                config_.input_width, config_.input_height, ResizeMode::LETTERBOX));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(delivery_mutex_);
+        completed_.clear();
+        next_delivery_ = 0;
+        delivered_ = 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_ = HostInferenceStats{};
+        stats_.threads = threads;
+        batch_latencies_ms_.assign(std::max(host.latency_window, 1u), 0.0);
+        latency_head_ = 0;
+        total_batch_frames_ = 0.0;
+    }
+    next_index_ = 0;
+
+    DnnPoolOptions options;
+    options.model_path = config_.model_path;
+    options.name = "HostInference";
+    options.thread_name = "host-infer";
+    options.threads = threads;
+    options.batch_size = batch_size;
+    options.batch_timeout_ms = host.batch_timeout_ms;
+    options.input_width = config_.input_width;
+    options.input_height = config_.input_height;
+    options.thread_options = host.worker_threads;
+
+    DnnWorkerPool<Job>::Handlers handlers;
+    handlers.fill = [this](size_t worker, size_t slot, Job& job, float* tensor) {
+        const auto& host = config_.host;
+        const cv::Mat& input = workers_[worker].preprocessors[slot]->process(job.frame);
+        hwcToChwFloat(input.data, input.step, config_.input_width, config_.input_height,
+                      host.mean, host.scale, host.swap_rb, tensor);
+    };
+    handlers.done = [this](size_t worker, std::vector<Job>& batch, const cv::Mat& output,
+                           std::chrono::steady_clock::time_point start) {
+        finishBatch(workers_[worker], batch, output, start);
+    };
+    handlers.failed = [this](Job& job, const std::exception&) {
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.failed_frames++;
+        }
+        deliver(job.index, nullptr);
+    };
+    handlers.sequence = [](const Job& job) { return job.sequence_num; };
+
+    // Parallelism comes from the worker pool; OpenCV's own threads would oversubscribe the CPU
+    if (threads > 1) {
+        cv::setNumThreads(1);
+    }
+    if (!pool_.start(options, std::move(handlers))) {
+        workers_.clear();
+        return false;
+    }
+    running_ = true;
+
+    std::cout << "HostInference started: " << config_.model_path << " (" << threads
+              << " threads, batch " << batch_size << ")" << std::endl;
+    return true;
+}
+
+void HostInference::stop() {
+    if (!running_) {
+        return;
+    }
+
+    // Workers drain the pending queue before exiting
+    pool_.stop();
+    workers_.clear();
+    running_ = false;
+
+    auto stats = getStats();
+    std::cout << "HostInference stopped: " << stats.frames_processed << " frames in "
+              << stats.batches << " batches, " << stats.fps << " fps, batch p50 "
+              << stats.p50_batch_ms << " ms, p95 " << stats.p95_batch_ms << " ms" << std::endl;
+}
+
+bool HostInference::submit(const cv::Mat& bgr, int64_t sequence_num,
+                           std::chrono::steady_clock::time_point timestamp) {
+    if (!running_ || bgr.empty()) {
+        return false;
+    }
+    return enqueue(bgr.clone(), sequence_num, timestamp);
+}
+
+bool HostInference::submit(cv::Mat&& bgr, int64_t sequence_num,
+                           std::chrono::steady_clock::time_point timestamp) {
+    if (!running_ || bgr.empty()) {
+        return false;
+    }
+    return enqueue(std::move(bgr), sequence_num, timestamp);
+}
+
+bool HostInference::enqueue(cv::Mat frame, int64_t sequence_num,
+                            std::chrono::steady_clock::time_point timestamp) {
+    // Numbered once accepted, under the queue lock, so delivery order is queue order with no gaps
+    return pool_.push({0, sequence_num, timestamp, std::move(frame)}, config_.host.max_pending,
+                      [this](Job& job) {
+        job.index = next_index_.fetch_add(1);
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        if (stats_.frames_submitted++ == 0) {
+            first_submit_ = std::chrono::steady_clock::now();
+        }
+    });
+}
+
+void HostInference::waitIdle() {
+    uint64_t submitted = next_index_.load();
+    std::unique_lock<std::mutex> lock(delivery_mutex_);
+    idle_cv_.wait(lock, [&] { return delivered_ >= submitted || !running_; });
+}
+
+void HostInference::finishBatch(Worker& worker, std::vector<Job>& batch, const cv::Mat& output,
+                                std::chrono::steady_clock::time_point start) {
+    const int count = static_cast<int>(batch.size());
+    std::vector<std::shared_ptr<dai::ImgDetections>> results(batch.size());
+    {
+        TraceSpan span("decode", "HostInference", batch.front().sequence_num);
+        for (int i = 0; i < count; ++i) {
+            auto result = std::make_shared<dai::ImgDetections>();
+            decode(worker, output, static_cast<size_t>(i), *worker.preprocessors[i], result->detections);
+            result->setSequenceNum(batch[i].sequence_num);
+            result->setTimestamp(batch[i].timestamp);
+            results[i] = result;
+        }
+    }
+
+    double latency_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.frames_processed += batch.size();
+        stats_.batches++;
+        total_batch_frames_ += static_cast<double>(batch.size());
+        batch_latencies_ms_[latency_head_] = latency_ms;
+        latency_head_ = (latency_head_ + 1) % batch_latencies_ms_.size();
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        deliver(batch[i].index, std::move(results[i]));
+    }
+}
+
+void HostInference::decode(Worker& worker, const cv::Mat& output, size_t batch_index,
+                           const FramePreprocessor& preprocessor,
+                           std::vector<dai::ImgDetection>& detections) const {
+    if (output.dims < 2) {
+        return;
+    }
+
+    // Last two axes are [candidates, attributes] (YOLOv5) or
+    // [attributes, candidates] (YOLOv8, which has no objectness score)
+    const int rows = output.size[output.dims - 2];
+    const int cols = output.size[output.dims - 1];
+    const bool attributes_first = rows < cols;
+    const int candidates = attributes_first ? cols : rows;
+    const int attributes = attributes_first ? rows : cols;
+    const bool has_objectness = !attributes_first;
+    const int first_class = has_objectness ? 5 : 4;
+    const int num_classes = attributes - first_class;
+    if (num_classes <= 0) {
+        return;
+    }
+
+    const float* data = output.ptr<float>() + static_cast<size_t>(rows) * cols * batch_index;
+    const float threshold = config_.confidence_threshold;
+
+    // Best class per candidate; the attributes-first layout is scanned one
+    // class row at a time so the inner loop stays contiguous
+    auto& best_scores = worker.best_scores;
+    auto& best_labels = worker.best_labels;
+    best_scores.assign(candidates, 0.0f);
+    best_labels.assign(candidates, 0);
+    if (attributes_first) {
+        for (int c = 0; c < num_classes; ++c) {
+            const float* row = data + static_cast<size_t>(first_class + c) * candidates;
+            for (int i = 0; i < candidates; ++i) {
+                if (row[i] > best_scores[i]) {
+                    best_scores[i] = row[i];
+                    best_labels[i] = c;
+                }
+            }
+        }
+    } else {
+        for (int i = 0; i < candidates; ++i) {
+            const float* row = data + static_cast<size_t>(i) * attributes;
+            if (row[4] < threshold) {
+                continue;
+            }
+            const float* scores = row + first_class;
+            const float* best = std::max_element(scores, scores + num_classes);
+            best_scores[i] = *best * row[4];
+            best_labels[i] = static_cast<int>(best - scores);
+        }
+    }
+
+    auto attribute = [&](int i, int a) {
+        return attributes_first ? data[static_cast<size_t>(a) * candidates + i]
+                                : data[static_cast<size_t>(i) * attributes + a];
+    };
+
+    // Class-aware NMS: shift each class into its own coordinate range
+    const int class_offset = static_cast<int>(std::max(config_.input_width, config_.input_height)) + 1;
+    auto& boxes = worker.nms_boxes;
+    auto& scores = worker.nms_scores;
+    auto& keep = worker.nms_keep;
+    boxes.clear();
+    scores.clear();
+    auto& candidate_index = worker.nms_candidates;
+    keep.clear();
+    candidate_index.clear();
+    for (int i = 0; i < candidates; ++i) {
+        if (best_scores[i] < threshold) {
+            continue;
+        }
+        float cx = attribute(i, 0);
+        float cy = attribute(i, 1);
+        float w = attribute(i, 2);
+        float h = attribute(i, 3);
+        int offset = best_labels[i] * class_offset;
+        boxes.emplace_back(static_cast<int>(cx - w * 0.5f) + offset, static_cast<int>(cy - h * 0.5f) + offset,
+                           static_cast<int>(w), static_cast<int>(h));
+        scores.push_back(best_scores[i]);
+        candidate_index.push_back(i);
+    }
+    if (boxes.empty()) {
+        return;
+    }
+    cv::dnn::NMSBoxes(boxes, scores, threshold, config_.host.nms_threshold, keep);
+
+    const float input_w = static_cast<float>(config_.input_width);
+    const float input_h = static_cast<float>(config_.input_height);
+    detections.reserve(keep.size());
+    for (int k : keep) {
+        int i = candidate_index[k];
+        float cx = attribute(i, 0);
+        float cy = attribute(i, 1);
+        float w = attribute(i, 2);
+        float h = attribute(i, 3);
+
+        dai::ImgDetection det{};
+        det.label = static_cast<uint32_t>(best_labels[i]);
+        det.confidence = best_scores[i];
+        det.xmin = (cx - w * 0.5f) / input_w;
+        det.ymin = (cy - h * 0.5f) / input_h;
+        det.xmax = (cx + w * 0.5f) / input_w;
+        det.ymax = (cy + h * 0.5f) / input_h;
+        preprocessor.mapToSource(det.xmin, det.ymin, det.xmax, det.ymax);
+        detections.push_back(det);
+    }
+}
+
+void HostInference::deliver(uint64_t index, std::shared_ptr<dai::ImgDetections> result) {
+    std::unique_lock<std::mutex> lock(delivery_mutex_);
+    completed_[index] = std::move(result);
+    if (delivering_) {
+        return;  // The delivering worker picks it up once it is next
+    }
+
+    // One worker delivers at a time, with the lock released during the
+    // callbacks so the others can keep completing batches
+    delivering_ = true;
+    std::vector<std::shared_ptr<dai::ImgDetections>>& ready = ready_;
+    while (true) {
+        // Release every result that is next in submission order
+        ready.clear();
+        for (auto it = completed_.find(next_delivery_); it != completed_.end();
+             it = completed_.find(next_delivery_)) {
+            ready.push_back(std::move(it->second));
+            completed_.erase(it);
+            ++next_delivery_;
+        }
+        if (ready.empty()) {
+            break;
+        }
+
+        lock.unlock();
+        for (auto& frame : ready) {
+            if (frame && detection_callback_) {
+                TraceSpan span("detection_callback", "HostInference", frame->getSequenceNum());
+                detection_callback_(frame);
+            }
+            frame.reset();
+        }
+        lock.lock();
+        delivered_ += ready.size();
+    }
+    delivering_ = false;
+
+    {
+        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+        last_delivery_ = std::chrono::steady_clock::now();
+    }
+    lock.unlock();
+    idle_cv_.notify_all();
+}
+
+HostInferenceStats HostInference::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    HostInferenceStats stats = stats_;
+    stats.batch_size = pool_.batchSize();
+
+    if (stats.frames_processed > 0) {
+        double elapsed_s = std::chrono::duration<double>(last_delivery_ - first_submit_).count();
+        stats.fps = elapsed_s > 0.0 ? static_cast<double>(stats.frames_processed) / elapsed_s : 0.0;
+        stats.mean_batch_size = total_batch_frames_ / static_cast<double>(stats.batches);
+    }
+
+    size_t samples = static_cast<size_t>(std::min<uint64_t>(stats.batches, batch_latencies_ms_.size()));
+    if (samples > 0) {
+        std::vector<double> latencies(batch_latencies_ms_.begin(), batch_latencies_ms_.begin() + samples);
+        SampleSummary summary = summarizeSamples(latencies);
+        stats.mean_batch_ms = summary.mean;
+        stats.max_batch_ms = summary.max;
+        stats.p50_batch_ms = summary.p50;
+        stats.p95_batch_ms = summary.p95;
+    }
+    return stats;
+}
+
+} // namespace oak
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+#include "../engine/ModuleBase.h"
+#include "FramePreprocessor.h"
+#include "DnnWorkerPool.h"
+
+namespace oak {
+
+struct HostInferenceStats {
+    uint32_t threads = 0;
+    uint32_t batch_size = 0;             // Effective batch size (1 if the model has a fixed batch)
+    uint64_t frames_submitted = 0;
+    uint64_t frames_processed = 0;
+    uint64_t batches = 0;
+    uint64_t failed_frames = 0;          // Frames whose forward pass threw
+    double fps = 0.0;                    // Processed frames per second since the first submit
+    double mean_batch_size = 0.0;
+    double mean_batch_ms = 0.0;          // Preprocess + forward + decode, over the latency window
+    double p50_batch_ms = 0.0;
+    double p95_batch_ms = 0.0;
+    double max_batch_ms = 0.0;
+};
+
+// CPU inference backend using OpenCV DNN, for re-running a detector over
+// archived footage or on machines without a device. Takes the same
+// InferenceConfig as InferenceModule (model_path pointing at the ONNX export
+// of the model) and delivers results through the same DetectionCallback.
+//
+// Frames are preprocessed exactly like the device path (letterbox to the
+// network input), grouped into batches and run on a DnnWorkerPool. Results
+// are delivered in submission order, one callback at a time, with boxes
+// normalized to the source frame. Supports YOLOv5-style [N, 5 + classes]
+// and YOLOv8-style [4 + classes, N] outputs.
+class HostInference {
+public:
+    explicit HostInference(const InferenceConfig& config);
+    ~HostInference();
+
+    HostInference(const HostInference&) = delete;
+    HostInference& operator=(const HostInference&) = delete;
+
+    // Load the model on every worker and start the pool
+    bool start();
+
+    // Process everything already submitted, then stop the workers
+    void stop();
+
+    // Queue a BGR frame (copied); blocks while max_pending frames are waiting.
+    // Returns false if the backend is not running.
+    bool submit(const cv::Mat& bgr, int64_t sequence_num,
+                std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now());
+
+    // Same, taking over a frame the caller no longer uses (no copy)
+    bool submit(cv::Mat&& bgr, int64_t sequence_num,
+                std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now());
+
+    // Block until every submitted frame has been delivered
+    void waitIdle();
+
+    void setDetectionCallback(DetectionCallback callback) { detection_callback_ = callback; }
+
+    bool isRunning() const { return running_.load(); }
+    HostInferenceStats getStats() const;
+
+private:
+    struct Job {
+        uint64_t index;                  // Submission order, used for in-order delivery
+        int64_t sequence_num;
+        std::chrono::steady_clock::time_point timestamp;
+        cv::Mat frame;
+    };
+
+    // Per-worker scratch, indexed like the pool's workers
+    struct Worker {
+        std::vector<std::unique_ptr<FramePreprocessor>> preprocessors;  // One per batch slot
+        std::vector<float> best_scores;  // Decode scratch, reused between batches
+        std::vector<int> best_labels;
+        std::vector<cv::Rect> nms_boxes;
+        std::vector<float> nms_scores;
+        std::vector<int> nms_keep;
+        std::vector<int> nms_candidates;
+    };
+
+    bool enqueue(cv::Mat frame, int64_t sequence_num, std::chrono::steady_clock::time_point timestamp);
+    void finishBatch(Worker& worker, std::vector<Job>& batch, const cv::Mat& output,
+                     std::chrono::steady_clock::time_point start);
+    void decode(Worker& worker, const cv::Mat& output, size_t batch_index,
+                const FramePreprocessor& preprocessor, std::vector<dai::ImgDetection>& detections) const;
+    void deliver(uint64_t index, std::shared_ptr<dai::ImgDetections> result);
+
+    InferenceConfig config_;
+    DetectionCallback detection_callback_;
+
+    std::vector<Worker> workers_;
+    DnnWorkerPool<Job> pool_;            // After workers_, so its threads stop first
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> next_index_{0};  // Assigned under the pool's queue lock, so in queue order
+
+    // In-order delivery (guarded by delivery_mutex_)
+    std::mutex delivery_mutex_;
+    std::condition_variable idle_cv_;
+    std::map<uint64_t, std::shared_ptr<dai::ImgDetections>> completed_;
+    uint64_t next_delivery_ = 0;         // Next index to hand to the callback
+    uint64_t delivered_ = 0;             // Results whose callback has returned
+    bool delivering_ = false;            // A worker is running callbacks (without the lock)
+    std::vector<std::shared_ptr<dai::ImgDetections>> ready_;  // Owned by the delivering worker
+
+    // Statistics
+    mutable std::mutex stats_mutex_;
+    HostInferenceStats stats_;
+    std::vector<double> batch_latencies_ms_;  // Ring of recent batches
+    size_t latency_head_ = 0;
+    double total_batch_frames_ = 0.0;
+    std::chrono::steady_clock::time_point first_submit_;
+    std::chrono::steady_clock::time_point last_delivery_;
+};
+
+} // namespace oak
@@ -0,0 +1,567 @@
+#include "ImageKernels.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace oak {
+
+namespace {
+
+constexpr int kWeightBits = 11;                 // Same precision as cv::INTER_LINEAR
+constexpr int32_t kWeightOne = 1 << kWeightBits;
+
+inline uint8_t clamp8(int32_t v) {
+    return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// BT.601 limited range, 8-bit fixed point. Luma below 16 is clamped like
+// OpenCV does; without it, footroom values land up to 19 levels apart.
+inline void yuvToBgr(int32_t y, int32_t u, int32_t v, uint8_t* out) {
+    int32_t c = (y > 16 ? y - 16 : 0) * 298;
+    int32_t d = u - 128;
+    int32_t e = v - 128;
+    out[0] = clamp8((c + 516 * d + 128) >> 8);
+    out[1] = clamp8((c - 100 * d - 208 * e + 128) >> 8);
+    out[2] = clamp8((c + 409 * e + 128) >> 8);
+}
+
+#if defined(OAK_SIMD_AVX2)
+// pshufb masks converting between three 16-byte planes and 48 interleaved bytes
+struct ShuffleMasks {
+    __m128i interleave[3][3];    // [output chunk][source channel]
+    __m128i deinterleave[3][3];  // [output channel][source chunk]
+};
+
+const ShuffleMasks& shuffleMasks() {
+    static const ShuffleMasks masks = [] {
+        ShuffleMasks m;
+        alignas(16) uint8_t bytes[16];
+        for (int k = 0; k < 3; ++k) {
+            for (int c = 0; c < 3; ++c) {
+                for (int j = 0; j < 16; ++j) {
+                    int p = 16 * k + j;
+                    bytes[j] = (p % 3 == c) ? static_cast<uint8_t>(p / 3) : 0x80;
+                }
+                m.interleave[k][c] = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
+            }
+        }
+        for (int c = 0; c < 3; ++c) {
+            for (int k = 0; k < 3; ++k) {
+                for (int j = 0; j < 16; ++j) {
+                    int g = 3 * j + c;
+                    bytes[j] = (g / 16 == k) ? static_cast<uint8_t>(g % 16) : 0x80;
+                }
+                m.deinterleave[c][k] = _mm_load_si128(reinterpret_cast<const __m128i*>(bytes));
+            }
+        }
+        return m;
+    }();
+    return masks;
+}
+
+OAK_TARGET_AVX2 inline void storeInterleaved(const ShuffleMasks& m, __m128i c0, __m128i c1, __m128i c2, uint8_t* out) {
+    for (int k = 0; k < 3; ++k) {
+        __m128i v = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m.interleave[k][0]),
+                                              _mm_shuffle_epi8(c1, m.interleave[k][1])),
+                                 _mm_shuffle_epi8(c2, m.interleave[k][2]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * k), v);
+    }
+}
+
+OAK_TARGET_AVX2 inline void loadDeinterleaved(const ShuffleMasks& m, const uint8_t* in, __m128i out[3]) {
+    __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+    __m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+    for (int c = 0; c < 3; ++c) {
+        out[c] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(s0, m.deinterleave[c][0]),
+                                           _mm_shuffle_epi8(s1, m.deinterleave[c][1])),
+                              _mm_shuffle_epi8(s2, m.deinterleave[c][2]));
+    }
+}
+
+// Two vectors of 8 int32 -> 16 saturated bytes in order
+OAK_TARGET_AVX2 inline __m128i packU8(__m256i lo, __m256i hi) {
+    __m256i p16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+    return _mm_packus_epi16(_mm256_castsi256_si128(p16), _mm256_extracti128_si256(p16, 1));
+}
+
+// Row kernels, called only when simdAvx2(). Each returns how many pixels (or
+// bytes) it did; the caller finishes the row with the scalar loop.
+
+OAK_TARGET_AVX2 uint32_t nv12RowAvx2(const uint8_t* yrow, const uint8_t* uvrow, uint32_t width, uint8_t* out) {
+    const ShuffleMasks& masks = shuffleMasks();
+    const __m256i idx_u = _mm256_setr_epi32(0, 0, 2, 2, 4, 4, 6, 6);
+    const __m256i idx_v = _mm256_setr_epi32(1, 1, 3, 3, 5, 5, 7, 7);
+    const __m256i k16 = _mm256_set1_epi32(16);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i k128 = _mm256_set1_epi32(128);
+    const __m256i k298 = _mm256_set1_epi32(298);
+    const __m256i k516 = _mm256_set1_epi32(516);
+    const __m256i k100 = _mm256_set1_epi32(100);
+    const __m256i k208 = _mm256_set1_epi32(208);
+    const __m256i k409 = _mm256_set1_epi32(409);
+
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m256i b32[2], g32[2], r32[2];
+        for (int h = 0; h < 2; ++h) {
+            __m256i y = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(yrow + x + 8 * h)));
+            __m256i uv = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(uvrow + x + 8 * h)));
+            __m256i u = _mm256_sub_epi32(_mm256_permutevar8x32_epi32(uv, idx_u), k128);
+            __m256i v = _mm256_sub_epi32(_mm256_permutevar8x32_epi32(uv, idx_v), k128);
+            __m256i luma = _mm256_max_epi32(_mm256_sub_epi32(y, k16), zero);
+            __m256i c = _mm256_add_epi32(_mm256_mullo_epi32(luma, k298), k128);
+            b32[h] = _mm256_srai_epi32(_mm256_add_epi32(c, _mm256_mullo_epi32(u, k516)), 8);
+            g32[h] = _mm256_srai_epi32(_mm256_sub_epi32(c, _mm256_add_epi32(_mm256_mullo_epi32(u, k100),
+                                                                             _mm256_mullo_epi32(v, k208))), 8);
+            r32[h] = _mm256_srai_epi32(_mm256_add_epi32(c, _mm256_mullo_epi32(v, k409)), 8);
+        }
+        storeInterleaved(masks, packU8(b32[0], b32[1]), packU8(g32[0], g32[1]),
+                         packU8(r32[0], r32[1]), out + 3 * x);
+    }
+    return x;
+}
+
+OAK_TARGET_AVX2 uint32_t hwcToChwRowAvx2(const uint8_t* in, uint32_t width, uint8_t* const planes[3], size_t base) {
+    const ShuffleMasks& masks = shuffleMasks();
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i ch[3];
+        loadDeinterleaved(masks, in + 3 * x, ch);
+        for (int c = 0; c < 3; ++c) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(planes[c] + base + x), ch[c]);
+        }
+    }
+    return x;
+}
+
+OAK_TARGET_AVX2 uint32_t hwcToChwFloatRowAvx2(const uint8_t* in, uint32_t width, float* const planes[3], size_t base,
+                                              const float mean[3], const float scale[3]) {
+    const ShuffleMasks& masks = shuffleMasks();
+    __m256 vmean[3], vscale[3];
+    for (int c = 0; c < 3; ++c) {
+        vmean[c] = _mm256_set1_ps(mean[c]);
+        vscale[c] = _mm256_set1_ps(scale[c]);
+    }
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i ch[3];
+        loadDeinterleaved(masks, in + 3 * x, ch);
+        for (int c = 0; c < 3; ++c) {
+            __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(ch[c]));
+            __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(ch[c], 8)));
+            _mm256_storeu_ps(planes[c] + base + x, _mm256_mul_ps(_mm256_sub_ps(lo, vmean[c]), vscale[c]));
+            _mm256_storeu_ps(planes[c] + base + x + 8, _mm256_mul_ps(_mm256_sub_ps(hi, vmean[c]), vscale[c]));
+        }
+    }
+    return x;
+}
+
+OAK_TARGET_AVX2 uint32_t countChangedRowAvx2(const uint8_t* pa, const uint8_t* pb, uint32_t width,
+                                             uint8_t threshold, uint32_t& changed) {
+    const __m256i thr = _mm256_set1_epi8(static_cast<char>(threshold));
+    const __m256i zero = _mm256_setzero_si256();
+    uint32_t x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa + x));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb + x));
+        // |a - b| from two saturating subtractions, then > threshold as a nonzero remainder
+        __m256i diff = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+        __m256i over = _mm256_subs_epu8(diff, thr);
+        auto unchanged = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(over, zero)));
+        changed += 32 - popcount32(unchanged);
+    }
+    return x;
+}
+
+// Vertical pass of the resize: out = (r0 * wt + r1 * wb) >> 22, rounded
+OAK_TARGET_AVX2 size_t blendRowsAvx2(const int32_t* r0, const int32_t* r1, size_t n,
+                                     int32_t wt, int32_t wb, uint8_t* out) {
+    const __m256i vwt = _mm256_set1_epi32(wt);
+    const __m256i vwb = _mm256_set1_epi32(wb);
+    const __m256i vround = _mm256_set1_epi32(1 << (2 * kWeightBits - 1));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v[2];
+        for (int h = 0; h < 2; ++h) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + i + 8 * h));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + i + 8 * h));
+            __m256i sum = _mm256_add_epi32(_mm256_mullo_epi32(a, vwt), _mm256_mullo_epi32(b, vwb));
+            v[h] = _mm256_srai_epi32(_mm256_add_epi32(sum, vround), 2 * kWeightBits);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packU8(v[0], v[1]));
+    }
+    return i;
+}
+#endif
+
+#if defined(OAK_SIMD_NEON)
+// 8 pixels of one channel: (298*y + cu*u + cv*v + 128) >> 8, saturated to u8
+inline uint8x8_t yuvChannel(int16x8_t y, int16x8_t u, int16x8_t v, int16_t cu, int16_t cv) {
+    int32x4_t lo = vmull_n_s16(vget_low_s16(y), 298);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(y), 298);
+    lo = vmlal_n_s16(vmlal_n_s16(lo, vget_low_s16(u), cu), vget_low_s16(v), cv);
+    hi = vmlal_n_s16(vmlal_n_s16(hi, vget_high_s16(u), cu), vget_high_s16(v), cv);
+    int32x4_t round = vdupq_n_s32(128);
+    int16x8_t r = vcombine_s16(vshrn_n_s32(vaddq_s32(lo, round), 8),
+                               vshrn_n_s32(vaddq_s32(hi, round), 8));
+    return vqmovun_s16(r);
+}
+#endif
+
+} // namespace
+
+void nv12ToBgr(const uint8_t* y_plane, size_t y_stride,
+               const uint8_t* uv_plane, size_t uv_stride,
+               uint32_t width, uint32_t height,
+               uint8_t* bgr, size_t bgr_stride) {
+#if defined(OAK_SIMD_AVX2)
+    const bool avx2 = simdAvx2();
+#elif defined(OAK_SIMD_NEON)
+    const bool neon = simdEnabled();
+#endif
+
+    for (uint32_t row = 0; row < height; ++row) {
+        const uint8_t* yrow = y_plane + row * y_stride;
+        const uint8_t* uvrow = uv_plane + (row / 2) * uv_stride;
+        uint8_t* out = bgr + row * bgr_stride;
+        uint32_t x = 0;
+
+#if defined(OAK_SIMD_AVX2)
+        if (avx2) {
+            x = nv12RowAvx2(yrow, uvrow, width, out);
+        }
+#elif defined(OAK_SIMD_NEON)
+        for (; neon && x + 16 <= width; x += 16) {
+            uint8x16_t yv = vld1q_u8(yrow + x);
+            uint8x8x2_t uv = vld2_u8(uvrow + x);
+            int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[0])), vdupq_n_s16(128));
+            int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[1])), vdupq_n_s16(128));
+            int16x8x2_t uu = vzipq_s16(u, u);
+            int16x8x2_t vv = vzipq_s16(v, v);
+            int16x8_t ylo = vmaxq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(yv))), vdupq_n_s16(16)),
+                                      vdupq_n_s16(0));
+            int16x8_t yhi = vmaxq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(yv))), vdupq_n_s16(16)),
+                                      vdupq_n_s16(0));
+
+            uint8x16x3_t px;
+            px.val[0] = vcombine_u8(yuvChannel(ylo, uu.val[0], vv.val[0], 516, 0),
+                                    yuvChannel(yhi, uu.val[1], vv.val[1], 516, 0));
+            px.val[1] = vcombine_u8(yuvChannel(ylo, uu.val[0], vv.val[0], -100, -208),
+                                    yuvChannel(yhi, uu.val[1], vv.val[1], -100, -208));
+            px.val[2] = vcombine_u8(yuvChannel(ylo, uu.val[0], vv.val[0], 0, 409),
+                                    yuvChannel(yhi, uu.val[1], vv.val[1], 0, 409));
+            vst3q_u8(out + 3 * x, px);
+        }
+#endif
+
+        for (; x < width; ++x) {
+            const uint8_t* uv = uvrow + (x & ~1u);
+            yuvToBgr(yrow[x], uv[0], uv[1], out + 3 * x);
+        }
+    }
+}
+
+void hwcToChw(const uint8_t* src, size_t src_stride,
+              uint32_t width, uint32_t height,
+              uint8_t* dst) {
+    const size_t plane = static_cast<size_t>(width) * height;
+    uint8_t* planes[3] = {dst, dst + plane, dst + 2 * plane};
+
+#if defined(OAK_SIMD_AVX2)
+    const bool avx2 = simdAvx2();
+#elif defined(OAK_SIMD_NEON)
+    const bool neon = simdEnabled();
+#endif
+
+    for (uint32_t row = 0; row < height; ++row) {
+        const uint8_t* in = src + row * src_stride;
+        const size_t base = static_cast<size_t>(row) * width;
+        uint32_t x = 0;
+
+#if defined(OAK_SIMD_AVX2)
+        if (avx2) {
+            x = hwcToChwRowAvx2(in, width, planes, base);
+        }
+#elif defined(OAK_SIMD_NEON)
+        for (; neon && x + 16 <= width; x += 16) {
+            uint8x16x3_t px = vld3q_u8(in + 3 * x);
+            for (int c = 0; c < 3; ++c) {
+                vst1q_u8(planes[c] + base + x, px.val[c]);
+            }
+        }
+#endif
+
+        for (; x < width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                planes[c][base + x] = in[3 * x + c];
+            }
+        }
+    }
+}
+
+void hwcToChwFloat(const uint8_t* src, size_t src_stride,
+                   uint32_t width, uint32_t height,
+                   const float mean[3], const float scale[3], bool swap_rb,
+                   float* dst) {
+    const size_t plane = static_cast<size_t>(width) * height;
+    float* planes[3];
+    for (int c = 0; c < 3; ++c) {
+        planes[c] = dst + plane * static_cast<size_t>(swap_rb ? 2 - c : c);
+    }
+
+#if defined(OAK_SIMD_AVX2)
+    const bool avx2 = simdAvx2();
+#elif defined(OAK_SIMD_NEON)
+    const bool neon = simdEnabled();
+#endif
+
+    for (uint32_t row = 0; row < height; ++row) {
+        const uint8_t* in = src + row * src_stride;
+        const size_t base = static_cast<size_t>(row) * width;
+        uint32_t x = 0;
+
+#if defined(OAK_SIMD_AVX2)
+        if (avx2) {
+            x = hwcToChwFloatRowAvx2(in, width, planes, base, mean, scale);
+        }
+#elif defined(OAK_SIMD_NEON)
+        for (; neon && x + 16 <= width; x += 16) {
+            uint8x16x3_t px = vld3q_u8(in + 3 * x);
+            for (int c = 0; c < 3; ++c) {
+                float32x4_t vmean = vdupq_n_f32(mean[c]);
+                uint16x8_t halves[2] = {vmovl_u8(vget_low_u8(px.val[c])), vmovl_u8(vget_high_u8(px.val[c]))};
+                for (int h = 0; h < 2; ++h) {
+                    float32x4_t a = vcvtq_f32_u32(vmovl_u16(vget_low_u16(halves[h])));
+                    float32x4_t b = vcvtq_f32_u32(vmovl_u16(vget_high_u16(halves[h])));
+                    float* o = planes[c] + base + x + 8 * h;
+                    vst1q_f32(o, vmulq_n_f32(vsubq_f32(a, vmean), scale[c]));
+                    vst1q_f32(o + 4, vmulq_n_f32(vsubq_f32(b, vmean), scale[c]));
+                }
+            }
+        }
+#endif
+
+        for (; x < width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                planes[c][base + x] = (static_cast<float>(in[3 * x + c]) - mean[c]) * scale[c];
+            }
+        }
+    }
+}
+
+uint32_t countChangedPixels(const uint8_t* a, size_t a_stride,
+                            const uint8_t* b, size_t b_stride,
+                            uint32_t width, uint32_t height, uint8_t threshold) {
+    uint32_t changed = 0;
+#if defined(OAK_SIMD_AVX2)
+    const bool avx2 = simdAvx2();
+#elif defined(OAK_SIMD_NEON)
+    const bool neon = simdEnabled();
+    const uint8x16_t thr = vdupq_n_u8(threshold);
+#endif
+
+    for (uint32_t row = 0; row < height; ++row) {
+        const uint8_t* pa = a + row * a_stride;
+        const uint8_t* pb = b + row * b_stride;
+        uint32_t x = 0;
+
+#if defined(OAK_SIMD_AVX2)
+        if (avx2) {
+            x = countChangedRowAvx2(pa, pb, width, threshold, changed);
+        }
+#elif defined(OAK_SIMD_NEON)
+        for (; neon && x + 16 <= width; x += 16) {
+            uint8x16_t diff = vabdq_u8(vld1q_u8(pa + x), vld1q_u8(pb + x));
+            uint8x16_t over = vshrq_n_u8(vcgtq_u8(diff, thr), 7);
+            uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(over)));
+            changed += static_cast<uint32_t>(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+        }
+#endif
+
+        for (; x < width; ++x) {
+            int d = static_cast<int>(pa[x]) - static_cast<int>(pb[x]);
+            changed += static_cast<uint32_t>((d < 0 ? -d : d) > threshold);
+        }
+    }
+    return changed;
+}
+
+void BilinearResizer::prepare(uint32_t src_width, uint32_t src_height,
+                              uint32_t dst_width, uint32_t dst_height) {
+    if (src_width == src_width_ && src_height == src_height_ &&
+        dst_width == dst_width_ && dst_height == dst_height_) {
+        return;
+    }
+    src_width_ = src_width;
+    src_height_ = src_height;
+    dst_width_ = dst_width;
+    dst_height_ = dst_height;
+
+    // Half-pixel centers: src = (dst + 0.5) * scale - 0.5, clamped at the borders
+    auto taps = [](uint32_t src_size, uint32_t dst_size, uint32_t index, int32_t& lo, int32_t& hi, int32_t& weight) {
+        double scale = static_cast<double>(src_size) / static_cast<double>(dst_size);
+        double f = (index + 0.5) * scale - 0.5;
+        int32_t i = static_cast<int32_t>(std::floor(f));
+        double a = f - i;
+        if (i < 0) {
+            i = 0;
+            a = 0.0;
+        }
+        if (i >= static_cast<int32_t>(src_size) - 1) {
+            i = static_cast<int32_t>(src_size) - 1;
+            a = 0.0;
+        }
+        lo = i;
+        hi = std::min(i + 1, static_cast<int32_t>(src_size) - 1);
+        weight = static_cast<int32_t>(std::lround(a * kWeightOne));
+    };
+
+    x_left_.resize(dst_width);
+    x_right_.resize(dst_width);
+    x_weight_.resize(dst_width);
+    for (uint32_t x = 0; x < dst_width; ++x) {
+        int32_t lo, hi, w;
+        taps(src_width, dst_width, x, lo, hi, w);
+        x_left_[x] = lo * 3;
+        x_right_[x] = hi * 3;
+        x_weight_[x] = w;
+    }
+
+    y_index_.resize(dst_height);
+    y_weight_.resize(dst_height);
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        int32_t lo, hi, w;
+        taps(src_height, dst_height, y, lo, hi, w);
+        y_index_[y] = lo;
+        y_weight_[y] = w;
+    }
+
+    rows_[0].resize(static_cast<size_t>(dst_width) * 3);
+    rows_[1].resize(static_cast<size_t>(dst_width) * 3);
+}
+
+void BilinearResizer::horizontalRow(const uint8_t* src_row, int32_t* out) const {
+    for (uint32_t x = 0; x < dst_width_; ++x) {
+        const uint8_t* l = src_row + x_left_[x];
+        const uint8_t* r = src_row + x_right_[x];
+        int32_t w = x_weight_[x];
+        int32_t iw = kWeightOne - w;
+        out[3 * x + 0] = l[0] * iw + r[0] * w;
+        out[3 * x + 1] = l[1] * iw + r[1] * w;
+        out[3 * x + 2] = l[2] * iw + r[2] * w;
+    }
+}
+
+void BilinearResizer::resize(const uint8_t* src, uint32_t src_width, uint32_t src_height, size_t src_stride,
+                             uint8_t* dst, uint32_t dst_width, uint32_t dst_height, size_t dst_stride) {
+    if (src_width == 0 || src_height == 0 || dst_width == 0 || dst_height == 0) {
+        return;
+    }
+    prepare(src_width, src_height, dst_width, dst_height);
+
+    // New source image: cached rows are stale
+    cached_rows_[0] = -1;
+    cached_rows_[1] = -1;
+
+    const int32_t last_row = static_cast<int32_t>(src_height) - 1;
+    const size_t n = static_cast<size_t>(dst_width) * 3;
+#if defined(OAK_SIMD_AVX2)
+    const bool avx2 = simdAvx2();
+#elif defined(OAK_SIMD_NEON)
+    const bool neon = simdEnabled();
+#endif
+
+    auto fetch = [&](int32_t src_row, int avoid_slot) {
+        for (int s = 0; s < 2; ++s) {
+            if (cached_rows_[s] == src_row) {
+                return s;
+            }
+        }
+        int slot = (avoid_slot == 0) ? 1 : 0;
+        horizontalRow(src + static_cast<size_t>(src_row) * src_stride, rows_[slot].data());
+        cached_rows_[slot] = src_row;
+        return slot;
+    };
+
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        int32_t y0 = y_index_[y];
+        int32_t y1 = std::min(y0 + 1, last_row);
+        // Keep the row that will be reused as the next top row
+        int keep = cached_rows_[0] == y1 ? 0 : (cached_rows_[1] == y1 ? 1 : -1);
+        int s0 = fetch(y0, keep);
+        int s1 = fetch(y1, s0);
+
+        const int32_t* r0 = rows_[s0].data();
+        const int32_t* r1 = rows_[s1].data();
+        const int32_t wb = y_weight_[y];
+        const int32_t wt = kWeightOne - wb;
+        uint8_t* out = dst + y * dst_stride;
+        size_t i = 0;
+
+#if defined(OAK_SIMD_AVX2)
+        if (avx2) {
+            i = blendRowsAvx2(r0, r1, n, wt, wb, out);
+        }
+#elif defined(OAK_SIMD_NEON)
+        const int32x4_t vround = vdupq_n_s32(1 << (2 * kWeightBits - 1));
+        for (; neon && i + 16 <= n; i += 16) {
+            int16x4_t parts[4];
+            for (int q = 0; q < 4; ++q) {
+                int32x4_t a = vld1q_s32(r0 + i + 4 * q);
+                int32x4_t b = vld1q_s32(r1 + i + 4 * q);
+                int32x4_t sum = vmlaq_n_s32(vmulq_n_s32(a, wt), b, wb);
+                parts[q] = vmovn_s32(vshrq_n_s32(vaddq_s32(sum, vround), 2 * kWeightBits));
+            }
+            uint8x16_t bytes = vcombine_u8(vqmovun_s16(vcombine_s16(parts[0], parts[1])),
+                                           vqmovun_s16(vcombine_s16(parts[2], parts[3])));
+            vst1q_u8(out + i, bytes);
+        }
+#endif
+
+        for (; i < n; ++i) {
+            out[i] = clamp8((r0[i] * wt + r1[i] * wb + (1 << (2 * kWeightBits - 1))) >> (2 * kWeightBits));
+        }
+    }
+}
+
+LetterboxInfo BilinearResizer::letterbox(const uint8_t* src, uint32_t src_width, uint32_t src_height, size_t src_stride,
+                                         uint8_t* dst, uint32_t dst_width, uint32_t dst_height, size_t dst_stride,
+                                         uint8_t pad_value) {
+    LetterboxInfo info;
+    if (src_width == 0 || src_height == 0 || dst_width == 0 || dst_height == 0) {
+        return info;
+    }
+
+    float scale = std::min(static_cast<float>(dst_width) / static_cast<float>(src_width),
+                           static_cast<float>(dst_height) / static_cast<float>(src_height));
+    uint32_t cw = std::min(dst_width, std::max(1u, static_cast<uint32_t>(std::lround(src_width * scale))));
+    uint32_t ch = std::min(dst_height, std::max(1u, static_cast<uint32_t>(std::lround(src_height * scale))));
+
+    info.scale = scale;
+    info.offset_x = (dst_width - cw) / 2;
+    info.offset_y = (dst_height - ch) / 2;
+    info.content_width = cw;
+    info.content_height = ch;
+
+    // Padding: full rows above/below, side bands left/right
+    const size_t row_bytes = static_cast<size_t>(dst_width) * 3;
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        uint8_t* row = dst + y * dst_stride;
+        if (y < info.offset_y || y >= info.offset_y + ch) {
+            std::memset(row, pad_value, row_bytes);
+        } else {
+            std::memset(row, pad_value, static_cast<size_t>(info.offset_x) * 3);
+            size_t right = static_cast<size_t>(info.offset_x + cw) * 3;
+            std::memset(row + right, pad_value, row_bytes - right);
+        }
+    }
+
+    resize(src, src_width, src_height, src_stride,
+           dst + info.offset_y * dst_stride + static_cast<size_t>(info.offset_x) * 3,
+           cw, ch, dst_stride);
+    return info;
+}
+
+} // namespace oak
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace oak {
+
+// Host-side preprocessing kernels mirroring what the device does for
+// requestOutput(..., ImgResizeMode::LETTERBOX) and the NV12 -> BGR888i
+// conversion, so replayed or file-sourced frames can be fed through the same
+// path as live ones. All images are 8-bit; strides are in bytes.
+// Each kernel has AVX2 and NEON paths with a scalar fallback (see Simd.h).
+
+// NV12 (full-res Y plane + half-res interleaved UV plane) to interleaved BGR.
+// BT.601 limited range, matching the device ISP and cv::COLOR_YUV2BGR_NV12
+// to within +-1 per channel for every input (checked exhaustively against
+// OpenCV's fixed-point formula). Width and height must be even.
+void nv12ToBgr(const uint8_t* y_plane, size_t y_stride,
+               const uint8_t* uv_plane, size_t uv_stride,
+               uint32_t width, uint32_t height,
+               uint8_t* bgr, size_t bgr_stride);
+
+// Interleaved HWC (e.g. BGR888i) to planar CHW (BGR888p), channel order kept
+void hwcToChw(const uint8_t* src, size_t src_stride,
+              uint32_t width, uint32_t height,
+              uint8_t* dst);
+
+// Interleaved HWC to planar float CHW: out = (in - mean[c]) * scale[c].
+// swap_rb writes channels in reverse order (BGR -> RGB planes).
+void hwcToChwFloat(const uint8_t* src, size_t src_stride,
+                   uint32_t width, uint32_t height,
+                   const float mean[3], const float scale[3], bool swap_rb,
+                   float* dst);
+
+// Number of pixels whose absolute difference between two single-channel
+// images exceeds threshold (frame differencing for motion detection)
+uint32_t countChangedPixels(const uint8_t* a, size_t a_stride,
+                            const uint8_t* b, size_t b_stride,
+                            uint32_t width, uint32_t height, uint8_t threshold);
+
+// Where the letterboxed image sits inside the output, for mapping
+// detections back to source coordinates
+struct LetterboxInfo {
+    float scale = 1.0f;      // Output pixels per source pixel
+    uint32_t offset_x = 0;   // Left padding
+    uint32_t offset_y = 0;   // Top padding
+    uint32_t content_width = 0;
+    uint32_t content_height = 0;
+};
+
+// Bilinear resize of 3-channel interleaved images (half-pixel centers, like
+// cv::INTER_LINEAR). Coefficient tables and row buffers are cached between
+// calls with the same geometry, so steady-state use does not allocate.
+class BilinearResizer {
+public:
+    void resize(const uint8_t* src, uint32_t src_width, uint32_t src_height, size_t src_stride,
+                uint8_t* dst, uint32_t dst_width, uint32_t dst_height, size_t dst_stride);
+
+    // Aspect-preserving resize centered in dst, remaining area set to pad_value
+    LetterboxInfo letterbox(const uint8_t* src, uint32_t src_width, uint32_t src_height, size_t src_stride,
+                            uint8_t* dst, uint32_t dst_width, uint32_t dst_height, size_t dst_stride,
+                            uint8_t pad_value = 0);
+
+private:
+    void prepare(uint32_t src_width, uint32_t src_height, uint32_t dst_width, uint32_t dst_height);
+    void horizontalRow(const uint8_t* src_row, int32_t* out) const;
+
+    uint32_t src_width_ = 0;
+    uint32_t src_height_ = 0;
+    uint32_t dst_width_ = 0;
+    uint32_t dst_height_ = 0;
+
+    std::vector<int32_t> x_left_;     // Source byte offset of the left tap, per dst column
+    std::vector<int32_t> x_right_;    // Source byte offset of the right tap
+    std::vector<int32_t> x_weight_;   // Right tap weight (11-bit fixed point)
+    std::vector<int32_t> y_index_;    // Top source row, per dst row
+    std::vector<int32_t> y_weight_;   // Bottom row weight (11-bit fixed point)
+
+    std::vector<int32_t> rows_[2];    // Horizontally interpolated rows
+    int32_t cached_rows_[2] = {-1, -1};
+};
+
+} // namespace oak
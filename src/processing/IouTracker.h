@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <depthai/depthai.hpp>
+
+namespace oak {
+
+// Greedy IoU association of detections to tracks of the same label
+class IouTracker {
+public:
+    IouTracker(float iou_threshold, uint32_t max_age_frames)
+        : iou_threshold_(iou_threshold), max_age_frames_(max_age_frames) {}
+
+    // Writes one track id per detection; unmatched detections open new tracks
+    void update(uint32_t frame, const std::vector<dai::ImgDetection>& detections,
+                std::vector<uint32_t>& ids, uint32_t& next_id) {
+        // Drop tracks that have not been seen for too long
+        tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [&](const Track& track) {
+            return frame - track.last_frame > max_age_frames_;
+        }), tracks_.end());
+
+        candidates_.clear();
+        for (size_t d = 0; d < detections.size(); ++d) {
+            for (size_t t = 0; t < tracks_.size(); ++t) {
+                if (tracks_[t].label != detections[d].label) {
+                    continue;
+                }
+                float overlap = iou(tracks_[t].det, detections[d]);
+                if (overlap >= iou_threshold_) {
+                    candidates_.push_back({overlap, d, t});
+                }
+            }
+        }
+        std::sort(candidates_.begin(), candidates_.end(),
+                  [](const Match& a, const Match& b) { return a.iou > b.iou; });
+
+        ids.assign(detections.size(), 0);
+        track_used_.assign(tracks_.size(), false);
+        for (const auto& match : candidates_) {
+            if (ids[match.detection] != 0 || track_used_[match.track]) {
+                continue;
+            }
+            ids[match.detection] = tracks_[match.track].id;
+            track_used_[match.track] = true;
+            tracks_[match.track].det = detections[match.detection];
+            tracks_[match.track].last_frame = frame;
+        }
+
+        for (size_t d = 0; d < detections.size(); ++d) {
+            if (ids[d] == 0) {
+                ids[d] = next_id++;
+                tracks_.push_back({ids[d], detections[d].label, detections[d], frame});
+            }
+        }
+    }
+
+private:
+    struct Track {
+        uint32_t id;
+        uint32_t label;
+        dai::ImgDetection det;
+        uint32_t last_frame;
+    };
+
+    struct Match {
+        float iou;
+        size_t detection;
+        size_t track;
+    };
+
+    static float iou(const dai::ImgDetection& a, const dai::ImgDetection& b) {
+        float ix = std::max(0.0f, std::min(a.xmax, b.xmax) - std::max(a.xmin, b.xmin));
+        float iy = std::max(0.0f, std::min(a.ymax, b.ymax) - std::max(a.ymin, b.ymin));
+        float inter = ix * iy;
+        float area_a = (a.xmax - a.xmin) * (a.ymax - a.ymin);
+        float area_b = (b.xmax - b.xmin) * (b.ymax - b.ymin);
+        float uni = area_a + area_b - inter;
+        return uni > 0.0f ? inter / uni : 0.0f;
+    }
+
+    float iou_threshold_;
+    uint32_t max_age_frames_;
+    std::vector<Track> tracks_;
+    std::vector<Match> candidates_;
+    std::vector<bool> track_used_;
+};
+
+} // namespace oak
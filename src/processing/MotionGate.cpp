@@ -0,0 +1,81 @@
+#include "MotionGate.h"
+#include "ImageKernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace oak {
+
+MotionGate::MotionGate(const MotionGateConfig& config)
+    : config_(config) {
+}
+
+MotionGateDecision MotionGate::update(const uint8_t* luma, uint32_t width, uint32_t height, size_t stride,
+                                      std::chrono::steady_clock::time_point now) {
+    bool motion;
+    float changed_fraction = 0.0f;
+    if (width != width_ || height != height_ || previous_.empty()) {
+        // Nothing to compare with yet; assume motion so detection starts open
+        width_ = width;
+        height_ = height;
+        previous_.resize(static_cast<size_t>(width) * height);
+        motion = true;
+    } else {
+        uint32_t changed = countChangedPixels(luma, stride, previous_.data(), width,
+                                              width, height, config_.pixel_threshold);
+        changed_fraction = static_cast<float>(changed) / static_cast<float>(width * height);
+        motion = changed_fraction >= config_.min_changed_fraction;
+    }
+    for (uint32_t row = 0; row < height; ++row) {
+        std::memcpy(previous_.data() + static_cast<size_t>(row) * width, luma + row * stride, width);
+    }
+
+    if (motion) {
+        last_motion_ = now;
+    }
+    bool active = now - last_motion_ < std::chrono::milliseconds(config_.hold_ms);
+
+    MotionGateDecision decision;
+    decision.mode = active ? 1 : static_cast<uint8_t>(std::min<uint32_t>(config_.idle_every_n, 255));
+    decision.mode_changed = decision.mode != mode_;
+    if (decision.mode_changed) {
+        mode_ = decision.mode;
+        idle_counter_ = 0;  // The device script restarts its count on a new mode too
+    }
+    decision.run = mode_ == 1 || (mode_ > 1 && idle_counter_ % mode_ == 0);
+    ++idle_counter_;
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.frames++;
+    stats_.motion_frames += motion ? 1 : 0;
+    if (!stats_.device_counts) {
+        if (decision.run) {
+            stats_.processed++;
+        } else {
+            stats_.gated++;
+        }
+    }
+    stats_.last_changed_fraction = changed_fraction;
+    stats_.active = active;
+    return decision;
+}
+
+void MotionGate::setDeviceCounts(uint64_t processed, uint64_t gated) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.device_counts = true;
+    stats_.processed = processed;
+    stats_.gated = gated;
+}
+
+MotionGateStats MotionGate::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    MotionGateStats stats = stats_;
+    // Detector frames, which need not match the motion frames one to one
+    uint64_t total = stats.processed + stats.gated;
+    if (total > 0) {
+        stats.processed_ratio = static_cast<double>(stats.processed) / static_cast<double>(total);
+        stats.gated_ratio = static_cast<double>(stats.gated) / static_cast<double>(total);
+    }
+    return stats;
+}
+
+} // namespace oak
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../engine/Types.h"
+
+namespace oak {
+
+struct MotionGateStats {
+    uint64_t frames = 0;                 // Motion stream frames evaluated
+    uint64_t motion_frames = 0;          // Frames with motion above the threshold
+    uint64_t processed = 0;              // Detector frames let through
+    uint64_t gated = 0;                  // Detector frames skipped
+    bool device_counts = false;          // processed/gated reported by the device script
+    double processed_ratio = 0.0;
+    double gated_ratio = 0.0;
+    float last_changed_fraction = 0.0f;
+    bool active = true;                  // Scene currently considered moving
+};
+
+// What the gate wants the detector to do from now on
+struct MotionGateDecision {
+    bool run = true;                     // Run the detector on this frame
+    uint8_t mode = 1;                    // 0 = paused, 1 = every frame, N = every Nth frame
+    bool mode_changed = false;
+};
+
+// Decides from a low-resolution luma stream whether the detector needs to
+// run. Each frame is differenced against the previous one (SIMD, see
+// countChangedPixels); motion opens the gate on that motion frame, and it
+// closes again hold_ms after the last motion. While closed the detector is
+// paused or throttled to every Nth frame.
+//
+// On a device the mode is applied by a Script node in front of the
+// detector (see InferenceModule). The detector frame captured with the
+// motion is already gone by the time the host has seen the motion, so the
+// script holds back the last frame it dropped and forwards it when the gate
+// opens: detection resumes one host round trip after the motion, on a frame
+// up to one frame period older than the newest. The script reports what it
+// actually forwarded through setDeviceCounts(); without those reports
+// (host-side gating of the simulated source) the counts follow update().
+class MotionGate {
+public:
+    explicit MotionGate(const MotionGateConfig& config);
+
+    // One frame of the motion stream; luma is 8-bit, stride in bytes
+    MotionGateDecision update(const uint8_t* luma, uint32_t width, uint32_t height, size_t stride,
+                              std::chrono::steady_clock::time_point now);
+
+    // Cumulative forwarded/dropped detector frames from the device script;
+    // from the first call on, these replace the host's own counts
+    void setDeviceCounts(uint64_t processed, uint64_t gated);
+
+    MotionGateStats getStats() const;
+
+private:
+    MotionGateConfig config_;
+    std::vector<uint8_t> previous_;      // Last frame, tightly packed
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    std::chrono::steady_clock::time_point last_motion_;
+    uint8_t mode_ = 1;
+    uint32_t idle_counter_ = 0;
+
+    mutable std::mutex stats_mutex_;
+    MotionGateStats stats_;
+};
+
+} // namespace oak
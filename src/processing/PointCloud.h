@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace oak {
+
+// Pinhole intrinsics for the camera the depth map is aligned to
+struct CameraIntrinsics {
+    float fx = 0.0f;
+    float fy = 0.0f;
+    float cx = 0.0f;
+    float cy = 0.0f;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool valid() const { return fx > 0.0f && fy > 0.0f && width > 0 && height > 0; }
+
+    // Rescale to a different output resolution of the same sensor
+    CameraIntrinsics scaled(uint32_t new_width, uint32_t new_height) const;
+
+    bool operator==(const CameraIntrinsics& other) const {
+        return fx == other.fx && fy == other.fy && cx == other.cx && cy == other.cy &&
+               width == other.width && height == other.height;
+    }
+    bool operator!=(const CameraIntrinsics& other) const { return !(*this == other); }
+};
+
+// Structure-of-arrays point cloud in meters.
+// Organized clouds (height > 1) keep one point per depth pixel with invalid
+// pixels stored as (0, 0, 0); unorganized clouds have height == 1.
+struct PointCloud {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t valid_count = 0;
+    int64_t sequence_num = -1;
+
+    size_t size() const { return z.size(); }
+    void resize(uint32_t w, uint32_t h);
+};
+
+// Converts 16-bit depth maps (millimeters) into point clouds.
+// Per-pixel ray directions are cached and only rebuilt when the intrinsics
+// change, so the per-frame cost is one multiply per coordinate.
+class PointCloudGenerator {
+public:
+    PointCloudGenerator() = default;
+
+    void setIntrinsics(const CameraIntrinsics& intrinsics);
+    const CameraIntrinsics& getIntrinsics() const { return intrinsics_; }
+
+    // depth_mm must be width x height of the current intrinsics; stride is in
+    // elements. Depths outside [min_depth_m, max_depth_m] are marked invalid.
+    // Returns the number of valid points.
+    size_t generate(const uint16_t* depth_mm, size_t stride,
+                    float min_depth_m, float max_depth_m,
+                    PointCloud& out) const;
+
+private:
+    void rebuildRayTables();
+
+    CameraIntrinsics intrinsics_;
+    std::vector<float> ray_x_;
+    std::vector<float> ray_y_;
+};
+
+// Voxel-grid downsampling: one centroid per occupied voxel.
+// Voxels are looked up in an open-addressing table sized for the largest
+// input so far. Its slots are invalidated by bumping a generation counter
+// rather than cleared, and all storage is kept between calls, so
+// steady-state runs do not allocate (out must keep its size too).
+class VoxelGrid {
+public:
+    void downsample(const PointCloud& in, float voxel_size_m, PointCloud& out);
+
+private:
+    struct Accumulator {
+        float sum_x;
+        float sum_y;
+        float sum_z;
+        uint32_t count;
+    };
+
+    struct Slot {
+        uint64_t key = 0;
+        uint32_t voxel = 0;
+        uint32_t generation = 0;         // Empty unless it equals generation_
+    };
+
+    std::vector<Slot> table_;            // Power of two, at least twice the input points
+    uint32_t generation_ = 0;
+    std::vector<Accumulator> voxels_;
+};
+
+struct PointCloudBenchmark {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const char* backend = "";            // SIMD path the generate_us numbers used
+    double generate_us = 0.0;            // Mean per frame
+    double generate_p99_us = 0.0;
+    double scalar_generate_us = 0.0;     // Same frames with SIMD turned off
+    double voxel_us = 0.0;               // Downsampling the generated cloud
+    double mean_points = 0.0;            // Valid points per frame
+    double mean_voxels = 0.0;
+};
+
+// Synthetic depth maps (tilted planes with noise and invalid pixels) through
+// generate(), with and without SIMD, then VoxelGrid at voxel_size_m
+PointCloudBenchmark benchmarkPointCloud(uint32_t width, uint32_t height, uint32_t frames,
+                                        float voxel_size_m = 0.05f);
+
+} // namespace oak
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <depthai/depthai.hpp>
+
+namespace oak {
+
+// Serializers for detection messages, track events and frame metadata, into
+// caller-owned buffers. Every encode/write call appends to the buffer, so
+// several records can share one buffer (e.g. one network write per batch);
+// clear() it to start over. Once the buffer's capacity covers the largest
+// message, nothing allocates.
+//
+// Binary records (little-endian, self-delimiting):
+//   header (16 bytes): u8 kind, u8 version, u16 source, u32 body_bytes, i64 sequence
+//   DETECTIONS body  : i64 timestamp_us, u16 count, u16 reserved, then count x
+//                      { u16 label, u16 confidence, u16 xmin, ymin, xmax, ymax }
+//   TRACK body       : i64 timestamp_us, u32 track_id, u8 event, u8 reserved, u16 label,
+//                      u16 confidence, u16 xmin, ymin, xmax, ymax
+//   FRAME body       : i64 timestamp_us, i64 device_timestamp_us, u32 width, u32 height,
+//                      u8 type, u8 reserved[3]
+// Confidence and coordinates are quantized as in the batch output format
+// (value * 65535, clamped to [0, 1]); timestamps are the messages' host
+// steady-clock time in microseconds. Readers skip kinds they do not know
+// using body_bytes.
+//
+// JSON is written directly, without a DOM, one object per record:
+//   {"kind":"detections","source":0,"seq":12,"ts_us":...,"detections":[
+//     {"label":2,"name":"car","conf":0.9132,"box":[0.1021,0.2,0.3312,0.4]}]}
+//   {"kind":"track","source":0,"seq":12,"ts_us":...,"track_id":7,"event":"start",...}
+//   {"kind":"frame","source":0,"seq":12,"ts_us":...,"device_ts_us":...,"width":1280,...}
+// Scores and coordinates have four decimals, enough for a 4K frame.
+//
+// Targets on one desktop core, 10 detections per message: 5M+ binary and
+// 1M+ JSON messages per second (see benchmarkSerializers and
+// `oak-camera-service --bench-serialize`).
+
+enum class RecordKind : uint8_t {
+    DETECTIONS = 1,
+    TRACK = 2,
+    FRAME = 3
+};
+
+enum class TrackEventType : uint8_t {
+    STARTED = 0,
+    UPDATED = 1,
+    ENDED = 2
+};
+
+struct TrackEvent {
+    uint16_t source = 0;                 // Caller-defined stream id (e.g. camera socket)
+    int64_t sequence = -1;               // Frame the event belongs to
+    int64_t timestamp_us = 0;
+    uint32_t track_id = 0;
+    TrackEventType event = TrackEventType::UPDATED;
+    uint16_t label = 0;
+    float confidence = 0.0f;
+    float xmin = 0.0f, ymin = 0.0f, xmax = 0.0f, ymax = 0.0f;
+};
+
+struct FrameMeta {
+    uint16_t source = 0;
+    int64_t sequence = -1;
+    int64_t timestamp_us = 0;
+    int64_t device_timestamp_us = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t type = 0;                    // dai::ImgFrame::Type as a number
+};
+
+FrameMeta frameMetaOf(const dai::ImgFrame& frame, uint16_t source = 0);
+
+// Binary
+void encodeDetections(const dai::ImgDetections& detections, uint16_t source, std::vector<uint8_t>& out);
+void encodeTrackEvent(const TrackEvent& event, std::vector<uint8_t>& out);
+void encodeFrameMeta(const FrameMeta& frame, std::vector<uint8_t>& out);
+
+struct RecordHeader {
+    RecordKind kind = RecordKind::DETECTIONS;
+    uint8_t version = 0;
+    uint16_t source = 0;
+    uint32_t body_bytes = 0;
+    int64_t sequence = -1;
+};
+
+// One decoded record; detections keeps its capacity between calls
+struct DecodedRecord {
+    RecordHeader header;
+    int64_t timestamp_us = 0;
+    std::vector<dai::ImgDetection> detections;  // DETECTIONS
+    TrackEvent track;                            // TRACK
+    FrameMeta frame;                             // FRAME
+};
+
+// Decodes the record at the start of data. Returns the bytes it spans, or 0
+// when data does not hold a whole record or the record is malformed. Unknown
+// kinds are skipped: their size is returned with only the header filled in.
+size_t decodeRecord(const uint8_t* data, size_t size, DecodedRecord& out);
+
+// JSON; labels, when given, adds a "name" for labels it covers
+void writeDetectionsJson(const dai::ImgDetections& detections, uint16_t source, std::string& out,
+                         const std::vector<std::string>* labels = nullptr);
+void writeTrackEventJson(const TrackEvent& event, std::string& out,
+                         const std::vector<std::string>* labels = nullptr);
+void writeFrameMetaJson(const FrameMeta& frame, std::string& out);
+
+struct SerializerBenchmark {
+    uint32_t detections_per_message = 0;
+    uint32_t messages = 0;
+    double binary_ns = 0.0;              // Mean per message
+    double json_ns = 0.0;
+    double stream_json_ns = 0.0;         // std::ostringstream baseline, as hand-written callbacks do it
+    size_t binary_bytes = 0;             // Per message
+    size_t json_bytes = 0;
+    double binary_allocations = 0.0;     // Per message, after the first (needs OAK_COUNT_ALLOCATIONS)
+    double json_allocations = 0.0;
+};
+
+// Serializes synthetic detection messages into reused buffers and reports
+// the per-message cost of each format
+SerializerBenchmark benchmarkSerializers(uint32_t detections_per_message, uint32_t messages);
+
+} // namespace oak
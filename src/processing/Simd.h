@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+// Host SIMD code paths.
+//
+// On x86-64 the AVX2 kernels are always compiled, as functions marked
+// OAK_TARGET_AVX2, and picked at run time when the CPU supports AVX2 (see
+// simdAvx2()), so one binary runs on any x86-64 machine. Building with
+// -mavx2 or -march=native (OAK_NATIVE_ARCH in CMakeLists.txt) additionally
+// lets the compiler use AVX2 everywhere and drops the check. NEON is always
+// available on AArch64. Every kernel keeps a scalar fallback so the library
+// builds on any target.
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define OAK_TARGET_AVX2          // MSVC emits any intrinsic without /arch
+    #else
+        #define OAK_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+    #define OAK_SIMD_AVX2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define OAK_SIMD_NEON 1
+#endif
+
+namespace oak {
+
+namespace detail {
+inline std::atomic<bool> g_simd_enabled{true};
+} // namespace detail
+
+// Whether the CPU and OS support AVX2; checked once
+inline bool cpuHasAvx2() {
+#if defined(__AVX2__)
+    return true;
+#elif defined(OAK_SIMD_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+    static const bool supported = [] {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;                // The OS does not save the YMM registers
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return supported;
+#elif defined(OAK_SIMD_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+// Turns the SIMD paths off (and on again) process-wide, e.g. to benchmark
+// the scalar fallback; on by default
+inline void setSimdEnabled(bool enabled) {
+    detail::g_simd_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+inline bool simdEnabled() {
+    return detail::g_simd_enabled.load(std::memory_order_relaxed);
+}
+
+// Kernels take their AVX2 path when this is true
+inline bool simdAvx2() {
+    return cpuHasAvx2() && simdEnabled();
+}
+
+inline const char* simdBackendName() {
+#if defined(OAK_SIMD_AVX2)
+    return simdAvx2() ? "AVX2" : "scalar";
+#elif defined(OAK_SIMD_NEON)
+    return simdEnabled() ? "NEON" : "scalar";
+#else
+    return "scalar";
+#endif
+}
+
+#if defined(OAK_SIMD_AVX2)
+// Set bits of a movemask, for the AVX2 paths (every AVX2 CPU has POPCNT)
+inline uint32_t popcount32(uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return static_cast<uint32_t>(__popcnt(v));
+#else
+    return static_cast<uint32_t>(__builtin_popcount(v));
+#endif
+}
+#endif
+
+} // namespace oak
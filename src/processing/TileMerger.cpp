@@ -0,0 +1,291 @@
+#include "TileMerger.h"
+#include "../engine/SampleStats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace oak {
+
+namespace {
+
+void letterbox(TileRect& tile, uint32_t input_width, uint32_t input_height) {
+    float scale = std::min(static_cast<float>(input_width) / static_cast<float>(tile.width),
+                           static_cast<float>(input_height) / static_cast<float>(tile.height));
+    tile.content_width = static_cast<float>(tile.width) * scale / static_cast<float>(input_width);
+    tile.content_height = static_cast<float>(tile.height) * scale / static_cast<float>(input_height);
+    tile.content_x = (1.0f - tile.content_width) * 0.5f;
+    tile.content_y = (1.0f - tile.content_height) * 0.5f;
+}
+
+// Evenly spread starts so the first tile touches 0 and the last touches the end
+std::vector<uint32_t> tileStarts(uint32_t extent, uint32_t tile, float overlap) {
+    if (tile >= extent) {
+        return {0};
+    }
+    float step = static_cast<float>(tile) * (1.0f - std::clamp(overlap, 0.0f, 0.9f));
+    auto count = 1 + static_cast<uint32_t>(std::ceil(static_cast<float>(extent - tile) / step));
+    std::vector<uint32_t> starts(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        starts[i] = static_cast<uint32_t>(std::lround(static_cast<double>(i) * (extent - tile) / (count - 1)));
+    }
+    return starts;
+}
+
+float clamp01(float v) {
+    return std::min(1.0f, std::max(0.0f, v));
+}
+
+} // namespace
+
+std::vector<TileRect> computeTiles(uint32_t source_width, uint32_t source_height,
+                                   uint32_t input_width, uint32_t input_height, const TilingConfig& config) {
+    std::vector<TileRect> tiles;
+    if (config.include_full_frame) {
+        TileRect full;
+        full.width = source_width;
+        full.height = source_height;
+        letterbox(full, input_width, input_height);
+        tiles.push_back(full);
+    }
+
+    uint32_t tile_width = std::min(source_width,
+        static_cast<uint32_t>(std::lround(static_cast<float>(input_width) * config.tile_scale)));
+    uint32_t tile_height = std::min(source_height,
+        static_cast<uint32_t>(std::lround(static_cast<float>(input_height) * config.tile_scale)));
+    bool grid_is_full_frame = tile_width == source_width && tile_height == source_height;
+    if (!(grid_is_full_frame && config.include_full_frame)) {
+        for (uint32_t y : tileStarts(source_height, tile_height, config.overlap)) {
+            for (uint32_t x : tileStarts(source_width, tile_width, config.overlap)) {
+                TileRect tile;
+                tile.x = x;
+                tile.y = y;
+                tile.width = tile_width;
+                tile.height = tile_height;
+                letterbox(tile, input_width, input_height);  // Only pads tiles clipped by the frame
+                tiles.push_back(tile);
+            }
+        }
+    }
+
+    if (tiles.size() > TileMerger::kMaxTiles) {
+        throw std::invalid_argument("tiling produces " + std::to_string(tiles.size()) +
+                                    " tiles, more than " + std::to_string(TileMerger::kMaxTiles) +
+                                    "; raise tile_scale or lower the source resolution");
+    }
+    return tiles;
+}
+
+TileMerger::TileMerger(std::vector<TileRect> tiles, uint32_t source_width, uint32_t source_height,
+                       const TilingConfig& config)
+    : tiles_(std::move(tiles)),
+      source_width_(static_cast<float>(source_width)),
+      source_height_(static_cast<float>(source_height)),
+      config_(config) {
+    if (tiles_.empty() || tiles_.size() > kMaxTiles) {
+        throw std::invalid_argument("TileMerger needs 1 to " + std::to_string(kMaxTiles) + " tiles");
+    }
+    candidates_.reserve(tiles_.size() * 32);
+    stats_.tiles = static_cast<uint32_t>(tiles_.size());
+}
+
+bool TileMerger::add(int64_t tile_sequence, const std::vector<dai::ImgDetection>& detections,
+                     std::vector<dai::ImgDetection>& merged, int64_t& frame) {
+    int64_t message_frame = tile_sequence / kSequenceStride;
+    auto tile = static_cast<uint32_t>(tile_sequence % kSequenceStride);
+    const uint64_t all_tiles = tiles_.size() == 64 ? ~0ull : (1ull << tiles_.size()) - 1;
+    bool ready = false;
+
+    if (message_frame != frame_) {
+        // A tile of the previous frame went missing; merge what we have
+        if (tiles_seen_ != 0) {
+            merge(merged, false);
+            frame = frame_;
+            ready = true;
+        }
+        frame_ = message_frame;
+        tiles_seen_ = 0;
+        candidates_.clear();
+    }
+
+    if (tile >= tiles_.size() || (tiles_seen_ & (1ull << tile))) {
+        return ready;
+    }
+    addTile(tile, detections);
+    tiles_seen_ |= 1ull << tile;
+
+    // With a single tile every frame completes on its own message, so a
+    // flush above and a completion here never coincide
+    if (!ready && tiles_seen_ == all_tiles) {
+        merge(merged, true);
+        frame = frame_;
+        tiles_seen_ = 0;
+        candidates_.clear();
+        ready = true;
+    }
+    return ready;
+}
+
+void TileMerger::addTile(uint32_t tile, const std::vector<dai::ImgDetection>& detections) {
+    const TileRect& rect = tiles_[tile];
+    // NN-normalized -> crop-normalized -> full-frame normalized
+    const float sx = static_cast<float>(rect.width) / source_width_ / rect.content_width;
+    const float sy = static_cast<float>(rect.height) / source_height_ / rect.content_height;
+    const float ox = static_cast<float>(rect.x) / source_width_;
+    const float oy = static_cast<float>(rect.y) / source_height_;
+
+    for (const auto& det : detections) {
+        Candidate candidate;
+        candidate.det = det;
+        candidate.det.xmin = clamp01(ox + (det.xmin - rect.content_x) * sx);
+        candidate.det.ymin = clamp01(oy + (det.ymin - rect.content_y) * sy);
+        candidate.det.xmax = clamp01(ox + (det.xmax - rect.content_x) * sx);
+        candidate.det.ymax = clamp01(oy + (det.ymax - rect.content_y) * sy);
+        candidate.area = (candidate.det.xmax - candidate.det.xmin) * (candidate.det.ymax - candidate.det.ymin);
+        if (candidate.area <= 0.0f) {
+            continue;
+        }
+        candidate.tile = tile;
+        candidate.suppressed = false;
+        candidates_.push_back(candidate);
+    }
+}
+
+void TileMerger::merge(std::vector<dai::ImgDetection>& merged, bool complete) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Grouped by label so each box is only compared within its class
+    std::sort(candidates_.begin(), candidates_.end(), [](const Candidate& a, const Candidate& b) {
+        return a.det.label != b.det.label ? a.det.label < b.det.label : a.det.confidence > b.det.confidence;
+    });
+
+    merged.clear();
+    for (size_t i = 0; i < candidates_.size(); ++i) {
+        Candidate& keep = candidates_[i];
+        if (keep.suppressed) {
+            continue;
+        }
+        for (size_t j = i + 1; j < candidates_.size(); ++j) {
+            Candidate& other = candidates_[j];
+            if (other.det.label != keep.det.label) {
+                break;
+            }
+            if (other.suppressed) {
+                continue;
+            }
+            float ix = std::min(keep.det.xmax, other.det.xmax) - std::max(keep.det.xmin, other.det.xmin);
+            float iy = std::min(keep.det.ymax, other.det.ymax) - std::max(keep.det.ymin, other.det.ymin);
+            if (ix <= 0.0f || iy <= 0.0f) {
+                continue;
+            }
+            float inter = ix * iy;
+            if (inter / (keep.area + other.area - inter) >= config_.iou_threshold) {
+                other.suppressed = true;
+            } else if (other.tile != keep.tile &&
+                       inter / std::min(keep.area, other.area) >= config_.containment_threshold) {
+                // Same object seen whole in one tile and cut in another
+                keep.det.xmin = std::min(keep.det.xmin, other.det.xmin);
+                keep.det.ymin = std::min(keep.det.ymin, other.det.ymin);
+                keep.det.xmax = std::max(keep.det.xmax, other.det.xmax);
+                keep.det.ymax = std::max(keep.det.ymax, other.det.ymax);
+                keep.area = (keep.det.xmax - keep.det.xmin) * (keep.det.ymax - keep.det.ymin);
+                other.suppressed = true;
+            }
+        }
+        merged.push_back(keep.det);
+    }
+
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.frames++;
+    stats_.incomplete_frames += complete ? 0 : 1;
+    stats_.input_detections += candidates_.size();
+    stats_.output_detections += merged.size();
+    stats_.mean_merge_us += (us - stats_.mean_merge_us) / static_cast<double>(stats_.frames);
+    stats_.max_merge_us = std::max(stats_.max_merge_us, us);
+}
+
+TileMergeStats TileMerger::getStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+TileMergeBenchmark benchmarkTileMerge(const TilingConfig& config, uint32_t input_width, uint32_t input_height,
+                                      uint32_t detections_per_tile, uint32_t frames) {
+    auto tiles = computeTiles(config.source_width, config.source_height, input_width, input_height, config);
+    TileMerger merger(tiles, config.source_width, config.source_height, config);
+    const float width = static_cast<float>(config.source_width);
+    const float height = static_cast<float>(config.source_height);
+
+    // A handful of distinct frames, replayed; objects are projected into
+    // every tile they touch, so most appear (often cut) in several tiles
+    constexpr uint32_t kVariants = 16;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(0.0f, 1.0f);
+    std::uniform_real_distribution<float> size(0.01f, 0.08f);
+    std::uniform_real_distribution<float> confidence(0.3f, 1.0f);
+    std::vector<std::vector<std::vector<dai::ImgDetection>>> variants(kVariants);
+    const uint32_t objects = std::max<uint32_t>(1, detections_per_tile * static_cast<uint32_t>(tiles.size()) / 3);
+    for (auto& variant : variants) {
+        variant.resize(tiles.size());
+        for (uint32_t o = 0; o < objects; ++o) {
+            float cx = position(rng), cy = position(rng), half_w = size(rng), half_h = size(rng);
+            auto label = static_cast<uint32_t>(o % 8);
+            float score = confidence(rng);
+            for (size_t t = 0; t < tiles.size(); ++t) {
+                const TileRect& r = tiles[t];
+                if (variant[t].size() >= detections_per_tile) {
+                    continue;
+                }
+                float x0 = std::max((cx - half_w) * width, static_cast<float>(r.x));
+                float y0 = std::max((cy - half_h) * height, static_cast<float>(r.y));
+                float x1 = std::min((cx + half_w) * width, static_cast<float>(r.x + r.width));
+                float y1 = std::min((cy + half_h) * height, static_cast<float>(r.y + r.height));
+                if (x1 <= x0 || y1 <= y0) {
+                    continue;
+                }
+                auto toInput = [](float v, uint32_t start, uint32_t extent, float content_start, float content) {
+                    return content_start + (v - static_cast<float>(start)) / static_cast<float>(extent) * content;
+                };
+                dai::ImgDetection det{};
+                det.label = label;
+                det.confidence = score;
+                det.xmin = toInput(x0, r.x, r.width, r.content_x, r.content_width);
+                det.ymin = toInput(y0, r.y, r.height, r.content_y, r.content_height);
+                det.xmax = toInput(x1, r.x, r.width, r.content_x, r.content_width);
+                det.ymax = toInput(y1, r.y, r.height, r.content_y, r.content_height);
+                variant[t].push_back(det);
+            }
+        }
+    }
+
+    std::vector<dai::ImgDetection> merged;
+    merged.reserve(static_cast<size_t>(objects) * 2);
+    std::vector<double> samples;
+    samples.reserve(frames);
+    int64_t merged_frame = 0;
+    for (uint32_t f = 0; f < frames; ++f) {
+        const auto& variant = variants[f % kVariants];
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < tiles.size(); ++t) {
+            merger.add(static_cast<int64_t>(f) * TileMerger::kSequenceStride + static_cast<int64_t>(t),
+                       variant[t], merged, merged_frame);
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    TileMergeBenchmark result;
+    result.tiles = static_cast<uint32_t>(tiles.size());
+    result.detections_per_tile = detections_per_tile;
+    result.frames = frames;
+    SampleSummary summary = summarizeSamples(samples);
+    result.mean_us = summary.mean;
+    result.p50_us = summary.p50;
+    result.p99_us = summary.p99;
+    result.max_us = summary.max;
+    return result;
+}
+
+} // namespace oak
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <depthai/depthai.hpp>
+#include "../engine/Types.h"
+
+namespace oak {
+
+// One network input cut from the high-resolution frame
+struct TileRect {
+    uint32_t x = 0;                      // Crop in source pixels
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Part of the (letterboxed) NN input the crop occupies, normalized
+    float content_x = 0.0f;
+    float content_y = 0.0f;
+    float content_width = 1.0f;
+    float content_height = 1.0f;
+};
+
+struct TileMergeStats {
+    uint32_t tiles = 0;                  // NN passes per frame
+    uint64_t frames = 0;
+    uint64_t incomplete_frames = 0;      // Merged before every tile arrived
+    uint64_t input_detections = 0;       // Tile detections before NMS
+    uint64_t output_detections = 0;
+    double mean_merge_us = 0.0;          // Host cost of the cross-tile NMS per frame
+    double max_merge_us = 0.0;
+};
+
+// Full frame first (when requested, letterboxed), then a grid of tiles of
+// NN input size * tile_scale spread evenly with at least `overlap` between
+// neighbours. At most TileMerger::kMaxTiles.
+std::vector<TileRect> computeTiles(uint32_t source_width, uint32_t source_height,
+                                   uint32_t input_width, uint32_t input_height, const TilingConfig& config);
+
+// Reassembles per-tile detection messages into full-frame detections.
+//
+// Tile messages carry sequence number frame * kSequenceStride + tile (set
+// by the device script) and arrive in order. A frame is merged when its
+// last tile arrives, or early when a tile of a newer frame shows up.
+// Detections are mapped to normalized full-frame coordinates and reduced
+// with class-aware greedy NMS across tiles: overlapping boxes above
+// iou_threshold are suppressed, and boxes from different tiles where one
+// mostly contains the other are merged into their union, which rejoins
+// objects cut by a tile edge. Buffers are reused from frame to frame.
+class TileMerger {
+public:
+    static constexpr int64_t kSequenceStride = 64;
+    static constexpr size_t kMaxTiles = 64;
+
+    TileMerger(std::vector<TileRect> tiles, uint32_t source_width, uint32_t source_height,
+               const TilingConfig& config);
+
+    size_t tileCount() const { return tiles_.size(); }
+    const std::vector<TileRect>& tiles() const { return tiles_; }
+
+    // Feeds one tile message. Returns true when a frame was merged into
+    // `merged` (replacing its contents); `frame` receives its sequence number.
+    bool add(int64_t tile_sequence, const std::vector<dai::ImgDetection>& detections,
+             std::vector<dai::ImgDetection>& merged, int64_t& frame);
+
+    TileMergeStats getStats() const;
+
+private:
+    struct Candidate {
+        dai::ImgDetection det;
+        float area;
+        uint32_t tile;
+        bool suppressed;
+    };
+
+    void addTile(uint32_t tile, const std::vector<dai::ImgDetection>& detections);
+    void merge(std::vector<dai::ImgDetection>& merged, bool complete);
+
+    std::vector<TileRect> tiles_;
+    float source_width_;
+    float source_height_;
+    TilingConfig config_;
+
+    int64_t frame_ = -1;                 // Frame being collected
+    uint64_t tiles_seen_ = 0;            // Bit per tile
+    std::vector<Candidate> candidates_;
+
+    mutable std::mutex stats_mutex_;
+    TileMergeStats stats_;
+};
+
+struct TileMergeBenchmark {
+    uint32_t tiles = 0;
+    uint32_t detections_per_tile = 0;
+    uint32_t frames = 0;
+    double mean_us = 0.0;
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+};
+
+// Merges synthetic frames (clustered boxes, many duplicated across tiles)
+// and reports the per-frame host cost
+TileMergeBenchmark benchmarkTileMerge(const TilingConfig& config, uint32_t input_width, uint32_t input_height,
+                                      uint32_t detections_per_tile, uint32_t frames);
+
+} // namespace oak
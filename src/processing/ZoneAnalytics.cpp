@@ -0,0 +1,574 @@
+#include "ZoneAnalytics.h"
+#include "../engine/Trace.h"
+#include "../engine/SampleStats.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <cmath>
+
+namespace oak {
+
+namespace {
+
+// > 0: p is right of a -> b (image coordinates, y down)
+float cross(ZonePoint a, ZonePoint b, ZonePoint p) {
+    return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+// Crossing-number test; works for concave polygons
+bool insidePolygon(const std::vector<ZonePoint>& polygon, ZonePoint p) {
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const ZonePoint& a = polygon[i];
+        const ZonePoint& b = polygon[j];
+        if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Liang-Barsky clip of segment a -> b against a rectangle
+bool segmentTouchesRect(ZonePoint a, ZonePoint b, float x0, float y0, float x1, float y1) {
+    float t0 = 0.0f;
+    float t1 = 1.0f;
+    auto clip = [&](float p, float q) {
+        if (p == 0.0f) {
+            return q >= 0.0f;
+        }
+        float r = q / p;
+        if (p < 0.0f) {
+            if (r > t1) {
+                return false;
+            }
+            t0 = std::max(t0, r);
+        } else {
+            if (r < t0) {
+                return false;
+            }
+            t1 = std::min(t1, r);
+        }
+        return true;
+    };
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    return clip(-dx, a.x - x0) && clip(dx, x1 - a.x) && clip(-dy, a.y - y0) && clip(dy, y1 - a.y);
+}
+
+// Cell -> items as offsets into one flat array (CSR). visit(item, add) calls
+// add(cell) for every cell the item belongs to; it runs twice, to count and to fill.
+template <typename Visit>
+void buildCells(size_t cells, size_t count, Visit visit, std::vector<uint32_t>& start, std::vector<uint16_t>& items) {
+    start.assign(cells + 1, 0);
+    for (size_t item = 0; item < count; ++item) {
+        visit(item, [&start](size_t cell) { start[cell + 1]++; });
+    }
+    for (size_t cell = 0; cell < cells; ++cell) {
+        start[cell + 1] += start[cell];
+    }
+    items.assign(start[cells], 0);
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (size_t item = 0; item < count; ++item) {
+        visit(item, [&](size_t cell) { items[fill[cell]++] = static_cast<uint16_t>(item); });
+    }
+}
+
+uint32_t cellIndex(float v, uint32_t cells) {
+    return static_cast<uint32_t>(std::clamp(static_cast<int>(v * static_cast<float>(cells)), 0,
+                                            static_cast<int>(cells) - 1));
+}
+
+} // namespace
+
+ZoneAnalytics::ZoneAnalytics(const AnalyticsConfig& config)
+    : config_(config),
+      cols_(std::max(config.grid_cols, 1u)),
+      rows_(std::max(config.grid_rows, 1u)),
+      tracker_(config.track_iou_threshold, config.max_missed_frames) {
+    // Indices are 16-bit in events and the grid
+    constexpr size_t kMaxItems = UINT16_MAX;
+    if (config_.zones.size() > kMaxItems || config_.tripwires.size() > kMaxItems) {
+        std::cerr << "Analytics: only the first " << kMaxItems << " zones and tripwires are used" << std::endl;
+    }
+
+    for (size_t i = 0; i < std::min(config_.zones.size(), kMaxItems); ++i) {
+        const ZoneConfig& source = config_.zones[i];
+        Zone zone;
+        zone.labels = source.labels;
+        if (source.polygon.size() < 3) {
+            // Kept so indices match the config, but never matches
+            std::cerr << "Analytics: zone '" << source.name << "' has fewer than 3 points, ignored" << std::endl;
+            zone.xmin = zone.ymin = 1.0f;
+            zone.xmax = zone.ymax = 0.0f;
+        } else {
+            zone.polygon = source.polygon;
+            zone.xmin = zone.xmax = source.polygon[0].x;
+            zone.ymin = zone.ymax = source.polygon[0].y;
+            for (const ZonePoint& p : source.polygon) {
+                zone.xmin = std::min(zone.xmin, p.x);
+                zone.xmax = std::max(zone.xmax, p.x);
+                zone.ymin = std::min(zone.ymin, p.y);
+                zone.ymax = std::max(zone.ymax, p.y);
+            }
+        }
+        zones_.push_back(std::move(zone));
+    }
+    for (size_t i = 0; i < std::min(config_.tripwires.size(), kMaxItems); ++i) {
+        const TripwireConfig& source = config_.tripwires[i];
+        Wire wire;
+        wire.a = source.a;
+        wire.b = source.b;
+        wire.labels = source.labels;
+        wires_.push_back(std::move(wire));
+    }
+    wire_stamp_.assign(wires_.size(), 0);
+
+    if (config_.heatmap_width > 0 && config_.heatmap_height > 0) {
+        heat_.assign(static_cast<size_t>(config_.heatmap_width) * config_.heatmap_height, 0.0f);
+    }
+    buildGrid();
+}
+
+void ZoneAnalytics::buildGrid() {
+    const size_t cells = static_cast<size_t>(cols_) * rows_;
+    const float cell_w = 1.0f / static_cast<float>(cols_);
+    const float cell_h = 1.0f / static_cast<float>(rows_);
+
+    // Zones: every cell their bounding box covers
+    buildCells(cells, zones_.size(), [this](size_t item, auto&& add) {
+        const Zone& zone = zones_[item];
+        if (zone.polygon.empty()) {
+            return;
+        }
+        for (uint32_t row = cellIndex(zone.ymin, rows_); row <= cellIndex(zone.ymax, rows_); ++row) {
+            for (uint32_t col = cellIndex(zone.xmin, cols_); col <= cellIndex(zone.xmax, cols_); ++col) {
+                add(static_cast<size_t>(row) * cols_ + col);
+            }
+        }
+    }, zone_grid_.start, zone_grid_.items);
+
+    // Tripwires: only the cells the segment passes through
+    buildCells(cells, wires_.size(), [this, cell_w, cell_h](size_t item, auto&& add) {
+        const Wire& wire = wires_[item];
+        uint32_t row0 = cellIndex(std::min(wire.a.y, wire.b.y), rows_);
+        uint32_t row1 = cellIndex(std::max(wire.a.y, wire.b.y), rows_);
+        uint32_t col0 = cellIndex(std::min(wire.a.x, wire.b.x), cols_);
+        uint32_t col1 = cellIndex(std::max(wire.a.x, wire.b.x), cols_);
+        for (uint32_t row = row0; row <= row1; ++row) {
+            for (uint32_t col = col0; col <= col1; ++col) {
+                float x0 = static_cast<float>(col) * cell_w;
+                float y0 = static_cast<float>(row) * cell_h;
+                if (segmentTouchesRect(wire.a, wire.b, x0, y0, x0 + cell_w, y0 + cell_h)) {
+                    add(static_cast<size_t>(row) * cols_ + col);
+                }
+            }
+        }
+    }, wire_grid_.start, wire_grid_.items);
+}
+
+ZonePoint ZoneAnalytics::anchorOf(const TrackedObject& object) const {
+    ZonePoint point;
+    point.x = (object.xmin + object.xmax) * 0.5f;
+    point.y = config_.anchor == AnchorPoint::BOTTOM_CENTER ? object.ymax : (object.ymin + object.ymax) * 0.5f;
+    return point;
+}
+
+size_t ZoneAnalytics::cellOf(float x, float y) const {
+    return static_cast<size_t>(cellIndex(y, rows_)) * cols_ + cellIndex(x, cols_);
+}
+
+bool ZoneAnalytics::labelMatches(const std::vector<uint32_t>& labels, uint32_t label) {
+    return labels.empty() || std::find(labels.begin(), labels.end(), label) != labels.end();
+}
+
+void ZoneAnalytics::update(const std::vector<TrackedObject>& objects, int64_t sequence,
+                           std::chrono::steady_clock::time_point timestamp, std::vector<AnalyticsEvent>& events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    updateLocked(objects, sequence, timestamp, events);
+}
+
+void ZoneAnalytics::update(const dai::ImgDetections& detections, std::vector<AnalyticsEvent>& events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto& list = detections.detections;
+    tracker_.update(tracker_frame_++, list, track_ids_, next_track_id_);
+
+    objects_.resize(list.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+        TrackedObject& object = objects_[i];
+        object.track_id = track_ids_[i];
+        object.label = list[i].label;
+        object.xmin = list[i].xmin;
+        object.ymin = list[i].ymin;
+        object.xmax = list[i].xmax;
+        object.ymax = list[i].ymax;
+    }
+    updateLocked(objects_, detections.getSequenceNum(), detections.getTimestamp(), events);
+}
+
+void ZoneAnalytics::updateLocked(const std::vector<TrackedObject>& objects, int64_t sequence,
+                                 std::chrono::steady_clock::time_point timestamp,
+                                 std::vector<AnalyticsEvent>& events) {
+    TraceSpan span("zone_analytics", "analytics", sequence);
+    auto start = std::chrono::steady_clock::now();
+    const size_t first_event = events.size();
+    ++frame_;
+
+    AnalyticsEvent base;
+    base.sequence = sequence;
+    base.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+
+    // Decay: raising the scale of new heat is the same as shrinking all old heat
+    if (!heat_.empty() && config_.heatmap_half_life_s > 0.0f &&
+        last_timestamp_.time_since_epoch().count() != 0 && timestamp > last_timestamp_) {
+        double dt = std::chrono::duration<double>(timestamp - last_timestamp_).count();
+        heat_scale_ *= std::exp2(dt / config_.heatmap_half_life_s);
+        if (heat_scale_ > 1e24) {
+            for (float& value : heat_) {
+                value = static_cast<float>(value / heat_scale_);
+            }
+            heat_scale_ = 1.0;
+        }
+    }
+    last_timestamp_ = timestamp;
+
+    auto zoneEvent = [&](AnalyticsEventType type, uint16_t index, AnalyticsEvent event) {
+        Zone& zone = zones_[index];
+        if (type == AnalyticsEventType::ZONE_ENTER) {
+            zone.occupancy++;
+            zone.entries++;
+        } else if (zone.occupancy > 0) {
+            zone.occupancy--;
+        }
+        event.type = type;
+        event.index = index;
+        event.count = zone.occupancy;
+        events.push_back(event);
+    };
+
+    for (const TrackedObject& object : objects) {
+        ZonePoint anchor = anchorOf(object);
+        auto [it, created] = tracks_.try_emplace(object.track_id);
+        Track& track = it->second;
+
+        AnalyticsEvent event = base;
+        event.track_id = object.track_id;
+        event.label = object.label;
+
+        if (!created && track.last_frame != frame_) {
+            crossWires(track, anchor, event, events);
+        }
+
+        // Zones of the anchor's cell are listed in zone order, so inside_ comes out sorted
+        inside_.clear();
+        size_t cell = cellOf(anchor.x, anchor.y);
+        for (uint32_t i = zone_grid_.start[cell]; i < zone_grid_.start[cell + 1]; ++i) {
+            uint16_t index = zone_grid_.items[i];
+            const Zone& zone = zones_[index];
+            candidates_++;
+            if (anchor.x < zone.xmin || anchor.x > zone.xmax || anchor.y < zone.ymin || anchor.y > zone.ymax ||
+                !labelMatches(zone.labels, object.label)) {
+                continue;
+            }
+            if (insidePolygon(zone.polygon, anchor)) {
+                inside_.push_back(index);
+            }
+        }
+
+        // Sorted merge of the previous zones against the current ones
+        size_t before = 0;
+        size_t now = 0;
+        while (before < track.zones.size() || now < inside_.size()) {
+            if (now == inside_.size() || (before < track.zones.size() && track.zones[before] < inside_[now])) {
+                zoneEvent(AnalyticsEventType::ZONE_EXIT, track.zones[before++], event);
+            } else if (before == track.zones.size() || inside_[now] < track.zones[before]) {
+                zoneEvent(AnalyticsEventType::ZONE_ENTER, inside_[now++], event);
+            } else {
+                ++before;
+                ++now;
+            }
+        }
+
+        track.zones.assign(inside_.begin(), inside_.end());
+        track.label = object.label;
+        track.anchor = anchor;
+        track.last_frame = frame_;
+        addHeat(anchor);
+    }
+
+    // Lost tracks leave their zones
+    for (auto it = tracks_.begin(); it != tracks_.end();) {
+        const Track& track = it->second;
+        if (frame_ - track.last_frame <= config_.max_missed_frames) {
+            ++it;
+            continue;
+        }
+        AnalyticsEvent event = base;
+        event.track_id = it->first;
+        event.label = track.label;
+        for (uint16_t index : track.zones) {
+            zoneEvent(AnalyticsEventType::ZONE_EXIT, index, event);
+        }
+        it = tracks_.erase(it);
+    }
+
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    stats_.frames++;
+    stats_.objects += objects.size();
+    stats_.events += events.size() - first_event;
+    stats_.active_tracks = static_cast<uint32_t>(tracks_.size());
+    stats_.max_update_us = std::max(stats_.max_update_us, us);
+    update_us_total_ += us;
+}
+
+void ZoneAnalytics::crossWires(const Track& track, ZonePoint to, AnalyticsEvent event,
+                               std::vector<AnalyticsEvent>& events) {
+    ZonePoint from = track.anchor;
+    if (wires_.empty() || (from.x == to.x && from.y == to.y)) {
+        return;
+    }
+    if (++stamp_ == 0) {
+        std::fill(wire_stamp_.begin(), wire_stamp_.end(), 0);
+        stamp_ = 1;
+    }
+
+    // A wire the movement crosses passes through a cell within the movement's bounding box
+    uint32_t row0 = cellIndex(std::min(from.y, to.y), rows_);
+    uint32_t row1 = cellIndex(std::max(from.y, to.y), rows_);
+    uint32_t col0 = cellIndex(std::min(from.x, to.x), cols_);
+    uint32_t col1 = cellIndex(std::max(from.x, to.x), cols_);
+    for (uint32_t row = row0; row <= row1; ++row) {
+        for (uint32_t col = col0; col <= col1; ++col) {
+            size_t cell = static_cast<size_t>(row) * cols_ + col;
+            for (uint32_t i = wire_grid_.start[cell]; i < wire_grid_.start[cell + 1]; ++i) {
+                uint16_t index = wire_grid_.items[i];
+                if (wire_stamp_[index] == stamp_) {
+                    continue;
+                }
+                wire_stamp_[index] = stamp_;
+                candidates_++;
+
+                Wire& wire = wires_[index];
+                if (!labelMatches(wire.labels, event.label)) {
+                    continue;
+                }
+                // Sides of the wire's line (on it counts as right), then the
+                // wire's ends against the movement's line
+                bool left_before = cross(wire.a, wire.b, from) < 0.0f;
+                bool left_after = cross(wire.a, wire.b, to) < 0.0f;
+                if (left_before == left_after) {
+                    continue;
+                }
+                float end_a = cross(from, to, wire.a);
+                float end_b = cross(from, to, wire.b);
+                if ((end_a < 0.0f && end_b < 0.0f) || (end_a > 0.0f && end_b > 0.0f)) {
+                    continue;
+                }
+
+                event.type = AnalyticsEventType::LINE_CROSS;
+                event.index = index;
+                event.direction = left_before ? 1 : -1;
+                event.count = static_cast<uint32_t>(left_before ? ++wire.forward : ++wire.backward);
+                events.push_back(event);
+            }
+        }
+    }
+}
+
+void ZoneAnalytics::addHeat(ZonePoint point) {
+    if (heat_.empty()) {
+        return;
+    }
+    size_t x = cellIndex(point.x, config_.heatmap_width);
+    size_t y = cellIndex(point.y, config_.heatmap_height);
+    heat_[y * config_.heatmap_width + x] += static_cast<float>(heat_scale_);
+}
+
+AnalyticsCounts ZoneAnalytics::getCounts() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AnalyticsCounts counts;
+    for (const Zone& zone : zones_) {
+        counts.occupancy.push_back(zone.occupancy);
+        counts.entries.push_back(zone.entries);
+    }
+    for (const Wire& wire : wires_) {
+        counts.forward.push_back(wire.forward);
+        counts.backward.push_back(wire.backward);
+    }
+    return counts;
+}
+
+cv::Mat ZoneAnalytics::getHeatmap() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (heat_.empty()) {
+        return {};
+    }
+    cv::Mat heatmap(static_cast<int>(config_.heatmap_height), static_cast<int>(config_.heatmap_width), CV_32F);
+    auto* out = heatmap.ptr<float>();
+    for (size_t i = 0; i < heat_.size(); ++i) {
+        out[i] = static_cast<float>(heat_[i] / heat_scale_);
+    }
+    return heatmap;
+}
+
+AnalyticsStats ZoneAnalytics::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AnalyticsStats stats = stats_;
+    if (stats_.frames > 0) {
+        stats.mean_update_us = update_us_total_ / static_cast<double>(stats_.frames);
+    }
+    if (stats_.objects > 0) {
+        stats.mean_candidates = static_cast<double>(candidates_) / static_cast<double>(stats_.objects);
+    }
+    return stats;
+}
+
+void ZoneAnalytics::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tracks_.clear();
+    for (Zone& zone : zones_) {
+        zone.occupancy = 0;
+        zone.entries = 0;
+    }
+    for (Wire& wire : wires_) {
+        wire.forward = 0;
+        wire.backward = 0;
+    }
+    std::fill(heat_.begin(), heat_.end(), 0.0f);
+    heat_scale_ = 1.0;
+    last_timestamp_ = {};
+    tracker_ = IouTracker(config_.track_iou_threshold, config_.max_missed_frames);
+    stats_ = AnalyticsStats{};
+    candidates_ = 0;
+    update_us_total_ = 0.0;
+}
+
+ZoneAnalyticsBenchmark benchmarkZoneAnalytics(uint32_t zones, uint32_t tripwires, uint32_t tracks,
+                                              uint32_t frames, uint32_t grid) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> radius(0.02f, 0.08f);
+    std::uniform_real_distribution<float> length(0.05f, 0.3f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> speed(0.002f, 0.01f);
+    std::uniform_int_distribution<uint32_t> lifetime(100, 1000);
+
+    AnalyticsConfig config;
+    config.grid_cols = config.grid_rows = std::max(grid, 1u);
+    config.heatmap_half_life_s = 60.0f;
+    // Irregular hexagons, some of them concave
+    for (uint32_t z = 0; z < zones; ++z) {
+        ZoneConfig zone;
+        zone.name = "zone" + std::to_string(z);
+        float cx = unit(rng);
+        float cy = unit(rng);
+        float r = radius(rng);
+        for (int v = 0; v < 6; ++v) {
+            float a = static_cast<float>(v) * 1.0471976f;
+            float rv = r * (0.5f + unit(rng));
+            zone.polygon.push_back({cx + rv * std::cos(a), cy + rv * std::sin(a)});
+        }
+        config.zones.push_back(std::move(zone));
+    }
+    for (uint32_t w = 0; w < tripwires; ++w) {
+        TripwireConfig wire;
+        wire.name = "wire" + std::to_string(w);
+        wire.a = {unit(rng), unit(rng)};
+        float a = angle(rng);
+        float l = length(rng);
+        wire.b = {std::clamp(wire.a.x + l * std::cos(a), 0.0f, 1.0f), std::clamp(wire.a.y + l * std::sin(a), 0.0f, 1.0f)};
+        config.tripwires.push_back(std::move(wire));
+    }
+    ZoneAnalytics analytics(config);
+
+    // Random walkers that bounce off the frame edges; each leaves after its
+    // lifetime and is replaced by a new track
+    struct Walker {
+        TrackedObject object;
+        float x, y, vx, vy;
+        uint32_t life;
+    };
+    uint32_t next_id = 1;
+    auto spawn = [&](Walker& walker) {
+        walker.object.track_id = next_id++;
+        walker.object.label = walker.object.track_id % 4;
+        walker.x = unit(rng);
+        walker.y = unit(rng);
+        float a = angle(rng);
+        float s = speed(rng);
+        walker.vx = s * std::cos(a);
+        walker.vy = s * std::sin(a);
+        walker.life = lifetime(rng);
+    };
+    std::vector<Walker> walkers(tracks);
+    for (auto& walker : walkers) {
+        spawn(walker);
+    }
+
+    std::vector<TrackedObject> objects(tracks);
+    std::vector<AnalyticsEvent> events;
+    events.reserve(1024);
+    std::vector<double> samples;
+    samples.reserve(frames);
+    uint64_t total_events = 0;
+    auto timestamp = std::chrono::steady_clock::now();
+
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (size_t i = 0; i < walkers.size(); ++i) {
+            Walker& walker = walkers[i];
+            if (--walker.life == 0) {
+                spawn(walker);
+            }
+            walker.x += walker.vx;
+            walker.y += walker.vy;
+            if (walker.x < 0.0f || walker.x > 1.0f) {
+                walker.vx = -walker.vx;
+                walker.x = std::clamp(walker.x, 0.0f, 1.0f);
+            }
+            if (walker.y < 0.0f || walker.y > 1.0f) {
+                walker.vy = -walker.vy;
+                walker.y = std::clamp(walker.y, 0.0f, 1.0f);
+            }
+            TrackedObject& object = walker.object;
+            object.xmin = walker.x - 0.02f;
+            object.xmax = walker.x + 0.02f;
+            object.ymin = walker.y - 0.1f;
+            object.ymax = walker.y;
+            objects[i] = object;
+        }
+        timestamp += std::chrono::milliseconds(33);
+
+        events.clear();
+        auto start = std::chrono::steady_clock::now();
+        analytics.update(objects, f, timestamp, events);
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        total_events += events.size();
+    }
+
+    ZoneAnalyticsBenchmark result;
+    result.zones = zones;
+    result.tripwires = tripwires;
+    result.tracks = tracks;
+    result.grid = std::max(grid, 1u);
+    if (samples.empty()) {
+        return result;
+    }
+    auto halfMean = [&samples](size_t from, size_t to) {
+        double sum = 0.0;
+        for (size_t i = from; i < to; ++i) {
+            sum += samples[i];
+        }
+        return to > from ? sum / static_cast<double>(to - from) : 0.0;
+    };
+    result.first_half_mean_us = halfMean(0, samples.size() / 2);
+    result.second_half_mean_us = halfMean(samples.size() / 2, samples.size());
+    result.mean_us = halfMean(0, samples.size());
+    result.events_per_frame = static_cast<double>(total_events) / static_cast<double>(samples.size());
+    result.candidates_per_object = analytics.getStats().mean_candidates;
+    SampleSummary summary = summarizeSamples(samples);
+    result.p50_us = summary.p50;
+    result.p99_us = summary.p99;
+    result.max_us = summary.max;
+    return result;
+}
+
+} // namespace oak
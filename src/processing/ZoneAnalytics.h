@@ -0,0 +1,186 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <depthai/depthai.hpp>
+#include <opencv2/opencv.hpp>
+#include "../engine/Types.h"
+#include "IouTracker.h"
+
+namespace oak {
+
+enum class AnalyticsEventType : uint8_t {
+    ZONE_ENTER = 0,
+    ZONE_EXIT = 1,                       // Also when the track is lost inside the zone
+    LINE_CROSS = 2
+};
+
+// Emitted only when something changes; 32 bytes
+struct AnalyticsEvent {
+    AnalyticsEventType type = AnalyticsEventType::ZONE_ENTER;
+    int8_t direction = 0;                // LINE_CROSS: +1 left to right of a -> b, -1 back
+    uint16_t index = 0;                  // Zone or tripwire, in config order
+    uint32_t track_id = 0;
+    uint32_t label = 0;
+    uint32_t count = 0;                  // Zone occupancy after the change, or the wire's crossings in this direction
+    int64_t sequence = -1;
+    int64_t timestamp_us = 0;
+};
+
+using AnalyticsCallback = std::function<void(const std::vector<AnalyticsEvent>&)>;
+
+// One object of a frame, with the id a tracker gave it
+struct TrackedObject {
+    uint32_t track_id = 0;
+    uint32_t label = 0;
+    float xmin = 0.0f, ymin = 0.0f, xmax = 0.0f, ymax = 0.0f;  // Normalized
+};
+
+// Running totals, in config order
+struct AnalyticsCounts {
+    std::vector<uint32_t> occupancy;     // Tracks inside each zone now
+    std::vector<uint64_t> entries;       // Per zone, since the start
+    std::vector<uint64_t> forward;       // Per tripwire, direction +1
+    std::vector<uint64_t> backward;      // Per tripwire, direction -1
+};
+
+struct AnalyticsStats {
+    uint64_t frames = 0;
+    uint64_t objects = 0;
+    uint64_t events = 0;
+    uint32_t active_tracks = 0;
+    double mean_candidates = 0.0;        // Zone and tripwire tests per object left by the grid
+    double mean_update_us = 0.0;
+    double max_update_us = 0.0;
+};
+
+// Zone occupancy, tripwire crossings and a position heatmap, updated
+// incrementally with every detection message.
+//
+// Zones and tripwires are bucketed once into a grid of cells over the frame
+// (a zone into the cells its bounding box covers, a tripwire into the cells
+// its segment passes through). Per object only the entries of the cell of
+// its anchor point are tested, and for tripwires those of the cells its
+// last movement spans, so hundreds of zones cost little more than a few.
+// Each track remembers its zones and last position; the new state is diffed
+// against it and only the differences become events. The heatmap decays
+// through a global scale rather than a pass over every cell, so a frame
+// costs O(objects), however long the analytics have been running.
+//
+// Thread-safe; updates are expected from one thread at a time, in order.
+class ZoneAnalytics {
+public:
+    explicit ZoneAnalytics(const AnalyticsConfig& config);
+
+    // Objects that already carry track ids. Appends this frame's events.
+    void update(const std::vector<TrackedObject>& objects, int64_t sequence,
+                std::chrono::steady_clock::time_point timestamp, std::vector<AnalyticsEvent>& events);
+    // Raw detections: associated into tracks with an IoU tracker first
+    void update(const dai::ImgDetections& detections, std::vector<AnalyticsEvent>& events);
+
+    AnalyticsCounts getCounts() const;
+    // Anchor-point density, heatmap_height x heatmap_width CV_32F, in
+    // detections (decayed by heatmap_half_life_s); empty if disabled
+    cv::Mat getHeatmap() const;
+    AnalyticsStats getStats() const;
+    // Forget tracks, counts and heat; zones and tripwires stay
+    void reset();
+
+private:
+    struct Zone {
+        std::vector<ZonePoint> polygon;
+        float xmin, ymin, xmax, ymax;
+        std::vector<uint32_t> labels;
+        uint32_t occupancy = 0;
+        uint64_t entries = 0;
+    };
+
+    struct Wire {
+        ZonePoint a;
+        ZonePoint b;
+        std::vector<uint32_t> labels;
+        uint64_t forward = 0;
+        uint64_t backward = 0;
+    };
+
+    struct Track {
+        uint32_t label = 0;
+        ZonePoint anchor;
+        uint64_t last_frame = 0;
+        std::vector<uint16_t> zones;     // Sorted
+    };
+
+    // Zone or tripwire indices per cell (see buildCells)
+    struct Grid {
+        std::vector<uint32_t> start;     // cols * rows + 1
+        std::vector<uint16_t> items;
+    };
+
+    ZonePoint anchorOf(const TrackedObject& object) const;
+    size_t cellOf(float x, float y) const;
+    void buildGrid();
+    void updateLocked(const std::vector<TrackedObject>& objects, int64_t sequence,
+                      std::chrono::steady_clock::time_point timestamp, std::vector<AnalyticsEvent>& events);
+    void crossWires(const Track& track, ZonePoint to, AnalyticsEvent event, std::vector<AnalyticsEvent>& events);
+    void addHeat(ZonePoint point);
+    static bool labelMatches(const std::vector<uint32_t>& labels, uint32_t label);
+
+    AnalyticsConfig config_;
+    uint32_t cols_;
+    uint32_t rows_;
+
+    mutable std::mutex mutex_;
+    std::vector<Zone> zones_;
+    std::vector<Wire> wires_;
+    Grid zone_grid_;
+    Grid wire_grid_;
+    std::vector<uint32_t> wire_stamp_;   // Last movement a wire was tested for (dedupes across cells)
+    uint32_t stamp_ = 0;
+
+    std::unordered_map<uint32_t, Track> tracks_;
+    uint64_t frame_ = 0;
+    std::vector<uint16_t> inside_;       // Scratch: zones of the current object
+
+    // Heat is stored multiplied by heat_scale_, which grows instead of every cell decaying
+    std::vector<float> heat_;
+    double heat_scale_ = 1.0;
+    std::chrono::steady_clock::time_point last_timestamp_;
+
+    // Raw detections
+    IouTracker tracker_;
+    uint32_t next_track_id_ = 1;
+    uint32_t tracker_frame_ = 0;
+    std::vector<uint32_t> track_ids_;
+    std::vector<TrackedObject> objects_;
+
+    AnalyticsStats stats_;
+    uint64_t candidates_ = 0;
+    double update_us_total_ = 0.0;
+};
+
+struct ZoneAnalyticsBenchmark {
+    uint32_t zones = 0;
+    uint32_t tripwires = 0;
+    uint32_t tracks = 0;
+    uint32_t grid = 0;                   // Cells per side
+    double mean_us = 0.0;                // Per frame
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+    double first_half_mean_us = 0.0;     // Same as the second half if cost does not grow with history
+    double second_half_mean_us = 0.0;
+    double events_per_frame = 0.0;
+    double candidates_per_object = 0.0;
+};
+
+// Random polygon zones and tripwires with synthetic tracks that wander,
+// leave and get replaced; reports the per-frame update cost
+ZoneAnalyticsBenchmark benchmarkZoneAnalytics(uint32_t zones, uint32_t tripwires, uint32_t tracks,
+                                              uint32_t frames, uint32_t grid = 32);
+
+} // namespace oak
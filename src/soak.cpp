@@ -0,0 +1,395 @@
+// Soak test: cycles the engine through preview, recording and inference for
+// hours, against the simulated source by default, and records resource use,
+// throughput and latency per phase. Each cycle ends by shutting the engine
+// down and initializing it again; only with --device does that close and
+// reopen a device. Fails when a later cycle regresses beyond the configured
+// thresholds relative to the baseline cycle.
+//
+//   oak-soak --hours 12 --phase-seconds 120 --report soak.csv
+//   oak-soak --device --model models/yolo.tar.xz --hours 1
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <algorithm>
+#include <filesystem>
+
+#include "engine/EngineManager.h"
+#include "engine/AllocationCounter.h"
+#include "engine/ProcessMetrics.h"
+#include "engine/SampleStats.h"
+#include "engine/Types.h"
+
+namespace {
+
+std::atomic<bool> g_running{true};
+
+void signalHandler(int) {
+    g_running = false;
+}
+
+struct SoakOptions {
+    double hours = 1.0;
+    uint32_t phase_seconds = 60;         // Time spent in each mode per cycle
+    uint32_t settle_seconds = 2;         // Excluded from a phase's measurements after start
+    uint32_t warmup_cycles = 1;          // The last warm-up cycle is the baseline
+    bool use_device = false;
+    std::string model_path;              // Inference on a device needs a model
+    float fps = 0.0f;                    // Simulated source rate, 0 = full rate
+    std::string report_path = "soak_report.csv";
+    std::string record_directory;        // Emptied after every recording phase; default: a temp dir
+    bool reconnect = true;               // Shut down and reinitialize the engine after each cycle
+    bool fail_fast = false;
+
+    // Regression thresholds relative to the baseline
+    double max_rss_growth_mb = 64.0;
+    int max_thread_growth = 0;
+    int max_fd_growth = 0;
+    double min_fps_ratio = 0.8;
+    double max_p99_ratio = 2.0;          // Plus 1 ms slack so sub-millisecond noise cannot fail a run
+};
+
+struct PhaseResult {
+    std::string mode;
+    uint64_t frames = 0;
+    double fps = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+    uint64_t queue_drops = 0;
+    uint64_t pool_drops = 0;
+    double allocations_per_frame = 0.0;  // Processing thread, after warm-up
+    oak::ProcessSample process;
+};
+
+void printUsage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options]\n"
+              << "  --hours <h>              Total run time (default 1)\n"
+              << "  --phase-seconds <s>      Time per mode per cycle (default 60)\n"
+              << "  --warmup-cycles <n>      Cycles before the baseline (default 1)\n"
+              << "  --fps <f>                Simulated frame rate, 0 = full rate (default 0)\n"
+              << "  --device                 Use a connected device instead of the simulator\n"
+              << "  --model <path>           Model for inference on a device\n"
+              << "  --report <file.csv>      Per-phase results (default soak_report.csv)\n"
+              << "  --record-dir <path>      Recordings, deleted after each phase (default: temp dir)\n"
+              << "  --no-reconnect           Keep the engine (and device) open between cycles\n"
+              << "  --max-rss-growth-mb <m>  (default 64)\n"
+              << "  --max-thread-growth <n>  (default 0)\n"
+              << "  --max-fd-growth <n>      (default 0)\n"
+              << "  --min-fps-ratio <r>      (default 0.8)\n"
+              << "  --max-p99-ratio <r>      (default 2.0)\n"
+              << "  --fail-fast              Stop at the first regression" << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], SoakOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(arg + " needs a value");
+            }
+            return argv[++i];
+        };
+        try {
+            if (arg == "--hours") options.hours = std::stod(value());
+            else if (arg == "--phase-seconds") options.phase_seconds = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--warmup-cycles") options.warmup_cycles = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--fps") options.fps = std::stof(value());
+            else if (arg == "--device") options.use_device = true;
+            else if (arg == "--model") options.model_path = value();
+            else if (arg == "--report") options.report_path = value();
+            else if (arg == "--record-dir") options.record_directory = value();
+            else if (arg == "--no-reconnect") options.reconnect = false;
+            else if (arg == "--max-rss-growth-mb") options.max_rss_growth_mb = std::stod(value());
+            else if (arg == "--max-thread-growth") options.max_thread_growth = std::stoi(value());
+            else if (arg == "--max-fd-growth") options.max_fd_growth = std::stoi(value());
+            else if (arg == "--min-fps-ratio") options.min_fps_ratio = std::stod(value());
+            else if (arg == "--max-p99-ratio") options.max_p99_ratio = std::stod(value());
+            else if (arg == "--fail-fast") options.fail_fast = true;
+            else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return false;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+    options.phase_seconds = std::max(options.phase_seconds, options.settle_seconds + 1);
+    if (options.record_directory.empty()) {
+        options.record_directory = (std::filesystem::temp_directory_path() / "oak-soak").string();
+    }
+    return true;
+}
+
+bool startMode(oak::EngineManager& engine, const std::string& mode, const SoakOptions& options) {
+    if (mode == "preview") {
+        oak::OutputConfig config;
+        config.show_preview = false;
+        return engine.startPreview(config);
+    }
+    if (mode == "record") {
+        oak::RecordConfig config;
+        config.output_path = (std::filesystem::path(options.record_directory) / "").string();
+        config.show_preview = false;
+        return engine.startRecording(config);
+    }
+    oak::InferenceConfig config;
+    config.model_path = options.model_path;
+    config.show_preview = false;
+    return engine.startInference(config);
+}
+
+// Deletes a recording phase's files, so hours of cycles do not fill the disk
+void clearRecordings(const SoakOptions& options) {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(options.record_directory, error)) {
+        std::filesystem::remove_all(entry.path(), error);
+    }
+}
+
+// Resource growth since the baseline; returns the failures
+std::vector<std::string> checkProcess(const oak::ProcessSample& process, const oak::ProcessSample& process_baseline,
+                                      const SoakOptions& options) {
+    std::vector<std::string> failures;
+    double rss_growth_mb = (static_cast<double>(process.rss_bytes) -
+                            static_cast<double>(process_baseline.rss_bytes)) / (1024.0 * 1024.0);
+    if (rss_growth_mb > options.max_rss_growth_mb) {
+        failures.push_back("RSS grew " + std::to_string(rss_growth_mb) + " MB");
+    }
+    int thread_growth = static_cast<int>(process.threads) - static_cast<int>(process_baseline.threads);
+    if (thread_growth > options.max_thread_growth) {
+        failures.push_back("thread count grew by " + std::to_string(thread_growth));
+    }
+    int fd_growth = static_cast<int>(process.open_files) - static_cast<int>(process_baseline.open_files);
+    if (fd_growth > options.max_fd_growth) {
+        failures.push_back("open files grew by " + std::to_string(fd_growth));
+    }
+    return failures;
+}
+
+// Compares a phase against the baseline of the same mode; returns the failures
+std::vector<std::string> checkRegressions(const PhaseResult& result, const PhaseResult& baseline,
+                                          const oak::ProcessSample& process_baseline,
+                                          const SoakOptions& options) {
+    std::vector<std::string> failures = checkProcess(result.process, process_baseline, options);
+    if (result.fps < baseline.fps * options.min_fps_ratio) {
+        failures.push_back(result.mode + " fps " + std::to_string(result.fps) + " vs baseline " +
+                           std::to_string(baseline.fps));
+    }
+    if (result.p99_ms > baseline.p99_ms * options.max_p99_ratio + 1.0) {
+        failures.push_back(result.mode + " p99 latency " + std::to_string(result.p99_ms) + " ms vs baseline " +
+                           std::to_string(baseline.p99_ms) + " ms");
+    }
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SoakOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    auto& engine = oak::EngineManager::getInstance();
+    oak::EngineConfig config;
+    config.simulation.enabled = !options.use_device;
+    config.simulation.fps = options.fps;
+    if (!engine.initialize(config)) {
+        std::cerr << "Failed to initialize engine" << std::endl;
+        return 2;
+    }
+
+    oak::LatencyRecorder latency;
+    std::atomic<uint64_t> detection_messages{0};
+    engine.setFrameCallback([&](std::shared_ptr<dai::ImgFrame> frame) {
+        latency.record(frame->getTimestamp());
+    });
+    engine.setDetectionCallback([&](std::shared_ptr<dai::ImgDetections>) {
+        detection_messages.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    if (!oak::AllocationCounter::enabled()) {
+        std::cout << "Built without OAK_COUNT_ALLOCATIONS, allocs_per_frame reads zero" << std::endl;
+    }
+
+    std::vector<std::string> modes = {"preview", "record"};
+    if (!options.use_device || !options.model_path.empty()) {
+        modes.push_back("inference");
+    } else {
+        std::cout << "No --model given, inference is not part of the cycle" << std::endl;
+    }
+
+    std::ofstream report(options.report_path);
+    report << "elapsed_s,cycle,mode,frames,fps,p50_ms,p95_ms,p99_ms,max_ms,queue_drops,pool_drops,allocs_per_frame,"
+              "rss_mb,threads,open_files,status\n";
+
+    using Clock = std::chrono::steady_clock;
+    const auto run_start = Clock::now();
+    const auto run_end = run_start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::ratio<3600>>(options.hours));
+
+    std::map<std::string, PhaseResult> baselines;
+    oak::ProcessSample process_baseline;
+    uint32_t regressions = 0;
+    uint32_t cycle = 0;
+    uint64_t pool_drops_total = 0;
+
+    while (g_running && Clock::now() < run_end && !(options.fail_fast && regressions > 0)) {
+        ++cycle;
+        for (const auto& mode : modes) {
+            if (!g_running || Clock::now() >= run_end) {
+                break;
+            }
+
+            PhaseResult result;
+            result.mode = mode;
+            if (!startMode(engine, mode, options)) {
+                std::cerr << "Failed to start " << mode << std::endl;
+                report << std::chrono::duration<double>(Clock::now() - run_start).count() << ","
+                       << cycle << "," << mode << ",,,,,,,,,,,,,START_FAILED\n";
+                ++regressions;
+                continue;
+            }
+
+            // Skip start-up transients, then measure the steady state
+            std::this_thread::sleep_for(std::chrono::seconds(options.settle_seconds));
+            latency.start();
+            auto measure_start = Clock::now();
+            auto measure_end = measure_start + std::chrono::seconds(options.phase_seconds - options.settle_seconds);
+            while (g_running && Clock::now() < measure_end) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            double measured_s = std::chrono::duration<double>(Clock::now() - measure_start).count();
+
+            for (const auto& stats : engine.getQueueStats()) {
+                result.queue_drops += stats.gap_dropped + stats.drained;
+            }
+            if (auto allocations = engine.getAllocationStats()) {
+                result.allocations_per_frame = allocations->steady_allocations_per_frame;
+            }
+            engine.stopModule();
+            latency.stop();
+            if (mode == "record") {
+                clearRecordings(options);
+            }
+            auto summary = latency.summarize();
+            result.frames = summary.count;
+            result.p50_ms = summary.p50;
+            result.p95_ms = summary.p95;
+            result.p99_ms = summary.p99;
+            result.max_ms = summary.max;
+            result.fps = measured_s > 0.0 ? static_cast<double>(result.frames) / measured_s : 0.0;
+            if (auto pool = engine.getTaskPoolStats()) {
+                result.pool_drops = pool->dropped - pool_drops_total;
+                pool_drops_total = pool->dropped;
+            }
+            // Sampled with no module running, so only leaked resources remain
+            result.process = oak::sampleProcess();
+
+            std::vector<std::string> failures;
+            bool baseline_cycle = cycle == std::max(options.warmup_cycles, 1u);
+            if (baseline_cycle) {
+                baselines[mode] = result;
+                process_baseline = result.process;
+            } else if (cycle > options.warmup_cycles && baselines.count(mode)) {
+                failures = checkRegressions(result, baselines[mode], process_baseline, options);
+            }
+            regressions += static_cast<uint32_t>(failures.size());
+
+            std::string status = cycle < options.warmup_cycles ? "WARMUP"
+                               : baseline_cycle ? "BASELINE"
+                               : failures.empty() ? "OK" : "REGRESSION";
+            double elapsed_s = std::chrono::duration<double>(Clock::now() - run_start).count();
+            report << std::fixed << std::setprecision(3)
+                   << elapsed_s << "," << cycle << "," << mode << "," << result.frames << ","
+                   << result.fps << "," << result.p50_ms << "," << result.p95_ms << ","
+                   << result.p99_ms << "," << result.max_ms << "," << result.queue_drops << ","
+                   << result.pool_drops << "," << result.allocations_per_frame << ","
+                   << static_cast<double>(result.process.rss_bytes) / (1024.0 * 1024.0) << ","
+                   << result.process.threads << "," << result.process.open_files << "," << status << "\n";
+            report.flush();
+
+            std::cout << "[soak] cycle " << cycle << " " << mode << ": " << result.fps << " fps, p99 "
+                      << result.p99_ms << " ms, RSS "
+                      << result.process.rss_bytes / (1024 * 1024) << " MB, "
+                      << result.process.threads << " threads, " << result.process.open_files
+                      << " files, " << status << std::endl;
+            for (const auto& failure : failures) {
+                std::cerr << "[soak] REGRESSION: " << failure << std::endl;
+            }
+            if (options.fail_fast && !failures.empty()) {
+                break;
+            }
+        }
+
+        // Close and reopen the engine (and with --device, the device), so
+        // leaks on that path show up as well
+        if (!options.reconnect || !g_running || Clock::now() >= run_end ||
+            (options.fail_fast && regressions > 0)) {
+            continue;
+        }
+        auto reconnect_start = Clock::now();
+        engine.shutdown();
+        bool reopened = engine.initialize(config);
+        double reconnect_ms = std::chrono::duration<double, std::milli>(Clock::now() - reconnect_start).count();
+        double elapsed_s = std::chrono::duration<double>(Clock::now() - run_start).count();
+        if (!reopened) {
+            std::cerr << "[soak] Failed to reinitialize the engine" << std::endl;
+            report << elapsed_s << "," << cycle << ",reconnect,,,,,,,,,,,,,START_FAILED\n";
+            ++regressions;
+            break;
+        }
+
+        oak::ProcessSample process = oak::sampleProcess();
+        std::vector<std::string> failures;
+        if (cycle > std::max(options.warmup_cycles, 1u)) {
+            failures = checkProcess(process, process_baseline, options);
+        }
+        regressions += static_cast<uint32_t>(failures.size());
+        std::string status = cycle <= std::max(options.warmup_cycles, 1u) ? "WARMUP"
+                           : failures.empty() ? "OK" : "REGRESSION";
+        // Reconnect time goes in the max_ms column
+        report << std::fixed << std::setprecision(3)
+               << elapsed_s << "," << cycle << ",reconnect,,,,,," << reconnect_ms << ",,,,"
+               << static_cast<double>(process.rss_bytes) / (1024.0 * 1024.0) << ","
+               << process.threads << "," << process.open_files << "," << status << "\n";
+        report.flush();
+        std::cout << "[soak] cycle " << cycle << " reconnect: " << reconnect_ms << " ms, RSS "
+                  << process.rss_bytes / (1024 * 1024) << " MB, " << process.threads << " threads, "
+                  << process.open_files << " files, " << status << std::endl;
+        for (const auto& failure : failures) {
+            std::cerr << "[soak] REGRESSION: " << failure << std::endl;
+        }
+    }
+
+    engine.shutdown();
+    std::error_code error;
+    std::filesystem::remove_all(options.record_directory, error);
+
+    std::cout << "[soak] " << cycle << " cycles in "
+              << std::chrono::duration<double>(Clock::now() - run_start).count() << " s, "
+              << detection_messages.load() << " detection messages, "
+              << regressions << " regressions; report: " << options.report_path << std::endl;
+    return regressions == 0 ? 0 : 1;
+}
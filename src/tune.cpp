@@ -0,0 +1,391 @@
+// Inference auto-tuner: sweeps DetectionNetwork resource settings (and,
+// optionally, the same network exported at other input sizes) on a device,
+// measures sustained detection fps and capture-to-callback latency for each
+// candidate, and saves the best as the model's profile, which later
+// startInference calls load automatically (see engine/InferenceProfile.h).
+//
+//   oak-tune --model models/yolo.blob
+//   oak-tune --model models/yolo.blob --variant models/yolo_416.blob:416x416 --max-p95-ms 80
+//
+// Parameters are tuned one at a time, each starting from the best settings
+// found so far, in the order threads, NCEs, shaves, pool frames, input queue,
+// input size. That is a dozen or so restarts instead of every combination,
+// and matches how these settings were tuned by hand.
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <algorithm>
+
+#include "engine/EngineManager.h"
+#include "engine/InferenceProfile.h"
+#include "engine/SampleStats.h"
+#include "engine/Types.h"
+
+namespace {
+
+std::atomic<bool> g_running{true};
+
+void signalHandler(int) {
+    g_running = false;
+}
+
+// Same network exported at another input size
+struct ModelVariant {
+    std::string model_path;
+    uint32_t input_width = 0;
+    uint32_t input_height = 0;
+};
+
+struct TuneOptions {
+    std::string model_path;
+    uint32_t input_width = 640;
+    uint32_t input_height = 640;
+    std::vector<ModelVariant> variants;
+    std::vector<int> inference_threads{1, 2};
+    std::vector<int> nce_per_thread{0, 1, 2};
+    std::vector<int> shaves_per_thread{0, 4, 6, 8};
+    std::vector<int> pool_frames{0, 4, 8};
+    std::vector<int> input_queue_sizes{0, 2, 4};
+    float camera_fps = 60.0f;            // Network input rate while tuning; the fastest candidates must stay below it
+    uint32_t warmup_seconds = 2;         // After each restart, before measuring
+    uint32_t measure_seconds = 5;
+    double max_p95_ms = 0.0;             // Candidates above are rejected; 0 = fastest wins
+    double min_gain = 0.02;              // fps gain that counts as better rather than noise
+    std::string profile_directory = "profiles/";
+    std::string report_path = "tune_report.csv";
+    bool save = true;
+    bool simulate = false;               // Dry run of the sweep against the simulated source
+};
+
+struct Candidate {
+    ModelVariant model;
+    oak::InferenceTuning tuning;
+    bool started = false;
+    uint64_t frames = 0;
+    double fps = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+void printUsage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " --model <path> [options]\n"
+              << "  --model <path>            Model to tune (blob or NN archive)\n"
+              << "  --input <W>x<H>           Its input size (default 640x640)\n"
+              << "  --variant <path>:<W>x<H>  Same network at another input size; repeatable\n"
+              << "  --threads <list>          Inference threads (default 1,2)\n"
+              << "  --nce <list>              NCEs per thread, 0 = default (default 0,1,2)\n"
+              << "  --shaves <list>           Shaves per thread, 0 = default (default 0,4,6,8)\n"
+              << "  --pool <list>             Network pool frames, 0 = default (default 0,4,8)\n"
+              << "  --queue <list>            Network input queue, 0 = default (default 0,2,4)\n"
+              << "  --camera-fps <f>          Network input rate while tuning (default 60)\n"
+              << "  --warmup-seconds <s>      Per candidate, not measured (default 2)\n"
+              << "  --measure-seconds <s>     Per candidate (default 5)\n"
+              << "  --max-p95-ms <ms>         Latency limit, 0 = none (default 0)\n"
+              << "  --profiles <dir>          Profile directory (default profiles/)\n"
+              << "  --report <file.csv>       Every candidate measured (default tune_report.csv)\n"
+              << "  --no-save                 Report only, keep the existing profile\n"
+              << "  --simulate                Dry run against the simulated source" << std::endl;
+}
+
+std::vector<int> parseList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(std::stoi(item));
+    }
+    if (values.empty()) {
+        throw std::invalid_argument("empty list");
+    }
+    return values;
+}
+
+void parseSize(const std::string& text, uint32_t& width, uint32_t& height) {
+    auto x = text.find('x');
+    if (x == std::string::npos) {
+        throw std::invalid_argument("expected <W>x<H>");
+    }
+    width = static_cast<uint32_t>(std::stoul(text.substr(0, x)));
+    height = static_cast<uint32_t>(std::stoul(text.substr(x + 1)));
+}
+
+bool parseOptions(int argc, char* argv[], TuneOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(arg + " needs a value");
+            }
+            return argv[++i];
+        };
+        try {
+            if (arg == "--model") options.model_path = value();
+            else if (arg == "--input") parseSize(value(), options.input_width, options.input_height);
+            else if (arg == "--variant") {
+                std::string text = value();
+                auto colon = text.rfind(':');
+                if (colon == std::string::npos) {
+                    throw std::invalid_argument("expected <path>:<W>x<H>");
+                }
+                ModelVariant variant;
+                variant.model_path = text.substr(0, colon);
+                parseSize(text.substr(colon + 1), variant.input_width, variant.input_height);
+                options.variants.push_back(variant);
+            }
+            else if (arg == "--threads") options.inference_threads = parseList(value());
+            else if (arg == "--nce") options.nce_per_thread = parseList(value());
+            else if (arg == "--shaves") options.shaves_per_thread = parseList(value());
+            else if (arg == "--pool") options.pool_frames = parseList(value());
+            else if (arg == "--queue") options.input_queue_sizes = parseList(value());
+            else if (arg == "--camera-fps") options.camera_fps = std::stof(value());
+            else if (arg == "--warmup-seconds") options.warmup_seconds = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--measure-seconds") options.measure_seconds = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--max-p95-ms") options.max_p95_ms = std::stod(value());
+            else if (arg == "--profiles") options.profile_directory = value();
+            else if (arg == "--report") options.report_path = value();
+            else if (arg == "--no-save") options.save = false;
+            else if (arg == "--simulate") options.simulate = true;
+            else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return false;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+    if (options.model_path.empty() && !options.simulate) {
+        std::cerr << "--model is required" << std::endl;
+        return false;
+    }
+    options.measure_seconds = std::max(options.measure_seconds, 1u);
+    return true;
+}
+
+std::string describe(const Candidate& candidate) {
+    std::ostringstream text;
+    const auto& t = candidate.tuning;
+    text << candidate.model.input_width << "x" << candidate.model.input_height
+         << " threads=" << t.inference_threads << " nce=" << t.nce_per_thread << " shaves=" << t.shaves_per_thread
+         << " pool=" << t.pool_frames << " queue=" << t.input_queue_size;
+    return text.str();
+}
+
+// a beats b: within the latency limit, then clearly faster, or as fast with lower latency
+bool better(const Candidate& a, const Candidate& b, const TuneOptions& options) {
+    auto acceptable = [&](const Candidate& c) {
+        return c.started && c.frames > 0 && (options.max_p95_ms <= 0.0 || c.p95_ms <= options.max_p95_ms);
+    };
+    if (!acceptable(a)) {
+        return false;
+    }
+    if (!acceptable(b)) {
+        return true;
+    }
+    if (a.fps > b.fps * (1.0 + options.min_gain)) {
+        return true;
+    }
+    return a.fps >= b.fps * (1.0 - options.min_gain) && a.p95_ms < b.p95_ms;
+}
+
+class Tuner {
+public:
+    Tuner(oak::EngineManager& engine, const TuneOptions& options, oak::LatencyRecorder& recorder,
+          std::ofstream& report)
+        : engine_(engine), options_(options), recorder_(recorder), report_(report) {}
+
+    Candidate run() {
+        Candidate best;
+        best.model = {options_.model_path, options_.input_width, options_.input_height};
+        best = measure(best);
+
+        auto sweep = [&](const std::vector<int>& values, int oak::InferenceTuning::*field) {
+            for (int value : values) {
+                if (!g_running) {
+                    return;
+                }
+                Candidate candidate = best;
+                candidate.tuning.*field = value;
+                candidate = measure(candidate);
+                if (better(candidate, best, options_)) {
+                    best = candidate;
+                }
+            }
+        };
+        sweep(options_.inference_threads, &oak::InferenceTuning::inference_threads);
+        sweep(options_.nce_per_thread, &oak::InferenceTuning::nce_per_thread);
+        sweep(options_.shaves_per_thread, &oak::InferenceTuning::shaves_per_thread);
+        sweep(options_.pool_frames, &oak::InferenceTuning::pool_frames);
+        sweep(options_.input_queue_sizes, &oak::InferenceTuning::input_queue_size);
+
+        for (const auto& variant : options_.variants) {
+            if (!g_running) {
+                break;
+            }
+            Candidate candidate = best;
+            candidate.model = variant;
+            candidate = measure(candidate);
+            if (better(candidate, best, options_)) {
+                best = candidate;
+            }
+        }
+        return best;
+    }
+
+private:
+    // Runs one candidate, or returns the earlier result for the same settings
+    Candidate measure(Candidate candidate) {
+        std::string key = candidate.model.model_path + " " + describe(candidate);
+        auto cached = measured_.find(key);
+        if (cached != measured_.end()) {
+            return cached->second;
+        }
+
+        oak::InferenceConfig config;
+        config.model_path = candidate.model.model_path;
+        config.input_width = candidate.model.input_width;
+        config.input_height = candidate.model.input_height;
+        // Well above the 30 fps default, so fast candidates are not all capped at the same rate
+        config.input_fps = options_.camera_fps;
+        config.show_preview = false;
+        config.tuning = candidate.tuning;
+        config.use_tuned_profile = false;
+        // Lossless, so the measured rate is what the network produced
+        config.detection_queue = oak::QueueConfig{16, false, oak::QueuePolicy::LOSSLESS};
+
+        std::cout << "[tune] " << describe(candidate) << " ..." << std::flush;
+        candidate.started = engine_.startInference(config);
+        if (candidate.started) {
+            std::this_thread::sleep_for(std::chrono::seconds(options_.warmup_seconds));
+            recorder_.start();
+            auto start = std::chrono::steady_clock::now();
+            auto end = start + std::chrono::seconds(options_.measure_seconds);
+            while (g_running && std::chrono::steady_clock::now() < end) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            double measured_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            recorder_.stop();
+            engine_.stopModule();
+            auto summary = recorder_.summarize();
+            candidate.frames = summary.count;
+            candidate.p50_ms = summary.p50;
+            candidate.p95_ms = summary.p95;
+            candidate.max_ms = summary.max;
+            candidate.fps = measured_s > 0.0 ? static_cast<double>(candidate.frames) / measured_s : 0.0;
+            std::cout << " " << candidate.fps << " fps, p95 " << candidate.p95_ms << " ms" << std::endl;
+        } else {
+            std::cout << " failed to start" << std::endl;
+        }
+
+        const auto& t = candidate.tuning;
+        report_ << std::fixed << std::setprecision(3)
+                << candidate.model.model_path << "," << candidate.model.input_width << "x"
+                << candidate.model.input_height << "," << t.inference_threads << "," << t.nce_per_thread << ","
+                << t.shaves_per_thread << "," << t.pool_frames << "," << t.input_queue_size << ","
+                << (candidate.started ? "OK" : "START_FAILED") << "," << candidate.frames << ","
+                << candidate.fps << "," << candidate.p50_ms << "," << candidate.p95_ms << ","
+                << candidate.max_ms << "\n";
+        report_.flush();
+
+        measured_[key] = candidate;
+        return candidate;
+    }
+
+    oak::EngineManager& engine_;
+    const TuneOptions& options_;
+    oak::LatencyRecorder& recorder_;
+    std::ofstream& report_;
+    std::map<std::string, Candidate> measured_;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    TuneOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // Keyed by the model as given; variants are stored in its profile
+    auto hash = oak::hashModelFile(options.model_path);
+    if (!hash && !options.simulate) {
+        std::cerr << "Cannot read model " << options.model_path << std::endl;
+        return 2;
+    }
+
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    auto& engine = oak::EngineManager::getInstance();
+    oak::EngineConfig config;
+    config.simulation.enabled = options.simulate;
+    config.snapshot.enabled = false;
+    if (!engine.initialize(config)) {
+        std::cerr << "Failed to initialize engine" << std::endl;
+        return 2;
+    }
+    if (options.simulate) {
+        std::cout << "[tune] simulated source: the sweep runs, the numbers mean nothing" << std::endl;
+    }
+
+    oak::LatencyRecorder recorder;
+    engine.setDetectionCallback([&recorder](std::shared_ptr<dai::ImgDetections> detections) {
+        recorder.record(detections->getTimestamp());
+    });
+
+    std::ofstream report(options.report_path);
+    report << "model,input,threads,nce,shaves,pool,queue,status,frames,fps,p50_ms,p95_ms,max_ms\n";
+
+    Tuner tuner(engine, options, recorder, report);
+    Candidate best = tuner.run();
+    engine.shutdown();
+
+    if (!best.started || best.frames == 0 ||
+        (options.max_p95_ms > 0.0 && best.p95_ms > options.max_p95_ms)) {
+        std::cerr << "[tune] no candidate met the requirements; report: " << options.report_path << std::endl;
+        return 1;
+    }
+
+    std::cout << "[tune] best: " << describe(best) << ", " << best.fps << " fps, p95 "
+              << best.p95_ms << " ms" << std::endl;
+    if (best.fps >= 0.95 * options.camera_fps) {
+        std::cout << "[tune] the best candidate ran at the camera rate, so faster settings may tie; "
+                  << "rerun with a higher --camera-fps" << std::endl;
+    }
+
+    if (options.save && hash && !options.simulate) {
+        oak::InferenceProfile profile;
+        profile.model_hash = *hash;
+        if (best.model.model_path != options.model_path) {
+            profile.model_path = best.model.model_path;
+            profile.input_width = best.model.input_width;
+            profile.input_height = best.model.input_height;
+        }
+        profile.tuning = best.tuning;
+        profile.fps = best.fps;
+        profile.p95_latency_ms = best.p95_ms;
+        if (!oak::saveInferenceProfile(options.profile_directory, profile)) {
+            return 1;
+        }
+        std::cout << "[tune] saved " << oak::inferenceProfilePath(options.profile_directory, *hash) << std::endl;
+    }
+    return 0;
+}
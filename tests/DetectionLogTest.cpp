@@ -0,0 +1,125 @@
+#include "Test.h"
+#include "engine/DetectionLog.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+using namespace oak;
+
+namespace {
+
+// Log in a fresh temporary directory, removed afterwards
+struct TempLog {
+    DetectionLogConfig config;
+
+    explicit TempLog(const char* name) {
+        config.directory = (fs::temp_directory_path() / name).string() + "/";
+        config.segment_capacity = 64;    // Several segments with a few hundred records
+        config.index_stride = 8;
+        fs::remove_all(config.directory);
+    }
+    ~TempLog() {
+        std::error_code error;
+        fs::remove_all(config.directory, error);
+    }
+};
+
+dai::ImgDetection detection(uint32_t label, float confidence) {
+    return dai::ImgDetection{label, confidence, 0.1f, 0.2f, 0.3f, 0.4f};
+}
+
+// Message i at 1000 * i us: two detections, labels i % 5 and 7, on source i % 2
+void fill(DetectionLog& log, int64_t messages) {
+    for (int64_t i = 0; i < messages; ++i) {
+        std::vector<dai::ImgDetection> detections{detection(static_cast<uint32_t>(i % 5), 0.5f), detection(7, 0.9f)};
+        CHECK(log.append(1000 * i, i, static_cast<uint16_t>(i % 2), detections));
+    }
+}
+
+} // namespace
+
+OAK_TEST(DetectionLog, QueryReturnsEveryRecordInAppendOrder) {
+    TempLog temp("oak-test-detection-log-order");
+    DetectionLog log(temp.config);
+    CHECK(log.open());
+    fill(log, 200);
+
+    auto stats = log.getStats();
+    CHECK_EQ(stats.records, 400u);
+    CHECK(stats.segments > 1);
+
+    std::vector<DetectionRecord> records;
+    CHECK_EQ(log.query(DetectionQuery{}, records), 400u);
+    for (size_t i = 0; i < records.size(); ++i) {
+        CHECK_EQ(records[i].sequence, static_cast<int64_t>(i / 2));
+        CHECK_EQ(records[i].timestamp_us, static_cast<int64_t>(i / 2) * 1000);
+    }
+    CHECK_EQ(records[1].label, 7);
+    CHECK(records[1].confidence == 0.9f);
+    CHECK(records[0].xmin == 0.1f && records[0].ymax == 0.4f);
+}
+
+OAK_TEST(DetectionLog, FiltersByLabelSourceAndWindow) {
+    TempLog temp("oak-test-detection-log-filters");
+    DetectionLog log(temp.config);
+    CHECK(log.open());
+    fill(log, 200);
+
+    std::vector<DetectionRecord> records;
+    DetectionQuery by_label;
+    by_label.label = 3;
+    CHECK_EQ(log.query(by_label, records), 40u);
+    for (const auto& record : records) {
+        CHECK_EQ(record.label, 3);
+        CHECK_EQ(record.sequence % 5, 3);
+    }
+
+    records.clear();
+    DetectionQuery by_source;
+    by_source.source = 1;
+    by_source.label = 7;
+    CHECK_EQ(log.query(by_source, records), 100u);
+    for (const auto& record : records) {
+        CHECK_EQ(record.source, 1);
+    }
+
+    // Both bounds inclusive
+    records.clear();
+    DetectionQuery window;
+    window.begin_us = 50000;
+    window.end_us = 59000;
+    CHECK_EQ(log.query(window, records), 20u);
+    CHECK_EQ(records.front().sequence, 50);
+    CHECK_EQ(records.back().sequence, 59);
+
+    records.clear();
+    DetectionQuery empty;
+    empty.begin_us = 300000;
+    CHECK_EQ(log.query(empty, records), 0u);
+
+    records.clear();
+    DetectionQuery limited;
+    limited.label = 7;
+    limited.limit = 5;
+    CHECK_EQ(log.query(limited, records), 5u);
+    CHECK_EQ(records.back().sequence, 4);
+}
+
+OAK_TEST(DetectionLog, ReopenKeepsRecordsAndAppendsAfterThem) {
+    TempLog temp("oak-test-detection-log-reopen");
+    {
+        DetectionLog log(temp.config);
+        CHECK(log.open());
+        fill(log, 100);
+    }
+
+    DetectionLog log(temp.config);
+    CHECK(log.open());
+    CHECK_EQ(log.getStats().records, 200u);
+    CHECK(log.append(500000, 500, 0, {detection(9, 0.7f)}));
+
+    std::vector<DetectionRecord> records;
+    CHECK_EQ(log.query(DetectionQuery{}, records), 201u);
+    CHECK_EQ(records[199].sequence, 99);
+    CHECK_EQ(records[200].sequence, 500);
+    CHECK_EQ(records[200].label, 9);
+}
@@ -0,0 +1,77 @@
+#include "Test.h"
+#include "engine/RingDeque.h"
+#include <memory>
+
+using namespace oak;
+
+OAK_TEST(RingDeque, FifoOrderAcrossWrapAndGrowth) {
+    RingDeque<int> queue(4);
+    int next_in = 0;
+    int next_out = 0;
+    // Keep the head moving so the contents wrap, then outgrow the capacity
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 3 + round % 4; ++i) {
+            queue.push_back(next_in++);
+        }
+        for (int i = 0; i < 2 + round % 3 && !queue.empty(); ++i) {
+            CHECK_EQ(queue.front(), next_out++);
+            queue.pop_front();
+        }
+        CHECK_EQ(queue.size(), static_cast<size_t>(next_in - next_out));
+        for (size_t i = 0; i < queue.size(); ++i) {
+            CHECK_EQ(queue[i], next_out + static_cast<int>(i));
+        }
+    }
+    while (!queue.empty()) {
+        CHECK_EQ(queue.front(), next_out++);
+        queue.pop_front();
+    }
+    CHECK_EQ(next_out, next_in);
+}
+
+OAK_TEST(RingDeque, PushFrontAndPopBack) {
+    RingDeque<int> queue;
+    for (int i = 0; i < 20; ++i) {
+        if (i % 2 == 0) {
+            queue.push_back(i);
+        } else {
+            queue.push_front(i);
+        }
+    }
+    // 19 17 ... 3 1 0 2 4 ... 18
+    CHECK_EQ(queue.front(), 19);
+    CHECK_EQ(queue.back(), 18);
+    CHECK_EQ(queue[9], 1);
+    CHECK_EQ(queue[10], 0);
+    for (int expected = 18; expected >= 0; expected -= 2) {
+        CHECK_EQ(queue.back(), expected);
+        queue.pop_back();
+    }
+    for (int expected = 19; expected >= 1; expected -= 2) {
+        CHECK_EQ(queue.front(), expected);
+        queue.pop_front();
+    }
+    CHECK(queue.empty());
+}
+
+OAK_TEST(RingDeque, PopReleasesAndClearKeepsCapacity) {
+    RingDeque<std::shared_ptr<int>> queue;
+    auto value = std::make_shared<int>(1);
+    queue.push_back(value);
+    queue.push_back(value);
+    CHECK_EQ(value.use_count(), 3);
+    queue.pop_front();
+    CHECK_EQ(value.use_count(), 2);
+    queue.pop_back();
+    CHECK_EQ(value.use_count(), 1);
+
+    for (int i = 0; i < 100; ++i) {
+        queue.push_back(value);
+    }
+    size_t capacity = queue.capacity();
+    CHECK(capacity >= 100u);
+    queue.clear();
+    CHECK(queue.empty());
+    CHECK_EQ(value.use_count(), 1);
+    CHECK_EQ(queue.capacity(), capacity);
+}
@@ -0,0 +1,136 @@
+#include "Test.h"
+#include "processing/Serializers.h"
+#include <cmath>
+
+using namespace oak;
+
+namespace {
+
+// Quantized to 1/65535
+constexpr float kStep = 1.0f / 65535.0f;
+
+bool near(float actual, float expected) {
+    return std::fabs(actual - expected) <= kStep;
+}
+
+dai::ImgDetections message(int64_t sequence, std::chrono::microseconds time) {
+    dai::ImgDetections detections;
+    detections.setSequenceNum(sequence);
+    detections.setTimestamp(std::chrono::steady_clock::time_point(time));
+    detections.detections.push_back(dai::ImgDetection{2, 0.9132f, 0.1021f, 0.2f, 0.3312f, 0.4f});
+    detections.detections.push_back(dai::ImgDetection{0, 1.0f, 0.0f, 0.5f, 1.0f, 0.75f});
+    detections.detections.push_back(dai::ImgDetection{14, 0.25f, 0.6f, 0.1f, 0.9f, 0.95f});
+    return detections;
+}
+
+} // namespace
+
+OAK_TEST(Serializers, DetectionsRoundTrip) {
+    auto detections = message(42, std::chrono::microseconds(123456789));
+    std::vector<uint8_t> buffer;
+    encodeDetections(detections, 3, buffer);
+
+    DecodedRecord record;
+    CHECK_EQ(decodeRecord(buffer.data(), buffer.size(), record), buffer.size());
+    CHECK(record.header.kind == RecordKind::DETECTIONS);
+    CHECK_EQ(record.header.source, 3);
+    CHECK_EQ(record.header.sequence, 42);
+    CHECK_EQ(record.header.body_bytes, buffer.size() - 16);
+    CHECK_EQ(record.timestamp_us, 123456789);
+    CHECK_EQ(record.detections.size(), detections.detections.size());
+    for (size_t i = 0; i < record.detections.size(); ++i) {
+        const auto& expected = detections.detections[i];
+        const auto& actual = record.detections[i];
+        CHECK_EQ(actual.label, expected.label);
+        CHECK(near(actual.confidence, expected.confidence));
+        CHECK(near(actual.xmin, expected.xmin) && near(actual.ymin, expected.ymin));
+        CHECK(near(actual.xmax, expected.xmax) && near(actual.ymax, expected.ymax));
+    }
+}
+
+OAK_TEST(Serializers, TrackAndFrameRoundTrip) {
+    TrackEvent event;
+    event.source = 1;
+    event.sequence = 77;
+    event.timestamp_us = -5;
+    event.track_id = 123456;
+    event.event = TrackEventType::ENDED;
+    event.label = 300;
+    event.confidence = 0.5f;
+    event.xmin = 0.25f;
+    event.ymin = 0.125f;
+    event.xmax = 0.75f;
+    event.ymax = 0.875f;
+
+    FrameMeta frame;
+    frame.source = 2;
+    frame.sequence = 78;
+    frame.timestamp_us = 1000;
+    frame.device_timestamp_us = 990;
+    frame.width = 1920;
+    frame.height = 1080;
+    frame.type = 7;
+
+    // Records share a buffer and are read back one after the other
+    std::vector<uint8_t> buffer;
+    encodeTrackEvent(event, buffer);
+    encodeFrameMeta(frame, buffer);
+
+    DecodedRecord record;
+    size_t used = decodeRecord(buffer.data(), buffer.size(), record);
+    CHECK(used > 0 && used < buffer.size());
+    CHECK(record.header.kind == RecordKind::TRACK);
+    CHECK_EQ(record.track.source, 1);
+    CHECK_EQ(record.track.sequence, 77);
+    CHECK_EQ(record.track.timestamp_us, -5);
+    CHECK_EQ(record.track.track_id, 123456u);
+    CHECK(record.track.event == TrackEventType::ENDED);
+    CHECK_EQ(record.track.label, 300);
+    CHECK(near(record.track.confidence, 0.5f) && near(record.track.xmin, 0.25f));
+    CHECK(near(record.track.ymin, 0.125f) && near(record.track.ymax, 0.875f));
+
+    size_t rest = decodeRecord(buffer.data() + used, buffer.size() - used, record);
+    CHECK_EQ(used + rest, buffer.size());
+    CHECK(record.header.kind == RecordKind::FRAME);
+    CHECK_EQ(record.frame.source, 2);
+    CHECK_EQ(record.frame.sequence, 78);
+    CHECK_EQ(record.frame.timestamp_us, 1000);
+    CHECK_EQ(record.frame.device_timestamp_us, 990);
+    CHECK_EQ(record.frame.width, 1920u);
+    CHECK_EQ(record.frame.height, 1080u);
+    CHECK_EQ(record.frame.type, 7);
+}
+
+OAK_TEST(Serializers, TruncatedAndUnknownRecords) {
+    std::vector<uint8_t> buffer;
+    encodeDetections(message(1, std::chrono::microseconds(0)), 0, buffer);
+
+    DecodedRecord record;
+    for (size_t size = 0; size < buffer.size(); ++size) {
+        CHECK_EQ(decodeRecord(buffer.data(), size, record), 0u);
+    }
+
+    // A kind this reader does not know is skipped whole
+    buffer[0] = 200;
+    CHECK_EQ(decodeRecord(buffer.data(), buffer.size(), record), buffer.size());
+    CHECK_EQ(static_cast<int>(record.header.kind), 200);
+    CHECK_EQ(record.header.sequence, 1);
+}
+
+OAK_TEST(Serializers, DetectionsJson) {
+    auto detections = message(12, std::chrono::microseconds(5000));
+    detections.detections.resize(1);
+    std::vector<std::string> labels{"person", "bicycle", "car"};
+
+    std::string json = "old ";  // Appended to, not replaced
+    writeDetectionsJson(detections, 0, json, &labels);
+    CHECK_EQ(json, std::string("old {\"kind\":\"detections\",\"source\":0,\"seq\":12,\"ts_us\":5000,\"detections\":["
+                               "{\"label\":2,\"name\":\"car\",\"conf\":0.9132,\"box\":[0.1021,0.2,0.3312,0.4]}]}"));
+
+    // Labels outside the list get no name
+    detections.detections[0].label = 9;
+    json.clear();
+    writeDetectionsJson(detections, 0, json, &labels);
+    CHECK(json.find("\"name\"") == std::string::npos);
+    CHECK(json.find("\"label\":9") != std::string::npos);
+}
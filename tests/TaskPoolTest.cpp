@@ -0,0 +1,44 @@
+#include "Test.h"
+#include "engine/TaskPool.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace oak;
+
+OAK_TEST(TaskPool, WaitStreamRunsEverySubmittedTask) {
+    TaskPool pool(4, 256);
+    pool.start();
+    std::atomic<int> done{0};
+    for (int round = 0; round < 50; ++round) {
+        int expected = done.load();
+        for (int i = 0; i < 20; ++i) {
+            CHECK(pool.submit(7, [&done] {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                done.fetch_add(1);
+            }));
+        }
+        pool.waitStream(7);
+        CHECK_EQ(done.load(), expected + 20);
+    }
+    pool.stop();
+}
+
+OAK_TEST(TaskPool, WaitStreamIgnoresOtherStreams) {
+    TaskPool pool(2, 16);
+    pool.start();
+    std::atomic<bool> release{false};
+    CHECK(pool.submit(1, [&release] {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }));
+    std::atomic<bool> ran{false};
+    CHECK(pool.submit(2, [&ran] { ran = true; }));
+    pool.waitStream(2);
+    CHECK(ran.load());
+    pool.waitStream(3);                  // Never used: returns at once
+    release = true;
+    pool.waitStream(1);
+    pool.stop();
+}
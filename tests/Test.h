@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <functional>
+
+// Minimal test harness: OAK_TEST registers a case under a suite, CHECK and
+// CHECK_EQ abort the case with the file and line on failure. oak-tests runs
+// every case, or the suites named on its command line (one ctest per suite).
+
+namespace oak::test {
+
+struct TestCase {
+    const char* suite;
+    const char* name;
+    std::function<void()> run;
+};
+
+std::vector<TestCase>& registry();
+
+struct Registrar {
+    Registrar(const char* suite, const char* name, std::function<void()> run) {
+        registry().push_back({suite, name, std::move(run)});
+    }
+};
+
+// Thrown by a failed check
+struct Failure {
+    std::string message;
+};
+
+[[noreturn]] void fail(const char* file, int line, const std::string& message);
+
+template <typename A, typename B>
+void checkEqual(const A& actual, const B& expected, const char* expression, const char* file, int line) {
+    if (!(actual == expected)) {
+        std::ostringstream out;
+        out << expression << ": got " << actual << ", expected " << expected;
+        fail(file, line, out.str());
+    }
+}
+
+} // namespace oak::test
+
+#define OAK_TEST(suite, name)                                                              \
+    static void suite##_##name();                                                          \
+    static ::oak::test::Registrar suite##_##name##_registrar(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            ::oak::test::fail(__FILE__, __LINE__, "CHECK(" #condition ")");                \
+        }                                                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    ::oak::test::checkEqual((actual), (expected), #actual " == " #expected, __FILE__, __LINE__)
@@ -0,0 +1,58 @@
+#include "Test.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace oak::test {
+
+std::vector<TestCase>& registry() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    throw Failure{std::string(file) + ":" + std::to_string(line) + ": " + message};
+}
+
+} // namespace oak::test
+
+// oak-tests [suite...]: runs the named suites, or every test
+int main(int argc, char* argv[]) {
+    using namespace oak::test;
+    size_t passed = 0;
+    size_t failed = 0;
+    for (const auto& test : registry()) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc && !selected; ++i) {
+            selected = std::strcmp(argv[i], test.suite) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::string error;
+        try {
+            test.run();
+        } catch (const Failure& failure) {
+            error = failure.message;
+        } catch (const std::exception& e) {
+            error = std::string("exception: ") + e.what();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (error.empty()) {
+            ++passed;
+            std::cout << "[ OK ] " << test.suite << "." << test.name << " (" << ms << " ms)" << std::endl;
+        } else {
+            ++failed;
+            std::cout << "[FAIL] " << test.suite << "." << test.name << ": " << error << std::endl;
+        }
+    }
+
+    if (passed + failed == 0) {
+        std::cerr << "No tests selected" << std::endl;
+        return 1;
+    }
+    std::cout << passed << " passed, " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "Test.h"
+#include "engine/ThumbnailHistory.h"
+#include "engine/SimulatedSource.h"
+#include <chrono>
+#include <thread>
+
+using namespace oak;
+
+namespace {
+
+constexpr uint32_t kWidth = 64;
+constexpr uint32_t kHeight = 48;
+constexpr size_t kFrameBytes = kWidth * kHeight * 3 / 2;   // NV12
+
+ThumbnailConfig smallHistory() {
+    ThumbnailConfig config;
+    config.enabled = true;
+    config.width = kWidth;
+    config.height = kHeight;
+    config.fps = 0.0f;                   // Keep every frame the source sends
+    config.format = ThumbnailFormat::NV12;
+    config.memory_budget_kb = 32;        // Room for 7 frames
+    return config;
+}
+
+// Runs a full-rate simulated source into the history until `frames` are stored
+void fill(ThumbnailHistory& history, uint64_t frames) {
+    SimulationConfig simulation;
+    simulation.enabled = true;
+    SimulatedSource source(simulation);
+    history.configureSimulated(source);
+    source.start();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (history.getStats().stored < frames && std::chrono::steady_clock::now() < deadline) {
+        history.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    source.stop();
+    history.detach();
+}
+
+} // namespace
+
+OAK_TEST(ThumbnailHistory, EvictsOldestWithinBudget) {
+    ThumbnailHistory history(smallHistory(), nullptr);
+    fill(history, 50);
+
+    ThumbnailStats stats = history.getStats();
+    CHECK(stats.stored >= 50);
+    CHECK_EQ(stats.skipped, 0u);
+    CHECK_EQ(stats.budget_bytes, 32u * 1024);
+    CHECK(stats.bytes <= stats.budget_bytes);
+    CHECK_EQ(stats.streams.size(), 1u);
+    CHECK_EQ(stats.streams[0].stream, std::string("CAM_A"));
+
+    uint64_t kept = stats.streams[0].frames;
+    CHECK_EQ(stats.bytes, kept * kFrameBytes);
+    CHECK_EQ(stats.evicted, stats.stored - kept);
+    // The arena wraps when the next frame no longer fits before its end
+    CHECK_EQ(kept, stats.budget_bytes / kFrameBytes);
+}
+
+OAK_TEST(ThumbnailHistory, NearestClampsToStoredRange) {
+    ThumbnailHistory history(smallHistory(), nullptr);
+    fill(history, 20);
+
+    ThumbnailStats stats = history.getStats();
+    auto oldest = history.nearest(stats.streams[0].oldest - std::chrono::seconds(60));
+    auto newest = history.nearest(std::chrono::steady_clock::now());
+    CHECK(oldest.has_value());
+    CHECK(newest.has_value());
+    CHECK(oldest->timestamp == stats.streams[0].oldest);
+    CHECK(newest->timestamp == stats.streams[0].newest);
+    // Only the newest frames survive eviction, in sequence order
+    CHECK_EQ(newest->sequence - oldest->sequence + 1, static_cast<int64_t>(stats.streams[0].frames));
+    CHECK_EQ(newest->sequence + 1, static_cast<int64_t>(stats.stored));
+
+    CHECK_EQ(newest->stream, std::string("CAM_A"));
+    CHECK(newest->format == ThumbnailFormat::NV12);
+    CHECK_EQ(newest->width, kWidth);
+    CHECK_EQ(newest->height, kHeight);
+    CHECK_EQ(newest->data.size(), kFrameBytes);
+
+    CHECK(!history.nearest(std::chrono::steady_clock::now(), "CAM_B").has_value());
+}
+
+OAK_TEST(ThumbnailHistory, MaxFramesCapsTheIndex) {
+    ThumbnailConfig config = smallHistory();
+    config.max_frames = 3;
+    ThumbnailHistory history(config, nullptr);
+    fill(history, 20);
+
+    ThumbnailStats stats = history.getStats();
+    CHECK_EQ(stats.streams[0].frames, 3u);
+    CHECK_EQ(stats.bytes, 3 * kFrameBytes);
+    CHECK_EQ(stats.evicted, stats.stored - 3);
+
+    history.clear();
+    CHECK(!history.nearest(std::chrono::steady_clock::now()).has_value());
+    CHECK_EQ(history.getStats().bytes, 0u);
+}
@@ -0,0 +1,173 @@
+#include "Test.h"
+#include "processing/ZoneAnalytics.h"
+#include <chrono>
+#include <vector>
+
+using namespace oak;
+
+namespace {
+
+// A 0.1 x 0.1 box centred on (x, y)
+TrackedObject at(uint32_t track_id, float x, float y, uint32_t label = 0) {
+    TrackedObject object;
+    object.track_id = track_id;
+    object.label = label;
+    object.xmin = x - 0.05f;
+    object.ymin = y - 0.05f;
+    object.xmax = x + 0.05f;
+    object.ymax = y + 0.05f;
+    return object;
+}
+
+ZoneConfig square(float min, float max, std::vector<uint32_t> labels = {}) {
+    ZoneConfig zone;
+    zone.name = "square";
+    zone.polygon = {{min, min}, {max, min}, {max, max}, {min, max}};
+    zone.labels = std::move(labels);
+    return zone;
+}
+
+AnalyticsConfig centered() {
+    AnalyticsConfig config;
+    config.anchor = AnchorPoint::CENTER;
+    config.grid_cols = 8;
+    config.grid_rows = 8;
+    config.heatmap_width = 0;
+    return config;
+}
+
+// Feeds one frame per call, numbered from 0
+class Feed {
+public:
+    explicit Feed(ZoneAnalytics& analytics) : analytics_(analytics) {}
+
+    std::vector<AnalyticsEvent> operator()(const std::vector<TrackedObject>& objects) {
+        std::vector<AnalyticsEvent> events;
+        auto timestamp = std::chrono::steady_clock::time_point(std::chrono::milliseconds(33 * (sequence_ + 1)));
+        analytics_.update(objects, sequence_++, timestamp, events);
+        return events;
+    }
+
+private:
+    ZoneAnalytics& analytics_;
+    int64_t sequence_ = 0;
+};
+
+} // namespace
+
+OAK_TEST(ZoneAnalytics, EnterAndExitUpdateOccupancy) {
+    AnalyticsConfig config = centered();
+    config.zones = {square(0.2f, 0.6f)};
+    ZoneAnalytics analytics(config);
+    Feed feed(analytics);
+
+    CHECK(feed({at(1, 0.1f, 0.1f)}).empty());
+
+    auto events = feed({at(1, 0.4f, 0.4f, 3)});
+    CHECK_EQ(events.size(), 1u);
+    CHECK(events[0].type == AnalyticsEventType::ZONE_ENTER);
+    CHECK_EQ(events[0].index, 0);
+    CHECK_EQ(events[0].track_id, 1u);
+    CHECK_EQ(events[0].label, 3u);
+    CHECK_EQ(events[0].count, 1u);
+    CHECK_EQ(events[0].sequence, 1);
+
+    // Moving inside the zone changes nothing
+    CHECK(feed({at(1, 0.5f, 0.3f, 3)}).empty());
+
+    events = feed({at(1, 0.5f, 0.3f, 3), at(2, 0.3f, 0.5f)});
+    CHECK_EQ(events.size(), 1u);
+    CHECK_EQ(events[0].track_id, 2u);
+    CHECK_EQ(events[0].count, 2u);
+
+    events = feed({at(1, 0.8f, 0.3f, 3), at(2, 0.3f, 0.5f)});
+    CHECK_EQ(events.size(), 1u);
+    CHECK(events[0].type == AnalyticsEventType::ZONE_EXIT);
+    CHECK_EQ(events[0].track_id, 1u);
+    CHECK_EQ(events[0].count, 1u);
+
+    AnalyticsCounts counts = analytics.getCounts();
+    CHECK_EQ(counts.occupancy[0], 1u);
+    CHECK_EQ(counts.entries[0], 2u);
+    CHECK_EQ(analytics.getStats().events, 3u);
+}
+
+OAK_TEST(ZoneAnalytics, LabelFilterAndOverlappingZones) {
+    AnalyticsConfig config = centered();
+    config.zones = {square(0.2f, 0.6f, {1}), square(0.4f, 0.8f)};
+    ZoneAnalytics analytics(config);
+    Feed feed(analytics);
+
+    // Label 2 is only counted by the second zone
+    auto events = feed({at(1, 0.5f, 0.5f, 2)});
+    CHECK_EQ(events.size(), 1u);
+    CHECK_EQ(events[0].index, 1);
+
+    // Label 1 in the overlap enters both, in zone order
+    events = feed({at(1, 0.5f, 0.5f, 2), at(2, 0.5f, 0.5f, 1)});
+    CHECK_EQ(events.size(), 2u);
+    CHECK_EQ(events[0].index, 0);
+    CHECK_EQ(events[1].index, 1);
+    CHECK_EQ(events[1].count, 2u);
+}
+
+OAK_TEST(ZoneAnalytics, LostTrackLeavesItsZones) {
+    AnalyticsConfig config = centered();
+    config.zones = {square(0.2f, 0.6f)};
+    config.max_missed_frames = 2;
+    ZoneAnalytics analytics(config);
+    Feed feed(analytics);
+
+    CHECK_EQ(feed({at(7, 0.4f, 0.4f)}).size(), 1u);
+    CHECK(feed({}).empty());
+    CHECK(feed({}).empty());
+
+    auto events = feed({});
+    CHECK_EQ(events.size(), 1u);
+    CHECK(events[0].type == AnalyticsEventType::ZONE_EXIT);
+    CHECK_EQ(events[0].track_id, 7u);
+    CHECK_EQ(events[0].count, 0u);
+    CHECK_EQ(analytics.getCounts().occupancy[0], 0u);
+    CHECK_EQ(analytics.getStats().active_tracks, 0u);
+}
+
+OAK_TEST(ZoneAnalytics, TripwireCountsEachDirection) {
+    AnalyticsConfig config = centered();
+    TripwireConfig wire;
+    wire.name = "door";
+    wire.a = {0.2f, 0.5f};
+    wire.b = {0.8f, 0.5f};
+    config.tripwires = {wire};
+    ZoneAnalytics analytics(config);
+    Feed feed(analytics);
+
+    CHECK(feed({at(1, 0.5f, 0.3f)}).empty());
+
+    // Heading along a -> b (+x) with y down, the left side is above the wire
+    auto events = feed({at(1, 0.5f, 0.7f)});
+    CHECK_EQ(events.size(), 1u);
+    CHECK(events[0].type == AnalyticsEventType::LINE_CROSS);
+    CHECK_EQ(events[0].index, 0);
+    CHECK_EQ(static_cast<int>(events[0].direction), 1);
+    CHECK_EQ(events[0].count, 1u);
+
+    events = feed({at(1, 0.6f, 0.2f)});
+    CHECK_EQ(events.size(), 1u);
+    CHECK_EQ(static_cast<int>(events[0].direction), -1);
+    CHECK_EQ(events[0].count, 1u);
+
+    // Past the end of the segment: no crossing
+    CHECK(feed({at(1, 0.9f, 0.2f)}).empty());
+    CHECK(feed({at(1, 0.9f, 0.8f)}).empty());
+    // A new track has no previous position to cross from
+    CHECK(feed({at(1, 0.9f, 0.8f), at(2, 0.5f, 0.7f)}).empty());
+
+    AnalyticsCounts counts = analytics.getCounts();
+    CHECK_EQ(counts.forward[0], 1u);
+    CHECK_EQ(counts.backward[0], 1u);
+
+    analytics.reset();
+    counts = analytics.getCounts();
+    CHECK_EQ(counts.forward[0], 0u);
+    CHECK_EQ(counts.backward[0], 0u);
+}